@@ -0,0 +1,141 @@
+/** 
+ * @file llvolume_libtest.cpp
+ * @brief Timings of sculpt generation in the llmath volume code
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "llpointer.h"
+#include "lltimer.h"
+
+// Linden library includes
+#include "llsculptcache.h"
+#include "llvolume.h"
+
+// system libraries
+#include <iostream>
+
+// doc string provided when invoking the program with --help 
+static const char USAGE[] = "\n"
+"usage:\tllvolume_libtest [options]\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -n, --iterations <n>\n"
+"        Number of sculpts timed for each map size. Default is 200.\n"
+" -d, --detail <n>\n"
+"        Volume detail (LOD scale) of the sculpted volumes. Default is 4.\n"
+"\n";
+
+// Same kind of map as the llvolume unit test: smooth, with a bit of noise
+static std::vector<U8> make_map(U16 width, U16 height)
+{
+	std::vector<U8> map(width * height * 3);
+	U32 seed = 12345;
+	for (U32 y = 0; y < height; ++y)
+	{
+		for (U32 x = 0; x < width; ++x)
+		{
+			F32 u = (F32)x / width * F_TWO_PI;
+			F32 v = (F32)y / height * F_PI;
+			seed = seed * 1103515245 + 12345;
+			U8* texel = &map[(y * width + x) * 3];
+			texel[0] = (U8)(127.5f + 120.f * sinf(v) * cosf(u)) ^ ((seed >> 16) & 0x3);
+			texel[1] = (U8)(127.5f + 120.f * sinf(v) * sinf(u));
+			texel[2] = (U8)(127.5f + 120.f * cosf(v));
+		}
+	}
+	return map;
+}
+
+// Times sculpting a sphere from a size x size map, once sampled from the
+// map and once picked up from the sculpt cache.
+static void time_sculpt(U16 size, S32 iterations, F32 detail)
+{
+	std::vector<U8> map = make_map(size, size);
+	LLUUID id;
+	id.generate();
+	LLVolumeParams params;
+	params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+	params.setSculptID(id, LL_SCULPT_TYPE_SPHERE);
+
+	F64 sampled = 0.0;
+	F64 shared = 0.0;
+	for (S32 i = 0; i < iterations; ++i)
+	{
+		LLSculptCache::clear();
+
+		LLPointer<LLVolume> volume = new LLVolume(params, detail);
+		LLTimer timer;
+		volume->sculpt(size, size, 3, &map[0], 0, false);
+		sampled += timer.getElapsedTimeF64();
+
+		LLPointer<LLVolume> other = new LLVolume(params, detail);
+		timer.reset();
+		other->sculpt(size, size, 3, &map[0], 0, false);
+		shared += timer.getElapsedTimeF64();
+	}
+
+	std::cout << "sculpt " << size << "x" << size << " : "
+			  << sampled * 1000000.0 / iterations << " us sampled, "
+			  << shared * 1000000.0 / iterations << " us from the sculpt cache" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	S32 iterations = 200;
+	F32 detail = 4.f;
+
+	// Analyze command line arguments
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+		{
+			// Send the usage to standard out
+			std::cout << USAGE << std::endl;
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n")) && arg < argc-1)
+		{
+			iterations = llmax(atoi(argv[++arg]), 1);
+		}
+		else if ((!strcmp(argv[arg], "--detail") || !strcmp(argv[arg], "-d")) && arg < argc-1)
+		{
+			detail = llclamp((F32)atof(argv[++arg]), 1.f, 4.f);
+		}
+		else
+		{
+			std::cout << "Unknown argument : " << argv[arg] << USAGE << std::endl;
+			return 1;
+		}
+	}
+
+	// The map sizes sculpts commonly come in
+	const U16 sizes[] = { 64, 128 };
+	for (U16 size : sizes)
+	{
+		time_sculpt(size, iterations, detail);
+	}
+	LLSculptCache::clear();
+
+	return 0;
+}
@@ -40,6 +40,8 @@
 #include "llvolume.h"
 #include "llendianswizzle.h"
 
+#include <thread>
+
 
 #define HEADER_ASCII "Linden Mesh 1.0"
 #define HEADER_BINARY "Linden Binary Mesh 1.0"
@@ -59,6 +61,7 @@ LLPolyMorphData *clone_morph_param_cleavage(const LLPolyMorphData *src_data,
 // Global table of loaded LLPolyMeshes
 //-----------------------------------------------------------------------------
 LLPolyMesh::LLPolyMeshSharedDataTable LLPolyMesh::sGlobalSharedMeshList;
+bool LLPolyMesh::sDeferMorphs = false;
 
 //-----------------------------------------------------------------------------
 // LLPolyMeshSharedData()
@@ -746,6 +749,103 @@ const LLVector2 &LLPolyMeshSharedData::getUVs(U32 index)
         return mTexCoords[index];
 }
 
+//-----------------------------------------------------------------------------
+// LLPolyMeshVertexData()
+//-----------------------------------------------------------------------------
+LLPolyMeshVertexData::LLPolyMeshVertexData(U32 num_vertices)
+:	mNumVertices(num_vertices)
+{
+	// Allocate memory without initializing every vector
+	// NOTE: This makes asusmptions about the size of LLVector[234]
+	S32 nverts = num_vertices;
+	//make sure it's an even number of verts for alignment
+	nverts += nverts%2;
+	mNumFloats = nverts * (
+				4 + //coords
+				4 + //normals
+				4 + //weights
+				2 + //coords
+				4 + //scaled normals
+				4 + //binormals
+				4); //scaled binormals
+
+	//use 16 byte aligned vertex data to make LLPolyMesh SSE friendly
+	mData = (F32*) ll_aligned_malloc_16(mNumFloats*4);
+	S32 offset = 0;
+	mCoords				= 	(LLVector4a*)(mData + offset); offset += 4*nverts;
+	mNormals			=	(LLVector4a*)(mData + offset); offset += 4*nverts;
+	mClothingWeights	= 	(LLVector4a*)(mData + offset); offset += 4*nverts;
+	mTexCoords			= 	(LLVector2*)(mData + offset);  offset += 2*nverts;
+	mScaledNormals		=   (LLVector4a*)(mData + offset); offset += 4*nverts;
+	mBinormals			=   (LLVector4a*)(mData + offset); offset += 4*nverts;
+	mScaledBinormals	=   (LLVector4a*)(mData + offset); offset += 4*nverts; 
+}
+
+//-----------------------------------------------------------------------------
+// ~LLPolyMeshVertexData()
+//-----------------------------------------------------------------------------
+LLPolyMeshVertexData::~LLPolyMeshVertexData()
+{
+	ll_aligned_free_16(mData);
+}
+
+//-----------------------------------------------------------------------------
+// copyFrom()
+//-----------------------------------------------------------------------------
+void LLPolyMeshVertexData::copyFrom(const LLPolyMeshVertexData& src)
+{
+	llassert(mNumFloats == src.mNumFloats);
+	LLVector4a::memcpyNonAliased16(mData, src.mData, mNumFloats * sizeof(F32));
+}
+
+//-----------------------------------------------------------------------------
+// LLPolyMorphJob
+//-----------------------------------------------------------------------------
+std::atomic<S32> LLPolyMorphJob::sNumOutstanding(0);
+
+LLPolyMorphJob::LLPolyMorphJob(LLPolyMeshVertexData* source, LLPolyMeshVertexData* target, std::vector<Morph>& morphs)
+:	mSource(source),
+	mTarget(target),
+	mState(QUEUED)
+{
+	mMorphs.swap(morphs);
+	sNumOutstanding++;
+}
+
+LLPolyMorphJob::~LLPolyMorphJob()
+{
+	if (mState != DONE)
+	{
+		sNumOutstanding--;
+	}
+}
+
+bool LLPolyMorphJob::run()
+{
+	S32 expected = QUEUED;
+	if (!mState.compare_exchange_strong(expected, RUNNING))
+	{
+		return false;
+	}
+
+	LL_PROFILE_ZONE_SCOPED;
+
+	mTarget->copyFrom(*mSource);
+	for (const Morph& morph : mMorphs)
+	{
+		morph.mMorphData->applyToVertices(*mTarget,
+										  morph.mMaskWeights.empty() ? NULL : &morph.mMaskWeights[0],
+										  morph.mDeltaWeight,
+										  morph.mIsClothing);
+	}
+
+	// the source is only needed until the copy is made
+	mSource = NULL;
+	sNumOutstanding--;
+	mState = DONE;
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 // LLPolyMesh()
 //-----------------------------------------------------------------------------
@@ -756,7 +856,6 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
 	mSharedData = shared_data;
 	mReferenceMesh = reference_mesh;
 	mAvatarp = NULL;
-	mVertexData = NULL;
 
 	mCurVertexCount = 0;
 	mFaceIndexCount = 0;
@@ -766,40 +865,12 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
 
 	if (shared_data->isLOD() && reference_mesh)
 	{
-		mCoords = reference_mesh->mCoords;
-		mNormals = reference_mesh->mNormals;
-		mScaledNormals = reference_mesh->mScaledNormals;
-		mBinormals = reference_mesh->mBinormals;
-		mScaledBinormals = reference_mesh->mScaledBinormals;
-		mTexCoords = reference_mesh->mTexCoords;
-		mClothingWeights = reference_mesh->mClothingWeights;
+		shareVertexData(reference_mesh);
+		reference_mesh->mLODMeshes.push_back(this);
 	}
 	else
 	{
-		// Allocate memory without initializing every vector
-		// NOTE: This makes asusmptions about the size of LLVector[234]
-		S32 nverts = mSharedData->mNumVertices;
-		//make sure it's an even number of verts for alignment
-		nverts += nverts%2;
-		S32 nfloats = nverts * (
-					4 + //coords
-					4 + //normals
-					4 + //weights
-					2 + //coords
-					4 + //scaled normals
-					4 + //binormals
-					4); //scaled binormals
-
-		//use 16 byte aligned vertex data to make LLPolyMesh SSE friendly
-		mVertexData = (F32*) ll_aligned_malloc_16(nfloats*4);
-		S32 offset = 0;
-		mCoords				= 	(LLVector4a*)(mVertexData + offset); offset += 4*nverts;
-		mNormals			=	(LLVector4a*)(mVertexData + offset); offset += 4*nverts;
-		mClothingWeights	= 	(LLVector4a*)(mVertexData + offset); offset += 4*nverts;
-		mTexCoords			= 	(LLVector2*)(mVertexData + offset);  offset += 2*nverts;
-		mScaledNormals		=   (LLVector4a*)(mVertexData + offset); offset += 4*nverts;
-		mBinormals			=   (LLVector4a*)(mVertexData + offset); offset += 4*nverts;
-		mScaledBinormals	=   (LLVector4a*)(mVertexData + offset); offset += 4*nverts; 
+		setVertexData(new LLPolyMeshVertexData(mSharedData->mNumVertices));
 		initializeForMorph();
 	}
 }
@@ -811,7 +882,8 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
 LLPolyMesh::~LLPolyMesh()
 {
 	delete_and_clear(mJointRenderData);
-	ll_aligned_free_16(mVertexData);
+	// any job still in flight keeps its own references to its buffers
+	mMorphJob = NULL;
 }
 
 
@@ -861,6 +933,13 @@ LLPolyMesh *LLPolyMesh::getMesh(const std::string &name, LLPolyMesh* reference_m
 //-----------------------------------------------------------------------------
 void LLPolyMesh::freeAllMeshes()
 {
+        // morph jobs still sitting in a worker queue reference shared morph data
+        while (LLPolyMorphJob::getNumOutstanding() > 0)
+        {
+                std::this_thread::yield();
+        }
+
+
         // delete each item in the global lists
         for_each(sGlobalSharedMeshList.begin(), sGlobalSharedMeshList.end(), DeletePairedPointer());
         sGlobalSharedMeshList.clear();
@@ -971,6 +1050,139 @@ LLVector4a *LLPolyMesh::getScaledBinormals()
 }
 
 
+//-----------------------------------------------------------------------------
+// setVertexData()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::setVertexData(LLPolyMeshVertexData* vertex_data)
+{
+	mVertexData = vertex_data;
+	mCoords = vertex_data->mCoords;
+	mNormals = vertex_data->mNormals;
+	mScaledNormals = vertex_data->mScaledNormals;
+	mBinormals = vertex_data->mBinormals;
+	mScaledBinormals = vertex_data->mScaledBinormals;
+	mTexCoords = vertex_data->mTexCoords;
+	mClothingWeights = vertex_data->mClothingWeights;
+
+	for (LLPolyMesh* lod_mesh : mLODMeshes)
+	{
+		lod_mesh->shareVertexData(this);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// shareVertexData()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::shareVertexData(const LLPolyMesh* reference_mesh)
+{
+	mVertexData = reference_mesh->mVertexData;
+	mCoords = reference_mesh->mCoords;
+	mNormals = reference_mesh->mNormals;
+	mScaledNormals = reference_mesh->mScaledNormals;
+	mBinormals = reference_mesh->mBinormals;
+	mScaledBinormals = reference_mesh->mScaledBinormals;
+	mTexCoords = reference_mesh->mTexCoords;
+	mClothingWeights = reference_mesh->mClothingWeights;
+}
+
+//-----------------------------------------------------------------------------
+// queueMorph()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::queueMorph(const LLPolyMorphData* morph_data, const F32* mask_weights, F32 delta_weight, bool is_clothing)
+{
+	// Morph deltas are linear in the weight, so repeated applications of
+	// the same morph between jobs (appearance animation) fold into one.
+	// Masks only change through applyMask(), which flushes first.
+	for (LLPolyMorphJob::Morph& morph : mQueuedMorphs)
+	{
+		if (morph.mMorphData == morph_data)
+		{
+			morph.mDeltaWeight += delta_weight;
+			return;
+		}
+	}
+
+	LLPolyMorphJob::Morph morph;
+	morph.mMorphData = morph_data;
+	if (mask_weights)
+	{
+		morph.mMaskWeights.assign(mask_weights, mask_weights + morph_data->mNumIndices);
+	}
+	morph.mDeltaWeight = delta_weight;
+	morph.mIsClothing = is_clothing;
+	mQueuedMorphs.push_back(morph);
+}
+
+//-----------------------------------------------------------------------------
+// startMorphJob()
+//-----------------------------------------------------------------------------
+LLPolyMorphJob* LLPolyMesh::startMorphJob()
+{
+	if (mQueuedMorphs.empty() || mMorphJob.notNull() || mVertexData.isNull())
+	{
+		return NULL;
+	}
+
+	LLPointer<LLPolyMeshVertexData> target = mSpareVertexData;
+	mSpareVertexData = NULL;
+	if (target.isNull() || target->mNumVertices != mVertexData->mNumVertices)
+	{
+		target = new LLPolyMeshVertexData(mVertexData->mNumVertices);
+	}
+
+	mMorphJob = new LLPolyMorphJob(mVertexData, target, mQueuedMorphs);
+	mQueuedMorphs.clear();
+	return mMorphJob;
+}
+
+//-----------------------------------------------------------------------------
+// finishMorphJob()
+//-----------------------------------------------------------------------------
+bool LLPolyMesh::finishMorphJob(bool wait)
+{
+	if (mMorphJob.isNull())
+	{
+		return false;
+	}
+
+	if (!mMorphJob->isDone())
+	{
+		if (!wait)
+		{
+			return false;
+		}
+
+		if (!mMorphJob->run())
+		{
+			// claimed by a worker, which won't be long
+			while (!mMorphJob->isDone())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	// The renderer only ever reads through mVertexData on this thread, so
+	// swapping the pointers here is all it takes to publish the result.
+	LLPointer<LLPolyMeshVertexData> previous = mVertexData;
+	setVertexData(mMorphJob->getResult());
+	mSpareVertexData = previous;
+	mMorphJob = NULL;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// flushMorphs()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::flushMorphs()
+{
+	finishMorphJob(true);
+	if (startMorphJob())
+	{
+		finishMorphJob(true);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // initializeForMorph()
 //-----------------------------------------------------------------------------
@@ -29,7 +29,10 @@
 
 #include <string>
 #include <map>
+#include <atomic>
 #include "llstl.h"
+#include "llrefcount.h"
+#include "llpointer.h"
 
 #include "v3math.h"
 #include "v2math.h"
@@ -53,6 +56,78 @@ typedef S32 LLPolyFace[3];
 
 //struct PrimitiveGroup;
 
+//-----------------------------------------------------------------------------
+// LLPolyMeshVertexData
+// The deformable, per-instance vertex arrays of an LLPolyMesh, carved out of
+// a single 16 byte aligned block so a complete copy can be handed to a
+// morph job while the current one is still being rendered.
+//-----------------------------------------------------------------------------
+class LLPolyMeshVertexData : public LLThreadSafeRefCount
+{
+public:
+	LLPolyMeshVertexData(U32 num_vertices);
+
+	void copyFrom(const LLPolyMeshVertexData& src);
+
+	U32						mNumVertices;
+	U32						mNumFloats;
+	F32						*mData;
+
+	LLVector4a				*mCoords;
+	LLVector4a				*mNormals;
+	LLVector4a				*mClothingWeights;
+	LLVector2				*mTexCoords;
+	LLVector4a				*mScaledNormals;
+	LLVector4a				*mBinormals;
+	LLVector4a				*mScaledBinormals;
+
+protected:
+	~LLPolyMeshVertexData();
+};
+
+//-----------------------------------------------------------------------------
+// LLPolyMorphJob
+// A batch of morph deltas to be applied to a copy of a mesh's vertex data,
+// usually on a worker thread.  The mesh swaps the result in once isDone().
+//-----------------------------------------------------------------------------
+class LLPolyMorphJob : public LLThreadSafeRefCount
+{
+public:
+	struct Morph
+	{
+		const LLPolyMorphData*	mMorphData;
+		std::vector<F32>		mMaskWeights;	// empty if the morph is unmasked
+		F32						mDeltaWeight;
+		bool					mIsClothing;
+	};
+
+	LLPolyMorphJob(LLPolyMeshVertexData* source, LLPolyMeshVertexData* target, std::vector<Morph>& morphs);
+
+	// Does the work unless another thread already has.  Safe to call from
+	// any thread; returns false if the job was already claimed.
+	bool run();
+	bool isDone() const { return mState == DONE; }
+	S32 getNumMorphs() const { return (S32)mMorphs.size(); }
+
+	LLPolyMeshVertexData* getResult() const { return mTarget; }
+
+	// jobs created but not yet run, across all meshes
+	static S32 getNumOutstanding() { return sNumOutstanding; }
+
+protected:
+	~LLPolyMorphJob();
+
+private:
+	enum EState { QUEUED, RUNNING, DONE };
+
+	std::vector<Morph>					mMorphs;
+	LLPointer<LLPolyMeshVertexData>		mSource;
+	LLPointer<LLPolyMeshVertexData>		mTarget;
+	std::atomic<S32>					mState;
+
+	static std::atomic<S32>				sNumOutstanding;
+};
+
 //-----------------------------------------------------------------------------
 // LLPolyMesh
 // A polyhedra consisting of any number of triangles and quads.
@@ -306,6 +381,32 @@ public:
 		return mSharedData->mJointNames;
 	}
 
+	//--------------------------------------------------------------------
+	// Deferred morphing
+	//--------------------------------------------------------------------
+	// When set, LLPolyMorphTarget::apply() queues its vertex deltas here
+	// and the owner is expected to run them through startMorphJob().
+	static bool sDeferMorphs;
+
+	void	queueMorph(const LLPolyMorphData* morph_data, const F32* mask_weights, F32 delta_weight, bool is_clothing);
+	bool	hasQueuedMorphs() const { return !mQueuedMorphs.empty(); }
+	bool	hasMorphJob() const { return mMorphJob.notNull(); }
+
+	// Packages the queued morphs into a job against a copy of the current
+	// vertex data.  Returns NULL if nothing is queued or a job is pending.
+	LLPolyMorphJob*	startMorphJob();
+
+	// Makes the output of a finished job current, returns true if it did.
+	// If wait is set, an unstarted job is run inline and a running one is
+	// waited for.
+	bool	finishMorphJob(bool wait = false);
+
+	// Applies everything pending or queued before the caller writes to the
+	// vertex data directly.
+	void	flushMorphs();
+
+	LLPolyMeshVertexData* getWritableVertexData() { return mVertexData; }
+
 	LLPolyMorphData*	getMorphData(const std::string& morph_name);
 // 	void	removeMorphData(LLPolyMorphData *morph_target);
 // 	void	deleteAllMorphData();
@@ -330,6 +431,8 @@ public:
 	U32				mCurVertexCount;
 private:
 	void initializeForMorph();
+	void setVertexData(LLPolyMeshVertexData* vertex_data);
+	void shareVertexData(const LLPolyMesh* reference_mesh);
 
 	// Dumps diagnostic information about the global mesh table
 	static void dumpDiagInfo();
@@ -337,8 +440,8 @@ private:
 protected:
 	// mesh data shared across all instances of a given mesh
 	LLPolyMeshSharedData	*mSharedData;
-	// Single array of floats for allocation / deletion
-	F32						*mVertexData;
+	// owns the arrays below; LOD meshes share their reference mesh's
+	LLPointer<LLPolyMeshVertexData>	mVertexData;
 	// deformed vertices (resulting from application of morph targets)
 	LLVector4a				*mCoords;
 	// deformed normals (resulting from application of morph targets)
@@ -356,6 +459,16 @@ protected:
 	
 	LLPolyMesh				*mReferenceMesh;
 
+	// LOD meshes sharing this mesh's vertex data, repointed on every swap.
+	// All meshes of an avatar are deleted together, so these are not
+	// unregistered.
+	std::vector<LLPolyMesh*>			mLODMeshes;
+
+	std::vector<LLPolyMorphJob::Morph>	mQueuedMorphs;
+	LLPointer<LLPolyMorphJob>			mMorphJob;
+	// previous vertex data, recycled as the target of the next job
+	LLPointer<LLPolyMeshVertexData>		mSpareVertexData;
+
 	// global mesh list
 	typedef std::map<std::string, LLPolyMeshSharedData*> LLPolyMeshSharedDataTable; 
 	static LLPolyMeshSharedDataTable sGlobalSharedMeshList;
@@ -252,6 +252,80 @@ void LLPolyMorphData::freeData()
 	}
 }
 
+//-----------------------------------------------------------------------------
+// applyToVertices()
+//-----------------------------------------------------------------------------
+void LLPolyMorphData::applyToVertices(LLPolyMeshVertexData& verts, const F32* mask_weights, F32 delta_weight, bool is_clothing) const
+{
+	LLVector4a *coords = verts.mCoords;
+
+	LLVector4a *scaled_normals = verts.mScaledNormals;
+	LLVector4a *normals = verts.mNormals;
+
+	LLVector4a *scaled_binormals = verts.mScaledBinormals;
+	LLVector4a *binormals = verts.mBinormals;
+
+	LLVector4a *clothing_weights = verts.mClothingWeights;
+	LLVector2 *tex_coords = verts.mTexCoords;
+
+	for(U32 vert_index_morph = 0; vert_index_morph < mNumIndices; vert_index_morph++)
+	{
+		S32 vert_index_mesh = mVertexIndices[vert_index_morph];
+
+		F32 maskWeight = 1.f;
+		if (mask_weights)
+		{
+			maskWeight = mask_weights[vert_index_morph];
+		}
+
+
+		LLVector4a pos = mCoords[vert_index_morph];
+		pos.mul(delta_weight*maskWeight);
+		coords[vert_index_mesh].add(pos);
+
+		if (is_clothing && clothing_weights)
+		{
+			LLVector4a clothing_offset = mCoords[vert_index_morph];
+			clothing_offset.mul(delta_weight * maskWeight);
+			LLVector4a* clothing_weight = &clothing_weights[vert_index_mesh];
+			clothing_weight->add(clothing_offset);
+			clothing_weight->getF32ptr()[VW] = maskWeight;
+		}
+
+		// calculate new normals based on half angles
+		LLVector4a norm = mNormals[vert_index_morph];
+		norm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
+		scaled_normals[vert_index_mesh].add(norm);
+		norm = scaled_normals[vert_index_mesh];
+
+		// guard against degenerate input data before we create NaNs below!
+		//
+		norm.normalize3fast();
+		normals[vert_index_mesh] = norm;
+
+		// calculate new binormals
+		LLVector4a binorm = mBinormals[vert_index_morph];
+
+		// guard against degenerate input data before we create NaNs below!
+		//
+		if (!binorm.isFinite3() || (binorm.dot3(binorm).getF32() <= F_APPROXIMATELY_ZERO))
+		{
+			binorm.set(1,0,0,1);
+		}
+
+		binorm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
+		scaled_binormals[vert_index_mesh].add(binorm);
+		LLVector4a tangent;
+		tangent.setCross3(scaled_binormals[vert_index_mesh], norm);
+		LLVector4a& normalized_binormal = binormals[vert_index_mesh];
+
+		normalized_binormal.setCross3(norm, tangent); 
+		normalized_binormal.normalize3fast();
+		
+		tex_coords[vert_index_mesh] += mTexCoords[vert_index_morph] * delta_weight * maskWeight;
+	}
+}
+
 //-----------------------------------------------------------------------------
 // LLPolyMorphTargetInfo()
 //-----------------------------------------------------------------------------
@@ -568,86 +642,21 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
 	if (delta_weight != 0.f)
 	{
 		llassert(!mMesh->isLOD());
-		LLVector4a *coords = mMesh->getWritableCoords();
-
-		LLVector4a *scaled_normals = mMesh->getScaledNormals();
-		LLVector4a *normals = mMesh->getWritableNormals();
-
-		LLVector4a *scaled_binormals = mMesh->getScaledBinormals();
-		LLVector4a *binormals = mMesh->getWritableBinormals();
-
-		LLVector4a *clothing_weights = mMesh->getWritableClothingWeights();
-		LLVector2 *tex_coords = mMesh->getWritableTexCoords();
-
 		F32 *maskWeightArray = (mVertMask) ? mVertMask->getMorphMaskWeights() : NULL;
 
-		for(U32 vert_index_morph = 0; vert_index_morph < mMorphData->mNumIndices; vert_index_morph++)
+		if (LLPolyMesh::sDeferMorphs)
 		{
-			S32 vert_index_mesh = mMorphData->mVertexIndices[vert_index_morph];
-
-			F32 maskWeight = 1.f;
-			if (maskWeightArray)
-			{
-				maskWeight = maskWeightArray[vert_index_morph];
-			}
-
-
-			LLVector4a pos = mMorphData->mCoords[vert_index_morph];
-			pos.mul(delta_weight*maskWeight);
-			coords[vert_index_mesh].add(pos);
-
-			if (getInfo()->mIsClothingMorph && clothing_weights)
-			{
-				LLVector4a clothing_offset = mMorphData->mCoords[vert_index_morph];
-				clothing_offset.mul(delta_weight * maskWeight);
-				LLVector4a* clothing_weight = &clothing_weights[vert_index_mesh];
-				clothing_weight->add(clothing_offset);
-				clothing_weight->getF32ptr()[VW] = maskWeight;
-			}
-
-			// calculate new normals based on half angles
-			LLVector4a norm = mMorphData->mNormals[vert_index_morph];
-			norm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-			scaled_normals[vert_index_mesh].add(norm);
-			norm = scaled_normals[vert_index_mesh];
-
-			// guard against degenerate input data before we create NaNs below!
-			//
-			norm.normalize3fast();
-			normals[vert_index_mesh] = norm;
-
-			// calculate new binormals
-			LLVector4a binorm = mMorphData->mBinormals[vert_index_morph];
-
-			// guard against degenerate input data before we create NaNs below!
-			//
-			if (!binorm.isFinite3() || (binorm.dot3(binorm).getF32() <= F_APPROXIMATELY_ZERO))
-			{
-				binorm.set(1,0,0,1);
-			}
-
-			binorm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-			scaled_binormals[vert_index_mesh].add(binorm);
-			LLVector4a tangent;
-			tangent.setCross3(scaled_binormals[vert_index_mesh], norm);
-			LLVector4a& normalized_binormal = binormals[vert_index_mesh];
-
-			normalized_binormal.setCross3(norm, tangent); 
-			normalized_binormal.normalize3fast();
-			
-			tex_coords[vert_index_mesh] += mMorphData->mTexCoords[vert_index_morph] * delta_weight * maskWeight;
+			// vertex work is picked up by the next morph job for this mesh
+			mMesh->queueMorph(mMorphData, maskWeightArray, delta_weight, getInfo()->mIsClothingMorph);
 		}
-
-		// now apply volume changes
-		for(LLPolyVolumeMorph& volume_morph : mVolumeMorphs)
+		else
 		{
-			LLVector3 scale_delta = volume_morph.mScale * delta_weight;
-			LLVector3 pos_delta = volume_morph.mPos * delta_weight;
-			
-			volume_morph.mVolume->setScale(volume_morph.mVolume->getScale() + scale_delta);
-            // SL-315
-			volume_morph.mVolume->setPosition(volume_morph.mVolume->getPosition() + pos_delta);
+			mMesh->flushMorphs();
+			mMorphData->applyToVertices(*mMesh->getWritableVertexData(), maskWeightArray, delta_weight, getInfo()->mIsClothingMorph);
 		}
+
+		// now apply volume changes
+		applyVolumeChanges(delta_weight);
 	}
 
 	if (mNext)
@@ -661,6 +670,9 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
 //-----------------------------------------------------------------------------
 void	LLPolyMorphTarget::applyMask(U8 *maskTextureData, S32 width, S32 height, S32 num_components, BOOL invert)
 {
+	// the mesh has to reflect mLastWeight before the old mask can be backed out
+	mMesh->flushMorphs();
+
 	LLVector4a *clothing_weights = getInfo()->mIsClothingMorph ? mMesh->getWritableClothingWeights() : NULL;
 
 	if (!mVertMask)
@@ -34,6 +34,7 @@
 
 class LLAvatarJointCollisionVolume;
 class LLPolyMeshSharedData;
+class LLPolyMeshVertexData;
 class LLVector2;
 class LLAvatarJointCollisionVolume;
 class LLWearable;
@@ -52,6 +53,11 @@ public:
 	BOOL			loadBinary(LLFILE* fp, LLPolyMeshSharedData *mesh);
 	const std::string& getName() { return mName; }
 
+	// Adds this morph, scaled by delta_weight and the optional per-vertex
+	// mask weights, to a set of mesh vertex arrays.  Only touches verts,
+	// so it is safe to run on a worker thread.
+	void applyToVertices(LLPolyMeshVertexData& verts, const F32* mask_weights, F32 delta_weight, bool is_clothing) const;
+
 public:
 	std::string			mName;
 
@@ -35,8 +35,8 @@
 #include "llcallstack.h"
 #include <boost/algorithm/string.hpp>
 
-S32 LLJoint::sNumUpdates = 0;
-S32 LLJoint::sNumTouches = 0;
+std::atomic<S32> LLJoint::sNumUpdates(0);
+std::atomic<S32> LLJoint::sNumTouches(0);
 
 template <class T> 
 bool attachment_map_iter_compare_key(const T& a, const T& b)
@@ -111,6 +111,7 @@ void LLJoint::init()
 	mUpdateXform = TRUE;
     mSupport = SUPPORT_BASE;
     mEnd = LLVector3(0.0f, 0.0f, 0.0f);
+	mTopologySerial = 0;
 }
 
 LLJoint::LLJoint() :
@@ -221,6 +222,7 @@ void LLJoint::touch(U32 flags)
 void LLJoint::setJointNum(S32 joint_num)
 {
     mJointNum = joint_num;
+    bumpTopologySerial();
     if (mJointNum + 2 >= LL_CHARACTER_MAX_ANIMATED_JOINTS)
     {
         LL_INFOS() << "LL_CHARACTER_MAX_ANIMATED_JOINTS needs to be increased" << LL_ENDL;
@@ -273,6 +275,7 @@ void LLJoint::addChild(LLJoint* joint)
 	joint->mXform.setParent(&mXform);
 	joint->mParent = this;	
 	joint->touch();
+	bumpTopologySerial();
 }
 
 
@@ -289,6 +292,7 @@ void LLJoint::removeChild(LLJoint* joint)
 		joint->mXform.setParent(NULL);
 		joint->mParent = NULL;
 		joint->touch();
+		bumpTopologySerial();
 	}
 }
 
@@ -308,9 +312,25 @@ void LLJoint::removeAllChildren()
             //delete joint;
         }
 	}
+    if (!mChildren.empty())
+    {
+        bumpTopologySerial();
+    }
     mChildren.clear();
 }
 
+//--------------------------------------------------------------------
+// bumpTopologySerial()
+//--------------------------------------------------------------------
+void LLJoint::bumpTopologySerial()
+{
+	// every ancestor, so a hierarchy built from any of them sees the change
+	for (LLJoint* joint = this; joint; joint = joint->mParent)
+	{
+		joint->mTopologySerial++;
+	}
+}
+
 
 //--------------------------------------------------------------------
 // getPosition()
@@ -937,6 +957,16 @@ void LLJoint::setWorldMatrix( const LLMatrix4& mat )
 	setWorldRotation( rot );
 }
 
+//-----------------------------------------------------------------------------
+// setWorldTransform()
+//-----------------------------------------------------------------------------
+void LLJoint::setWorldTransform(const LLVector3& pos, const LLQuaternion& rot, const LLMatrix4a& mat)
+{
+	mXform.setWorldTransform(pos, rot, LLMatrix4(mat.getF32ptr()));
+	mWorldMatrix = mat;
+	mDirtyFlags = HIERARCHY_SYNCED;
+}
+
 //-----------------------------------------------------------------------------
 // updateWorldMatrixParent()
 //-----------------------------------------------------------------------------
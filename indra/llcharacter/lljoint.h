@@ -30,6 +30,7 @@
 //-----------------------------------------------------------------------------
 // Header Files
 //-----------------------------------------------------------------------------
+#include <atomic>
 #include <string>
 #include <list>
 
@@ -108,7 +109,9 @@ public:
 		MATRIX_DIRTY = 0x1 << 0,
 		ROTATION_DIRTY = 0x1 << 1,
 		POSITION_DIRTY = 0x1 << 2,
-		ALL_DIRTY = 0x7
+		ALL_DIRTY = 0x7,
+		// world state was last written by LLJointHierarchy::update()
+		HIERARCHY_SYNCED = 0x1 << 3
 	};
 public:
     enum SupportCategory
@@ -148,9 +151,9 @@ public:
 	typedef std::vector<LLJoint*> joints_t;
 	joints_t mChildren;
 
-	// debug statics
-	static S32		sNumTouches;
-	static S32		sNumUpdates;
+	// debug statics, joints of different avatars are updated on worker threads
+	static std::atomic<S32>	sNumTouches;
+	static std::atomic<S32>	sNumUpdates;
     typedef std::set<std::string> debug_joint_name_t;
     static debug_joint_name_t s_debugJointNames;
     static void setDebugJointNames(const debug_joint_name_t& names);
@@ -191,6 +194,9 @@ public:
 
 private:
 	void init();
+	void bumpTopologySerial();
+
+	U32				mTopologySerial;
 
 public:
 	// set name and parent
@@ -272,6 +278,14 @@ public:
 
 	void updateWorldMatrix();
 
+	// Bumped whenever a joint in the tree below this one, or this one, is
+	// reparented or renumbered.
+	U32 getTopologySerial() const { return mTopologySerial; }
+
+	// store a world transform computed by LLJointHierarchy and mark it clean,
+	// the caller counts it in sNumUpdates
+	void setWorldTransform(const LLVector3& pos, const LLQuaternion& rot, const LLMatrix4a& mat);
+
 	// get/set skin offset
 	const LLVector3 &getSkinOffset();
 	void setSkinOffset( const LLVector3 &offset);
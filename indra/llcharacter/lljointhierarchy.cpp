@@ -0,0 +1,244 @@
+/**
+ * @file lljointhierarchy.cpp
+ * @brief Implementation of LLJointHierarchy class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+//-----------------------------------------------------------------------------
+// Header Files
+//-----------------------------------------------------------------------------
+#include "linden_common.h"
+
+#include "lljointhierarchy.h"
+
+#include "lljoint.h"
+
+//-----------------------------------------------------------------------------
+// LLJointHierarchy()
+//-----------------------------------------------------------------------------
+LLJointHierarchy::LLJointHierarchy()
+:	mTopologySerial(0),
+	mNeedsFullUpdate(true)
+{
+}
+
+//-----------------------------------------------------------------------------
+// clear()
+//-----------------------------------------------------------------------------
+void LLJointHierarchy::clear()
+{
+	mJoints.clear();
+	mParents.clear();
+	mRigid.clear();
+	mWorld.clear();
+	mWorldRotation.clear();
+	mUpdated.clear();
+	mJointNumToIndex.clear();
+	mTopologySerial = 0;
+	mNeedsFullUpdate = true;
+}
+
+//-----------------------------------------------------------------------------
+// build()
+//-----------------------------------------------------------------------------
+void LLJointHierarchy::build(LLJoint* root)
+{
+	clear();
+	if (!root)
+	{
+		return;
+	}
+
+	// Breadth-first, so every parent lands before its children and
+	// siblings sit next to each other in memory.
+	mJoints.push_back(root);
+	mParents.push_back(-1);
+	for (S32 i = 0; i < (S32)mJoints.size(); ++i)
+	{
+		for (LLJoint* child : mJoints[i]->mChildren)
+		{
+			mJoints.push_back(child);
+			mParents.push_back(i);
+		}
+	}
+
+	const S32 count = (S32)mJoints.size();
+	mRigid.resize(count);
+	mWorld.resize(count);
+	mWorldRotation.resize(count);
+	mUpdated.assign(count, FALSE);
+
+	for (S32 i = 0; i < count; ++i)
+	{
+		S32 joint_num = mJoints[i]->getJointNum();
+		if (joint_num < 0)
+		{
+			continue;
+		}
+		if (joint_num >= (S32)mJointNumToIndex.size())
+		{
+			mJointNumToIndex.resize(joint_num + 1, -1);
+		}
+		mJointNumToIndex[joint_num] = i;
+	}
+
+	mTopologySerial = root->getTopologySerial();
+	mNeedsFullUpdate = true;
+}
+
+//-----------------------------------------------------------------------------
+// isStale()
+//-----------------------------------------------------------------------------
+bool LLJointHierarchy::isStale() const
+{
+	return mJoints.empty() || mTopologySerial != mJoints[0]->getTopologySerial();
+}
+
+//-----------------------------------------------------------------------------
+// update()
+//-----------------------------------------------------------------------------
+void LLJointHierarchy::update()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	const S32 count = (S32)mJoints.size();
+	S32 num_updates = 0;
+	for (S32 i = 0; i < count; ++i)
+	{
+		LLJoint* joint = mJoints[i];
+		const S32 parent = mParents[i];
+
+		// Same pruning as LLJoint::updateWorldMatrixChildren()
+		if (!joint->mUpdateXform || (parent >= 0 && !mUpdated[parent]))
+		{
+			mUpdated[i] = FALSE;
+			continue;
+		}
+		mUpdated[i] = TRUE;
+
+		LLXformMatrix* xform = joint->getXform();
+		LLQuaternion& world_rot = mWorldRotation[i];
+		LLMatrix4a& rigid = mRigid[i];
+
+		// Like updateWorldMatrixChildren(), only recompute what was touched.
+		// touch() dirties the whole subtree, so a clean joint's parent is
+		// clean too.
+		const U32 flags = mNeedsFullUpdate ? (U32)LLJoint::MATRIX_DIRTY : joint->mDirtyFlags;
+		if (flags == LLJoint::HIERARCHY_SYNCED)
+		{
+			// still as of the last update()
+			continue;
+		}
+		if (flags == 0x0)
+		{
+			// brought up to date by LLJoint::updateWorldMatrix() since,
+			// pick up its state for the children
+			const LLVector3& world_pos = xform->getWorldPosition();
+			world_rot = xform->getWorldRotation();
+			rigid.loadu(world_rot.getMatrix3());
+			rigid.mMatrix[3].set(world_pos.mV[VX], world_pos.mV[VY], world_pos.mV[VZ], 1.f);
+			mWorld[i] = joint->getWorldMatrix4a();
+			joint->mDirtyFlags = LLJoint::HIERARCHY_SYNCED;
+			continue;
+		}
+
+		if (parent >= 0)
+		{
+			LLXformMatrix* parent_xform = mJoints[parent]->getXform();
+
+			LLVector4a pos;
+			pos.load3(xform->getPosition().mV);
+			if (parent_xform->getScaleChildOffset())
+			{
+				LLVector4a parent_scale;
+				parent_scale.load3(parent_xform->getScale().mV);
+				pos.mul(parent_scale);
+			}
+
+			world_rot = xform->getRotation() * mWorldRotation[parent];
+			rigid.loadu(world_rot.getMatrix3());
+			mRigid[parent].affineTransform(pos, rigid.mMatrix[3]);
+		}
+		else
+		{
+			// The root may still hang off a transform outside this tree.
+			LLVector3 pos = xform->getPosition();
+			world_rot = xform->getRotation();
+
+			LLXform* parent_xform = xform->getParent();
+			if (parent_xform)
+			{
+				if (parent_xform->getScaleChildOffset())
+				{
+					pos.scaleVec(parent_xform->getScale());
+				}
+				pos *= parent_xform->getWorldRotation();
+				pos += parent_xform->getWorldPosition();
+				world_rot = world_rot * parent_xform->getWorldRotation();
+			}
+
+			rigid.loadu(world_rot.getMatrix3());
+			rigid.mMatrix[3].set(pos.mV[VX], pos.mV[VY], pos.mV[VZ], 1.f);
+		}
+
+		// Scale is local to each joint and does not propagate to children.
+		const LLVector3& scale = xform->getScale();
+		LLMatrix4a& world = mWorld[i];
+		world.mMatrix[0].setMul(rigid.mMatrix[0], scale.mV[VX]);
+		world.mMatrix[1].setMul(rigid.mMatrix[1], scale.mV[VY]);
+		world.mMatrix[2].setMul(rigid.mMatrix[2], scale.mV[VZ]);
+		world.mMatrix[3] = rigid.mMatrix[3];
+
+		joint->setWorldTransform(LLVector3(rigid.mMatrix[3].getF32ptr()), world_rot, world);
+		++num_updates;
+	}
+
+	// one shared add per skeleton, update() runs for several at once
+	LLJoint::sNumUpdates += num_updates;
+	mNeedsFullUpdate = false;
+}
+
+//-----------------------------------------------------------------------------
+// getWorldMatrix4a()
+//-----------------------------------------------------------------------------
+const LLMatrix4a* LLJointHierarchy::getWorldMatrix4a(S32 joint_num) const
+{
+	if (isStale() || joint_num < 0 || joint_num >= (S32)mJointNumToIndex.size())
+	{
+		return NULL;
+	}
+
+	S32 index = mJointNumToIndex[joint_num];
+	if (index < 0 || !mUpdated[index])
+	{
+		return NULL;
+	}
+
+	// Any touch or lazy recompute since update() clears this state.
+	if (mJoints[index]->mDirtyFlags != LLJoint::HIERARCHY_SYNCED)
+	{
+		return NULL;
+	}
+
+	return &mWorld[index];
+}
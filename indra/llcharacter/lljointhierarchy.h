@@ -0,0 +1,97 @@
+/**
+ * @file lljointhierarchy.h
+ * @brief Flattened, topologically sorted joint hierarchy for batched world matrix updates.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLJOINTHIERARCHY_H
+#define LL_LLJOINTHIERARCHY_H
+
+//-----------------------------------------------------------------------------
+// Header Files
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <boost/align/aligned_allocator.hpp>
+
+#include "llmath.h"
+#include "llquaternion.h"
+#include "llmatrix4a.h"
+
+class LLJoint;
+
+//-----------------------------------------------------------------------------
+// class LLJointHierarchy
+//
+// Flat copy of a joint tree, stored in parent-before-child order with
+// parallel arrays for the per-joint state.  update() walks the arrays once
+// and computes every world matrix without recursion or virtual calls, then
+// writes the results back into the joints so the lazy LLJoint accessors
+// keep working.  The world matrices can also be read directly by joint
+// number, which is what LLSkinningUtil uses to build matrix palettes.
+//-----------------------------------------------------------------------------
+class LLJointHierarchy
+{
+public:
+	LLJointHierarchy();
+
+	// (Re)build the flat arrays from the tree rooted at root.
+	void build(LLJoint* root);
+	void clear();
+
+	// True if the joint tree has been added to, removed from or renumbered
+	// since build().
+	bool isStale() const;
+	bool isEmpty() const { return mJoints.empty(); }
+
+	// Equivalent to root->updateWorldMatrixChildren(), done as one linear
+	// pass.  Like it, only joints touched since their last update are
+	// recomputed.
+	void update();
+
+	// World matrix of the joint with the given joint number as of the last
+	// update(), or NULL if that joint was not updated or has been touched since.
+	const LLMatrix4a* getWorldMatrix4a(S32 joint_num) const;
+
+	S32 getNumJoints() const { return (S32)mJoints.size(); }
+
+private:
+	typedef std::vector<LLMatrix4a, boost::alignment::aligned_allocator<LLMatrix4a, 16> > matrix_list_t;
+
+	// joints in topological order, and index of each joint's parent (-1 for the root)
+	std::vector<LLJoint*>		mJoints;
+	std::vector<S32>			mParents;
+
+	// per-joint results of the last update()
+	matrix_list_t				mRigid;			// world rotation and translation, without scale
+	matrix_list_t				mWorld;			// final world matrix, as returned by LLJoint::getWorldMatrix4a()
+	std::vector<LLQuaternion>	mWorldRotation;
+	std::vector<U8>				mUpdated;
+
+	// joint number -> index into the arrays above, -1 if not present
+	std::vector<S32>			mJointNumToIndex;
+
+	U32							mTopologySerial;
+	bool						mNeedsFullUpdate;	// arrays not filled in since build()
+};
+
+#endif // LL_LLJOINTHIERARCHY_H
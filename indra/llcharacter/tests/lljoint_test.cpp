@@ -31,6 +31,11 @@
 #include "v3math.h"
 
 #include "../lljoint.h"
+#include "../lljointhierarchy.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "../test/lltut.h"
 
@@ -39,6 +44,59 @@ namespace tut
 {
 	struct lljoint_data
 	{
+		typedef std::vector<std::unique_ptr<LLJoint> > tree_t;
+
+		// Builds a small skeleton, the same every time: a root with two
+		// chains of joints under it, some of them scaled and rotated.
+		void build(tree_t& tree)
+		{
+			tree.clear();
+			for (S32 i = 0; i < 9; ++i)
+			{
+				tree.emplace_back(new LLJoint());
+				LLJoint* joint = tree.back().get();
+				joint->setJointNum(i);
+				joint->setPosition(LLVector3(0.1f * i, 0.5f, -0.25f * (i % 3)));
+				joint->setRotation(LLQuaternion(0.3f * i, LLVector3(i % 2, 1.f, 0.5f)));
+				joint->setScale(LLVector3(1.f + 0.1f * (i % 4), 1.f, 1.f - 0.05f * i));
+				if (i > 0)
+				{
+					// 0 -> 1 -> 3 -> 5 -> 7 and 0 -> 2 -> 4 -> 6 -> 8
+					tree[i > 2 ? i - 2 : 0]->addChild(joint);
+				}
+			}
+		}
+
+		static bool close(const LLMatrix4a& lhs, const LLMatrix4a& rhs)
+		{
+			for (U32 row = 0; row < 4; ++row)
+			{
+				LLVector4a diff;
+				diff.setSub(lhs.mMatrix[row], rhs.mMatrix[row]);
+				if (diff.getLength3().getF32() > 0.0001f)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Every joint of flat, as cached by the hierarchy and as stored in
+		// the joint, has the world matrix of the same joint of recursive.
+		bool matches(LLJointHierarchy& hierarchy, tree_t& flat, tree_t& recursive)
+		{
+			for (size_t i = 0; i < flat.size(); ++i)
+			{
+				const LLMatrix4a* cached = hierarchy.getWorldMatrix4a((S32)i);
+				if (!cached
+					|| !close(*cached, recursive[i]->getWorldMatrix4a())
+					|| !close(*cached, flat[i]->getWorldMatrix4a()))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
 	};
 	typedef test_group<lljoint_data> lljoint_test;
 	typedef lljoint_test::object lljoint_object;
@@ -222,6 +280,115 @@ namespace tut
 	}
 
 
+	template<> template<>
+	void lljoint_object::test<15>()
+	{
+		set_test_name("LLJointHierarchy matches updateWorldMatrixChildren");
+
+		tree_t flat;
+		tree_t recursive;
+		build(flat);
+		build(recursive);
+
+		LLJointHierarchy hierarchy;
+		hierarchy.build(flat[0].get());
+		ensure_equals("all joints", hierarchy.getNumJoints(), 9);
+		hierarchy.update();
+		recursive[0]->updateWorldMatrixChildren();
+		ensure("first update", matches(hierarchy, flat, recursive));
+
+		// only part of the tree moves
+		for (tree_t* tree : { &flat, &recursive })
+		{
+			(*tree)[3]->setRotation(LLQuaternion(1.1f, LLVector3(0.f, 0.f, 1.f)));
+			(*tree)[2]->setScale(LLVector3(2.f, 0.5f, 1.f));
+		}
+		hierarchy.update();
+		recursive[0]->updateWorldMatrixChildren();
+		ensure("after partial change", matches(hierarchy, flat, recursive));
+
+		// a joint brought up to date through LLJoint in between
+		for (tree_t* tree : { &flat, &recursive })
+		{
+			(*tree)[1]->setPosition(LLVector3(0.f, 2.f, 0.f));
+		}
+		flat[5]->getWorldMatrix4a();
+		hierarchy.update();
+		recursive[0]->updateWorldMatrixChildren();
+		ensure("after lazy update", matches(hierarchy, flat, recursive));
+
+		S32 updates = LLJoint::sNumUpdates;
+		hierarchy.update();
+		ensure_equals("nothing to recompute", (S32)LLJoint::sNumUpdates, updates);
+	}
+
+	template<> template<>
+	void lljoint_object::test<16>()
+	{
+		set_test_name("LLJointHierarchy only goes stale for its own tree");
+
+		tree_t mine;
+		tree_t other;
+		build(mine);
+		build(other);
+
+		LLJointHierarchy hierarchy;
+		hierarchy.build(mine[0].get());
+		ensure("fresh", !hierarchy.isStale());
+
+		LLJoint extra;
+		other[4]->addChild(&extra);
+		other[7]->setJointNum(20);
+		ensure("other tree changed", !hierarchy.isStale());
+
+		mine[6]->addChild(&extra);
+		ensure("joint added deep down", hierarchy.isStale());
+		hierarchy.build(mine[0].get());
+		ensure("rebuilt", !hierarchy.isStale());
+
+		mine[5]->setJointNum(30);
+		ensure("renumbered", hierarchy.isStale());
+		hierarchy.build(mine[0].get());
+
+		mine[6]->removeChild(&extra);
+		ensure("joint removed", hierarchy.isStale());
+	}
+
+	template<> template<>
+	void lljoint_object::test<17>()
+	{
+		set_test_name("LLJointHierarchy updates on several threads");
+
+		const S32 skeletons = 8;
+		std::vector<tree_t> trees(skeletons);
+		std::vector<LLJointHierarchy> hierarchies(skeletons);
+		for (S32 i = 0; i < skeletons; ++i)
+		{
+			build(trees[i]);
+			hierarchies[i].build(trees[i][0].get());
+		}
+
+		S32 updates = LLJoint::sNumUpdates;
+		std::vector<std::thread> threads;
+		for (S32 i = 0; i < skeletons; ++i)
+		{
+			threads.emplace_back([&hierarchies, i]() { hierarchies[i].update(); });
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		ensure_equals("every joint counted", (S32)LLJoint::sNumUpdates - updates, skeletons * 9);
+
+		// a joint moved after the update, and everything under it, is no
+		// longer current
+		trees[0][3]->setRotation(LLQuaternion(0.5f, LLVector3(0.f, 0.f, 1.f)));
+		ensure("moved joint", hierarchies[0].getWorldMatrix4a(3) == NULL);
+		ensure("below the moved joint", hierarchies[0].getWorldMatrix4a(7) == NULL);
+		ensure("other chain", hierarchies[0].getWorldMatrix4a(4) != NULL);
+		ensure("other skeleton", hierarchies[1].getWorldMatrix4a(3) != NULL);
+	}
+
 	/*
 		Test cases for the following not added. They perform operations 
 		on underlying LLXformMatrix	and LLVector3 elements which have
@@ -0,0 +1,334 @@
+/**
+ * @file llframegraph.cpp
+ * @brief Implementation of LL::FrameGraph class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llframegraph.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <thread>
+
+#include "lltimer.h"
+#include "threadpool.h"
+#include "workqueue.h"
+
+// Everything a run shares with the pool tasks it posts.  A task may start
+// after its job was taken by the calling thread, even after run() returned,
+// so it holds on to this and only touches the graph once it has claimed a
+// job out of mReadyAny.
+struct LL::FrameGraph::RunState
+{
+	std::mutex						mMutex;
+	std::condition_variable			mCond;
+	std::set<job_t>					mReadyMain;		// ordered, so main thread jobs keep their add() order
+	std::deque<job_t>				mReadyAny;		// unclaimed
+	std::vector<U32>				mWaiting;		// unfinished dependencies per job
+	std::map<std::thread::id, U32>	mThreads;
+	std::vector<S32>				mLastOnThread;
+	U32								mRemaining;
+	U64								mStartTime;
+	LL::WorkQueue::ptr_t			mQueue;
+};
+
+LL::FrameGraph::FrameGraph()
+:	mAnyThread(false)
+{
+}
+
+LL::FrameGraph::~FrameGraph()
+{
+}
+
+LL::FrameGraph::job_t LL::FrameGraph::add(const std::string& name, const func_t& func, EThread thread,
+										  std::initializer_list<job_t> after)
+{
+	job_t id = (job_t)mJobs.size();
+	mJobs.push_back(Job());
+	Job& job = mJobs.back();
+	job.mName = name;
+	job.mFunc = func;
+	job.mThread = thread;
+	job.mStart = 0;
+	job.mEnd = 0;
+	job.mThreadIndex = 0;
+	job.mPrevOnThread = -1;
+	mAnyThread |= (thread == ANY_THREAD);
+	for (job_t dep : after)
+	{
+		llassert_always(dep < id);
+		job.mAfter.push_back(dep);
+		mJobs[dep].mNext.push_back(id);
+	}
+	return id;
+}
+
+void LL::FrameGraph::clear()
+{
+	mJobs.clear();
+	mAnyThread = false;
+}
+
+void LL::FrameGraph::run()
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	const U32 count = size();
+	if (!count)
+	{
+		return;
+	}
+
+	if (!mAnyThread)
+	{
+		// Jobs only depend on earlier ones, so add() order already respects
+		// every edge; only the timings are left to record.
+		const U64 start_time = totalTime();
+		for (job_t i = 0; i < count; ++i)
+		{
+			Job& job = mJobs[i];
+			job.mStart = totalTime() - start_time;
+			job.mFunc();
+			job.mEnd = totalTime() - start_time;
+			job.mThreadIndex = 0;
+			job.mPrevOnThread = (S32)i - 1;
+		}
+		return;
+	}
+
+	auto state = std::make_shared<RunState>();
+	if (LL::ThreadPool::getInstance("General"))
+	{
+		state->mQueue = LL::WorkQueue::getInstance("General");
+	}
+	state->mRemaining = count;
+	state->mWaiting.resize(count);
+	state->mThreads[std::this_thread::get_id()] = 0;
+	state->mLastOnThread.push_back(-1);
+
+	std::vector<job_t> posts;
+	for (job_t i = 0; i < count; ++i)
+	{
+		state->mWaiting[i] = (U32)mJobs[i].mAfter.size();
+		if (state->mWaiting[i] == 0)
+		{
+			if (mJobs[i].mThread == MAIN_THREAD)
+			{
+				state->mReadyMain.insert(i);
+			}
+			else
+			{
+				state->mReadyAny.push_back(i);
+				posts.push_back(i);
+			}
+		}
+	}
+
+	state->mStartTime = totalTime();
+	for (job_t job : posts)
+	{
+		post(state, this, job);
+	}
+
+	std::unique_lock<std::mutex> lock(state->mMutex);
+	while (state->mRemaining)
+	{
+		job_t job;
+		if (!state->mReadyMain.empty())
+		{
+			job = *state->mReadyMain.begin();
+			state->mReadyMain.erase(state->mReadyMain.begin());
+		}
+		else if (!state->mReadyAny.empty())
+		{
+			// nothing for this thread to do but help out
+			job = state->mReadyAny.front();
+			state->mReadyAny.pop_front();
+		}
+		else
+		{
+			state->mCond.wait(lock);
+			continue;
+		}
+
+		lock.unlock();
+		execute(state, job);
+		lock.lock();
+	}
+}
+
+// static
+void LL::FrameGraph::post(const std::shared_ptr<RunState>& state, FrameGraph* graph, job_t job)
+{
+	if (!state->mQueue)
+	{
+		return;
+	}
+
+	// If the queue is closed the job just waits in mReadyAny for run().
+	state->mQueue->postIfOpen([state, graph, job]()
+	{
+		{
+			std::lock_guard<std::mutex> lock(state->mMutex);
+			std::deque<job_t>::iterator iter = std::find(state->mReadyAny.begin(), state->mReadyAny.end(), job);
+			if (iter == state->mReadyAny.end())
+			{
+				return;
+			}
+			state->mReadyAny.erase(iter);
+		}
+		graph->execute(state, job);
+	});
+}
+
+void LL::FrameGraph::execute(const std::shared_ptr<RunState>& state, job_t job)
+{
+	Job& info = mJobs[job];
+	const U64 start = totalTime() - state->mStartTime;
+	info.mFunc();
+	const U64 end = totalTime() - state->mStartTime;
+
+	std::vector<job_t> posts;
+	bool done;
+	{
+		std::lock_guard<std::mutex> lock(state->mMutex);
+		info.mStart = start;
+		info.mEnd = end;
+
+		std::pair<std::map<std::thread::id, U32>::iterator, bool> thread =
+			state->mThreads.insert(std::make_pair(std::this_thread::get_id(), (U32)state->mThreads.size()));
+		if (thread.second)
+		{
+			state->mLastOnThread.push_back(-1);
+		}
+		info.mThreadIndex = thread.first->second;
+		info.mPrevOnThread = state->mLastOnThread[info.mThreadIndex];
+		state->mLastOnThread[info.mThreadIndex] = (S32)job;
+
+		for (job_t next : info.mNext)
+		{
+			if (--state->mWaiting[next] == 0)
+			{
+				if (mJobs[next].mThread == MAIN_THREAD)
+				{
+					state->mReadyMain.insert(next);
+				}
+				else
+				{
+					state->mReadyAny.push_back(next);
+					posts.push_back(next);
+				}
+			}
+		}
+		done = --state->mRemaining == 0;
+	}
+	state->mCond.notify_all();
+
+	// From here on run() may return at any time, so only state is safe
+	// to use; a posted task checks its claim before touching the graph.
+	if (!done)
+	{
+		for (job_t next : posts)
+		{
+			post(state, this, next);
+		}
+	}
+}
+
+std::vector<LL::FrameGraph::job_t> LL::FrameGraph::getCriticalPath() const
+{
+	std::vector<job_t> path;
+	if (mJobs.empty())
+	{
+		return path;
+	}
+
+	S32 current = 0;
+	for (job_t i = 1; i < size(); ++i)
+	{
+		if (mJobs[i].mEnd > mJobs[current].mEnd)
+		{
+			current = (S32)i;
+		}
+	}
+
+	// Each step goes to a job that finished before the current one started,
+	// so this always ends.
+	while (current >= 0)
+	{
+		path.push_back((job_t)current);
+		const Job& job = mJobs[current];
+		S32 blocker = job.mPrevOnThread;
+		U64 blocker_end = blocker >= 0 ? mJobs[blocker].mEnd : 0;
+		for (job_t dep : job.mAfter)
+		{
+			if (blocker < 0 || mJobs[dep].mEnd >= blocker_end)
+			{
+				blocker = (S32)dep;
+				blocker_end = mJobs[dep].mEnd;
+			}
+		}
+		current = blocker;
+	}
+
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+void LL::FrameGraph::writeTrace(std::ostream& out) const
+{
+	std::vector<bool> critical(mJobs.size(), false);
+	for (job_t job : getCriticalPath())
+	{
+		critical[job] = true;
+	}
+
+	out << "{\"traceEvents\":[";
+	for (job_t i = 0; i < size(); ++i)
+	{
+		const Job& job = mJobs[i];
+		std::string name;
+		for (char c : job.mName)
+		{
+			if (c == '"' || c == '\\')
+			{
+				name += '\\';
+			}
+			name += c;
+		}
+		out << (i ? ",\n" : "\n")
+			<< "{\"name\":\"" << name << "\",\"cat\":\"frame\",\"ph\":\"X\""
+			<< ",\"ts\":" << job.mStart << ",\"dur\":" << job.mEnd - job.mStart
+			<< ",\"pid\":1,\"tid\":" << job.mThreadIndex
+			<< ",\"args\":{\"critical\":" << (critical[i] ? "true" : "false") << "}}";
+	}
+	out << "\n]}\n";
+}
@@ -0,0 +1,119 @@
+/**
+ * @file llframegraph.h
+ * @brief Per-frame graph of jobs with explicit dependencies.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFRAMEGRAPH_H
+#define LL_LLFRAMEGRAPH_H
+
+#include <functional>
+#include <initializer_list>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "stdtypes.h"
+
+namespace LL
+{
+	/**
+	 * A set of jobs making up part of a frame, each listing the jobs that
+	 * must finish before it starts.  run() executes them all and returns
+	 * when the last one is done:
+	 *
+	 * - MAIN_THREAD jobs run on the thread calling run(), in the order they
+	 *   were added as far as their dependencies allow.  A graph of only main
+	 *   thread jobs therefore runs exactly in add() order, inline, without
+	 *   any of the scheduling state.
+	 * - ANY_THREAD jobs are posted to the "General" thread pool as soon as
+	 *   they are ready.  The calling thread also takes them when it has
+	 *   nothing else to do, so they still run without a pool.
+	 *
+	 * Jobs may only depend on jobs added before them, which rules out cycles.
+	 * The graph can be run again every frame; each run records when every
+	 * job ran and on which thread, for getCriticalPath() and writeTrace().
+	 */
+	class LL_COMMON_API FrameGraph
+	{
+	public:
+		typedef U32 job_t;
+		typedef std::function<void()> func_t;
+
+		enum EThread
+		{
+			MAIN_THREAD,
+			ANY_THREAD
+		};
+
+		FrameGraph();
+		~FrameGraph();
+
+		job_t add(const std::string& name, const func_t& func, EThread thread = MAIN_THREAD,
+				  std::initializer_list<job_t> after = {});
+		void clear();
+		U32 size() const { return (U32)mJobs.size(); }
+
+		void run();
+
+		// Times of the last run, in microseconds from its start.
+		const std::string& getName(job_t job) const { return mJobs[job].mName; }
+		U64 getStart(job_t job) const { return mJobs[job].mStart; }
+		U64 getEnd(job_t job) const { return mJobs[job].mEnd; }
+		U32 getThreadIndex(job_t job) const { return mJobs[job].mThreadIndex; }
+
+		// The chain of jobs that set the length of the last run, first job
+		// first: from the job that finished last, back through whichever
+		// held up its start -- the dependency that finished last, or the job
+		// that kept its thread busy.
+		std::vector<job_t> getCriticalPath() const;
+
+		// Writes the last run in the Chrome trace event format (load it in
+		// chrome://tracing or Perfetto), critical path jobs flagged in args.
+		void writeTrace(std::ostream& out) const;
+
+	private:
+		struct Job
+		{
+			std::string			mName;
+			func_t				mFunc;
+			EThread				mThread;
+			std::vector<job_t>	mAfter;
+			std::vector<job_t>	mNext;
+			U64					mStart;
+			U64					mEnd;
+			U32					mThreadIndex;
+			S32					mPrevOnThread;	// job run before this one on the same thread, or -1
+		};
+
+		struct RunState;
+		void execute(const std::shared_ptr<RunState>& state, job_t job);
+		static void post(const std::shared_ptr<RunState>& state, FrameGraph* graph, job_t job);
+
+		std::vector<Job>	mJobs;
+		bool				mAnyThread;		// some job may leave the calling thread
+	};
+}
+
+#endif // LL_LLFRAMEGRAPH_H
@@ -0,0 +1,112 @@
+/**
+ * @file llparallel.cpp
+ * @brief Implementation of LL::parallel_for().
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llparallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include "threadpool.h"
+#include "workqueue.h"
+
+namespace
+{
+	// Outlives parallel_for() if a helper starts late; such a helper finds
+	// no index left and never touches mBody.
+	struct ParallelState
+	{
+		ParallelState(U32 count, const std::function<void(U32)>& body)
+		:	mBody(&body), mCount(count), mNext(0), mRemaining(count)
+		{
+		}
+
+		void run()
+		{
+			U32 index;
+			while ((index = mNext.fetch_add(1)) < mCount)
+			{
+				(*mBody)(index);
+				if (mRemaining.fetch_sub(1) == 1)
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					mDone.notify_all();
+				}
+			}
+		}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDone.wait(lock, [this]() { return mRemaining.load() == 0; });
+		}
+
+		const std::function<void(U32)>*	mBody;
+		const U32						mCount;
+		std::atomic<U32>				mNext;
+		std::atomic<U32>				mRemaining;
+		std::mutex						mMutex;
+		std::condition_variable			mDone;
+	};
+}
+
+void LL::parallel_for(U32 count, const std::function<void(U32)>& body, U32 max_helpers)
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	LL::ThreadPool::ptr_t pool;
+	LL::WorkQueue::ptr_t queue;
+	if (count > 1 && max_helpers > 0)
+	{
+		pool = LL::ThreadPool::getInstance("General");
+		queue = LL::WorkQueue::getInstance("General");
+	}
+
+	if (!pool || !queue)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			body(i);
+		}
+		return;
+	}
+
+	auto state = std::make_shared<ParallelState>(count, body);
+	U32 helpers = llmin(llmin(max_helpers, count - 1), (U32)pool->getWidth());
+	for (U32 i = 0; i < helpers; ++i)
+	{
+		if (!queue->postIfOpen([state]() { state->run(); }))
+		{
+			break;
+		}
+	}
+
+	state->run();
+	state->wait();
+}
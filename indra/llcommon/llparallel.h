@@ -0,0 +1,45 @@
+/**
+ * @file llparallel.h
+ * @brief Fork/join helper running a loop across the General thread pool.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPARALLEL_H
+#define LL_LLPARALLEL_H
+
+#include <functional>
+
+#include "stdtypes.h"
+
+namespace LL
+{
+	// Calls body(i) for every i in [0, count) and returns once all calls are
+	// done.  Up to max_helpers tasks on the "General" thread pool claim
+	// indices alongside the calling thread, which claims them too, so a pool
+	// busy with other work only costs parallelism, never a wait for a queued
+	// task.  body must be safe to call concurrently for different indices.
+	// Without a pool, or for a single index, the loop simply runs inline.
+	void parallel_for(U32 count, const std::function<void(U32)>& body, U32 max_helpers = 8);
+}
+
+#endif // LL_LLPARALLEL_H
@@ -0,0 +1,112 @@
+/**
+ * @file llradixsort.h
+ * @brief Stable radix sort of items carrying packed 64 bit keys.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLRADIXSORT_H
+#define LL_LLRADIXSORT_H
+
+#include <string.h>
+#include <vector>
+
+#include "stdtypes.h"
+
+// An item to sort and its key.  Callers pack whatever they sort on into the
+// key, most significant criterion in the highest bits.
+template <typename T>
+struct LLRadixSortItem
+{
+	U64	mKey;
+	T	mValue;
+};
+
+// Maps a float onto an unsigned integer with the same ordering, so floats
+// can be packed into a radix sort key.
+inline U32 ll_float_sort_key(F32 value)
+{
+	U32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	// flip all bits of negatives, only the sign bit of positives
+	return bits ^ ((U32)((S32)bits >> 31) | 0x80000000);
+}
+
+// Sorts items by ascending key, keeping the relative order of equal keys.
+// Eight passes of one byte each, least significant first; a byte that is
+// the same in every key costs no pass.  scratch is working storage, keep it
+// around between calls to avoid reallocating it.
+template <typename T>
+void ll_radix_sort(std::vector<LLRadixSortItem<T> >& items, std::vector<LLRadixSortItem<T> >& scratch)
+{
+	const size_t count = items.size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	// histograms of every byte in one read of the keys
+	size_t counts[8][256];
+	memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < count; ++i)
+	{
+		U64 key = items[i].mKey;
+		for (U32 pass = 0; pass < 8; ++pass)
+		{
+			++counts[pass][(key >> (pass * 8)) & 0xFF];
+		}
+	}
+
+	scratch.resize(count);
+	LLRadixSortItem<T>* src = &items[0];
+	LLRadixSortItem<T>* dst = &scratch[0];
+	for (U32 pass = 0; pass < 8; ++pass)
+	{
+		size_t* histogram = counts[pass];
+		const U32 shift = pass * 8;
+		if (histogram[(src[0].mKey >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (U32 digit = 0; digit < 256; ++digit)
+		{
+			size_t digit_count = histogram[digit];
+			histogram[digit] = offset;
+			offset += digit_count;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			dst[histogram[(src[i].mKey >> shift) & 0xFF]++] = src[i];
+		}
+		std::swap(src, dst);
+	}
+
+	if (src != &items[0])
+	{
+		items.swap(scratch);
+	}
+}
+
+#endif // LL_LLRADIXSORT_H
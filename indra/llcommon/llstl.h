@@ -31,6 +31,7 @@
 #include <functional>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <list>
 #include <set>
@@ -242,6 +243,21 @@ inline T* get_ptr_in_map(const std::map<K,T*>& inmap, const K& key)
 	}
 };
 
+template <typename K, typename T>
+inline T* get_ptr_in_map(const std::unordered_map<K,T*>& inmap, const K& key)
+{
+	typedef typename std::unordered_map<K,T*>::const_iterator map_iter;
+	map_iter iter = inmap.find(key);
+	if(iter == inmap.end())
+	{
+		return NULL;
+	}
+	else
+	{
+		return iter->second;
+	}
+};
+
 // helper function which returns true if key is in inmap.
 template <typename K, typename T>
 inline bool is_in_map(const std::map<K,T>& inmap, const K& key)
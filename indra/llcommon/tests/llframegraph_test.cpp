@@ -0,0 +1,169 @@
+/**
+ * @file llframegraph_test.cpp
+ * @brief LL::FrameGraph test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llframegraph.h"
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../threadpool.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct framegraph_data
+	{
+		framegraph_data()
+		:	mClock(0)
+		{
+		}
+
+		// Builds a diamond per column: top -> left, right -> bottom, and
+		// chains the bottoms, with a finish order stamp for every job.
+		void build(LL::FrameGraph& graph, U32 columns, LL::FrameGraph::EThread thread)
+		{
+			mStamps.clear();
+			mStamps.resize(columns * 4);
+			S32 prev = -1;
+			for (U32 i = 0; i < columns; ++i)
+			{
+				auto stamp = [this](U32 job) { return [this, job]() { mStamps[job] = ++mClock; }; };
+				LL::FrameGraph::job_t top = prev < 0
+					? graph.add("top", stamp(i * 4), thread)
+					: graph.add("top", stamp(i * 4), thread, { (LL::FrameGraph::job_t)prev });
+				LL::FrameGraph::job_t left = graph.add("left", stamp(i * 4 + 1), LL::FrameGraph::ANY_THREAD, { top });
+				LL::FrameGraph::job_t right = graph.add("right", stamp(i * 4 + 2), thread, { top });
+				prev = graph.add("bottom", stamp(i * 4 + 3), thread, { left, right });
+			}
+		}
+
+		bool ordered(U32 columns) const
+		{
+			for (U32 i = 0; i < columns; ++i)
+			{
+				const U32* s = &mStamps[i * 4];
+				if (!s[0] || !s[1] || !s[2] || !s[3]
+					|| s[1] < s[0] || s[2] < s[0] || s[3] < s[1] || s[3] < s[2]
+					|| (i && s[0] < mStamps[i * 4 - 1]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		std::vector<U32>	mStamps;
+		std::atomic<U32>	mClock;
+	};
+	typedef test_group<framegraph_data> framegraph_test;
+	typedef framegraph_test::object framegraph_object;
+	tut::framegraph_test framegraph_testcase("LLFrameGraph");
+
+	template<> template<>
+	void framegraph_object::test<1>()
+	{
+		set_test_name("main thread jobs keep their order");
+
+		std::vector<U32> order;
+		LL::FrameGraph graph;
+		LL::FrameGraph::job_t a = graph.add("a", [&order]() { order.push_back(0); });
+		graph.add("b", [&order]() { order.push_back(1); });
+		graph.add("c", [&order]() { order.push_back(2); }, LL::FrameGraph::MAIN_THREAD, { a });
+		graph.add("d", [&order]() { order.push_back(3); });
+		graph.run();
+
+		ensure_equals("all ran", order.size(), (size_t)4);
+		for (U32 i = 0; i < order.size(); ++i)
+		{
+			ensure_equals("add order", order[i], i);
+		}
+
+		// and again, the graph is reusable
+		order.clear();
+		graph.run();
+		ensure_equals("ran twice", order.size(), (size_t)4);
+	}
+
+	template<> template<>
+	void framegraph_object::test<2>()
+	{
+		set_test_name("without a pool");
+
+		LL::FrameGraph graph;
+		build(graph, 10, LL::FrameGraph::MAIN_THREAD);
+		graph.run();
+		ensure("dependencies respected", ordered(10));
+	}
+
+	template<> template<>
+	void framegraph_object::test<3>()
+	{
+		set_test_name("with a pool");
+
+		LL::ThreadPool pool("General", 3);
+		pool.start();
+
+		for (U32 i = 0; i < 50; ++i)
+		{
+			LL::FrameGraph graph;
+			build(graph, 20, (i & 1) ? LL::FrameGraph::ANY_THREAD : LL::FrameGraph::MAIN_THREAD);
+			graph.run();
+			ensure("dependencies respected", ordered(20));
+		}
+
+		pool.close();
+	}
+
+	template<> template<>
+	void framegraph_object::test<4>()
+	{
+		set_test_name("critical path and trace");
+
+		LL::FrameGraph graph;
+		auto sleep = [](U32 ms) { return [ms]() { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }; };
+		LL::FrameGraph::job_t slow = graph.add("slow", sleep(5));
+		LL::FrameGraph::job_t quick = graph.add("quick", sleep(0));
+		LL::FrameGraph::job_t last = graph.add("last", sleep(1), LL::FrameGraph::MAIN_THREAD, { quick });
+		graph.run();
+
+		std::vector<LL::FrameGraph::job_t> path = graph.getCriticalPath();
+		ensure_equals("whole chain", path.size(), (size_t)3);
+		ensure_equals("starts with the slow job", path[0], slow);
+		ensure_equals("ends with the last job", path[2], last);
+		ensure("times recorded", graph.getEnd(slow) - graph.getStart(slow) >= 5000);
+
+		std::ostringstream trace;
+		graph.writeTrace(trace);
+		ensure("trace names jobs", trace.str().find("\"name\":\"slow\"") != std::string::npos);
+		ensure("trace flags the critical path", trace.str().find("\"critical\":true") != std::string::npos);
+	}
+}
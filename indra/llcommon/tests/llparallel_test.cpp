@@ -0,0 +1,90 @@
+/**
+ * @file llparallel_test.cpp
+ * @brief LL::parallel_for() test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llparallel.h"
+
+#include <atomic>
+#include <vector>
+
+#include "../threadpool.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct parallel_data
+	{
+		// Runs a loop with every index counted, returns true if each index ran once.
+		static bool runOnce(U32 count)
+		{
+			std::vector<std::atomic<U32> > calls(count);
+			for (U32 i = 0; i < count; ++i)
+			{
+				calls[i] = 0;
+			}
+			LL::parallel_for(count, [&calls](U32 i) { ++calls[i]; });
+			for (U32 i = 0; i < count; ++i)
+			{
+				if (calls[i] != 1)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+	typedef test_group<parallel_data> parallel_test;
+	typedef parallel_test::object parallel_object;
+	tut::parallel_test parallel_testcase("LLParallel");
+
+	template<> template<>
+	void parallel_object::test<1>()
+	{
+		set_test_name("without a pool");
+
+		ensure("empty loop", runOnce(0));
+		ensure("inline loop", runOnce(100));
+	}
+
+	template<> template<>
+	void parallel_object::test<2>()
+	{
+		set_test_name("with a pool");
+
+		LL::ThreadPool pool("General", 3);
+		pool.start();
+
+		ensure("single index", runOnce(1));
+		for (U32 i = 0; i < 50; ++i)
+		{
+			ensure("every index once", runOnce(1000));
+		}
+
+		pool.close();
+	}
+}
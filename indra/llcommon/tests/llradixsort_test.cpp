@@ -0,0 +1,105 @@
+/**
+ * @file llradixsort_test.cpp
+ * @brief ll_radix_sort() test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llradixsort.h"
+
+#include <algorithm>
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct radixsort_data
+	{
+		typedef LLRadixSortItem<U32> item_t;
+
+		static bool lessKey(const item_t& lhs, const item_t& rhs)
+		{
+			return lhs.mKey < rhs.mKey;
+		}
+	};
+	typedef test_group<radixsort_data> radixsort_test;
+	typedef radixsort_test::object radixsort_object;
+	tut::radixsort_test radixsort_testcase("LLRadixSort");
+
+	template<> template<>
+	void radixsort_object::test<1>()
+	{
+		set_test_name("matches a stable sort");
+
+		std::vector<item_t> items;
+		U64 seed = 0x2545F4914F6CDD1DULL;
+		for (U32 i = 0; i < 5000; ++i)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			// few distinct keys in the low bits, so there are plenty of ties
+			item_t item = { (seed & 0xFFFF000000000000ULL) | (seed & 0x7), i };
+			items.push_back(item);
+		}
+
+		std::vector<item_t> expected = items;
+		std::stable_sort(expected.begin(), expected.end(), lessKey);
+
+		std::vector<item_t> scratch;
+		ll_radix_sort(items, scratch);
+		ensure_equals("size", items.size(), expected.size());
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			ensure_equals("key", items[i].mKey, expected[i].mKey);
+			ensure_equals("equal keys keep their order", items[i].mValue, expected[i].mValue);
+		}
+
+		// sorted input comes back unchanged
+		ll_radix_sort(items, scratch);
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			ensure_equals("resort", items[i].mValue, expected[i].mValue);
+		}
+	}
+
+	template<> template<>
+	void radixsort_object::test<2>()
+	{
+		set_test_name("float keys");
+
+		const F32 values[] = { 3.5f, -0.f, -2.f, 0.f, 1e-20f, -1e20f, 1e20f, -1e-20f, 0.25f };
+		const U32 count = sizeof(values) / sizeof(values[0]);
+		for (U32 i = 0; i < count; ++i)
+		{
+			for (U32 j = 0; j < count; ++j)
+			{
+				if (values[i] < values[j])
+				{
+					ensure("order preserved", ll_float_sort_key(values[i]) < ll_float_sort_key(values[j]));
+				}
+			}
+		}
+	}
+}
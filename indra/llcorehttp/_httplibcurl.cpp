@@ -32,6 +32,7 @@
 #include "_httppolicy.h"
 
 #include "llhttpconstants.h"
+#include "httpstats.h"
 
 namespace
 {
@@ -275,6 +276,20 @@ bool HttpLibcurl::cancel(HttpHandle handle)
 }
 
 
+bool HttpLibcurl::changePriority(HttpHandle handle, HttpRequest::priority_t priority)
+{
+    HttpOpRequest::ptr_t op = HttpOpRequest::fromHandle<HttpOpRequest>(handle);
+	active_set_t::iterator it(mActiveOps.find(op));
+	if (mActiveOps.end() == it)
+	{
+		return false;
+	}
+
+	op->changeActivePriority(priority);
+	return true;
+}
+
+
 // *NOTE:  cancelRequest logic parallels completeRequest logic.
 // Keep them synchronized as necessary.  Caller is expected to
 // remove the op from the active list and release the op *after*
@@ -399,6 +414,25 @@ bool HttpLibcurl::completeRequest(CURLM * multi_handle, CURL * handle, CURLcode
         }
 	}
 
+	// Time to first byte and connection use for anything that got a reply
+	if (handle)
+	{
+		double ttfb(0.0);
+		long new_connects(0L);
+		long http_version(0L);
+		if (CURLE_OK == curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME, &ttfb)
+			&& CURLE_OK == curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &new_connects)
+			&& ttfb > 0.0)
+		{
+#if LIBCURL_VERSION_NUM >= 0x073200
+			curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &http_version);
+#endif
+			HTTPStats::instance().recordTransfer(ttfb,
+												 CURL_HTTP_VERSION_2_0 == http_version,
+												 new_connects > 0L);
+		}
+	}
+
     if (multi_handle && handle)
     {
         // Detach from multi and recycle handle
@@ -476,7 +510,26 @@ void HttpLibcurl::policyUpdated(int policy_class)
 		policy.stallPolicy(policy_class, false);
 		mDirtyPolicy[policy_class] = false;
 
-		if (options.mPipelining > 1)
+		if (options.mHttp2Streams > 0)
+		{
+			// HTTP/2 multiplexing, requests wait for a free stream
+			// rather than opening connections beyond the host limit.
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_PIPELINING,
+									 long(CURLPIPE_MULTIPLEX));
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_HOST_CONNECTIONS,
+									 long(options.mPerHostConnectionLimit));
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_TOTAL_CONNECTIONS,
+									 long(options.mConnectionLimit));
+#if LIBCURL_VERSION_NUM >= 0x074300
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_CONCURRENT_STREAMS,
+									 long(options.mHttp2Streams));
+#endif
+		}
+		else if (options.mPipelining > 1)
 		{
 			// We'll try to do pipelining on this multihandle
 			check_curl_multi_setopt(multi_handle,
@@ -118,6 +118,16 @@ public:
 	/// Threading:  called by worker thread.
 	bool cancel(HttpHandle handle);
 
+	/// Change the priority of an active request.  Only HTTP/2
+	/// streams do anything with it, by reweighting the stream.
+	///
+	/// Interface shadows HttpService's method.
+	///
+	/// @return			True if handle was found among active requests.
+	///
+	/// Threading:  called by worker thread.
+	bool changePriority(HttpHandle handle, HttpRequest::priority_t priority);
+
 	/// Informs transport that a particular policy class has had
 	/// options changed and so should effect any transport state
 	/// change necessary to effect those changes.  Used mainly for
@@ -117,6 +117,21 @@ void check_curl_easy_setopt(CURL* handle, CURLoption option, ARG argument)
     check_curl_easy_code(code, option);
 }
 
+// HTTP/2 stream weight (1-256) for a request priority.  Callers use
+// larger values for more urgent requests (texture fetch scales into the
+// low 28 bits), so the weight grows with the magnitude of the value: 0
+// maps to 1 and the full 32 bit range spreads evenly up to 256.
+long stream_weight(LLCore::HttpRequest::priority_t priority)
+{
+	long bits(0L);
+	while (priority)
+	{
+		priority >>= 1;
+		++bits;
+	}
+	return 1L + bits * 255L / 32L;
+}
+
 static const char * const LOG_CORE("CoreHttp");
 
 } // end anonymous namespace
@@ -139,6 +154,7 @@ HttpOpRequest::HttpOpRequest()
 	  mCurlHandle(NULL),
 	  mCurlService(NULL),
 	  mCurlHeaders(NULL),
+	  mCurlStream(false),
 	  mCurlBodyPos(0),
 	  mCurlTemp(NULL),
 	  mCurlTempLen(0),
@@ -290,6 +306,17 @@ void HttpOpRequest::visitNotifier(HttpRequest * request)
 // }
 
 
+void HttpOpRequest::changeActivePriority(HttpRequest::priority_t priority)
+{
+	mReqPriority = priority;
+	if (mCurlStream && mCurlHandle)
+	{
+		// libcurl sends the new weight with the stream's next frame
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_STREAM_WEIGHT, stream_weight(priority));
+	}
+}
+
+
 HttpStatus HttpOpRequest::cancel()
 {
 	mStatus = HttpStatus(HttpStatus::LLCORE, HE_OP_CANCELED);
@@ -474,6 +501,7 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 		curl_slist_free_all(mCurlHeaders);
 		mCurlHeaders = NULL;
 	}
+	mCurlStream = false;
 	mCurlBodyPos = 0;
 
 	if (mReplyBody)
@@ -647,8 +675,12 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 
 
     // *TODO: Should this be 'Keep-Alive' ?
-    mCurlHeaders = curl_slist_append(mCurlHeaders, "Connection: keep-alive");
-    mCurlHeaders = curl_slist_append(mCurlHeaders, "Keep-alive: 300");
+    // Connection-specific headers are forbidden in HTTP/2.
+    if (cpolicy.mHttp2Streams <= 0L)
+    {
+        mCurlHeaders = curl_slist_append(mCurlHeaders, "Connection: keep-alive");
+        mCurlHeaders = curl_slist_append(mCurlHeaders, "Keep-alive: 300");
+    }
 
 	// Tracing
 	if (mTracing >= HTTP_TRACE_CURL_HEADERS)
@@ -704,7 +736,27 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	{
 		xfer_timeout = timeout;
 	}
-	if (cpolicy.mPipelining > 1L)
+	if (cpolicy.mHttp2Streams > 0L)
+	{
+		// Multiplexed streams share a connection much like a pipeline
+		// but don't block each other, so only the pipeline's transfer
+		// timeout allowance is kept.
+		xfer_timeout *= 2L;
+
+		// Negotiate h2 over TLS with a fallback to 1.1.  Plain http
+		// has no ALPN, ask for an h2c upgrade which servers that
+		// don't know it simply ignore.
+		bool secure(0 == mReqURL.compare(0, 8, "https://"));
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION,
+							   (secure ? CURL_HTTP_VERSION_2TLS : CURL_HTTP_VERSION_2_0));
+
+		// Wait for a stream on an existing connection rather than
+		// opening a new one; the policy limits the number of streams.
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_STREAM_WEIGHT, stream_weight(mReqPriority));
+		mCurlStream = true;
+	}
+	else if (cpolicy.mPipelining > 1L)
 	{
 		// Pipelining affects both connection and transfer timeout values.
 		// Requests that are added to a pipeling immediately have completed
@@ -732,13 +784,6 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 		//
 		// xfer_timeout *= cpolicy.mPipelining;
 		xfer_timeout *= 2L;
-
-		// Also try requesting HTTP/2.
-/******************************/
-		// but for test purposes, only if overriding VIEWERASSET
-		if (getenv("VIEWERASSET"))
-/******************************/
-		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
 	}
 	// *DEBUG:  Enable following override for timeout handling and "[curl:bugs] #1420" tests
     //if (cpolicy.mPipelining)
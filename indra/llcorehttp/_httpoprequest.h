@@ -163,6 +163,13 @@ public:
 	// Threading:  called by worker thread
 	//
 	HttpStatus prepareRequest(HttpService * service);
+
+	// Change the priority of a request already handed to libcurl.
+	// HTTP/2 streams send their new weight to the server.
+	//
+	// Threading:  called by worker thread
+	//
+	void changeActivePriority(HttpRequest::priority_t priority);
 	
 	virtual HttpStatus cancel();
 
@@ -214,6 +221,7 @@ public:
 	CURL *				mCurlHandle;
 	HttpService *		mCurlService;
 	curl_slist *		mCurlHeaders;
+	bool				mCurlStream;			// Weighted HTTP/2 stream
 	size_t				mCurlBodyPos;
 	char *				mCurlTemp;				// Scratch buffer for header processing
 	size_t				mCurlTempLen;
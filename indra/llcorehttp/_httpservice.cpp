@@ -62,6 +62,7 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
 	{	true,		true,		true,		false,		false	},		// PO_LLPROXY
 	{	true,		true,		true,		false,		false	},		// PO_TRACE
 	{	true,		true,		false,		true,		false	},		// PO_ENABLE_PIPELINING
+	{	true,		true,		false,		true,		false	},		// PO_HTTP2_STREAMS
 	{	true,		true,		false,		true,		false	},		// PO_THROTTLE_RATE
 	{   false,		false,		true,		false,		true	}		// PO_SSL_VERIFY_CALLBACK
 };
@@ -229,8 +230,12 @@ bool HttpService::changePriority(HttpHandle handle, HttpRequest::priority_t prio
 	// requests sitting there.  Start with the ready queue...
 	found = mPolicy->changePriority(handle, priority);
 
-	// If not there, we could try the transport/active queue but priority
-	// doesn't really have much effect there so we don't waste cycles.
+	// If not there, try the transport/active queue.  Priority only
+	// matters there for HTTP/2 streams, which get reweighted.
+	if (! found)
+	{
+		found = mTransport->changePriority(handle, priority);
+	}
 	
 	return found;
 }
@@ -218,6 +218,27 @@ public:
 		/// Per-class only
 		PO_PIPELINING_DEPTH,
 
+		/// If greater than 0, requests in the class ask for HTTP/2
+		/// and, where the server agrees, are multiplexed as streams
+		/// over shared connections.  Value gives the maximum number
+		/// of concurrent streams on a connection.  Takes precedence
+		/// over PO_PIPELINING_DEPTH.
+		///
+		/// PO_PER_HOST_CONNECTION_LIMIT then bounds the connections
+		/// to a host and the class keeps up to that many times this
+		/// value in flight.  New requests wait for a free stream on
+		/// an existing connection rather than open another one.
+		/// Request priority becomes the stream weight.
+		///
+		/// https:// URLs negotiate HTTP/2 through ALPN and fall back
+		/// to HTTP/1.1.  http:// URLs use HTTP/2 with prior knowledge
+		/// (h2c), which is how a local h2 test server is exercised,
+		/// so only enable this for classes whose cleartext servers
+		/// speak h2c.
+		///
+		/// Per-class only
+		PO_HTTP2_STREAMS,
+
 		/// Controls whether client-side throttling should be
 		/// performed on this policy class.  Positive values
 		/// enable throttling and specify the request rate
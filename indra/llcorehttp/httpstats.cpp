@@ -44,7 +44,10 @@ void HTTPStats::resetStats()
     mResutCodes.clear();
     mDataDown.reset();
     mDataUp.reset();
+    mTimeToFirstByte.reset();
     mRequests = 0;
+    mHttp2Requests = 0;
+    mHttp2Connections = 0;
 }
 
 
@@ -61,6 +64,24 @@ void HTTPStats::recordResultCode(S32 code)
 
 }
 
+void HTTPStats::recordTransfer(F64 time_to_first_byte, bool http2, bool new_connection)
+{
+    mTimeToFirstByte.push((F32)time_to_first_byte);
+    if (http2)
+    {
+        ++mHttp2Requests;
+        if (new_connection)
+        {
+            ++mHttp2Connections;
+        }
+    }
+}
+
+F32 HTTPStats::getStreamsPerConnection() const
+{
+    return mHttp2Connections ? (F32)mHttp2Requests / (F32)mHttp2Connections : 0.f;
+}
+
 namespace
 {
     std::string byte_count_converter(F32 bytes)
@@ -93,6 +114,10 @@ void HTTPStats::dumpStats()
     out << "Data Sent: " << byte_count_converter(mDataUp.getSum()) << "   (" << mDataUp.getSum() << ")" << std::endl;
     out << "Data Recv: " << byte_count_converter(mDataDown.getSum()) << "   (" << mDataDown.getSum() << ")" << std::endl;
     out << "Total requests: " << mRequests << "(request objects created)" << std::endl;
+    out << "Time to first byte: " << mTimeToFirstByte.getMean() << "s mean, "
+        << mTimeToFirstByte.getMaxValue() << "s max over " << mTimeToFirstByte.getCount() << std::endl;
+    out << "HTTP/2 requests: " << mHttp2Requests << " over " << mHttp2Connections << " connections ("
+        << getStreamsPerConnection() << " streams per connection)" << std::endl;
     out << std::endl;
     out << "Result Codes:" << std::endl << "--- -----" << std::endl;
 
@@ -59,12 +59,24 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        // Seconds until the first response byte, whether the transfer
+        // ran over HTTP/2 and whether it had to open a connection.
+        void    recordTransfer(F64 time_to_first_byte, bool http2, bool new_connection);
+
+        const StatsAccumulator& getTimeToFirstByte() const { return mTimeToFirstByte; }
+
+        // HTTP/2 requests carried per HTTP/2 connection opened.
+        F32     getStreamsPerConnection() const;
+
         void    dumpStats();
     private:
         StatsAccumulator mDataDown;
         StatsAccumulator mDataUp;
+        StatsAccumulator mTimeToFirstByte;
 
         S32              mRequests;
+        S32              mHttp2Requests;
+        S32              mHttp2Connections;
 
         std::map<S32, S32> mResutCodes;
     };
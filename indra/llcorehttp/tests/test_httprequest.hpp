@@ -32,6 +32,7 @@
 #include "httpheaders.h"
 #include "httpresponse.h"
 #include "httpoptions.h"
+#include "httpstats.h"
 #include "_httpservice.h"
 #include "_httprequestqueue.h"
 
@@ -3055,6 +3056,130 @@ void HttpRequestTestObjectType::test<23>()
 	}
 }
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GET over HTTP/2 multiplexing");
+
+	// The test server only speaks HTTP/1.1.  Point LL_TEST_H2_URL at
+	// a local h2 or h2c server (e.g. 'nghttpd --no-tls 8443') to run.
+	const char * h2_url(getenv("LL_TEST_H2_URL"));
+	if (! h2_url || ! *h2_url)
+	{
+		skip("LL_TEST_H2_URL not set, no HTTP/2 server to test against");
+	}
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	std::string url(h2_url);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+
+		// Multiplex everything on the default class over one connection
+		HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+										   HttpRequest::DEFAULT_POLICY_ID,
+										   1,
+										   NULL);
+		HttpStatus status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS,
+															   HttpRequest::DEFAULT_POLICY_ID,
+															   8,
+															   NULL);
+		ensure("HTTP/2 streams option accepted", bool(status));
+		LLCore::HTTPStats::instance().resetStats();
+
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// Issue GETs at a spread of priorities
+		mStatus = HttpStatus(200);
+		int url_limit(8);
+		for (int i(0); i < url_limit; ++i)
+		{
+			HttpHandle handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+												HttpRequest::priority_t(i),
+												url,
+												HttpOptions::ptr_t(),
+												HttpHeaders::ptr_t(),
+												handlerp);
+
+			std::ostringstream testtag;
+			testtag << "Valid handle returned for HTTP/2 request #" << i;
+			ensure(testtag.str(), handle != LLCORE_HTTP_HANDLE_INVALID);
+		}
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < url_limit)
+		{
+			req->update(0);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure("One handler invocation for each request", mHandlerCalls == url_limit);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// Stats are written by the (now stopped) worker thread
+		const LLCore::HTTPStats & stats(LLCore::HTTPStats::instance());
+		ensure_equals("Time to first byte recorded for each request",
+					  stats.getTimeToFirstByte().getCount(), U32(url_limit));
+		ensure("Requests carried over HTTP/2 streams", stats.getStreamsPerConnection() >= 1.f);
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
 
 }  // end namespace tut
 
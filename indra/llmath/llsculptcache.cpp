@@ -0,0 +1,142 @@
+/**
+ * @file llsculptcache.cpp
+ * @brief Implementation of LLSculptCache class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llsculptcache.h"
+
+U32 LLSculptCache::sHits = 0;
+U32 LLSculptCache::sMisses = 0;
+LLMutex LLSculptCache::sMutex;
+LLSculptCache::lru_list_t LLSculptCache::sEntries;
+std::unordered_map<LLSculptCache::Key, LLSculptCache::lru_list_t::iterator, LLSculptCache::KeyHash> LLSculptCache::sIndex;
+size_t LLSculptCache::sSize = 0;
+size_t LLSculptCache::sMaxSize = 32 * 1024 * 1024;
+
+size_t LLSculptCache::Entry::getSize() const
+{
+	size_t size = sizeof(Entry) + mMesh.size() * sizeof(LLVector4a);
+	for (const LLVolumeFace& face : mFaces)
+	{
+		size_t vert_size = sizeof(LLVector4a) * 2 + sizeof(LLVector2);
+		if (face.mTangents)
+		{
+			vert_size += sizeof(LLVector4a);
+		}
+		size += sizeof(LLVolumeFace) + face.mNumVertices * vert_size + face.mNumIndices * sizeof(U16);
+	}
+	return size;
+}
+
+size_t LLSculptCache::KeyHash::operator()(const Key& key) const
+{
+	size_t seed = hash_value(key.mSculptID);
+	boost::hash_combine(seed, key.mDiscardLevel);
+	boost::hash_combine(seed, key.mDetail);
+	boost::hash_combine(seed, key.mSculptType);
+	return seed;
+}
+
+// static
+LLPointer<LLSculptCache::Entry> LLSculptCache::find(const Key& key)
+{
+	LLMutexLock lock(&sMutex);
+
+	auto iter = sIndex.find(key);
+	if (iter == sIndex.end())
+	{
+		++sMisses;
+		return NULL;
+	}
+
+	++sHits;
+	sEntries.splice(sEntries.begin(), sEntries, iter->second);
+	return iter->second->second;
+}
+
+// static
+void LLSculptCache::insert(const Key& key, const LLPointer<Entry>& entry)
+{
+	LLMutexLock lock(&sMutex);
+
+	if (sMaxSize == 0)
+	{
+		return;
+	}
+
+	auto iter = sIndex.find(key);
+	if (iter != sIndex.end())
+	{
+		sSize -= iter->second->second->getSize();
+		sEntries.erase(iter->second);
+		sIndex.erase(iter);
+	}
+
+	sEntries.push_front(std::make_pair(key, entry));
+	sIndex[key] = sEntries.begin();
+	sSize += entry->getSize();
+	evict();
+}
+
+// static
+void LLSculptCache::setMaxSize(size_t bytes)
+{
+	LLMutexLock lock(&sMutex);
+
+	if (bytes != sMaxSize)
+	{
+		sMaxSize = bytes;
+		evict();
+	}
+}
+
+// static
+size_t LLSculptCache::getSize()
+{
+	LLMutexLock lock(&sMutex);
+	return sSize;
+}
+
+// static
+void LLSculptCache::clear()
+{
+	LLMutexLock lock(&sMutex);
+
+	sIndex.clear();
+	sEntries.clear();
+	sSize = 0;
+}
+
+// static
+void LLSculptCache::evict()
+{
+	while (sSize > sMaxSize && !sEntries.empty())
+	{
+		sSize -= sEntries.back().second->getSize();
+		sIndex.erase(sEntries.back().first);
+		sEntries.pop_back();
+	}
+}
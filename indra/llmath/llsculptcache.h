@@ -0,0 +1,121 @@
+/**
+ * @file llsculptcache.h
+ * @brief Cache of sculpted volume geometry shared between volumes.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSCULPTCACHE_H
+#define LL_LLSCULPTCACHE_H
+
+#include <list>
+#include <unordered_map>
+
+#include "llmutex.h"
+#include "llpointer.h"
+#include "llrefcount.h"
+#include "llvolume.h"
+
+//-----------------------------------------------------------------------------
+// class LLSculptCache
+//
+// Results of LLVolume::sculpt(), keyed by sculpt texture, discard level,
+// volume detail and sculpt type, so that every prim using the same sculpt
+// map shares one sampling pass, and a LOD that is dropped and requested
+// again does not sample the map again.
+//
+// An entry holds the vertex grid sampled from the map, which only depends
+// on the key, plus the finished faces along with the path and profile
+// parameters they were built with.  A volume with the same parameters
+// copies the faces, any other one rebuilds its faces from the grid.
+//
+// Entries are evicted least recently used first once the cache grows past
+// its budget.  All calls are thread safe.
+//-----------------------------------------------------------------------------
+class LLSculptCache
+{
+public:
+	struct Key
+	{
+		Key(const LLUUID& sculpt_id, S32 discard_level, F32 detail, U8 sculpt_type)
+		:	mSculptID(sculpt_id), mDiscardLevel(discard_level), mDetail(detail), mSculptType(sculpt_type)
+		{
+		}
+
+		bool operator==(const Key& rhs) const
+		{
+			return mSculptID == rhs.mSculptID && mDiscardLevel == rhs.mDiscardLevel
+				&& mDetail == rhs.mDetail && mSculptType == rhs.mSculptType;
+		}
+
+		LLUUID	mSculptID;
+		S32		mDiscardLevel;
+		F32		mDetail;
+		U8		mSculptType;
+	};
+
+	class Entry : public LLThreadSafeRefCount
+	{
+	public:
+		Entry() : mSizeS(0), mSizeT(0), mSurfaceArea(0.f), mHasSurfaceArea(false) {}
+
+		size_t getSize() const;
+
+		S32								mSizeS;
+		S32								mSizeT;
+		LLAlignedArray<LLVector4a,64>	mMesh;
+		F32								mSurfaceArea;
+		bool							mHasSurfaceArea;	// false for LODs that skip the area test
+		LLPathParams					mPathParams;
+		LLProfileParams					mProfileParams;
+		std::vector<LLVolumeFace>		mFaces;
+	};
+
+	static LLPointer<Entry> find(const Key& key);
+	static void insert(const Key& key, const LLPointer<Entry>& entry);
+
+	// Budget in bytes, 0 disables the cache.
+	static void setMaxSize(size_t bytes);
+	static size_t getSize();
+	static void clear();
+
+	static U32 sHits;
+	static U32 sMisses;
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	typedef std::list<std::pair<Key, LLPointer<Entry> > > lru_list_t;
+
+	static void evict();
+
+	static LLMutex sMutex;
+	static lru_list_t sEntries;		// most recently used first
+	static std::unordered_map<Key, lru_list_t::iterator, KeyHash> sIndex;
+	static size_t sSize;
+	static size_t sMaxSize;
+};
+
+#endif // LL_LLSCULPTCACHE_H
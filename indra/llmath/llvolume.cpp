@@ -44,6 +44,7 @@
 #include "llmatrix3a.h"
 #include "lloctree.h"
 #include "llvolume.h"
+#include "llsculptcache.h"
 #include "llvolumeoctree.h"
 #include "llstl.h"
 #include "llsdserialize.h"
@@ -2040,7 +2041,7 @@ LLProfile::~LLProfile()
 }
 
 
-S32 LLVolume::sNumMeshPoints = 0;
+std::atomic<S32> LLVolume::sNumMeshPoints(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -2098,7 +2099,7 @@ void LLVolume::genTangents(S32 face)
 
 LLVolume::~LLVolume()
 {
-	sNumMeshPoints -= mMesh.size();
+	sNumMeshPoints -= (S32)mMesh.size();
 	delete mPathp;
 
 	delete mProfilep;
@@ -2165,9 +2166,9 @@ BOOL LLVolume::generate()
 		S32 sizeS = mPathp->mPath.size();
 		S32 sizeT = mProfilep->mProfile.size();
 
-		sNumMeshPoints -= mMesh.size();
+		sNumMeshPoints -= (S32)mMesh.size();
 		mMesh.resize(sizeT * sizeS);
-		sNumMeshPoints += mMesh.size();		
+		sNumMeshPoints += (S32)mMesh.size();		
 
 		//generate vertex positions
 
@@ -3053,6 +3054,8 @@ void LLVolume::sculptGenerateSpherePlaceholder()
 // create the vertices from the map
 void LLVolume::sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, U8 sculpt_type)
 {
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
 	U8 sculpt_stitching = sculpt_type & LL_SCULPT_TYPE_MASK;
 	BOOL sculpt_invert = sculpt_type & LL_SCULPT_FLAG_INVERT;
 	BOOL sculpt_mirror = sculpt_type & LL_SCULPT_FLAG_MIRROR;
@@ -3060,79 +3063,93 @@ void LLVolume::sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8
 	
 	S32 sizeS = mPathp->mPath.size();
 	S32 sizeT = mProfilep->mProfile.size();
-	
-	S32 line = 0;
-	for (S32 s = 0; s < sizeS; s++)
+
+	// The map column only depends on t and the row only on s, so resolve the
+	// stitching for each once rather than per vertex.
+	std::vector<U32> columns(sizeT);
+	for (S32 t = 0; t < sizeT; t++)
 	{
-		// Run along the profile.
-		for (S32 t = 0; t < sizeT; t++)
+		S32 reversed_t = t;
+
+		if (reverse_horizontal)
 		{
-			S32 i = t + line;
-			LLVector4a& pt = mMesh[i];
+			reversed_t = sizeT - t - 1;
+		}
 
-			S32 reversed_t = t;
+		U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
 
-			if (reverse_horizontal)
+		if (x == sculpt_width)   // side stitching
+		{
+			// wrap?
+			if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
 			{
-				reversed_t = sizeT - t - 1;
+				x = 0;
 			}
-			
-			U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
-			U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
-
-			
-			if (y == 0)  // top row stitching
+			else
 			{
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
+				x = sculpt_width - 1;
 			}
+		}
 
-			if (y == sculpt_height)  // bottom row stitching
-			{
-				// wrap?
-				if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
-				{
-					y = 0;
-				}
-				else
-				{
-					y = sculpt_height - 1;
-				}
+		columns[t] = x * sculpt_components;
+	}
 
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
-			}
+	// maps RGB values to vector values [0..255] -> [-0.5..0.5], negating x
+	// when mirrored
+	const F32 x_sign = sculpt_mirror ? -1.f : 1.f;
+	LLVector4a scale(x_sign / 255.f, 1.f / 255.f, 1.f / 255.f, 0.f);
+	LLVector4a offset(x_sign * 0.5f, 0.5f, 0.5f, 0.f);
+	const __m128i zero = _mm_setzero_si128();
 
-			if (x == sculpt_width)   // side stitching
-			{
-				// wrap?
-				if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
-				{
-					x = 0;
-				}
-					
-				else
-				{
-					x = sculpt_width - 1;
-				}
-			}
+	S32 line = 0;
+	for (S32 s = 0; s < sizeS; s++)
+	{
+		U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
+		bool pinch = false;
 
-			pt = sculpt_xy_to_vector(x, y, sculpt_width, sculpt_height, sculpt_components, sculpt_data);
+		if (y == 0)  // top row stitching
+		{
+			// pinch?
+			pinch = (sculpt_stitching == LL_SCULPT_TYPE_SPHERE);
+		}
 
-			if (sculpt_mirror)
+		if (y == sculpt_height)  // bottom row stitching
+		{
+			// wrap?
+			if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
+			{
+				y = 0;
+			}
+			else
 			{
-				LLVector4a scale(-1.f,1,1,1);
-				pt.mul(scale);
+				y = sculpt_height - 1;
 			}
 
+			// pinch?
+			pinch = (sculpt_stitching == LL_SCULPT_TYPE_SPHERE);
+		}
+
+		const U8* row = sculpt_data + sculpt_xy_to_index(0, y, sculpt_width, sculpt_height, sculpt_components);
+		const U32 pinch_column = (sculpt_width / 2) * sculpt_components;
+
+		// Run along the profile.
+		for (S32 t = 0; t < sizeT; t++)
+		{
+			const U8* texel = row + (pinch ? pinch_column : columns[t]);
+
+			// widen the three channels to floats in one register; bytes are
+			// read one at a time so the last texel of an RGB map can't be
+			// read past
+			__m128i rgb = _mm_cvtsi32_si128(texel[0] | (texel[1] << 8) | (texel[2] << 16));
+			rgb = _mm_unpacklo_epi16(_mm_unpacklo_epi8(rgb, zero), zero);
+
+			LLVector4a& pt = mMesh[t + line];
+			pt = _mm_cvtepi32_ps(rgb);
+			pt.mul(scale);
+			pt.sub(offset);
+
 			llassert(pt.isFinite3());
 		}
 		
@@ -3236,9 +3253,55 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
 		LL_WARNS() << "sculpt bad mesh size " << sizeS << " " << sizeT << LL_ENDL;
 	}
 	
-	sNumMeshPoints -= mMesh.size();
+	sNumMeshPoints -= (S32)mMesh.size();
 	mMesh.resize(sizeS * sizeT);
-	sNumMeshPoints += mMesh.size();
+	sNumMeshPoints += (S32)mMesh.size();
+
+	// Another volume may already have sampled this map at this detail.
+	// Maps without an asset ID (local previews) can't be told apart, so
+	// they are never cached.
+	LLSculptCache::Key cache_key(mParams.getSculptID(), sculpt_level, mDetail, sculpt_type);
+	const bool use_cache = mParams.getSculptID().notNull();
+	LLPointer<LLSculptCache::Entry> cached;
+	if (use_cache && !data_is_empty && sizeS > 0 && sizeT > 0)
+	{
+		cached = LLSculptCache::find(cache_key);
+		if (cached.notNull() && (cached->mSizeS != sizeS || cached->mSizeT != sizeT))
+		{
+			cached = NULL;
+		}
+	}
+
+	if (cached.notNull())
+	{
+		LLVector4a::memcpyNonAliased16((F32*) &mMesh[0], (F32*) &cached->mMesh[0], sizeS * sizeT * sizeof(LLVector4a));
+		if (cached->mHasSurfaceArea)
+		{
+			mSurfaceArea = cached->mSurfaceArea;
+		}
+
+		for (S32 i = 0; i < (S32)mProfilep->mFaces.size(); i++)
+		{
+			mFaceMask |= mProfilep->mFaces[i].mFaceID;
+		}
+
+		mSculptLevel = sculpt_level;
+
+		if (!mGenerateSingleFace
+			&& cached->mPathParams == mParams.getPathParams()
+			&& cached->mProfileParams == mParams.getProfileParams())
+		{
+			mVolumeFaces = cached->mFaces;
+		}
+		else
+		{
+			mVolumeFaces.clear();
+			createVolumeFaces();
+		}
+		return;
+	}
+
+	bool has_area = false;
 
 	//generate vertex positions
 	if (!data_is_empty)
@@ -3251,6 +3314,7 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
 			F32 area = sculptGetSurfaceArea();
 
 			mSurfaceArea = area;
+			has_area = true;
 
 			const F32 SCULPT_MAX_AREA = 384.f;
 
@@ -3288,6 +3352,21 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
 	mVolumeFaces.clear();
 	
 	createVolumeFaces();
+
+	if (use_cache && sculpt_level >= 0 && !mGenerateSingleFace && sizeS > 0 && sizeT > 0)
+	{
+		LLPointer<LLSculptCache::Entry> entry = new LLSculptCache::Entry;
+		entry->mSizeS = sizeS;
+		entry->mSizeT = sizeT;
+		entry->mMesh.resize(sizeS * sizeT);
+		LLVector4a::memcpyNonAliased16((F32*) &entry->mMesh[0], (F32*) &mMesh[0], sizeS * sizeT * sizeof(LLVector4a));
+		entry->mSurfaceArea = mSurfaceArea;
+		entry->mHasSurfaceArea = has_area;
+		entry->mPathParams = mParams.getPathParams();
+		entry->mProfileParams = mParams.getProfileParams();
+		entry->mFaces = mVolumeFaces;
+		LLSculptCache::insert(cache_key, entry);
+	}
 }
 
 
@@ -4860,6 +4939,9 @@ LLVolumeFace& LLVolumeFace::operator=(const LLVolumeFace& src)
         mIndices = NULL;
     }
 
+	// silhouettes of sculpted faces are built from this, see createSide()
+	mEdge = src.mEdge;
+
 	mOptimized = src.mOptimized;
 
 	//delete 
@@ -27,6 +27,7 @@
 
 #include "llvolumemgr.h"
 #include "llvolume.h"
+#include "workqueue.h"
 
 
 const F32 BASE_THRESHOLD = 0.03f;
@@ -245,6 +246,68 @@ std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 	return s;
 }
 
+LLPointer<LLVolumeRequest> LLVolumeMgr::requestVolume(const LLVolumeParams &volume_params, const S32 detail)
+{
+	LLVolumeLODGroup* volgroupp = getGroup(volume_params);
+	if (!volgroupp)
+	{
+		// Nothing to show meanwhile, the caller might as well wait
+		return NULL;
+	}
+	return volgroupp->requestLOD(detail);
+}
+
+LLVolumeRequest::LLVolumeRequest(const LLVolumeParams& params, F32 detail)
+	: mParams(params),
+	  mDetail(detail),
+	  mState(PENDING)
+{
+}
+
+bool LLVolumeRequest::claim()
+{
+	U32 expected = PENDING;
+	return mState.compare_exchange_strong(expected, RUNNING, std::memory_order_acq_rel);
+}
+
+void LLVolumeRequest::build()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+	// Only the claiming thread touches mVolume until the state is READY.
+	mVolume = new LLVolume(mParams, mDetail);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mState.store(READY, std::memory_order_release);
+	}
+	mReadyCond.notify_all();
+}
+
+void LLVolumeRequest::generate()
+{
+	if (claim())
+	{
+		build();
+	}
+}
+
+LLPointer<LLVolume> LLVolumeRequest::finish()
+{
+	if (claim())
+	{
+		build();
+	}
+	else
+	{
+		LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("volume request wait");
+		std::unique_lock<std::mutex> lock(mMutex);
+		mReadyCond.wait(lock, [this]() { return isReady(); });
+	}
+	LLPointer<LLVolume> volume = mVolume;
+	mVolume = NULL;
+	return volume;
+}
+
 LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
 	: mVolumeParams(params),
 	  mRefs(0)
@@ -293,6 +356,13 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 detail)
 	mAccessCount[detail]++;
 	
 	mRefs++;
+	if (mVolumeLODs[detail].isNull() && mPendingLODs[detail].notNull())
+	{
+		// Adopts the request's volume, waiting for a worker that is part way
+		// through it rather than starting over.
+		mVolumeLODs[detail] = mPendingLODs[detail]->finish();
+	}
+	mPendingLODs[detail] = NULL;
 	if (mVolumeLODs[detail].isNull())
 	{
 		mVolumeLODs[detail] = new LLVolume(mVolumeParams, mDetailScales[detail]);
@@ -301,6 +371,40 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 detail)
 	return mVolumeLODs[detail];
 }
 
+LLPointer<LLVolumeRequest> LLVolumeLODGroup::requestLOD(const S32 detail)
+{
+	llassert(detail >=0 && detail < NUM_LODS);
+	if (mVolumeLODs[detail].notNull())
+	{
+		return NULL;
+	}
+	if (mPendingLODs[detail].notNull())
+	{
+		return mPendingLODs[detail];
+	}
+
+	// Sculpt and mesh volumes only get their faces from elsewhere later,
+	// only procedural prims have real work to move.
+	if (mVolumeParams.getSculptType() != LL_SCULPT_TYPE_NONE)
+	{
+		return NULL;
+	}
+
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (!general_queue)
+	{
+		return NULL;
+	}
+
+	LLPointer<LLVolumeRequest> request = new LLVolumeRequest(mVolumeParams, mDetailScales[detail]);
+	if (!general_queue->postIfOpen([request]() mutable { request->generate(); }))
+	{
+		return NULL;
+	}
+	mPendingLODs[detail] = request;
+	return request;
+}
+
 BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
 	llassert_always(mRefs > 0);
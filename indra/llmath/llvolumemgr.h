@@ -27,7 +27,10 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
+#include <atomic>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 
 #include "llvolume.h"
 #include "llpointer.h"
@@ -36,6 +39,38 @@
 class LLVolumeParams;
 class LLVolumeLODGroup;
 
+// Handle to a volume LOD being generated on a worker thread, see
+// LLVolumeMgr::requestVolume().  The worker builds the volume (profile,
+// path and faces) without touching anything shared; the owning LOD group
+// adopts it on the main thread.  Whichever side starts first builds it.
+class LLVolumeRequest : public LLThreadSafeRefCount
+{
+public:
+	LLVolumeRequest(const LLVolumeParams& params, F32 detail);
+
+	bool isReady() const { return mState.load(std::memory_order_acquire) == READY; }
+
+	// Worker side, does nothing if finish() got there first.
+	void generate();
+
+	// Main thread side: hands over the volume, building it here if no
+	// worker has started on it, or waiting for the one that has.
+	LLPointer<LLVolume> finish();
+
+private:
+	enum EState { PENDING, RUNNING, READY };
+
+	bool claim();
+	void build();
+
+	LLVolumeParams			mParams;
+	F32						mDetail;
+	LLPointer<LLVolume>		mVolume;
+	std::atomic<U32>		mState;
+	std::mutex				mMutex;
+	std::condition_variable	mReadyCond;
+};
+
 class LLVolumeLODGroup
 {
 	LOG_CLASS(LLVolumeLODGroup);
@@ -57,6 +92,10 @@ public:
 
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
+
+	// Starts generating a LOD that doesn't exist yet on the "General" work
+	// queue.  Returns NULL if refLOD() can return the LOD right away.
+	LLPointer<LLVolumeRequest> requestLOD(const S32 detail);
 	S32 getNumRefs() const { return mRefs; }
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
@@ -70,6 +109,7 @@ protected:
 	S32 mRefs;
 	S32 mLODRefs[NUM_LODS];
 	LLPointer<LLVolume> mVolumeLODs[NUM_LODS];
+	LLPointer<LLVolumeRequest> mPendingLODs[NUM_LODS];
 	static F32 mDetailThresholds[NUM_LODS];
 	static F32 mDetailScales[NUM_LODS];
 	S32		mAccessCount[NUM_LODS];
@@ -90,6 +130,13 @@ public:
 	virtual LLVolume *refVolume(const LLVolumeParams &volume_params, const S32 detail);
 	virtual void unrefVolume(LLVolume *volumep);
 
+	// Asynchronous refVolume(): if another LOD of these parameters is in
+	// use and the requested one still has to be built, generation starts on
+	// a worker thread and the returned request turns ready when refVolume()
+	// can pick the result up without blocking.  Returns NULL when there is
+	// nothing to wait for, or nothing worth moving off the calling thread.
+	LLPointer<LLVolumeRequest> requestVolume(const LLVolumeParams &volume_params, const S32 detail);
+
 	void dump();
 
 	// manually call this for mutex magic
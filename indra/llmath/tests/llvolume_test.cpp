@@ -0,0 +1,229 @@
+/**
+ * @file llvolume_test.cpp
+ * @brief Sculpted LLVolume and LLSculptCache test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llsculptcache.h"
+#include "../llvolume.h"
+
+#include "../test/lltut.h"
+
+#include <algorithm>
+
+namespace tut
+{
+	struct volume_data
+	{
+		volume_data()
+		{
+			LLSculptCache::clear();
+		}
+
+		~volume_data()
+		{
+			LLSculptCache::clear();
+		}
+
+		// A smooth map with some noise, so the area test passes
+		static std::vector<U8> makeMap(U16 width, U16 height)
+		{
+			std::vector<U8> map(width * height * 3);
+			U32 seed = 12345;
+			for (U32 y = 0; y < height; ++y)
+			{
+				for (U32 x = 0; x < width; ++x)
+				{
+					F32 u = (F32)x / width * F_TWO_PI;
+					F32 v = (F32)y / height * F_PI;
+					seed = seed * 1103515245 + 12345;
+					U8* texel = &map[(y * width + x) * 3];
+					texel[0] = (U8)(127.5f + 120.f * sinf(v) * cosf(u)) ^ ((seed >> 16) & 0x3);
+					texel[1] = (U8)(127.5f + 120.f * sinf(v) * sinf(u));
+					texel[2] = (U8)(127.5f + 120.f * cosf(v));
+				}
+			}
+			return map;
+		}
+
+		static LLVolumeParams makeParams(const LLUUID& sculpt_id, U8 sculpt_type)
+		{
+			LLVolumeParams params;
+			params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+			params.setSculptID(sculpt_id, sculpt_type);
+			return params;
+		}
+
+		// Scalar version of the sampling done by LLVolume::sculptGenerateMapVertices()
+		static LLVector4a referencePoint(S32 s, S32 t, S32 sizeS, S32 sizeT, U16 width, U16 height, const U8* data, U8 sculpt_type)
+		{
+			U8 stitching = sculpt_type & LL_SCULPT_TYPE_MASK;
+			bool invert = sculpt_type & LL_SCULPT_FLAG_INVERT;
+			bool mirror = sculpt_type & LL_SCULPT_FLAG_MIRROR;
+			S32 reversed_t = (invert != mirror) ? sizeT - t - 1 : t;
+
+			U32 x = (U32)((F32)reversed_t / (sizeT - 1) * (F32)width);
+			U32 y = (U32)((F32)s / (sizeS - 1) * (F32)height);
+			if (y == 0 && stitching == LL_SCULPT_TYPE_SPHERE)
+			{
+				x = width / 2;
+			}
+			if (y == height)
+			{
+				y = (stitching == LL_SCULPT_TYPE_TORUS) ? 0 : height - 1;
+				if (stitching == LL_SCULPT_TYPE_SPHERE)
+				{
+					x = width / 2;
+				}
+			}
+			if (x == width)
+			{
+				x = (stitching == LL_SCULPT_TYPE_PLANE) ? width - 1 : 0;
+			}
+
+			const U8* texel = data + (x + y * width) * 3;
+			LLVector4a pt(texel[0], texel[1], texel[2]);
+			pt.mul(1.f / 255.f);
+			pt.sub(LLVector4a(0.5f, 0.5f, 0.5f));
+			if (mirror)
+			{
+				pt.mul(LLVector4a(-1.f, 1.f, 1.f, 1.f));
+			}
+			return pt;
+		}
+	};
+	typedef test_group<volume_data> volume_test;
+	typedef volume_test::object volume_object;
+	tut::volume_test volume_testcase("LLVolume");
+
+	template<> template<>
+	void volume_object::test<1>()
+	{
+		set_test_name("sculpt map sampling");
+
+		const U16 width = 64;
+		const U16 height = 32;
+		std::vector<U8> map = makeMap(width, height);
+
+		const U8 types[] = { LL_SCULPT_TYPE_SPHERE, LL_SCULPT_TYPE_TORUS, LL_SCULPT_TYPE_PLANE, LL_SCULPT_TYPE_CYLINDER,
+							 LL_SCULPT_TYPE_SPHERE | LL_SCULPT_FLAG_MIRROR, LL_SCULPT_TYPE_TORUS | LL_SCULPT_FLAG_INVERT,
+							 LL_SCULPT_TYPE_CYLINDER | LL_SCULPT_FLAG_MIRROR | LL_SCULPT_FLAG_INVERT };
+		for (U8 sculpt_type : types)
+		{
+			LLUUID id;
+			id.generate();
+			LLPointer<LLVolume> volume = new LLVolume(makeParams(id, sculpt_type), 4.f);
+			volume->sculpt(width, height, 3, &map[0], 0, false);
+
+			const LLAlignedArray<LLVector4a,64>& mesh = volume->getMesh();
+			S32 sizeS = volume->getPath().mPath.size();
+			S32 sizeT = volume->getProfile().mProfile.size();
+			ensure_equals("grid size", (S32)mesh.size(), sizeS * sizeT);
+			ensure("faces built", volume->getNumVolumeFaces() > 0);
+
+			for (S32 s = 0; s < sizeS; ++s)
+			{
+				for (S32 t = 0; t < sizeT; ++t)
+				{
+					LLVector4a expected = referencePoint(s, t, sizeS, sizeT, width, height, &map[0], sculpt_type);
+					ensure(llformat("type %d point %d,%d", sculpt_type, s, t),
+						   mesh[s * sizeT + t].equals3(expected, 1e-6f));
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void volume_object::test<2>()
+	{
+		set_test_name("sculpt cache shares results");
+
+		const U16 width = 64;
+		const U16 height = 64;
+		std::vector<U8> map = makeMap(width, height);
+		LLUUID id;
+		id.generate();
+
+		LLPointer<LLVolume> first = new LLVolume(makeParams(id, LL_SCULPT_TYPE_SPHERE), 3.f);
+		first->sculpt(width, height, 3, &map[0], 1, false);
+		ensure("first sculpt is cached", LLSculptCache::getSize() > 0);
+
+		U32 hits = LLSculptCache::sHits;
+		LLPointer<LLVolume> second = new LLVolume(makeParams(id, LL_SCULPT_TYPE_SPHERE), 3.f);
+		second->sculpt(width, height, 3, &map[0], 1, false);
+		ensure_equals("second sculpt hits", LLSculptCache::sHits, hits + 1);
+		ensure_equals("same faces", second->getNumVolumeFaces(), first->getNumVolumeFaces());
+		for (S32 i = 0; i < first->getNumVolumeFaces(); ++i)
+		{
+			const LLVolumeFace& a = first->getVolumeFace(i);
+			const LLVolumeFace& b = second->getVolumeFace(i);
+			ensure_equals("vertices", b.mNumVertices, a.mNumVertices);
+			ensure_equals("indices", b.mNumIndices, a.mNumIndices);
+			ensure("positions", !memcmp(a.mPositions, b.mPositions, a.mNumVertices * sizeof(LLVector4a)));
+			ensure("normals", !memcmp(a.mNormals, b.mNormals, a.mNumVertices * sizeof(LLVector4a)));
+			// needed for the selection silhouette
+			ensure("edges built", !a.mEdge.empty());
+			ensure("edges", b.mEdge == a.mEdge);
+		}
+		ensure_equals("surface area", second->getSurfaceArea(), first->getSurfaceArea());
+
+		// a different discard level or type is a different entry
+		hits = LLSculptCache::sHits;
+		LLPointer<LLVolume> other_discard = new LLVolume(makeParams(id, LL_SCULPT_TYPE_SPHERE), 3.f);
+		other_discard->sculpt(width, height, 3, &map[0], 2, false);
+		LLPointer<LLVolume> other_type = new LLVolume(makeParams(id, LL_SCULPT_TYPE_TORUS), 3.f);
+		other_type->sculpt(width, height, 3, &map[0], 1, false);
+		ensure_equals("distinct keys miss", LLSculptCache::sHits, hits);
+
+		// nothing is kept without a budget
+		LLSculptCache::setMaxSize(0);
+		ensure_equals("evicted", LLSculptCache::getSize(), (size_t)0);
+		LLSculptCache::setMaxSize(32 * 1024 * 1024);
+	}
+
+	template<> template<>
+	void volume_object::test<3>()
+	{
+		set_test_name("sculpts without an ID are not cached");
+
+		const U16 width = 64;
+		const U16 height = 64;
+		std::vector<U8> map = makeMap(width, height);
+		std::vector<U8> other_map = makeMap(width, height);
+		std::reverse(other_map.begin(), other_map.end());
+
+		// what image previews do
+		LLPointer<LLVolume> first = new LLVolume(makeParams(LLUUID::null, LL_SCULPT_TYPE_SPHERE), 3.f);
+		first->sculpt(width, height, 3, &map[0], 0, false);
+		ensure_equals("not inserted", LLSculptCache::getSize(), (size_t)0);
+
+		U32 hits = LLSculptCache::sHits;
+		LLPointer<LLVolume> second = new LLVolume(makeParams(LLUUID::null, LL_SCULPT_TYPE_SPHERE), 3.f);
+		second->sculpt(width, height, 3, &other_map[0], 0, false);
+		ensure_equals("not looked up", LLSculptCache::sHits, hits);
+		ensure("own geometry", memcmp(&first->getMesh()[0], &second->getMesh()[0],
+									  first->getMesh().size() * sizeof(LLVector4a)) != 0);
+	}
+}
@@ -0,0 +1,120 @@
+/**
+ * @file llvolumemgr_test.cpp
+ * @brief LLVolumeMgr asynchronous LOD request test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include <thread>
+
+#include "../llvolumemgr.h"
+
+#include "workqueue.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct volumemgr_data
+	{
+		volumemgr_data()
+			: mQueue(new LL::WorkQueue("General"))
+		{
+			mParams.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+		}
+
+		~volumemgr_data()
+		{
+			mQueue->close();
+		}
+
+		LLVolumeMgr				mMgr;
+		LLVolumeParams			mParams;
+		LL::WorkQueue::ptr_t	mQueue;
+	};
+	typedef test_group<volumemgr_data> volumemgr_test;
+	typedef volumemgr_test::object volumemgr_object;
+	tut::volumemgr_test tvm("LLVolumeMgr");
+
+	template<> template<>
+	void volumemgr_object::test<1>()
+	{
+		set_test_name("Request without a group");
+		ensure("no request before the first refVolume()", mMgr.requestVolume(mParams, 0).isNull());
+		ensure("nothing posted", mQueue->size() == 0);
+	}
+
+	template<> template<>
+	void volumemgr_object::test<2>()
+	{
+		set_test_name("refVolume() adopts a request no worker started");
+		LLVolume* high = mMgr.refVolume(mParams, 3);
+		LLPointer<LLVolumeRequest> request = mMgr.requestVolume(mParams, 0);
+		ensure("request posted", request.notNull());
+		ensure("not built yet", !request->isReady());
+
+		LLVolume* low = mMgr.refVolume(mParams, 0);
+		ensure("request finished", request->isReady());
+		ensure("low LOD built", low && low->getNumVolumeFaces() > 0);
+		ensure("distinct LODs", low != high);
+
+		// The worker gets to it too late and must not build it again
+		S32 points = LLVolume::sNumMeshPoints;
+		mQueue->runPending();
+		ensure_equals("built once", (S32)LLVolume::sNumMeshPoints, points);
+
+		mMgr.unrefVolume(low);
+		mMgr.unrefVolume(high);
+	}
+
+	template<> template<>
+	void volumemgr_object::test<3>()
+	{
+		set_test_name("refVolume() against a running worker");
+		S32 start_points = LLVolume::sNumMeshPoints;
+		LLVolume* high = mMgr.refVolume(mParams, 3);
+		for (S32 detail = 0; detail < 3; ++detail)
+		{
+			LLPointer<LLVolumeRequest> request = mMgr.requestVolume(mParams, detail);
+			ensure("request posted", request.notNull());
+
+			std::thread worker([this]() { mQueue->runPending(); });
+			LLVolume* volume = mMgr.refVolume(mParams, detail);
+			worker.join();
+
+			ensure("request finished", request->isReady());
+			ensure("LOD built", volume && volume->getNumVolumeFaces() > 0);
+			ensure("same volume on the next ref", mMgr.refVolume(mParams, detail) == volume);
+
+			S32 points = LLVolume::sNumMeshPoints;
+			mQueue->runPending();
+			ensure_equals("built once", (S32)LLVolume::sNumMeshPoints, points);
+
+			mMgr.unrefVolume(volume);
+			mMgr.unrefVolume(volume);
+		}
+		mMgr.unrefVolume(high);
+		ensure_equals("mesh points released", (S32)LLVolume::sNumMeshPoints, start_points);
+	}
+}
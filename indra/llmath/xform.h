@@ -138,6 +138,12 @@ public:
 
 	const LLMatrix4&    getWorldMatrix() const      { return mWorldMatrix; }
 	void setWorldMatrix (const LLMatrix4& mat)   { mWorldMatrix = mat; }
+	void setWorldTransform(const LLVector3& pos, const LLQuaternion& rot, const LLMatrix4& mat)
+	{
+		mWorldPosition = pos;
+		mWorldRotation = rot;
+		mWorldMatrix = mat;
+	}
 
 	void init()
 	{
@@ -134,6 +134,9 @@ private:
 
 	// Flag indicating if username should be shown after display name or not
 	static bool sUseUsernames;
+
+	// reads and writes the fields directly for its binary cache file
+	friend class LLAvatarNameCache;
 };
 
 #endif
@@ -44,6 +44,7 @@
 #include "lleventcoro.h"
 #include "llcorehttputil.h"
 #include "llexception.h"
+#include "lltrace.h"
 #include "stringize.h"
 
 #include <map>
@@ -55,9 +56,33 @@ const F64 TEMP_CACHE_ENTRY_LIFETIME = 60.0;
 // Maximum time an unrefreshed cache entry is allowed.
 const F64 MAX_UNREFRESHED_TIME = 20.0 * 60.0;
 
-// Send bulk lookup requests a few times a second at most.
-// Only need per-frame timing resolution.
-static LLFrameTimer sRequestTimer;
+// URL format is like:
+// http://pdp60.lindenlab.com:8000/agents/?ids=3941037e-78ab-45f0-b421-bd6e77c1804d&ids=0012809d-7d2d-4c24-9609-af1230a37715&ids=0019aaba-24af-4f0a-aa72-6457953cf7f0
+//
+// Apache can handle URLs of 4096 chars, but let's be conservative
+static const U32 NAME_URL_MAX = 4096;
+static const U32 NAME_URL_SEND_THRESHOLD = 3500;
+// A queue this long fills a request, no point waiting for more.
+static const U32 NAME_IDS_PER_REQUEST = NAME_URL_SEND_THRESHOLD / (UUID_STR_LENGTH + 5);
+
+static LLTrace::SampleStatHandle<> sNameBatchSize("namebatchsize", "Agent ids per display name request");
+static LLTrace::SampleStatHandle<F64Seconds> sNameBatchLatency("namebatchlatency", "Round trip of display name requests");
+
+// Request counts by ids per request (1, 2-3, 4-7, ... 128 and over) and by
+// round trip (under 50 ms, 100 ms, 200 ms, ... 3.2 s and over).
+static const S32 NAME_HISTOGRAM_BUCKETS = 8;
+static U32 sNameBatchSizeHistogram[NAME_HISTOGRAM_BUCKETS] = { 0 };
+static U32 sNameBatchLatencyHistogram[NAME_HISTOGRAM_BUCKETS] = { 0 };
+
+static void add_to_histogram(U32* histogram, F64 value, F64 first_limit)
+{
+	S32 bucket = 0;
+	for (F64 limit = first_limit; value >= limit && bucket < NAME_HISTOGRAM_BUCKETS - 1; limit *= 2.0)
+	{
+		++bucket;
+	}
+	++histogram[bucket];
+}
 
 // static to avoid unnessesary dependencies
 LLCore::HttpRequest::ptr_t		sHttpRequest;
@@ -117,6 +142,12 @@ LLAvatarNameCache::LLAvatarNameCache()
 
     mUsePeopleAPI = true;
 
+    mDeferSignals = false;
+    mAskQueueStart = 0.0;
+    // 100 ms is the threshold for "user speed" operations, so we can
+    // stall for about that long to batch up requests.
+    mBatchWindow = 0.1f;
+
     sHttpRequest = LLCore::HttpRequest::ptr_t(new LLCore::HttpRequest());
     sHttpHeaders = LLCore::HttpHeaders::ptr_t(new LLCore::HttpHeaders());
     sHttpOptions = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions());
@@ -130,8 +161,25 @@ LLAvatarNameCache::~LLAvatarNameCache()
     sHttpHeaders.reset();
     sHttpOptions.reset();
     mCache.clear();
+
+    for (BatchRequest* request : mBatchRequests)
+    {
+        delete request;
+    }
+    mBatchRequests.clear();
 }
 
+// Holds name signals back while a response is applied, and releases them
+// even if applying it throws.
+class LLDeferNameSignals
+{
+public:
+	LLDeferNameSignals(bool& defer) : mDefer(defer) { mDefer = true; }
+	~LLDeferNameSignals() { mDefer = false; }
+private:
+	bool& mDefer;
+};
+
 void LLAvatarNameCache::requestAvatarNameCache_(std::string url, std::vector<LLUUID> agentIds)
 {
     LL_DEBUGS("AvNameCache") << "Entering coroutine " << LLCoros::getName()
@@ -151,8 +199,13 @@ void LLAvatarNameCache::requestAvatarNameCache_(std::string url, std::vector<LLU
     {
 
         LLCoreHttpUtil::HttpCoroutineAdapter httpAdapter("NameCache", sHttpPolicy);
+        LLTimer round_trip;
         LLSD results = httpAdapter.getAndSuspend(sHttpRequest, url);
 
+        F64 latency = round_trip.getElapsedTimeF64();
+        sample(sNameBatchLatency, F64Seconds(latency));
+        add_to_histogram(sNameBatchLatencyHistogram, latency, 0.05);
+
         LL_DEBUGS() << results << LL_ENDL;
 
         if (!results.isMap())
@@ -181,19 +234,25 @@ void LLAvatarNameCache::requestAvatarNameCache_(std::string url, std::vector<LLU
 
         if (LLAvatarNameCache::instanceExists())
         {
-            if (!success)
-            {   // on any sort of failure add dummy records for any agent IDs 
-                // in this request that we do not have cached already
-                std::vector<LLUUID>::const_iterator it = agentIds.begin();
-                for (; it != agentIds.end(); ++it)
+            LLAvatarNameCache* cache = LLAvatarNameCache::getInstance();
+            {
+                LLDeferNameSignals defer(cache->mDeferSignals);
+                if (!success)
+                {   // on any sort of failure add dummy records for any agent IDs 
+                    // in this request that we do not have cached already
+                    std::vector<LLUUID>::const_iterator it = agentIds.begin();
+                    for (; it != agentIds.end(); ++it)
+                    {
+                        const LLUUID& agent_id = *it;
+                        cache->handleAgentError(agent_id);
+                    }
+                }
+                else
                 {
-                    const LLUUID& agent_id = *it;
-                    LLAvatarNameCache::getInstance()->handleAgentError(agent_id);
+                    cache->handleAvNameCacheSuccess(results, httpResults);
                 }
-                return;
             }
-
-            LLAvatarNameCache::getInstance()->handleAvNameCacheSuccess(results, httpResults);
+            cache->deliverResolved();
         }
     }
     catch (const LLCoros::Stop&)
@@ -270,8 +329,8 @@ void LLAvatarNameCache::handleAvNameCacheSuccess(const LLSD &data, const LLSD &h
 // Provide some fallback for agents that return errors
 void LLAvatarNameCache::handleAgentError(const LLUUID& agent_id)
 {
-	std::map<LLUUID,LLAvatarName>::iterator existing = mCache.find(agent_id);
-	if (existing == mCache.end())
+	LLAvatarName* existing = findName(agent_id);
+	if (!existing)
     {
         // there is no existing cache entry, so make a temporary name from legacy
         LL_DEBUGS("AvNameCache") << "LLAvatarNameCache get legacy for agent "
@@ -287,12 +346,15 @@ void LLAvatarNameCache::handleAgentError(const LLUUID& agent_id)
         // Clear this agent from the pending list
         LLAvatarNameCache::mPendingQueue.erase(agent_id);
 
-        LLAvatarName& av_name = existing->second;
+        LLAvatarName& av_name = *existing;
         LL_DEBUGS("AvNameCache") << "LLAvatarNameCache use cache for agent " << agent_id << LL_ENDL;
 		av_name.dump();
 
 		 // Reset expiry time so we don't constantly rerequest.
 		av_name.setExpires(TEMP_CACHE_ENTRY_LIFETIME);
+
+		// getNames() callers take what there is
+		mResolvedIds.push_back(agent_id);
     }
 }
 
@@ -305,9 +367,9 @@ void LLAvatarNameCache::processName(const LLUUID& agent_id, const LLAvatarName&
 
     bool updated_account = true; // assume obsolete value for new arrivals by default
 
-    std::map<LLUUID, LLAvatarName>::iterator it = mCache.find(agent_id);
-    if (it != mCache.end()
-        && (*it).second.getAccountName() == av_name.getAccountName())
+    const LLAvatarName* existing = findName(agent_id);
+    if (existing
+        && existing->getAccountName() == av_name.getAccountName())
     {
         updated_account = false;
     }
@@ -324,6 +386,13 @@ void LLAvatarNameCache::processName(const LLUUID& agent_id, const LLAvatarName&
         mAccountNameChangedCallback(agent_id, av_name);
     }
 
+	mResolvedIds.push_back(agent_id);
+	if (mDeferSignals)
+	{
+		mDeferredIds.push_back(agent_id);
+		return;
+	}
+
 	// Signal everyone waiting on this name
 	signal_map_t::iterator sig_it =	mSignalMap.find(agent_id);
 	if (sig_it != mSignalMap.end())
@@ -336,21 +405,81 @@ void LLAvatarNameCache::processName(const LLUUID& agent_id, const LLAvatarName&
 		delete signal;
 		signal = NULL;
 	}
+}
+
+void LLAvatarNameCache::deliverResolved()
+{
+	// Callbacks may ask for more names; work on copies.
+	uuid_vec_t deferred_ids;
+	deferred_ids.swap(mDeferredIds);
+	for (const LLUUID& agent_id : deferred_ids)
+	{
+		signal_map_t::iterator sig_it = mSignalMap.find(agent_id);
+		const LLAvatarName* av_name = findName(agent_id);
+		if (sig_it != mSignalMap.end() && av_name)
+		{
+			callback_signal_t* signal = sig_it->second;
+			mSignalMap.erase(sig_it);
+			LLAvatarName name = *av_name;
+			(*signal)(agent_id, name);
+			delete signal;
+		}
+	}
+
+	// Even with nothing resolved, requests whose callers disconnected are
+	// reaped here.
+	if (mResolvedIds.empty() && mBatchRequests.empty())
+	{
+		return;
+	}
+	uuid_vec_t resolved_ids;
+	resolved_ids.swap(mResolvedIds);
 
+	std::vector<std::pair<BatchRequest*, uuid_vec_t> > deliveries;
+	std::vector<BatchRequest*> finished;
+	for (batch_request_list_t::iterator it = mBatchRequests.begin(); it != mBatchRequests.end(); )
+	{
+		BatchRequest* request = *it;
+		uuid_vec_t ids;
+		if (!request->mSignal.empty())
+		{
+			for (const LLUUID& agent_id : resolved_ids)
+			{
+				if (request->mRemaining.erase(agent_id))
+				{
+					ids.push_back(agent_id);
+				}
+			}
+		}
+		if (!ids.empty())
+		{
+			deliveries.push_back(std::make_pair(request, ids));
+		}
+		if (request->mRemaining.empty() || request->mSignal.empty())
+		{
+			finished.push_back(request);
+			it = mBatchRequests.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
 
+	for (auto& delivery : deliveries)
+	{
+		delivery.first->mSignal(delivery.second);
+	}
+	for (BatchRequest* request : finished)
+	{
+		delete request;
+	}
 }
 
 void LLAvatarNameCache::requestNamesViaCapability()
 {
 	F64 now = LLFrameTimer::getTotalSeconds();
 
-	// URL format is like:
-	// http://pdp60.lindenlab.com:8000/agents/?ids=3941037e-78ab-45f0-b421-bd6e77c1804d&ids=0012809d-7d2d-4c24-9609-af1230a37715&ids=0019aaba-24af-4f0a-aa72-6457953cf7f0
-	//
-	// Apache can handle URLs of 4096 chars, but let's be conservative
-	static const U32 NAME_URL_MAX = 4096;
-	static const U32 NAME_URL_SEND_THRESHOLD = 3500;
-
 	std::string url;
 	url.reserve(NAME_URL_MAX);
 
@@ -365,6 +494,17 @@ void LLAvatarNameCache::requestNamesViaCapability()
 		LLUUID agent_id = *it;
 		mAskQueue.erase(it);
 
+		// Another request may have answered it while it was queued.
+		if (isRequestPending(agent_id))
+		{
+			continue;
+		}
+		const LLAvatarName* cached = findName(agent_id);
+		if (cached && cached->mExpires > now && !mSignalMap.count(agent_id))
+		{
+			continue;
+		}
+
 		if (url.empty())
 		{
 			// ...starting new request
@@ -393,6 +533,8 @@ void LLAvatarNameCache::requestNamesViaCapability()
     if (!url.empty())
     {
         LL_DEBUGS("AvNameCache") << "requested " << ids << " ids" << LL_ENDL;
+        sample(sNameBatchSize, (F64)ids);
+        add_to_histogram(sNameBatchSizeHistogram, (F64)ids, 2.0);
 
         std::string coroname = 
             LLCoros::instance().launch("LLAvatarNameCache::requestAvatarNameCache_",
@@ -457,6 +599,15 @@ void LLAvatarNameCache::requestNamesViaLegacy()
 	}
 }
 
+void LLAvatarNameCache::queueRequest(const LLUUID& agent_id)
+{
+	if (mAskQueue.empty())
+	{
+		mAskQueueStart = LLFrameTimer::getTotalSeconds();
+	}
+	mAskQueue.insert(agent_id);
+}
+
 bool LLAvatarNameCache::importFile(std::istream& istr)
 {
 	LLSD data;
@@ -510,6 +661,133 @@ void LLAvatarNameCache::exportFile(std::ostream& ostr)
 	LLSDSerialize::toPrettyXML(data, ostr);
 }
 
+// LLNameCacheFile entry layout
+static const U32 CACHE_FLAG_DISPLAY_NAME_DEFAULT = 1;
+enum { CACHE_USERNAME, CACHE_DISPLAY_NAME, CACHE_LEGACY_FIRST_NAME, CACHE_LEGACY_LAST_NAME };
+
+bool LLAvatarNameCache::openCacheFile(const std::string& filename)
+{
+	// same cut-off as eraseUnrefreshed()
+	return mCacheFile.open(filename, LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME);
+}
+
+// static
+bool LLAvatarNameCache::toCacheEntry(const LLUUID& agent_id, const LLAvatarName& av_name, F64 max_unrefreshed, LLNameCacheFile::Entry& entry)
+{
+	// Same filter as exportFile()
+	if (!av_name.isValidName(max_unrefreshed))
+	{
+		return false;
+	}
+
+	entry.mID = agent_id;
+	entry.mTime = av_name.mExpires;
+	entry.mNextUpdate = av_name.mNextUpdate;
+	entry.mFlags = av_name.mIsDisplayNameDefault ? CACHE_FLAG_DISPLAY_NAME_DEFAULT : 0;
+	entry.mStrings[CACHE_USERNAME] = av_name.mUsername;
+	entry.mStrings[CACHE_DISPLAY_NAME] = av_name.mDisplayName;
+	entry.mStrings[CACHE_LEGACY_FIRST_NAME] = av_name.mLegacyFirstName;
+	entry.mStrings[CACHE_LEGACY_LAST_NAME] = av_name.mLegacyLastName;
+	return true;
+}
+
+LLAvatarName* LLAvatarNameCache::findName(const LLUUID& agent_id)
+{
+	cache_t::iterator it = mCache.find(agent_id);
+	if (it != mCache.end())
+	{
+		return &it->second;
+	}
+
+	LLNameCacheFile::Entry entry;
+	if (!mCacheFile.find(agent_id, entry))
+	{
+		return NULL;
+	}
+
+	// eraseUnrefreshed() would have dropped it right after an import
+	if (entry.mTime < LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME)
+	{
+		return NULL;
+	}
+
+	LLAvatarName& av_name = mCache[agent_id];
+	av_name.mExpires = entry.mTime;
+	av_name.mNextUpdate = entry.mNextUpdate;
+	av_name.mIsDisplayNameDefault = (entry.mFlags & CACHE_FLAG_DISPLAY_NAME_DEFAULT) != 0;
+	av_name.mIsTemporaryName = false;
+	av_name.mUsername = entry.mStrings[CACHE_USERNAME];
+	av_name.mDisplayName = entry.mStrings[CACHE_DISPLAY_NAME];
+	av_name.mLegacyFirstName = entry.mStrings[CACHE_LEGACY_FIRST_NAME];
+	av_name.mLegacyLastName = entry.mStrings[CACHE_LEGACY_LAST_NAME];
+	return &av_name;
+}
+
+void LLAvatarNameCache::loadAllFromCacheFile()
+{
+	if (mCacheFile.size() == 0)
+	{
+		return;
+	}
+
+	std::vector<LLUUID> ids;
+	mCacheFile.getIDs(ids);
+	for (const LLUUID& id : ids)
+	{
+		findName(id);
+	}
+}
+
+void LLAvatarNameCache::saveCacheFile()
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	F64 max_unrefreshed = LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME;
+	LLNameCacheFile::Entry entry;
+	// names promoted from the file are in both, count them once
+	size_t live_count = mCacheFile.size();
+	for (cache_t::const_iterator it = mCache.begin(); it != mCache.end(); ++it)
+	{
+		if (!mCacheFile.contains(it->first))
+		{
+			++live_count;
+		}
+	}
+	if (!mCacheFile.needsRewrite(live_count))
+	{
+		// Append whatever differs from the mapped file.
+		LLNameCacheFile::Entry cached;
+		for (cache_t::const_iterator it = mCache.begin(); it != mCache.end(); ++it)
+		{
+			if (!toCacheEntry(it->first, it->second, max_unrefreshed, entry))
+			{
+				mCacheFile.remove(it->first);
+			}
+			else if (!mCacheFile.find(it->first, cached) || !(cached == entry))
+			{
+				mCacheFile.append(entry);
+			}
+		}
+		if (mCacheFile.flush())
+		{
+			return;
+		}
+	}
+
+	loadAllFromCacheFile();
+	std::vector<LLNameCacheFile::Entry> entries;
+	entries.reserve(mCache.size());
+	for (cache_t::const_iterator it = mCache.begin(); it != mCache.end(); ++it)
+	{
+		if (toCacheEntry(it->first, it->second, max_unrefreshed, entry))
+		{
+			entries.push_back(entry);
+		}
+	}
+	LL_INFOS("AvNameCache") << "LLAvatarNameCache rewriting cache file with " << entries.size() << " names" << LL_ENDL;
+	mCacheFile.rewrite(entries);
+}
+
 void LLAvatarNameCache::setNameLookupURL(const std::string& name_lookup_url)
 {
 	mNameLookupURL = name_lookup_url;
@@ -535,16 +813,15 @@ void LLAvatarNameCache::idle()
 	// By convention, start running at first idle() call
 	mRunning = true;
 
-	// *TODO: Possibly re-enabled this based on People API load measurements
-	// 100 ms is the threshold for "user speed" operations, so we can
-	// stall for about that long to batch up requests.
-	const F32 SECS_BETWEEN_REQUESTS = 0.1f;
-	if (!sRequestTimer.hasExpired())
-	{
-		return;
-	}
+	// Names that arrived outside of a capability response, e.g. through
+	// the legacy system.
+	deliverResolved();
 
-	if (!mAskQueue.empty())
+	// Hold the queue open for the batch window after its first id, unless
+	// it already has enough to fill a request.
+	if (!mAskQueue.empty()
+		&& (mAskQueue.size() >= NAME_IDS_PER_REQUEST
+			|| LLFrameTimer::getTotalSeconds() - mAskQueueStart >= mBatchWindow))
 	{
         if (usePeopleAPI())
         {
@@ -557,12 +834,6 @@ void LLAvatarNameCache::idle()
         }
 	}
 
-	if (mAskQueue.empty())
-	{
-		// cleared the list, reset the request timer.
-		sRequestTimer.resetWithExpiry(SECS_BETWEEN_REQUESTS);
-	}
-
     // erase anything that has not been refreshed for more than MAX_UNREFRESHED_TIME
     eraseUnrefreshed();
 }
@@ -590,6 +861,8 @@ void LLAvatarNameCache::eraseUnrefreshed()
     if (!mLastExpireCheck || mLastExpireCheck < max_unrefreshed)
     {
         mLastExpireCheck = now;
+        // names never asked for this session only live in the file
+        mCacheFile.expire(max_unrefreshed);
         S32 expired = 0;
         for (cache_t::iterator it = mCache.begin(); it != mCache.end();)
         {
@@ -600,6 +873,7 @@ void LLAvatarNameCache::eraseUnrefreshed()
                                          << " user '" << av_name.getAccountName() << "' "
                                          << "expired " << now - av_name.mExpires << " secs ago"
                                          << LL_ENDL;
+                mCacheFile.remove(it->first);
                 mCache.erase(it++);
                 expired++;
             }
@@ -625,10 +899,10 @@ bool LLAvatarNameCache::getName(const LLUUID& agent_id, LLAvatarName *av_name)
 	if (mRunning)
 	{
 		// ...only do immediate lookups when cache is running
-		std::map<LLUUID,LLAvatarName>::iterator it = mCache.find(agent_id);
-		if (it != mCache.end())
+		const LLAvatarName* cached = findName(agent_id);
+		if (cached)
 		{
-			*av_name = it->second;
+			*av_name = *cached;
 
 			// re-request name if entry is expired
 			if (av_name->mExpires < LLFrameTimer::getTotalSeconds())
@@ -637,7 +911,7 @@ bool LLAvatarNameCache::getName(const LLUUID& agent_id, LLAvatarName *av_name)
 				{
 					LL_DEBUGS("AvNameCache") << "LLAvatarNameCache refresh agent " << agent_id
 											 << LL_ENDL;
-					mAskQueue.insert(agent_id);
+					queueRequest(agent_id);
 				}
 			}
 				
@@ -648,7 +922,7 @@ bool LLAvatarNameCache::getName(const LLUUID& agent_id, LLAvatarName *av_name)
 	if (!isRequestPending(agent_id))
 	{
 		LL_DEBUGS("AvNameCache") << "LLAvatarNameCache queue request for agent " << agent_id << LL_ENDL;
-		mAskQueue.insert(agent_id);
+		queueRequest(agent_id);
 	}
 
 	return false;
@@ -676,10 +950,10 @@ LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNameCallback(cons
 	if (mRunning)
 	{
 		// ...only do immediate lookups when cache is running
-		std::map<LLUUID,LLAvatarName>::iterator it = mCache.find(agent_id);
-		if (it != mCache.end())
+		const LLAvatarName* cached = findName(agent_id);
+		if (cached)
 		{
-			const LLAvatarName& av_name = it->second;
+			const LLAvatarName& av_name = *cached;
 			
 			if (av_name.mExpires > LLFrameTimer::getTotalSeconds())
 			{
@@ -693,7 +967,7 @@ LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNameCallback(cons
 	// schedule a request
 	if (!isRequestPending(agent_id))
 	{
-		mAskQueue.insert(agent_id);
+		queueRequest(agent_id);
 	}
 
 	// always store additional callback, even if request is pending
@@ -715,6 +989,58 @@ LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNameCallback(cons
 	return connection;
 }
 
+// static, wrapper
+LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNames(const uuid_vec_t& agent_ids, batch_callback_slot_t slot)
+{
+	return LLAvatarNameCache::getInstance()->getNamesCallback(agent_ids, slot);
+}
+
+LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNamesCallback(const uuid_vec_t& agent_ids, batch_callback_slot_t slot)
+{
+	callback_connection_t connection;
+
+	F64 now = LLFrameTimer::getTotalSeconds();
+	uuid_set_t cached_ids;
+	BatchRequest* request = new BatchRequest();
+	for (const LLUUID& agent_id : agent_ids)
+	{
+		if (agent_id.isNull() || cached_ids.count(agent_id))
+		{
+			continue;
+		}
+
+		const LLAvatarName* cached = mRunning ? findName(agent_id) : NULL;
+		if (cached && cached->mExpires > now)
+		{
+			cached_ids.insert(agent_id);
+			continue;
+		}
+
+		// ids wanted by several callers are only requested once
+		if (request->mRemaining.insert(agent_id).second && !isRequestPending(agent_id))
+		{
+			queueRequest(agent_id);
+		}
+	}
+
+	if (!cached_ids.empty())
+	{
+		batch_callback_signal_t signal;
+		signal.connect(slot);
+		signal(uuid_vec_t(cached_ids.begin(), cached_ids.end()));
+	}
+
+	if (request->mRemaining.empty())
+	{
+		delete request;
+		return connection;
+	}
+
+	connection = request->mSignal.connect(slot);
+	mBatchRequests.push_back(request);
+	return connection;
+}
+
 
 void LLAvatarNameCache::setUseDisplayNames(bool use)
 {
@@ -737,6 +1063,7 @@ void LLAvatarNameCache::setUseUsernames(bool use)
 void LLAvatarNameCache::erase(const LLUUID& agent_id)
 {
 	mCache.erase(agent_id);
+	mCacheFile.remove(agent_id);
 }
 
 void LLAvatarNameCache::insert(const LLUUID& agent_id, const LLAvatarName& av_name)
@@ -747,6 +1074,8 @@ void LLAvatarNameCache::insert(const LLUUID& agent_id, const LLAvatarName& av_na
 
 LLUUID LLAvatarNameCache::findIdByName(const std::string& name)
 {
+    loadAllFromCacheFile();
+
     std::map<LLUUID, LLAvatarName>::iterator it;
     std::map<LLUUID, LLAvatarName>::iterator end = mCache.end();
     for (it = mCache.begin(); it != end; ++it)
@@ -862,6 +1191,18 @@ void LLAvatarNameCache::addUseDisplayNamesCallback(const use_display_name_signal
 	mUseDisplayNamesSignal.connect(cb); 
 }
 
+LLSD LLAvatarNameCache::getBatchStats() const
+{
+	LLSD stats;
+	for (S32 i = 0; i < NAME_HISTOGRAM_BUCKETS; ++i)
+	{
+		stats["ids_per_request"].append((LLSD::Integer)sNameBatchSizeHistogram[i]);
+		stats["round_trip"].append((LLSD::Integer)sNameBatchLatencyHistogram[i]);
+	}
+	stats["pending_batches"] = (LLSD::Integer)mBatchRequests.size();
+	return stats;
+}
+
 
 static const std::string MAX_AGE("max-age");
 static const boost::char_separator<char> EQUALS_SEPARATOR("=");
@@ -29,8 +29,10 @@
 #define LLAVATARNAMECACHE_H
 
 #include "llavatarname.h"	// for convenience
+#include "llnamecachefile.h"
 #include "llsingleton.h"
 #include <boost/signals2.hpp>
+#include <list>
 #include <set>
 
 class LLSD;
@@ -48,6 +50,13 @@ public:
 	bool importFile(std::istream& istr);
 	void exportFile(std::ostream& ostr);
 
+	// Binary cache file, see LLNameCacheFile.  Names are read from the
+	// mapped file when first asked for rather than all at login, and saving
+	// only appends the ones that changed.  openCacheFile() returns false if
+	// there is no usable file; saveCacheFile() then creates it.
+	bool openCacheFile(const std::string& filename);
+	void saveCacheFile();
+
 	// On the viewer, usually a simulator capabilities.
 	// If empty, name cache will fall back to using legacy name lookup system.
 	void setNameLookupURL(const std::string& name_lookup_url);
@@ -62,6 +71,10 @@ public:
 	// cache. Called once per frame.
 	void idle();
 
+	// Ids asked for within this many seconds of each other, by any number
+	// of callers, are sent in the same request.
+	void setBatchWindow(F32 seconds) { mBatchWindow = seconds; }
+
 	// If name is in cache, returns true and fills in provided LLAvatarName
 	// otherwise returns false.
 	static bool get(const LLUUID& agent_id, LLAvatarName *av_name);
@@ -79,6 +92,19 @@ public:
 	static callback_connection_t get(const LLUUID& agent_id, callback_slot_t slot);
 	callback_connection_t getNameCallback(const LLUUID& agent_id, callback_slot_t slot);
 
+	// Callback type for getNames() below, given the ids whose names have
+	// arrived since the last call.
+	typedef boost::signals2::signal<
+		void (const uuid_vec_t& agent_ids)>
+			batch_callback_signal_t;
+	typedef batch_callback_signal_t::slot_type batch_callback_slot_t;
+
+	// Fetches names for many ids at once.  Rather than one call per id, the
+	// slot is called once with the ids already in cache, then once per batch
+	// of responses, and is dropped when every id has been delivered.
+	static callback_connection_t getNames(const uuid_vec_t& agent_ids, batch_callback_slot_t slot);
+	callback_connection_t getNamesCallback(const uuid_vec_t& agent_ids, batch_callback_slot_t slot);
+
 	// Set display name: flips the switch and triggers the callbacks.
 	void setUseDisplayNames(bool use);
 	
@@ -104,6 +130,10 @@ public:
 
 	void addUseDisplayNamesCallback(const use_display_name_signal_t::slot_type& cb);
 
+	// Histograms of ids per request and of request round trips, for the
+	// viewer stats report.
+	LLSD getBatchStats() const;
+
     void setAccountNameChangedCallback(const account_name_changed_callback_t& cb) { mAccountNameChangedCallback = cb; }
 
 private:
@@ -123,6 +153,13 @@ private:
 
     void requestNamesViaLegacy();
 
+    // Add to mAskQueue, opening a batch window if it was empty.
+    void queueRequest(const LLUUID& agent_id);
+
+    // Fire the signals held back while a response was processed, then
+    // hand everything resolved since the last call to getNames() callers.
+    void deliverResolved();
+
     // Do a single callback to a given slot
     void fireSignal(const LLUUID& agent_id,
         const callback_slot_t& slot,
@@ -134,6 +171,11 @@ private:
     // Erase expired names from cache
     void eraseUnrefreshed();
 
+    // mCache lookup that falls back to mCacheFile; NULL if unknown.
+    LLAvatarName* findName(const LLUUID& agent_id);
+    void loadAllFromCacheFile();
+    static bool toCacheEntry(const LLUUID& agent_id, const LLAvatarName& av_name, F64 max_unrefreshed, LLNameCacheFile::Entry& entry);
+
     bool expirationFromCacheControl(const LLSD& headers, F64 *expires);
 
     // This is a coroutine.
@@ -180,8 +222,32 @@ private:
     typedef std::map<LLUUID, LLAvatarName> cache_t;
     cache_t mCache;
 
+    // Many-id requests from getNames(), and the ids resolved since they
+    // were last called.
+    struct BatchRequest
+    {
+        batch_callback_signal_t mSignal;
+        uuid_set_t mRemaining;
+    };
+    typedef std::list<BatchRequest*> batch_request_list_t;
+    batch_request_list_t mBatchRequests;
+    uuid_vec_t mResolvedIds;
+
+    // While a response is processed, per-id signals wait in mDeferredIds
+    // so that they all fire after the cache holds the whole batch.
+    bool mDeferSignals;
+    uuid_vec_t mDeferredIds;
+
+    // Frame time the oldest id in mAskQueue was added, and how long it
+    // may wait for company.
+    F64 mAskQueueStart;
+    F32 mBatchWindow;
+
     // Time when unrefreshed cached names were checked last.
     F64 mLastExpireCheck;
+
+    // Names saved by earlier sessions, moved to mCache when first used.
+    LLNameCacheFile mCacheFile;
 };
 
 // Parse a cache-control header to get the max-age delta-seconds.
@@ -32,6 +32,7 @@
 #include "lldbstrings.h"
 #include "llframetimer.h"
 #include "llhost.h"
+#include "llnamecachefile.h"
 #include "llrand.h"
 #include "llsdserialize.h"
 #include "lluuid.h"
@@ -51,6 +52,13 @@ static const std::string NAME("name");
 // We won't re-request a name during this time
 const U32 PENDING_TIMEOUT_SECS = 5 * 60;
 
+// Names older than this are not read back from the disk cache.
+const U32 CACHE_ENTRY_LIFETIME_SECS = 7 * 60 * 60 * 24;
+
+// LLNameCacheFile entry layout
+const U32 CACHE_FLAG_GROUP = 1;
+enum { CACHE_FIRST_NAME, CACHE_LAST_NAME, CACHE_GROUP_NAME };
+
 // Globals
 LLCacheName* gCacheName = NULL;
 std::map<std::string, std::string> LLCacheName::sCacheName;
@@ -197,6 +205,11 @@ public:
 		// the map of UUIDs to names
 	ReverseCache   	  	mReverseCache;
 		// map of names to UUIDs
+
+	LLNameCacheFile		mCacheFile;
+		// names saved by earlier sessions, moved to mCache when first used
+	bool				mCacheFileLoaded;
+		// true once everything in mCacheFile is in mCache
 	
 	AskQueue			mAskNameQueue;
 	AskQueue			mAskGroupQueue;
@@ -217,6 +230,10 @@ public:
 
 	BOOL getName(const LLUUID& id, std::string& first, std::string& last);
 
+	// mCache lookup that falls back to mCacheFile.
+	LLCacheNameEntry* findEntry(const LLUUID& id);
+	void loadAllFromCacheFile();
+
 	boost::signals2::connection addPending(const LLUUID& id, const LLCacheNameCallback& callback);
 	void addPending(const LLUUID& id, const LLHost& host);
 	
@@ -259,7 +276,7 @@ LLCacheName::~LLCacheName()
 }
 
 LLCacheName::Impl::Impl(LLMessageSystem* msg)
-	: mMsg(msg), mUpstreamHost(LLHost())
+	: mMsg(msg), mUpstreamHost(LLHost()), mCacheFileLoaded(false)
 {
 	mMsg->setHandlerFuncFast(
 		_PREHASH_UUIDNameRequest, handleUUIDNameRequest, (void**)this);
@@ -401,6 +418,139 @@ void LLCacheName::exportFile(std::ostream& ostr)
 	LLSDSerialize::toPrettyXML(data, ostr);
 }
 
+LLCacheNameEntry* LLCacheName::Impl::findEntry(const LLUUID& id)
+{
+	LLCacheNameEntry* entry = get_ptr_in_map(mCache, id);
+	if (entry)
+	{
+		return entry;
+	}
+
+	LLNameCacheFile::Entry cached;
+	if (!mCacheFile.find(id, cached))
+	{
+		return NULL;
+	}
+
+	// same cut-off importFile() applies
+	U32 ctime = (U32)cached.mTime;
+	if (ctime < (U32)time(NULL) - CACHE_ENTRY_LIFETIME_SECS)
+	{
+		return NULL;
+	}
+
+	entry = new LLCacheNameEntry();
+	entry->mIsGroup = (cached.mFlags & CACHE_FLAG_GROUP) != 0;
+	entry->mCreateTime = ctime;
+	entry->mFirstName = cached.mStrings[CACHE_FIRST_NAME];
+	entry->mLastName = cached.mStrings[CACHE_LAST_NAME];
+	entry->mGroupName = cached.mStrings[CACHE_GROUP_NAME];
+	mCache[id] = entry;
+	if (entry->mIsGroup)
+	{
+		mReverseCache[entry->mGroupName] = id;
+	}
+	else
+	{
+		mReverseCache[buildFullName(entry->mFirstName, entry->mLastName)] = id;
+	}
+	return entry;
+}
+
+void LLCacheName::Impl::loadAllFromCacheFile()
+{
+	if (mCacheFileLoaded)
+	{
+		return;
+	}
+	mCacheFileLoaded = true;
+
+	std::vector<LLUUID> ids;
+	mCacheFile.getIDs(ids);
+	for (const LLUUID& id : ids)
+	{
+		findEntry(id);
+	}
+}
+
+bool LLCacheName::openCacheFile(const std::string& filename)
+{
+	impl.mCacheFileLoaded = false;
+	// same cut-off as findEntry()
+	return impl.mCacheFile.open(filename, (F64)((U32)time(NULL) - CACHE_ENTRY_LIFETIME_SECS));
+}
+
+// Fills entry from name; false if name should not be stored, using the
+// same filter as exportFile().
+static bool to_cache_entry(const LLUUID& id, const LLCacheNameEntry* name, LLNameCacheFile::Entry& entry)
+{
+	if (!name
+		|| std::string::npos != name->mFirstName.find('?')
+		|| std::string::npos != name->mGroupName.find('?')
+		|| !((!name->mFirstName.empty() && !name->mLastName.empty())
+			 || (name->mIsGroup && !name->mGroupName.empty())))
+	{
+		return false;
+	}
+
+	entry.mID = id;
+	entry.mTime = name->mCreateTime;
+	entry.mFlags = name->mIsGroup ? CACHE_FLAG_GROUP : 0;
+	entry.mStrings[CACHE_FIRST_NAME] = name->mFirstName;
+	entry.mStrings[CACHE_LAST_NAME] = name->mLastName;
+	entry.mStrings[CACHE_GROUP_NAME] = name->mGroupName;
+	return true;
+}
+
+void LLCacheName::saveCacheFile()
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	LLNameCacheFile& file = impl.mCacheFile;
+	LLNameCacheFile::Entry entry;
+	// names promoted from the file are in both, count them once
+	size_t live_count = file.size();
+	for (Cache::iterator iter = impl.mCache.begin(); iter != impl.mCache.end(); ++iter)
+	{
+		if (!file.contains(iter->first))
+		{
+			++live_count;
+		}
+	}
+	if (!file.needsRewrite(live_count))
+	{
+		// Append whatever differs from the mapped file.
+		LLNameCacheFile::Entry cached;
+		for (Cache::iterator iter = impl.mCache.begin(); iter != impl.mCache.end(); ++iter)
+		{
+			if (!to_cache_entry(iter->first, iter->second, entry))
+			{
+				file.remove(iter->first);
+			}
+			else if (!file.find(iter->first, cached) || !(cached == entry))
+			{
+				file.append(entry);
+			}
+		}
+		if (file.flush())
+		{
+			return;
+		}
+	}
+
+	impl.loadAllFromCacheFile();
+	std::vector<LLNameCacheFile::Entry> entries;
+	entries.reserve(impl.mCache.size());
+	for (Cache::iterator iter = impl.mCache.begin(); iter != impl.mCache.end(); ++iter)
+	{
+		if (to_cache_entry(iter->first, iter->second, entry))
+		{
+			entries.push_back(entry);
+		}
+	}
+	file.rewrite(entries);
+}
+
 
 BOOL LLCacheName::Impl::getName(const LLUUID& id, std::string& first, std::string& last)
 {
@@ -411,7 +561,7 @@ BOOL LLCacheName::Impl::getName(const LLUUID& id, std::string& first, std::strin
 		return TRUE;
 	}
 
-	LLCacheNameEntry* entry = get_ptr_in_map(mCache, id );
+	LLCacheNameEntry* entry = findEntry(id);
 	if (entry)
 	{
 		first = entry->mFirstName;
@@ -458,7 +608,7 @@ BOOL LLCacheName::getGroupName(const LLUUID& id, std::string& group)
 		return TRUE;
 	}
 
-	LLCacheNameEntry* entry = get_ptr_in_map(impl.mCache,id);
+	LLCacheNameEntry* entry = impl.findEntry(id);
 	if (entry && entry->mGroupName.empty())
 	{
 		// COUNTER-HACK to combat James' HACK in exportFile()...
@@ -493,6 +643,12 @@ BOOL LLCacheName::getUUID(const std::string& first, const std::string& last, LLU
 BOOL LLCacheName::getUUID(const std::string& full_name, LLUUID& id)
 {
 	ReverseCache::iterator iter = impl.mReverseCache.find(full_name);
+	if (iter == impl.mReverseCache.end() && !impl.mCacheFileLoaded)
+	{
+		// Reverse lookups are rare; pull in the rest of the cache file.
+		impl.loadAllFromCacheFile();
+		iter = impl.mReverseCache.find(full_name);
+	}
 	if (iter != impl.mReverseCache.end())
 	{
 		id = iter->second;
@@ -618,7 +774,7 @@ boost::signals2::connection LLCacheName::get(const LLUUID& id, bool is_group, co
 		return res;
 	}
 
-	LLCacheNameEntry* entry = get_ptr_in_map(impl.mCache, id );
+	LLCacheNameEntry* entry = impl.findEntry(id);
 	if (entry)
 	{
 		LLCacheNameSignal signal;
@@ -688,12 +844,15 @@ void LLCacheName::deleteEntriesOlderThan(S32 secs)
 {
 	U32 now = (U32)time(NULL);
 	U32 expire_time = now - secs;
+	// names never asked for this session only live in the file
+	impl.mCacheFile.expire((F64)expire_time);
 	for(Cache::iterator iter = impl.mCache.begin(); iter != impl.mCache.end(); )
 	{
 		Cache::iterator curiter = iter++;
 		LLCacheNameEntry* entry = curiter->second;
 		if (entry->mCreateTime < expire_time)
 		{
+			impl.mCacheFile.remove(curiter->first);
 			delete entry;
 			impl.mCache.erase(curiter);
 		}
@@ -756,6 +915,8 @@ void LLCacheName::clear()
 {
 	for_each(impl.mCache.begin(), impl.mCache.end(), DeletePairedPointer());
 	impl.mCache.clear();
+	// forget the cache file too; the next save rewrites it
+	impl.mCacheFile.close();
 }
 
 //static 
@@ -784,7 +945,7 @@ void LLCacheName::Impl::processPendingReplies()
 	for(ReplyQueue::iterator it = mReplyQueue.begin(); it != mReplyQueue.end(); ++it)
 	{
 		PendingReply* reply = *it;
-		LLCacheNameEntry* entry = get_ptr_in_map(mCache, reply->mID);
+		LLCacheNameEntry* entry = findEntry(reply->mID);
 		if(!entry) continue;
 
 		if (!entry->mIsGroup)
@@ -804,7 +965,7 @@ void LLCacheName::Impl::processPendingReplies()
 	for(ReplyQueue::iterator it = mReplyQueue.begin(); it != mReplyQueue.end(); ++it)
 	{
 		PendingReply* reply = *it;
-		LLCacheNameEntry* entry = get_ptr_in_map(mCache, reply->mID);
+		LLCacheNameEntry* entry = findEntry(reply->mID);
 		if(!entry) continue;
 
 		if (reply->mHost.isOk())
@@ -897,7 +1058,7 @@ void LLCacheName::Impl::processUUIDRequest(LLMessageSystem* msg, bool isGroup)
 	{
 		LLUUID id;
 		msg->getUUIDFast(_PREHASH_UUIDNameBlock, _PREHASH_ID, id, i);
-		LLCacheNameEntry* entry = get_ptr_in_map(mCache, id);
+		LLCacheNameEntry* entry = findEntry(id);
 		if(entry)
 		{
 			if (isGroup != entry->mIsGroup)
@@ -942,7 +1103,7 @@ void LLCacheName::Impl::processUUIDReply(LLMessageSystem* msg, bool isGroup)
 	{
 		LLUUID id;
 		msg->getUUIDFast(_PREHASH_UUIDNameBlock, _PREHASH_ID, id, i);
-		LLCacheNameEntry* entry = get_ptr_in_map(mCache, id);
+		LLCacheNameEntry* entry = findEntry(id);
 		if (!entry)
 		{
 			entry = new LLCacheNameEntry;
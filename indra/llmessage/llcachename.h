@@ -68,6 +68,13 @@ public:
 	bool importFile(std::istream& istr);
 	void exportFile(std::ostream& ostr);
 
+	// Binary cache file, see LLNameCacheFile.  Names are read from the
+	// mapped file when first asked for rather than all at startup, and
+	// saving only appends the ones that changed.  openCacheFile() returns
+	// false if there is no usable file; saveCacheFile() then creates it.
+	bool openCacheFile(const std::string& filename);
+	void saveCacheFile();
+
 	// If available, copies name ("bobsmith123" or "James Linden") into string
 	// If not available, copies the string "waiting".
 	// Returns TRUE iff available.
@@ -36,6 +36,9 @@
 #include <boost/fiber/buffered_channel.hpp>
 
 #include "llexception.h"
+#include "llmutex.h"
+#include "lltimer.h"
+#include "lltrace.h"
 #include "stringize.h"
 
 //=========================================================================
@@ -52,13 +55,59 @@ static const U32 DEFAULT_POOL_SIZE = 5;
 // unlimited.
 const U32 LLCoprocedureManager::DEFAULT_QUEUE_SIZE = 1024*1024;
 
+// Queue bounds for known pools; "QueueSize<pool>" overrides them.
+static const std::map<std::string, U32> DefaultQueueSizes{
+    // AISAPI holds back anything over this until the queue drains.
+    {std::string("AIS"),     2048},
+};
+
+//=========================================================================
+// LLTrace stats have to exist before any recording starts, so they are
+// declared here for the pools the viewer creates; any other pool reports
+// as "Other".
+struct LLCoprocedureStats
+{
+    LLCoprocedureStats(const std::string &pool) :
+        mQueueTime(("coprocqueuetime" + pool).c_str(), ("Time coprocedures waited in the " + pool + " pool queue").c_str()),
+        mRunTime(("coprocruntime" + pool).c_str(), ("Time coprocedures ran in the " + pool + " pool").c_str()),
+        mPending(("coprocpending" + pool).c_str(), ("Coprocedures queued in the " + pool + " pool").c_str()),
+        mCompleted(("coproccompleted" + pool).c_str(), ("Coprocedures finished by the " + pool + " pool").c_str()),
+        mRejected(("coprocrejected" + pool).c_str(), ("Coprocedures refused by the full " + pool + " pool").c_str()),
+        mCancelled(("coproccancelled" + pool).c_str(), ("Coprocedures cancelled in the " + pool + " pool").c_str())
+    {}
+
+    LLTrace::SampleStatHandle<F64Seconds>   mQueueTime;
+    LLTrace::SampleStatHandle<F64Seconds>   mRunTime;
+    LLTrace::SampleStatHandle<>             mPending;
+    LLTrace::CountStatHandle<>              mCompleted;
+    LLTrace::CountStatHandle<>              mRejected;
+    LLTrace::CountStatHandle<>              mCancelled;
+};
+
+static LLCoprocedureStats sUploadStats("Upload");
+static LLCoprocedureStats sAISStats("AIS");
+static LLCoprocedureStats sAssetStorageStats("AssetStorage");
+static LLCoprocedureStats sExpCacheStats("ExpCache");
+static LLCoprocedureStats sOtherStats("Other");
+
+static LLCoprocedureStats& get_pool_stats(const std::string &pool)
+{
+    if (pool == "Upload") return sUploadStats;
+    if (pool == "AIS") return sAISStats;
+    if (pool == "AssetStorage") return sAssetStorageStats;
+    if (pool == "ExpCache") return sExpCacheStats;
+    return sOtherStats;
+}
+
 //=========================================================================
 class LLCoprocedurePool: private boost::noncopyable
 {
 public:
     typedef LLCoprocedureManager::CoProcedure_t CoProcedure_t;
 
-    LLCoprocedurePool(const std::string &name, size_t size);
+    typedef LLCoprocedureManager::EPriority EPriority;
+
+    LLCoprocedurePool(const std::string &name, size_t size, size_t capacity);
     ~LLCoprocedurePool();
 
     /// Places the coprocedure on the queue for processing. 
@@ -67,7 +116,16 @@ public:
     /// @param proc Is a bound function to be executed 
     /// 
     /// @return This method returns a UUID that can be used later to cancel execution.
-    LLUUID enqueueCoprocedure(const std::string &name, CoProcedure_t proc);
+    LLUUID enqueueCoprocedure(const std::string &name, CoProcedure_t proc, EPriority priority);
+
+    /// Removes a queued coprocedure, or cancels the HTTP operation of a
+    /// running one.  Returns false if the id is unknown to this pool.
+    bool cancelCoprocedure(const LLUUID &id);
+
+    inline bool hasCapacity() const
+    {
+        return mPending < mCapacity;
+    }
 
     /// Returns the number of coprocedures in the queue awaiting processing.
     ///
@@ -100,33 +158,56 @@ private:
         QueuedCoproc(const std::string &name, const LLUUID &id, CoProcedure_t proc) :
             mName(name),
             mId(id),
-            mProc(proc)
+            mProc(proc),
+            mEnqueueTime(LLTimer::getTotalSeconds())
         {}
 
         std::string mName;
         LLUUID mId;
         CoProcedure_t mProc;
+        F64 mEnqueueTime;
     };
 
+    // Pending coprocedures ordered by priority, then by arrival.
+    typedef std::pair<S32, U64> QueueKey_t;
+    typedef std::map<QueueKey_t, QueuedCoproc::ptr_t> PendingMap_t;
+
+    // Pops the next coprocedure to run, or an empty pointer if the one
+    // this wakeup was for got cancelled.
+    QueuedCoproc::ptr_t popPending();
+
+    // The channel carries one wakeup per enqueued coprocedure; the
+    // coprocedures themselves wait in mPendingMap so that they can be
+    // ordered and cancelled.
     // we use a buffered_channel here rather than unbuffered_channel since we want to be able to 
     // push values without blocking,even if there's currently no one calling a pop operation (due to
     // fiber running right now)
-    typedef boost::fibers::buffered_channel<QueuedCoproc::ptr_t>  CoprocQueue_t;
+    typedef boost::fibers::buffered_channel<bool>  CoprocQueue_t;
     // Use shared_ptr to control the lifespan of our CoprocQueue_t instance
     // because the consuming coroutine might outlive this LLCoprocedurePool
     // instance.
     typedef boost::shared_ptr<CoprocQueue_t> CoprocQueuePtr;
 
     std::string     mPoolName;
-    size_t          mPoolSize, mActiveCoprocsCount, mPending;
+    size_t          mPoolSize, mActiveCoprocsCount, mPending, mCapacity;
     CoprocQueuePtr  mPendingCoprocs;
     LLTempBoundListener mStatusListener;
 
+    LLMutex         mPendingMutex;
+    PendingMap_t    mPendingMap;
+    U64             mNextSequence;
+
     typedef std::map<std::string, LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t> CoroAdapterMap_t;
     LLCore::HttpRequest::policy_t mHTTPPolicy;
 
     CoroAdapterMap_t mCoroMapping;
 
+    // Adapters of the coprocedures running now, for cancelCoprocedure().
+    typedef std::map<LLUUID, LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t> ActiveMap_t;
+    ActiveMap_t     mActiveCoprocs;
+
+    LLCoprocedureStats &mStats;
+
     void coprocedureInvokerCoro(CoprocQueuePtr pendingCoprocs,
                                 LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter);
 };
@@ -180,7 +261,20 @@ void LLCoprocedureManager::initializePool(const std::string &poolName)
         LL_WARNS("CoProcMgr") << "LLCoprocedureManager: No setting for \"" << keyName << "\" setting pool size to default of " << size << LL_ENDL;
     }
 
-    poolPtr_t pool(new LLCoprocedurePool(poolName, size));
+    // Queue bound, only queried: most pools keep the unlimited default.
+    U32 capacity = 0;
+    if (mPropertyQueryFn)
+    {
+        capacity = mPropertyQueryFn("QueueSize" + poolName);
+    }
+    if (capacity == 0)
+    {
+        auto it = DefaultQueueSizes.find(poolName);
+        capacity = (it != DefaultQueueSizes.end()) ? it->second : DEFAULT_QUEUE_SIZE;
+    }
+    capacity = llmin(capacity, DEFAULT_QUEUE_SIZE);
+
+    poolPtr_t pool(new LLCoprocedurePool(poolName, size, capacity));
     LL_ERRS_IF(!pool, "CoprocedureManager") << "Unable to create pool named \"" << poolName << "\" FATAL!" << LL_ENDL;
 
     bool inserted = mPoolMap.emplace(poolName, pool).second;
@@ -188,7 +282,8 @@ void LLCoprocedureManager::initializePool(const std::string &poolName)
 }
 
 //-------------------------------------------------------------------------
-LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc)
+LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc,
+                                                EPriority priority)
 {
     // Attempt to find the pool and enqueue the procedure.  If the pool does 
     // not exist, create it.
@@ -202,7 +297,28 @@ LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const s
     }
 
     poolPtr_t targetPool = it->second;
-    return targetPool->enqueueCoprocedure(name, proc);
+    return targetPool->enqueueCoprocedure(name, proc, priority);
+}
+
+bool LLCoprocedureManager::cancelCoprocedure(const LLUUID &id)
+{
+    for (const auto& pair : mPoolMap)
+    {
+        if (pair.second->cancelCoprocedure(id))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LLCoprocedureManager::hasCapacity(const std::string &pool) const
+{
+    poolMap_t::const_iterator it = mPoolMap.find(pool);
+
+    if (it == mPoolMap.end())
+        return false;
+    return it->second->hasCapacity();
 }
 
 void LLCoprocedureManager::setPropertyMethods(SettingQuery_t queryfn, SettingUpdate_t updatefn)
@@ -296,14 +412,17 @@ void LLCoprocedureManager::close(const std::string &pool)
 }
 
 //=========================================================================
-LLCoprocedurePool::LLCoprocedurePool(const std::string &poolName, size_t size):
+LLCoprocedurePool::LLCoprocedurePool(const std::string &poolName, size_t size, size_t capacity):
     mPoolName(poolName),
     mPoolSize(size),
     mActiveCoprocsCount(0),
     mPending(0),
+    mCapacity(capacity),
     mPendingCoprocs(boost::make_shared<CoprocQueue_t>(LLCoprocedureManager::DEFAULT_QUEUE_SIZE)),
+    mNextSequence(0),
     mHTTPPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
-    mCoroMapping()
+    mCoroMapping(),
+    mStats(get_pool_stats(poolName))
 {
     try
     {
@@ -352,7 +471,7 @@ LLCoprocedurePool::LLCoprocedurePool(const std::string &poolName, size_t size):
         mCoroMapping.insert(CoroAdapterMap_t::value_type(pooledCoro, httpAdapter));
     }
 
-    LL_INFOS("CoProcMgr") << "Created coprocedure pool named \"" << mPoolName << "\" with " << size << " items, queue max " << LLCoprocedureManager::DEFAULT_QUEUE_SIZE << LL_ENDL;
+    LL_INFOS("CoProcMgr") << "Created coprocedure pool named \"" << mPoolName << "\" with " << size << " items, queue max " << mCapacity << LL_ENDL;
 }
 
 LLCoprocedurePool::~LLCoprocedurePool() 
@@ -360,8 +479,17 @@ LLCoprocedurePool::~LLCoprocedurePool()
 }
 
 //-------------------------------------------------------------------------
-LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoprocedurePool::CoProcedure_t proc)
+LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoprocedurePool::CoProcedure_t proc, EPriority priority)
 {
+    if (mPending >= mCapacity && priority != LLCoprocedureManager::PRIORITY_HIGH)
+    {
+        // Backpressure: callers check hasCapacity() and hold on to their work.
+        LL_WARNS("CoProcMgr") << "Refusing coprocedure '" << name << "' because pool \"" << mPoolName
+                              << "\" already has " << mPending << " pending" << LL_ENDL;
+        add(mStats.mRejected, 1);
+        return {};
+    }
+
     LLUUID id(LLUUID::generateNewID());
 
     if (mPoolName == "AIS")
@@ -384,13 +512,32 @@ LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoproced
         LL_INFOS("CoProcMgr") << "Coprocedure(" << name << ") enqueuing with id=" << id.asString() << " in pool \"" << mPoolName << "\" at "
                               << mPending << LL_ENDL;
     }
-    auto pushed = mPendingCoprocs->try_push(boost::make_shared<QueuedCoproc>(name, id, proc));
+    QueueKey_t key;
+    {
+        LLMutexLock lock(&mPendingMutex);
+        key = QueueKey_t((S32)priority, mNextSequence++);
+        mPendingMap.emplace(key, boost::make_shared<QueuedCoproc>(name, id, proc));
+    }
+    auto pushed = mPendingCoprocs->try_push(true);
     if (pushed == boost::fibers::channel_op_status::success)
     {
         ++mPending;
+        sample(mStats.mPending, (F64)mPending);
         return id;
     }
 
+    // No worker will come for it.
+    QueuedCoproc::ptr_t coproc;
+    {
+        LLMutexLock lock(&mPendingMutex);
+        PendingMap_t::iterator it = mPendingMap.find(key);
+        if (it != mPendingMap.end())
+        {
+            coproc = it->second;
+            mPendingMap.erase(it);
+        }
+    }
+
     // Here we didn't succeed in pushing. Shutdown could be the reason.
     if (pushed == boost::fibers::channel_op_status::closed)
     {
@@ -427,11 +574,11 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
         // - which tried to acquire the lock on pendingCoprocs... alas.
         // Using a fresh, clean ptr_t ensures that no previous value is
         // destroyed during pop_wait_for().
-        QueuedCoproc::ptr_t coproc;
+        bool wakeup;
         boost::fibers::channel_op_status status;
         {
             LLCoros::TempStatus st("waiting for work for 10s");
-            status = pendingCoprocs->pop_wait_for(coproc, std::chrono::seconds(10));
+            status = pendingCoprocs->pop_wait_for(wakeup, std::chrono::seconds(10));
         }
         if (status == boost::fibers::channel_op_status::closed)
         {
@@ -444,11 +591,21 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
             continue;
         }
         // we actually popped an item
+        QueuedCoproc::ptr_t coproc = popPending();
+        if (!coproc)
+        {
+            // cancelled while queued
+            continue;
+        }
         --mPending;
         mActiveCoprocsCount++;
+        sample(mStats.mPending, (F64)mPending);
+        sample(mStats.mQueueTime, F64Seconds(LLTimer::getTotalSeconds() - coproc->mEnqueueTime));
 
         LL_DEBUGS("CoProcMgr") << "Dequeued and invoking coprocedure(" << coproc->mName << ") with id=" << coproc->mId.asString() << " in pool \"" << mPoolName << "\" (" << mPending << " left)" << LL_ENDL;
 
+        LLTimer run_time;
+        mActiveCoprocs[coproc->mId] = httpAdapter;
         try
         {
             coproc->mProc(httpAdapter, coproc->mId);
@@ -457,6 +614,7 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
         {
             LL_INFOS("LLCoros") << "coprocedureInvokerCoro terminating because "
                 << e.what() << LL_ENDL;
+            mActiveCoprocs.erase(coproc->mId);
             throw; // let toplevel handle this as LLContinueError
         }
         catch (...)
@@ -465,16 +623,74 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
                                               << "', id=" << coproc->mId.asString()
                                               << ") in pool '" << mPoolName << "'"));
             // must NOT omit this or we deplete the pool
+            mActiveCoprocs.erase(coproc->mId);
             mActiveCoprocsCount--;
             continue;
         }
 
         LL_DEBUGS("CoProcMgr") << "Finished coprocedure(" << coproc->mName << ")" << " in pool \"" << mPoolName << "\"" << LL_ENDL;
 
+        mActiveCoprocs.erase(coproc->mId);
         mActiveCoprocsCount--;
+        sample(mStats.mRunTime, F64Seconds(run_time.getElapsedTimeF64()));
+        add(mStats.mCompleted, 1);
     }
 }
 
+LLCoprocedurePool::QueuedCoproc::ptr_t LLCoprocedurePool::popPending()
+{
+    LLMutexLock lock(&mPendingMutex);
+    if (mPendingMap.empty())
+    {
+        return QueuedCoproc::ptr_t();
+    }
+    PendingMap_t::iterator it = mPendingMap.begin();
+    QueuedCoproc::ptr_t coproc = it->second;
+    mPendingMap.erase(it);
+    return coproc;
+}
+
+bool LLCoprocedurePool::cancelCoprocedure(const LLUUID &id)
+{
+    ActiveMap_t::iterator active = mActiveCoprocs.find(id);
+    if (active != mActiveCoprocs.end())
+    {
+        LL_INFOS("CoProcMgr") << "Cancelling running coprocedure " << id << " in pool \"" << mPoolName << "\"" << LL_ENDL;
+        LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t adapter = active->second;
+        adapter->cancelSuspendedOperation();
+        add(mStats.mCancelled, 1);
+        return true;
+    }
+
+    // See coprocedureInvokerCoro(): the cancelled coprocedure must not be
+    // destroyed while the lock is held.
+    QueuedCoproc::ptr_t coproc;
+    {
+        LLMutexLock lock(&mPendingMutex);
+        // Cancelling is rare, a scan is fine.
+        for (PendingMap_t::iterator it = mPendingMap.begin(); it != mPendingMap.end(); ++it)
+        {
+            if (it->second->mId == id)
+            {
+                coproc = it->second;
+                mPendingMap.erase(it);
+                break;
+            }
+        }
+    }
+    if (!coproc)
+    {
+        return false;
+    }
+
+    // Its wakeup stays in the channel and finds nothing to do.
+    --mPending;
+    sample(mStats.mPending, (F64)mPending);
+    add(mStats.mCancelled, 1);
+    LL_DEBUGS("CoProcMgr") << "Cancelled queued coprocedure(" << coproc->mName << ") with id=" << id << " in pool \"" << mPoolName << "\"" << LL_ENDL;
+    return true;
+}
+
 void LLCoprocedurePool::close()
 {
     mPendingCoprocs->close();
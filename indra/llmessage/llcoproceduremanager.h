@@ -46,18 +46,37 @@ public:
 
     typedef boost::function<void(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, const LLUUID &id)> CoProcedure_t;
 
+    /// Each pool runs its queued coprocedures highest priority first, and
+    /// in order of arrival within a priority.
+    enum EPriority
+    {
+        PRIORITY_HIGH = 0,
+        PRIORITY_NORMAL,
+        PRIORITY_LOW,
+    };
+
     /// Places the coprocedure on the queue for processing. 
     /// 
     /// @param name Is used for debugging and should identify this coroutine.
     /// @param proc Is a bound function to be executed 
+    /// @param priority Position in the pool's queue.
     /// 
     /// @return This method returns a UUID that can be used later to cancel execution.
-    LLUUID enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc);
+    /// The UUID is null if the coprocedure was refused: the pool is shutting
+    /// down, or its queue is full and priority is not PRIORITY_HIGH.
+    LLUUID enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc,
+                              EPriority priority = PRIORITY_NORMAL);
 
     /// Cancel a coprocedure. If the coprocedure is already being actively executed 
-    /// this method calls cancelYieldingOperation() on the associated HttpAdapter
+    /// this method calls cancelSuspendedOperation() on the associated HttpAdapter
     /// If it has not yet been dequeued it is simply removed from the queue.
-    //void cancelCoprocedure(const LLUUID &id);
+    /// Returns false if the id is neither queued nor running.
+    bool cancelCoprocedure(const LLUUID &id);
+
+    /// Returns false once the pool's queue holds as many coprocedures as the
+    /// "QueueSize<pool>" setting allows.  Callers that must not lose work
+    /// should hold it back until this turns true again.
+    bool hasCapacity(const std::string &pool) const;
 
     void setPropertyMethods(SettingQuery_t queryfn, SettingUpdate_t updatefn);
 
@@ -0,0 +1,369 @@
+/**
+ * @file llnamecachefile.cpp
+ * @brief Implementation of LLNameCacheFile class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llnamecachefile.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "llfile.h"
+
+// Bump when the records below change layout.
+static const U32 NAME_CACHE_FORMAT_VERSION = 1;
+static const char NAME_CACHE_MAGIC[8] = { 'S', 'L', 'N', 'A', 'M', 'E', 'S', 0 };
+
+// Record flag reserved for tombstones; owner flags must stay clear of it.
+static const U32 RECORD_ERASED = 0x80000000;
+
+// A file this many records larger than twice the live entries is rewritten.
+static const U32 REWRITE_SLACK = 256;
+
+struct LLNameCacheFile::Header
+{
+	char	mMagic[8];
+	U32		mFormatVersion;
+	U32		mPad;
+};
+
+// Followed by the strings, back to back, then padding to 8 bytes.
+struct LLNameCacheFile::Record
+{
+	LLUUID	mID;
+	F64		mTime;
+	F64		mNextUpdate;
+	U32		mFlags;
+	U32		mSize;			// whole record, padding included
+	U16		mLength[MAX_STRINGS];
+};
+
+static_assert(sizeof(LLUUID) == UUID_BYTES, "LLUUID is stored raw in the name cache");
+
+LLNameCacheFile::LLNameCacheFile()
+:	mMapping(NULL),
+	mRegion(NULL),
+	mData(NULL),
+	mSize(0),
+	mRecordCount(0),
+	mDamaged(false)
+{
+}
+
+LLNameCacheFile::~LLNameCacheFile()
+{
+	close();
+}
+
+bool LLNameCacheFile::open(const std::string& filename, F64 expire_before)
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	close();
+	mFilename = filename;
+	if (!LLFile::isfile(filename))
+	{
+		return false;
+	}
+
+	try
+	{
+		mMapping = new boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+		mRegion = new boost::interprocess::mapped_region(*mMapping, boost::interprocess::read_only);
+	}
+	catch (const boost::interprocess::interprocess_exception& e)
+	{
+		LL_WARNS("NameCache") << "Unable to map name cache " << filename << ": " << e.what() << LL_ENDL;
+		close();
+		return false;
+	}
+
+	mData = (const U8*)mRegion->get_address();
+	mSize = mRegion->get_size();
+
+	Header header;
+	if (mSize < sizeof(header))
+	{
+		close();
+		return false;
+	}
+	memcpy(&header, mData, sizeof(header));
+	if (memcmp(header.mMagic, NAME_CACHE_MAGIC, sizeof(NAME_CACHE_MAGIC))
+		|| header.mFormatVersion != NAME_CACHE_FORMAT_VERSION)
+	{
+		LL_INFOS("NameCache") << "Ignoring name cache " << filename << " from another format version" << LL_ENDL;
+		close();
+		return false;
+	}
+
+	// Only the fixed-size record headers are read here.
+	size_t offset = sizeof(header);
+	Record record;
+	while (offset + sizeof(record) <= mSize)
+	{
+		memcpy(&record, mData + offset, sizeof(record));
+		size_t strings = 0;
+		for (U32 i = 0; i < MAX_STRINGS; ++i)
+		{
+			strings += record.mLength[i];
+		}
+		if (record.mSize < sizeof(record) + strings
+			|| record.mSize % 8
+			|| offset + record.mSize > mSize)
+		{
+			break;
+		}
+
+		if ((record.mFlags & RECORD_ERASED) || record.mTime < expire_before)
+		{
+			mIndex.erase(record.mID);
+		}
+		else
+		{
+			mIndex[record.mID] = offset;
+		}
+		++mRecordCount;
+		offset += record.mSize;
+	}
+
+	if (offset != mSize)
+	{
+		// Most likely an append cut short; what came before is still good.
+		LL_WARNS("NameCache") << "Name cache " << filename << " is damaged after "
+							  << mRecordCount << " records" << LL_ENDL;
+		mDamaged = true;
+	}
+
+	LL_INFOS("NameCache") << "Mapped " << filename << ": " << mIndex.size() << " names in "
+						  << mRecordCount << " records" << LL_ENDL;
+	return true;
+}
+
+void LLNameCacheFile::close()
+{
+	delete mRegion;
+	mRegion = NULL;
+	delete mMapping;
+	mMapping = NULL;
+	mData = NULL;
+	mSize = 0;
+	mIndex.clear();
+	mAppended.clear();
+	mRecordCount = 0;
+	mDamaged = false;
+}
+
+void LLNameCacheFile::getIDs(std::vector<LLUUID>& ids) const
+{
+	ids.reserve(ids.size() + mIndex.size());
+	for (const auto& indexed : mIndex)
+	{
+		ids.push_back(indexed.first);
+	}
+}
+
+bool LLNameCacheFile::find(const LLUUID& id, Entry& entry) const
+{
+	auto it = mIndex.find(id);
+	if (it == mIndex.end())
+	{
+		return false;
+	}
+
+	// Bounds were checked when the index was built.
+	Record record;
+	memcpy(&record, mData + it->second, sizeof(record));
+	entry.mID = record.mID;
+	entry.mTime = record.mTime;
+	entry.mNextUpdate = record.mNextUpdate;
+	entry.mFlags = record.mFlags;
+	const char* str = (const char*)mData + it->second + sizeof(record);
+	for (U32 i = 0; i < MAX_STRINGS; ++i)
+	{
+		entry.mStrings[i].assign(str, record.mLength[i]);
+		str += record.mLength[i];
+	}
+	return true;
+}
+
+// static
+bool LLNameCacheFile::encode(const Entry& entry, U32 flags, std::vector<U8>& out)
+{
+	Record record;
+	memset(&record, 0, sizeof(record));
+	record.mID = entry.mID;
+	record.mTime = entry.mTime;
+	record.mNextUpdate = entry.mNextUpdate;
+	record.mFlags = flags;
+
+	size_t strings = 0;
+	for (U32 i = 0; i < MAX_STRINGS; ++i)
+	{
+		if (entry.mStrings[i].size() > 0xffff)
+		{
+			return false;
+		}
+		record.mLength[i] = (U16)entry.mStrings[i].size();
+		strings += entry.mStrings[i].size();
+	}
+	record.mSize = (U32)((sizeof(record) + strings + 7) & ~(size_t)7);
+
+	size_t start = out.size();
+	out.resize(start + record.mSize, 0);
+	memcpy(&out[start], &record, sizeof(record));
+	size_t pos = start + sizeof(record);
+	for (U32 i = 0; i < MAX_STRINGS; ++i)
+	{
+		if (!entry.mStrings[i].empty())
+		{
+			memcpy(&out[pos], entry.mStrings[i].data(), entry.mStrings[i].size());
+			pos += entry.mStrings[i].size();
+		}
+	}
+	return true;
+}
+
+void LLNameCacheFile::append(const Entry& entry)
+{
+	llassert(!(entry.mFlags & RECORD_ERASED));
+
+	// The owner holds the new value from now on.
+	mIndex.erase(entry.mID);
+	mAppended.insert(entry.mID);
+	if (encode(entry, entry.mFlags & ~RECORD_ERASED, mPending))
+	{
+		++mRecordCount;
+	}
+}
+
+void LLNameCacheFile::remove(const LLUUID& id)
+{
+	// an id appended this session has a record even though it left the index
+	bool indexed = mIndex.erase(id) > 0;
+	bool appended = mAppended.erase(id) > 0;
+	if (indexed || appended)
+	{
+		Entry tombstone;
+		tombstone.mID = id;
+		encode(tombstone, RECORD_ERASED, mPending);
+		++mRecordCount;
+	}
+}
+
+void LLNameCacheFile::expire(F64 expire_before)
+{
+	Record record;
+	for (auto it = mIndex.begin(); it != mIndex.end();)
+	{
+		memcpy(&record, mData + it->second, sizeof(record));
+		if (record.mTime < expire_before)
+		{
+			it = mIndex.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+bool LLNameCacheFile::needsRewrite(size_t live_count) const
+{
+	return !isOpen() || mDamaged || mRecordCount > 2 * live_count + REWRITE_SLACK;
+}
+
+bool LLNameCacheFile::flush()
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	if (mPending.empty())
+	{
+		return true;
+	}
+	if (!isOpen() || mDamaged)
+	{
+		// Appending after a damaged tail would orphan the new records.
+		return false;
+	}
+
+	LLFILE* fp = LLFile::fopen(mFilename, "ab");
+	if (!fp)
+	{
+		return false;
+	}
+	bool success = fwrite(&mPending[0], 1, mPending.size(), fp) == mPending.size();
+	LLFile::close(fp);
+	if (!success)
+	{
+		// A partial write leaves a damaged tail for the next open() to find.
+		mDamaged = true;
+		return false;
+	}
+	mPending.clear();
+	return true;
+}
+
+bool LLNameCacheFile::rewrite(const std::vector<Entry>& entries)
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	std::vector<U8> data;
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mMagic, NAME_CACHE_MAGIC, sizeof(NAME_CACHE_MAGIC));
+	header.mFormatVersion = NAME_CACHE_FORMAT_VERSION;
+	data.resize(sizeof(header));
+	memcpy(&data[0], &header, sizeof(header));
+	for (const Entry& entry : entries)
+	{
+		encode(entry, entry.mFlags & ~RECORD_ERASED, data);
+	}
+	mPending.clear();
+
+	std::string filename = mFilename;
+	std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+	if (!fp)
+	{
+		return false;
+	}
+	bool success = fwrite(&data[0], 1, data.size(), fp) == data.size();
+	LLFile::close(fp);
+
+	// The old file can't be replaced while it is mapped.
+	close();
+	if (success)
+	{
+		LLFile::remove(filename, ENOENT);
+		success = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!success)
+	{
+		LLFile::remove(temp_filename);
+	}
+	open(filename);
+	return success;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file llnamecachefile.h
+ * @brief Append-only, memory-mapped binary store for the name caches.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLNAMECACHEFILE_H
+#define LL_LLNAMECACHEFILE_H
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "lluuid.h"
+
+namespace boost { namespace interprocess { class file_mapping; class mapped_region; } }
+
+//-----------------------------------------------------------------------------
+// class LLNameCacheFile
+//
+// Binary backing store for LLAvatarNameCache and LLCacheName.  The file is a
+// short header followed by variable-size records, each holding an id, two
+// timestamps, some flags and up to four strings.  A later record for the same
+// id supersedes an earlier one, and an erase is recorded as a tombstone, so
+// saving only has to append what changed during the session.
+//
+// open() maps the file and walks the record headers to build an in-memory
+// id -> offset index without decoding any string; find() decodes a single
+// record straight from the mapping.  The file is rewritten from scratch only
+// when superseded records make up most of it.
+//-----------------------------------------------------------------------------
+class LLNameCacheFile
+{
+public:
+	static const U32 MAX_STRINGS = 4;
+
+	struct Entry
+	{
+		Entry() : mTime(0.0), mNextUpdate(0.0), mFlags(0) {}
+
+		bool operator==(const Entry& rhs) const
+		{
+			if (mID != rhs.mID || mTime != rhs.mTime || mNextUpdate != rhs.mNextUpdate || mFlags != rhs.mFlags)
+			{
+				return false;
+			}
+			for (U32 i = 0; i < MAX_STRINGS; ++i)
+			{
+				if (mStrings[i] != rhs.mStrings[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		LLUUID		mID;
+		F64			mTime;			// meaning is up to the owner
+		F64			mNextUpdate;
+		U32			mFlags;			// ditto
+		std::string	mStrings[MAX_STRINGS];
+	};
+
+	LLNameCacheFile();
+	~LLNameCacheFile();
+
+	// Maps filename and indexes its records.  Returns false if the file is
+	// missing or not a name cache; a damaged tail is dropped from the index
+	// and forces the next save to rewrite the file.  Records whose mTime is
+	// below expire_before are left out of the index, see expire().
+	bool open(const std::string& filename, F64 expire_before = 0.0);
+	void close();
+	bool isOpen() const { return mData != NULL; }
+
+	// Number of ids answerable from the mapped file.
+	size_t size() const { return mIndex.size(); }
+	bool contains(const LLUUID& id) const { return mIndex.find(id) != mIndex.end(); }
+	void getIDs(std::vector<LLUUID>& ids) const;
+
+	// Decodes the mapped record for id.  Ids that were appended or removed
+	// since open() are not found; their owner has the current value.
+	bool find(const LLUUID& id, Entry& entry) const;
+
+	// Queue a new value, or a tombstone, for the next flush().
+	void append(const Entry& entry);
+	void remove(const LLUUID& id);
+
+	// Drops indexed records whose mTime is below expire_before.  They need
+	// no tombstone: they stay expired for any later open() with a cut-off at
+	// least as late, and the next rewrite() leaves them out.
+	void expire(F64 expire_before);
+
+	// True if the next save should call rewrite() rather than flush(),
+	// given the number of distinct live ids between the owner and the file.
+	bool needsRewrite(size_t live_count) const;
+
+	// Appends the queued records to the file.
+	bool flush();
+	// Replaces the file with entries only and maps the result.
+	bool rewrite(const std::vector<Entry>& entries);
+
+private:
+	struct Header;
+	struct Record;
+
+	static bool encode(const Entry& entry, U32 flags, std::vector<U8>& out);
+
+	std::string							mFilename;
+	boost::interprocess::file_mapping*	mMapping;
+	boost::interprocess::mapped_region*	mRegion;
+	const U8*							mData;
+	size_t								mSize;
+	std::unordered_map<LLUUID, U64>		mIndex;		// id -> record offset
+	std::unordered_set<LLUUID>			mAppended;	// ids append()ed since open()
+	std::vector<U8>						mPending;	// records not yet flushed
+	U32									mRecordCount;
+	bool								mDamaged;
+};
+
+#endif // LL_LLNAMECACHEFILE_H
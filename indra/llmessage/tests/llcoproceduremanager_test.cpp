@@ -176,4 +176,38 @@ namespace tut
         LL_INFOS("CoMain") << "checking count" << LL_ENDL;
         ensure_equals("coprocedure failed to update counter", counter, 5);
     }
+
+    template<> template<>
+    void coproceduremanager_object_t::test<5>()
+    {
+        Sync sync;
+        std::vector<std::string> order;
+        auto make_proc = [&order, &sync](const std::string& name)
+        {
+            return [&order, &sync, name](LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t & ptr, const LLUUID & id) {
+                order.push_back(name);
+                sync.bump();
+            };
+        };
+
+        LLCoprocedureManager& manager = LLCoprocedureManager::instance();
+        manager.initializePool("PriorityPool");
+        manager.enqueueCoprocedure("PriorityPool", "low", make_proc("low"), LLCoprocedureManager::PRIORITY_LOW);
+        LLUUID cancelled = manager.enqueueCoprocedure("PriorityPool", "cancelled", make_proc("cancelled"));
+        manager.enqueueCoprocedure("PriorityPool", "normal", make_proc("normal"));
+        manager.enqueueCoprocedure("PriorityPool", "high", make_proc("high"), LLCoprocedureManager::PRIORITY_HIGH);
+        ensure_equals("queued coprocedures", manager.countPending("PriorityPool"), 4);
+
+        ensure("cancel queued coprocedure", manager.cancelCoprocedure(cancelled));
+        ensure("cancel it again", !manager.cancelCoprocedure(cancelled));
+        ensure_equals("queued after cancel", manager.countPending("PriorityPool"), 3);
+
+        sync.yield(3);
+        ensure_equals("coprocedures run", order.size(), 3);
+        ensure_equals("high priority first", order[0], "high");
+        ensure_equals("then normal", order[1], "normal");
+        ensure_equals("low priority last", order[2], "low");
+
+        manager.close("PriorityPool");
+    }
 }  // namespace tut
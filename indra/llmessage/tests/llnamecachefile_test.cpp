@@ -0,0 +1,205 @@
+/**
+ * @file llnamecachefile_test.cpp
+ * @brief LLNameCacheFile test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llnamecachefile.h"
+
+#include "llfile.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+namespace tut
+{
+	struct namecachefile_data
+	{
+		namecachefile_data()
+		:	mTempFile("namecache", "")
+		{
+		}
+
+		static LLNameCacheFile::Entry makeEntry(const LLUUID& id, const std::string& name, F64 time)
+		{
+			LLNameCacheFile::Entry entry;
+			entry.mID = id;
+			entry.mTime = time;
+			entry.mNextUpdate = time + 1.0;
+			entry.mFlags = 1;
+			entry.mStrings[0] = name;
+			entry.mStrings[2] = name + " Resident";
+			return entry;
+		}
+
+		NamedTempFile mTempFile;
+	};
+	typedef test_group<namecachefile_data> namecachefile_test;
+	typedef namecachefile_test::object namecachefile_object;
+	tut::namecachefile_test namecachefile_testcase("LLNameCacheFile");
+
+	template<> template<>
+	void namecachefile_object::test<1>()
+	{
+		set_test_name("rewrite and find");
+
+		LLNameCacheFile file;
+		ensure("empty file is not a name cache", !file.open(mTempFile.getName()));
+		ensure("unopened file needs a rewrite", file.needsRewrite(0));
+
+		LLUUID first_id, second_id;
+		first_id.generate();
+		second_id.generate();
+		std::vector<LLNameCacheFile::Entry> entries;
+		entries.push_back(makeEntry(first_id, "first", 100.0));
+		entries.push_back(makeEntry(second_id, "second", 200.0));
+		ensure("rewrite", file.rewrite(entries));
+		ensure("rewritten file is mapped", file.isOpen());
+		ensure_equals("indexed names", file.size(), 2);
+
+		LLNameCacheFile::Entry entry;
+		ensure("first found", file.find(first_id, entry));
+		ensure("first round trip", entry == entries[0]);
+		ensure("second found", file.find(second_id, entry));
+		ensure("second round trip", entry == entries[1]);
+
+		LLUUID unknown_id;
+		unknown_id.generate();
+		ensure("unknown id", !file.find(unknown_id, entry));
+	}
+
+	template<> template<>
+	void namecachefile_object::test<2>()
+	{
+		set_test_name("appended records supersede older ones");
+
+		LLUUID kept_id, changed_id, erased_id, added_id;
+		kept_id.generate();
+		changed_id.generate();
+		erased_id.generate();
+		added_id.generate();
+
+		std::vector<LLNameCacheFile::Entry> entries;
+		entries.push_back(makeEntry(kept_id, "kept", 1.0));
+		entries.push_back(makeEntry(changed_id, "changed", 2.0));
+		entries.push_back(makeEntry(erased_id, "erased", 3.0));
+
+		{
+			LLNameCacheFile file;
+			file.open(mTempFile.getName());
+			ensure("rewrite", file.rewrite(entries));
+
+			file.append(makeEntry(changed_id, "renamed", 4.0));
+			file.remove(erased_id);
+			file.append(makeEntry(added_id, "added", 5.0));
+
+			LLNameCacheFile::Entry entry;
+			ensure("appended id is up to the owner", !file.find(changed_id, entry));
+			ensure("removed id is gone", !file.find(erased_id, entry));
+			ensure("flush", file.flush());
+		}
+
+		LLNameCacheFile file;
+		ensure("reopen", file.open(mTempFile.getName()));
+		ensure_equals("indexed names", file.size(), 3);
+
+		LLNameCacheFile::Entry entry;
+		ensure("kept found", file.find(kept_id, entry));
+		ensure("kept unchanged", entry == entries[0]);
+		ensure("changed found", file.find(changed_id, entry));
+		ensure("latest record wins", entry == makeEntry(changed_id, "renamed", 4.0));
+		ensure("tombstone hides erased", !file.find(erased_id, entry));
+		ensure("added found", file.find(added_id, entry));
+		ensure("added round trip", entry == makeEntry(added_id, "added", 5.0));
+		ensure("no rewrite needed yet", !file.needsRewrite(3));
+	}
+
+	template<> template<>
+	void namecachefile_object::test<3>()
+	{
+		set_test_name("damaged tail");
+
+		LLUUID id;
+		id.generate();
+		std::vector<LLNameCacheFile::Entry> entries;
+		entries.push_back(makeEntry(id, "survivor", 1.0));
+		{
+			LLNameCacheFile file;
+			file.open(mTempFile.getName());
+			ensure("rewrite", file.rewrite(entries));
+		}
+
+		// simulate an append cut short
+		LLFILE* fp = LLFile::fopen(mTempFile.getName(), "ab");
+		ensure("append", fp != NULL);
+		fwrite("garbage", 1, 7, fp);
+		LLFile::close(fp);
+
+		LLNameCacheFile file;
+		ensure("damaged file still opens", file.open(mTempFile.getName()));
+		LLNameCacheFile::Entry entry;
+		ensure("records before the damage survive", file.find(id, entry));
+		ensure("damage forces a rewrite", file.needsRewrite(1));
+
+		file.append(makeEntry(id, "renamed", 2.0));
+		ensure("no appending after a damaged tail", !file.flush());
+	}
+
+	template<> template<>
+	void namecachefile_object::test<4>()
+	{
+		set_test_name("expiry and removing appended ids");
+
+		LLUUID old_id, new_id, added_id;
+		old_id.generate();
+		new_id.generate();
+		added_id.generate();
+		std::vector<LLNameCacheFile::Entry> entries;
+		entries.push_back(makeEntry(old_id, "old", 10.0));
+		entries.push_back(makeEntry(new_id, "new", 20.0));
+		{
+			LLNameCacheFile file;
+			file.open(mTempFile.getName());
+			ensure("rewrite", file.rewrite(entries));
+
+			// appended and removed before the same flush
+			file.append(makeEntry(added_id, "added", 30.0));
+			file.remove(added_id);
+			ensure("flush", file.flush());
+		}
+
+		LLNameCacheFile file;
+		ensure("reopen with a cut-off", file.open(mTempFile.getName(), 15.0));
+		LLNameCacheFile::Entry entry;
+		ensure("expired at open", !file.find(old_id, entry));
+		ensure("kept at open", file.find(new_id, entry));
+		ensure("tombstone for an appended id", !file.find(added_id, entry));
+		ensure_equals("indexed names", file.size(), 1);
+
+		file.expire(25.0);
+		ensure("expired later", !file.find(new_id, entry));
+		ensure_equals("nothing left", file.size(), 0);
+	}
+}
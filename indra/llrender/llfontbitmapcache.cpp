@@ -37,7 +37,8 @@ LLFontBitmapCache::LLFontBitmapCache()
 	mMaxCharWidth(0),
 	mMaxCharHeight(0),
 	mCurrentOffsetX(1),
-	mCurrentOffsetY(1)
+	mCurrentOffsetY(1),
+	mHasDirty(false)
 {
 }
 
@@ -89,6 +90,7 @@ BOOL LLFontBitmapCache::nextOpenPos(S32 width, S32 &pos_x, S32 &pos_y, S32& bitm
 			// Make corresponding GL image.
 			mImageGLVec.push_back(new LLImageGL(FALSE));
 			LLImageGL *image_gl = getImageGL(mBitmapNum);
+			mDirtyRects.push_back(LLRect());
 			
 			S32 image_width = mMaxCharWidth * 20;
 			S32 pow_iw = 2;
@@ -141,6 +143,53 @@ BOOL LLFontBitmapCache::nextOpenPos(S32 width, S32 &pos_x, S32 &pos_y, S32& bitm
 	return TRUE;
 }
 
+void LLFontBitmapCache::markDirty(U32 bitmap_num, S32 x, S32 y, S32 width, S32 height)
+{
+	if (bitmap_num >= mDirtyRects.size() || width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	LLRect glyph_rect(x, y + height, x + width, y);
+	LLRect& dirty_rect = mDirtyRects[bitmap_num];
+	if (dirty_rect.isEmpty())
+	{
+		dirty_rect = glyph_rect;
+	}
+	else
+	{
+		dirty_rect.unionWith(glyph_rect);
+	}
+	mHasDirty = true;
+}
+
+void LLFontBitmapCache::uploadDirty()
+{
+	if (!mHasDirty)
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
+	for (U32 i = 0; i < mDirtyRects.size(); ++i)
+	{
+		LLRect& dirty_rect = mDirtyRects[i];
+		if (dirty_rect.isEmpty())
+		{
+			continue;
+		}
+
+		LLImageGL *image_gl = getImageGL(i);
+		LLImageRaw *image_raw = getImageRaw(i);
+		if (image_gl && image_raw)
+		{
+			image_gl->setSubImage(image_raw, dirty_rect.mLeft, dirty_rect.mBottom, dirty_rect.getWidth(), dirty_rect.getHeight(), TRUE);
+		}
+		dirty_rect = LLRect();
+	}
+	mHasDirty = false;
+}
+
 void LLFontBitmapCache::destroyGL()
 {
 	for (std::vector<LLPointer<LLImageGL> >::iterator it = mImageGLVec.begin();
@@ -155,6 +204,9 @@ void LLFontBitmapCache::reset()
 	mImageRawVec.clear();
 
 	mImageGLVec.clear();
+
+	mDirtyRects.clear();
+	mHasDirty = false;
 	
 	mBitmapWidth = 0;
 	mBitmapHeight = 0;
@@ -29,6 +29,7 @@
 
 #include <vector>
 #include "lltrace.h"
+#include "llrect.h"
 
 // Maintain a collection of bitmaps containing rendered glyphs.
 // Generalizes the single-bitmap logic from LLFontFreetype and LLFontGL.
@@ -46,7 +47,14 @@ public:
 	void reset();
 
 	BOOL nextOpenPos(S32 width, S32 &posX, S32 &posY, S32 &bitmapNum);
-	
+
+	// Glyph pixels are written to the raw images as they are rasterized and
+	// only pushed to the GL textures by uploadDirty(), so a burst of new
+	// glyphs costs one sub-image upload per bitmap instead of one per glyph.
+	void markDirty(U32 bitmap_num, S32 x, S32 y, S32 width, S32 height);
+	bool hasDirty() const { return mHasDirty; }
+	void uploadDirty();
+
 	void destroyGL();
 	
  	LLImageRaw *getImageRaw(U32 bitmapNum = 0) const;
@@ -68,6 +76,8 @@ private:
 	S32 mCurrentOffsetY;
 	std::vector<LLPointer<LLImageRaw> >	mImageRawVec;
 	std::vector<LLPointer<LLImageGL> > mImageGLVec;
+	std::vector<LLRect> mDirtyRects;
+	bool mHasDirty;
 };
 
 #endif //LL_LLFONTBITMAPCACHE_H
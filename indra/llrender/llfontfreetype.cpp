@@ -48,9 +48,23 @@
 //#include "imdebug.h"
 #include "llfontbitmapcache.h"
 #include "llgl.h"
+#include "llfile.h"
+#include "lltrace.h"
+#include "workqueue.h"
 
 FT_Render_Mode gFontRenderMode = FT_RENDER_MODE_NORMAL;
 
+static LLTrace::CountStatHandle<> sGlyphCacheHits("fontglyphcachehits", "Glyph lookups served from the font bitmap cache");
+static LLTrace::CountStatHandle<> sGlyphCacheMisses("fontglyphcachemisses", "Glyphs rasterized on demand by the UI thread");
+static LLTrace::CountStatHandle<> sGlyphsPrewarmed("fontglyphsprewarmed", "Glyphs rasterized ahead of use on a worker thread");
+
+// Upper bound on the persisted recent glyph list, and so on prewarm work per font
+const U32 MAX_RECENT_GLYPHS = 512;
+
+LLWString LLFontFreetype::sRecentGlyphs;
+U32 LLFontFreetype::sPendingGlyphCacheHits = 0;
+boost::unordered_set<llwchar> LLFontFreetype::sRecentGlyphSet;
+
 LLFontManager *gFontManagerp = NULL;
 
 FT_Library gFTLibrary = NULL;
@@ -117,7 +131,11 @@ LLFontFreetype::LLFontFreetype()
 	mRenderGlyphCount(0),
 	mAddGlyphCount(0),
 	mStyle(0),
-	mPointSize(0)
+	mPointSize(0),
+	mVertDPI(0.f),
+	mHorzDPI(0.f),
+	mFaceIndex(0),
+	mResetSerial(0)
 {
 }
 
@@ -154,6 +172,37 @@ void ft_close_cb(FT_Stream stream) {
 	llifstream *file_stream = static_cast<llifstream *>(stream->descriptor.pointer);
 	file_stream->close();
 }
+
+// FT_New_Face() can't open every UTF-8 path on Windows, so read the file
+// through an llifstream.  Both streams must outlive the face; file_stream
+// is allocated even if the file can't be opened.
+static S32 ft_open_stream_face(FT_Library library, const std::string& filename, S32 face_n, FT_Face* face, llifstream*& file_stream, LLFT_Stream*& ft_stream)
+{
+	S32 error = -1;
+	file_stream = new llifstream(filename, std::ios::binary);
+	if (file_stream->is_open())
+	{
+		std::streampos beg = file_stream->tellg();
+		file_stream->seekg(0, std::ios::end);
+		std::streampos end = file_stream->tellg();
+		std::size_t file_size = end - beg;
+		file_stream->seekg(0, std::ios::beg);
+
+		ft_stream = new LLFT_Stream();
+		ft_stream->base = 0;
+		ft_stream->pos = 0;
+		ft_stream->size = file_size;
+		ft_stream->descriptor.pointer = file_stream;
+		ft_stream->read = ft_read_cb;
+		ft_stream->close = ft_close_cb;
+
+		FT_Open_Args args;
+		args.flags = FT_OPEN_STREAM;
+		args.stream = (FT_StreamRec*)ft_stream;
+		error = FT_Open_Face(library, &args, face_n, face);
+	}
+	return error;
+}
 #endif
 
 BOOL LLFontFreetype::loadFace(const std::string& filename, F32 point_size, F32 vert_dpi, F32 horz_dpi, S32 components, BOOL is_fallback, S32 face_n)
@@ -236,6 +285,14 @@ BOOL LLFontFreetype::loadFace(const std::string& filename, F32 point_size, F32 v
 
 	mName = filename;
 	mPointSize = point_size;
+	mVertDPI = vert_dpi;
+	mHorzDPI = horz_dpi;
+#ifdef LL_WINDOWS
+	mFaceIndex = face_n;
+#else
+	mFaceIndex = 0;
+#endif
+	mResetSerial++;
 
 	mStyle = LLFontGL::NORMAL;
 	if(mFTFace->style_flags & FT_STYLE_FLAG_BOLD)
@@ -284,30 +341,7 @@ S32 LLFontFreetype::getNumFaces(const std::string& filename)
 #ifdef LL_WINDOWS
 S32 LLFontFreetype::ftOpenFace(const std::string& filename, S32 face_n)
 {
-	S32 error = -1;
-	pFileStream = new llifstream(filename, std::ios::binary);
-	if (pFileStream->is_open())
-	{
-		std::streampos beg = pFileStream->tellg();
-		pFileStream->seekg(0, std::ios::end);
-		std::streampos end = pFileStream->tellg();
-		std::size_t file_size = end - beg;
-		pFileStream->seekg(0, std::ios::beg);
-
-		pFtStream = new LLFT_Stream();
-		pFtStream->base = 0;
-		pFtStream->pos = 0;
-		pFtStream->size = file_size;
-		pFtStream->descriptor.pointer = pFileStream;
-		pFtStream->read = ft_read_cb;
-		pFtStream->close = ft_close_cb;
-
-		FT_Open_Args args;
-		args.flags = FT_OPEN_STREAM;
-		args.stream = (FT_StreamRec*)pFtStream;
-		error = FT_Open_Face(gFTLibrary, &args, face_n, &mFTFace);
-	}
-	return error;
+	return ft_open_stream_face(gFTLibrary, filename, face_n, &mFTFace, pFileStream, pFtStream);
 }
 
 void LLFontFreetype::clearFontStreams()
@@ -465,34 +499,18 @@ LLFontGlyphInfo* LLFontFreetype::addGlyphFromFont(const LLFontFreetype *fontp, l
 	S32 width = fontp->mFTFace->glyph->bitmap.width;
 	S32 height = fontp->mFTFace->glyph->bitmap.rows;
 
-	S32 pos_x, pos_y;
-	S32 bitmap_num;
-	mFontBitmapCachep->nextOpenPos(width, pos_x, pos_y, bitmap_num);
-	mAddGlyphCount++;
-
-	LLFontGlyphInfo* gi = new LLFontGlyphInfo(glyph_index);
-	gi->mXBitmapOffset = pos_x;
-	gi->mYBitmapOffset = pos_y;
-	gi->mBitmapNum = bitmap_num;
-	gi->mWidth = width;
-	gi->mHeight = height;
-	gi->mXBearing = fontp->mFTFace->glyph->bitmap_left;
-	gi->mYBearing = fontp->mFTFace->glyph->bitmap_top;
-	// Convert these from 26.6 units to float pixels.
-	gi->mXAdvance = fontp->mFTFace->glyph->advance.x / 64.f;
-	gi->mYAdvance = fontp->mFTFace->glyph->advance.y / 64.f;
-
-	insertGlyphInfo(wch, gi);
-
 	llassert(fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO
 	    || fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY);
 
+	U8 *buffer_data = NULL;
+	S32 buffer_row_stride = 0;
+	U8 *tmp_graydata = NULL;
+
 	if (fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO
 	    || fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY)
 	{
-		U8 *buffer_data = fontp->mFTFace->glyph->bitmap.buffer;
-		S32 buffer_row_stride = fontp->mFTFace->glyph->bitmap.pitch;
-		U8 *tmp_graydata = NULL;
+		buffer_data = fontp->mFTFace->glyph->bitmap.buffer;
+		buffer_row_stride = fontp->mFTFace->glyph->bitmap.pitch;
 
 		if (fontp->mFTFace->glyph->bitmap.pixel_mode
 		    == FT_PIXEL_MODE_MONO)
@@ -519,7 +537,52 @@ LLFontGlyphInfo* LLFontFreetype::addGlyphFromFont(const LLFontFreetype *fontp, l
 			buffer_data = tmp_graydata;
 			buffer_row_stride = width;
 		}
+	} else {
+		// we don't know how to handle this pixel format from FreeType;
+		// omit it from the font-image.
+	}
 
+	LLFontGlyphInfo* gi = addGlyphBitmap(wch,
+										 glyph_index,
+										 width,
+										 height,
+										 fontp->mFTFace->glyph->bitmap_left,
+										 fontp->mFTFace->glyph->bitmap_top,
+										 // Convert these from 26.6 units to float pixels.
+										 fontp->mFTFace->glyph->advance.x / 64.f,
+										 fontp->mFTFace->glyph->advance.y / 64.f,
+										 buffer_data,
+										 buffer_row_stride);
+
+	if (tmp_graydata)
+		delete[] tmp_graydata;
+
+	return gi;
+}
+
+LLFontGlyphInfo* LLFontFreetype::addGlyphBitmap(llwchar wch, U32 glyph_index, S32 width, S32 height, S32 x_bearing, S32 y_bearing,
+												F32 x_advance, F32 y_advance, const U8* buffer_data, S32 buffer_row_stride) const
+{
+	S32 pos_x, pos_y;
+	S32 bitmap_num;
+	mFontBitmapCachep->nextOpenPos(width, pos_x, pos_y, bitmap_num);
+	mAddGlyphCount++;
+
+	LLFontGlyphInfo* gi = new LLFontGlyphInfo(glyph_index);
+	gi->mXBitmapOffset = pos_x;
+	gi->mYBitmapOffset = pos_y;
+	gi->mBitmapNum = bitmap_num;
+	gi->mWidth = width;
+	gi->mHeight = height;
+	gi->mXBearing = x_bearing;
+	gi->mYBearing = y_bearing;
+	gi->mXAdvance = x_advance;
+	gi->mYAdvance = y_advance;
+
+	insertGlyphInfo(wch, gi);
+
+	if (buffer_data)
+	{
 		switch (mFontBitmapCachep->getNumComponents())
 		{
 		case 1:
@@ -543,17 +606,10 @@ LLFontGlyphInfo* LLFontFreetype::addGlyphFromFont(const LLFontFreetype *fontp, l
 		default:
 			break;
 		}
-
-		if (tmp_graydata)
-			delete[] tmp_graydata;
-	} else {
-		// we don't know how to handle this pixel format from FreeType;
-		// omit it from the font-image.
 	}
-	
-	LLImageGL *image_gl = mFontBitmapCachep->getImageGL(bitmap_num);
-	LLImageRaw *image_raw = mFontBitmapCachep->getImageRaw(bitmap_num);
-	image_gl->setSubImage(image_raw, 0, 0, image_gl->getWidth(), image_gl->getHeight());
+
+	// Uploaded to GL in a batch by uploadBitmaps()
+	mFontBitmapCachep->markDirty(bitmap_num, pos_x, pos_y, width, height);
 
 	return gi;
 }
@@ -563,15 +619,341 @@ LLFontGlyphInfo* LLFontFreetype::getGlyphInfo(llwchar wch) const
 	char_glyph_info_map_t::iterator iter = mCharGlyphInfoMap.find(wch);
 	if (iter != mCharGlyphInfoMap.end())
 	{
+		// reported by flushGlyphStats(), this is too hot for LLTrace
+		++sPendingGlyphCacheHits;
 		return iter->second;
 	}
 	else
 	{
+		add(sGlyphCacheMisses, 1);
+		if (wch > LAST_CHAR_FULL)
+		{
+			addRecentGlyph(wch);
+		}
+
 		// this glyph doesn't yet exist, so render it and return the result
 		return addGlyph(wch);
 	}
 }
 
+// Everything a worker needs to open its own copy of a face
+struct LLPrewarmFace
+{
+	std::string mFilename;
+	S32 mFaceIndex;
+	F32 mPointSize;
+	F32 mVertDPI;
+	F32 mHorzDPI;
+};
+
+struct LLPrewarmedGlyph
+{
+	llwchar mChar;
+	U32 mGlyphIndex;
+	S32 mWidth;
+	S32 mHeight;
+	S32 mXBearing;
+	S32 mYBearing;
+	F32 mXAdvance;
+	F32 mYAdvance;
+	std::vector<U8> mData; // 8-bit coverage, mWidth bytes per row
+};
+
+// Runs on a worker thread.  FreeType libraries and faces must not be used
+// from more than one thread, so this opens private copies of the faces,
+// the fallbacks only if some character needs them.
+static std::vector<LLPrewarmedGlyph> rasterize_glyphs(const std::vector<LLPrewarmFace>& faces, const LLWString& wstr, FT_Render_Mode render_mode)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
+
+	std::vector<LLPrewarmedGlyph> glyphs;
+	FT_Library library = NULL;
+	if (faces.empty() || FT_Init_FreeType(&library))
+	{
+		return glyphs;
+	}
+
+	std::vector<FT_Face> ft_faces(faces.size(), NULL);
+	std::vector<bool> opened(faces.size(), false);
+#ifdef LL_WINDOWS
+	std::vector<llifstream*> file_streams(faces.size(), NULL);
+	std::vector<LLFT_Stream*> ft_streams(faces.size(), NULL);
+#endif
+	auto get_face = [&](U32 i) -> FT_Face
+	{
+		if (!opened[i])
+		{
+			opened[i] = true;
+			const LLPrewarmFace& spec = faces[i];
+			FT_Face face = NULL;
+			// same as loadFace()
+#ifdef LL_WINDOWS
+			S32 error = ft_open_stream_face(library, spec.mFilename, spec.mFaceIndex, &face, file_streams[i], ft_streams[i]);
+#else
+			S32 error = FT_New_Face(library, spec.mFilename.c_str(), spec.mFaceIndex, &face);
+#endif
+			if (!error)
+			{
+				if (FT_Set_Char_Size(face, 0, (S32)(spec.mPointSize * 64), (U32)spec.mHorzDPI, (U32)spec.mVertDPI))
+				{
+					FT_Done_Face(face);
+					face = NULL;
+				}
+				else if (!face->charmap)
+				{
+					FT_Set_Charmap(face, face->charmaps[0]);
+				}
+			}
+			ft_faces[i] = face;
+		}
+		return ft_faces[i];
+	};
+
+	FT_Face primary = get_face(0);
+	for (U32 c = 0; primary && c < wstr.size(); ++c)
+	{
+		llwchar wch = wstr[c];
+
+		// Same lookup order as LLFontFreetype::addGlyph()
+		FT_Face face = primary;
+		FT_UInt glyph_index = FT_Get_Char_Index(primary, wch);
+		for (U32 i = 1; glyph_index == 0 && i < faces.size(); ++i)
+		{
+			FT_Face fallback = get_face(i);
+			if (fallback)
+			{
+				glyph_index = FT_Get_Char_Index(fallback, wch);
+				if (glyph_index)
+				{
+					face = fallback;
+				}
+			}
+		}
+
+		if (FT_Load_Glyph(face, glyph_index, FT_LOAD_FORCE_AUTOHINT)
+			|| FT_Render_Glyph(face->glyph, render_mode))
+		{
+			continue;
+		}
+
+		const FT_Bitmap& bitmap = face->glyph->bitmap;
+		if (bitmap.pixel_mode != FT_PIXEL_MODE_MONO && bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+		{
+			// leave it to the on-demand path
+			continue;
+		}
+
+		glyphs.push_back(LLPrewarmedGlyph());
+		LLPrewarmedGlyph& glyph = glyphs.back();
+		glyph.mChar = wch;
+		glyph.mGlyphIndex = glyph_index;
+		glyph.mWidth = bitmap.width;
+		glyph.mHeight = bitmap.rows;
+		glyph.mXBearing = face->glyph->bitmap_left;
+		glyph.mYBearing = face->glyph->bitmap_top;
+		glyph.mXAdvance = face->glyph->advance.x / 64.f;
+		glyph.mYAdvance = face->glyph->advance.y / 64.f;
+		glyph.mData.resize(glyph.mWidth * glyph.mHeight);
+
+		for (S32 y = 0; y < glyph.mHeight; ++y)
+		{
+			const U8* src = bitmap.buffer + bitmap.pitch * y;
+			U8* dst = glyph.mData.data() + glyph.mWidth * y;
+			if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
+			{
+				for (S32 x = 0; x < glyph.mWidth; ++x)
+				{
+					dst[x] = (src[x / 8] & (1 << (7 - (x % 8)))) ? 255 : 0;
+				}
+			}
+			else
+			{
+				memcpy(dst, src, glyph.mWidth);
+			}
+		}
+	}
+
+	for (FT_Face face : ft_faces)
+	{
+		if (face)
+		{
+			FT_Done_Face(face);
+		}
+	}
+	FT_Done_FreeType(library);
+#ifdef LL_WINDOWS
+	for (U32 i = 0; i < faces.size(); ++i)
+	{
+		delete file_streams[i]; // closed by FT_Done_Face
+		delete ft_streams[i];
+	}
+#endif
+
+	return glyphs;
+}
+
+void LLFontFreetype::prewarmGlyphs(const LLWString& wstr) const
+{
+	if (mFTFace == NULL || mIsFallback)
+		return;
+
+	LLWString missing;
+	for (llwchar wch : wstr)
+	{
+		if (mCharGlyphInfoMap.find(wch) == mCharGlyphInfoMap.end())
+		{
+			missing.push_back(wch);
+		}
+	}
+	if (missing.empty())
+	{
+		return;
+	}
+
+	LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (!main_queue || !general_queue)
+	{
+		return;
+	}
+
+	std::vector<LLPrewarmFace> faces;
+	faces.push_back({ mName, mFaceIndex, mPointSize, mVertDPI, mHorzDPI });
+	for (const LLPointer<LLFontFreetype>& fallback : mFallbackFonts)
+	{
+		faces.push_back({ fallback->mName, fallback->mFaceIndex, fallback->mPointSize, fallback->mVertDPI, fallback->mHorzDPI });
+	}
+
+	FT_Render_Mode render_mode = gFontRenderMode;
+	U32 reset_serial = mResetSerial;
+
+	// Keep this font alive until the results are in.  The reference is
+	// taken and dropped on the main thread; only plain data goes to the worker.
+	ref();
+	try
+	{
+		bool posted = main_queue->postTo(
+			general_queue,
+			[faces, missing, render_mode]()
+			{
+				return rasterize_glyphs(faces, missing, render_mode);
+			},
+			[this, reset_serial](std::vector<LLPrewarmedGlyph> glyphs)
+			{
+				addPrewarmedGlyphs(reset_serial, glyphs);
+				unref();
+			});
+		if (!posted)
+		{
+			unref();
+		}
+	}
+	catch (const LL::WorkQueue::Closed&)
+	{
+		unref();
+	}
+}
+
+void LLFontFreetype::addPrewarmedGlyphs(U32 reset_serial, const std::vector<LLPrewarmedGlyph>& glyphs) const
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
+	if (mFTFace == NULL || reset_serial != mResetSerial)
+	{
+		// rasterized for a size or dpi we no longer use
+		return;
+	}
+
+	for (const LLPrewarmedGlyph& glyph : glyphs)
+	{
+		if (mCharGlyphInfoMap.find(glyph.mChar) != mCharGlyphInfoMap.end())
+		{
+			// drawn while the job was in flight
+			continue;
+		}
+
+		addGlyphBitmap(glyph.mChar,
+					   glyph.mGlyphIndex,
+					   glyph.mWidth,
+					   glyph.mHeight,
+					   glyph.mXBearing,
+					   glyph.mYBearing,
+					   glyph.mXAdvance,
+					   glyph.mYAdvance,
+					   glyph.mData.empty() ? NULL : glyph.mData.data(),
+					   glyph.mWidth);
+		add(sGlyphsPrewarmed, 1);
+	}
+}
+
+void LLFontFreetype::uploadBitmaps() const
+{
+	mFontBitmapCachep->uploadDirty();
+}
+
+//static
+void LLFontFreetype::flushGlyphStats()
+{
+	if (sPendingGlyphCacheHits)
+	{
+		add(sGlyphCacheHits, sPendingGlyphCacheHits);
+		sPendingGlyphCacheHits = 0;
+	}
+}
+
+//static
+void LLFontFreetype::addRecentGlyph(llwchar wch)
+{
+	if (!sRecentGlyphSet.insert(wch).second)
+	{
+		return;
+	}
+
+	sRecentGlyphs.push_back(wch);
+	if (sRecentGlyphs.size() > MAX_RECENT_GLYPHS)
+	{
+		sRecentGlyphSet.erase(sRecentGlyphs.front());
+		sRecentGlyphs.erase(0, 1);
+	}
+}
+
+//static
+void LLFontFreetype::loadRecentGlyphs(const std::string& filename)
+{
+	llifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		return;
+	}
+
+	std::string utf8str((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	LLWString wstr = utf8str_to_wstring(utf8str);
+	for (llwchar wch : wstr)
+	{
+		if (wch > LAST_CHAR_FULL)
+		{
+			addRecentGlyph(wch);
+		}
+	}
+	LL_DEBUGS() << "Loaded " << sRecentGlyphs.size() << " recent glyphs from " << filename << LL_ENDL;
+}
+
+//static
+void LLFontFreetype::saveRecentGlyphs(const std::string& filename)
+{
+	if (sRecentGlyphs.empty())
+	{
+		return;
+	}
+
+	llofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LL_WARNS() << "Unable to save recent glyphs to " << filename << LL_ENDL;
+		return;
+	}
+	file << wstring_to_utf8str(sRecentGlyphs);
+}
+
 void LLFontFreetype::insertGlyphInfo(llwchar wch, LLFontGlyphInfo* gi) const
 {
 	char_glyph_info_map_t::iterator iter = mCharGlyphInfoMap.find(wch);
@@ -623,6 +1005,8 @@ void LLFontFreetype::reset(F32 vert_dpi, F32 horz_dpi)
 
 void LLFontFreetype::resetBitmapCache()
 {
+	mResetSerial++;
+
 	for (char_glyph_info_map_t::iterator it = mCharGlyphInfoMap.begin(), end_it = mCharGlyphInfoMap.end();
 		it != end_it;
 		++it)
@@ -666,7 +1050,7 @@ U8 LLFontFreetype::getStyle() const
 	return mStyle;
 }
 
-void LLFontFreetype::setSubImageLuminanceAlpha(U32 x, U32 y, U32 bitmap_num, U32 width, U32 height, U8 *data, S32 stride) const
+void LLFontFreetype::setSubImageLuminanceAlpha(U32 x, U32 y, U32 bitmap_num, U32 width, U32 height, const U8 *data, S32 stride) const
 {
 	LLImageRaw *image_raw = mFontBitmapCachep->getImageRaw(bitmap_num);
 
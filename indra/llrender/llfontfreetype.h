@@ -28,6 +28,7 @@
 #define LL_LLFONTFREETYPE_H
 
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include "llpointer.h"
 #include "llstl.h"
 
@@ -43,6 +44,8 @@ typedef struct FT_FaceRec_* LLFT_Face;
 struct FT_StreamRec_;
 typedef struct FT_StreamRec_ LLFT_Stream;
 
+struct LLPrewarmedGlyph;
+
 class LLFontManager
 {
 public:
@@ -137,6 +140,25 @@ public:
 
 	LLFontGlyphInfo* getGlyphInfo(llwchar wch) const;
 
+	// Rasterize any of these characters that are not cached yet on the
+	// "General" thread pool, adding them to the bitmap cache from the main
+	// loop once done.  Without a running pool the characters are left to the
+	// usual on-demand path.
+	void prewarmGlyphs(const LLWString& wstr) const;
+
+	// Push glyphs rasterized since the last call to the GL textures
+	void uploadBitmaps() const;
+
+	// Report the glyph cache hits counted since the last call, done once
+	// per string drawn rather than per lookup.
+	static void flushGlyphStats();
+
+	// Non Latin-1 characters this session (plus the loaded list) has needed,
+	// oldest first.  Persisted so the next session can prewarm them.
+	static const LLWString& getRecentGlyphs() { return sRecentGlyphs; }
+	static void loadRecentGlyphs(const std::string& filename);
+	static void saveRecentGlyphs(const std::string& filename);
+
 	void reset(F32 vert_dpi, F32 horz_dpi);
 
 	void destroyGL();
@@ -150,10 +172,14 @@ public:
 
 private:
 	void resetBitmapCache();
-	void setSubImageLuminanceAlpha(U32 x, U32 y, U32 bitmap_num, U32 width, U32 height, U8 *data, S32 stride = 0) const;
+	void setSubImageLuminanceAlpha(U32 x, U32 y, U32 bitmap_num, U32 width, U32 height, const U8 *data, S32 stride = 0) const;
 	BOOL hasGlyph(llwchar wch) const;		// Has a glyph for this character
 	LLFontGlyphInfo* addGlyph(llwchar wch) const;		// Add a new character to the font if necessary
 	LLFontGlyphInfo* addGlyphFromFont(const LLFontFreetype *fontp, llwchar wch, U32 glyph_index) const;	// Add a glyph from this font to the other (returns the glyph_index, 0 if not found)
+	LLFontGlyphInfo* addGlyphBitmap(llwchar wch, U32 glyph_index, S32 width, S32 height, S32 x_bearing, S32 y_bearing,
+									F32 x_advance, F32 y_advance, const U8* buffer_data, S32 buffer_row_stride) const;
+	void addPrewarmedGlyphs(U32 reset_serial, const std::vector<LLPrewarmedGlyph>& glyphs) const;
+	static void addRecentGlyph(llwchar wch);
 	void renderGlyph(U32 glyph_index) const;
 	void insertGlyphInfo(llwchar wch, LLFontGlyphInfo* gi) const;
 
@@ -162,6 +188,9 @@ private:
 	U8 mStyle;
 
 	F32 mPointSize;
+	F32 mVertDPI;
+	F32 mHorzDPI;
+	S32 mFaceIndex;
 	F32 mAscender;			
 	F32 mDescender;
 	F32 mLineHeight;
@@ -183,6 +212,15 @@ private:
 
 	mutable S32 mRenderGlyphCount;
 	mutable S32 mAddGlyphCount;
+
+	// Bumped whenever cached glyphs are thrown away, so prewarm results
+	// rasterized against the old size can be discarded.
+	U32 mResetSerial;
+
+	static LLWString sRecentGlyphs;
+	static boost::unordered_set<llwchar> sRecentGlyphSet;
+
+	static U32 sPendingGlyphCacheHits;
 };
 
 #endif // LL_FONTFREETYPE_H
@@ -71,6 +71,22 @@ std::vector<std::pair<LLCoordGL, F32> > LLFontGL::sOriginStack;
 const F32 PAD_UVY = 0.5f; // half of vertical padding between glyphs in the glyph texture
 const F32 DROP_SHADOW_SOFT_STRENGTH = 0.3f;
 
+// Glyphs are added to the bitmap cache without touching GL, so push any
+// new ones before drawing quads that may reference them.  Uploading binds
+// each dirty texture in turn, so put back the one being drawn from.
+static void upload_glyph_bitmaps(const LLFontFreetype* font, S32 bitmap_num)
+{
+	const LLFontBitmapCache* font_bitmap_cache = font->getFontBitmapCache();
+	if (font_bitmap_cache->hasDirty())
+	{
+		font->uploadBitmaps();
+		if (bitmap_num >= 0)
+		{
+			gGL.getTexUnit(0)->bind(font_bitmap_cache->getImageGL(bitmap_num));
+		}
+	}
+}
+
 LLFontGL::LLFontGL()
 {
 }
@@ -303,6 +319,7 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 			// otherwise the queued glyphs will be taken from wrong textures.
 			if (glyph_count > 0)
 			{
+				upload_glyph_bitmaps(mFontFreetype, bitmap_num);
 				gGL.begin(LLRender::QUADS);
 				{
 					gGL.vertexBatchPreTransformed(vertices, uvs, colors, glyph_count * 4);
@@ -336,6 +353,7 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 		
 		if (glyph_count >= GLYPH_BATCH_SIZE)
 		{
+			upload_glyph_bitmaps(mFontFreetype, bitmap_num);
 			gGL.begin(LLRender::QUADS);
 			{
 				gGL.vertexBatchPreTransformed(vertices, uvs, colors, glyph_count * 4);
@@ -370,6 +388,7 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 		cur_render_y = cur_y;
 	}
 
+	upload_glyph_bitmaps(mFontFreetype, bitmap_num);
 	gGL.begin(LLRender::QUADS);
 	{
 		gGL.vertexBatchPreTransformed(vertices, uvs, colors, glyph_count * 4);
@@ -415,6 +434,8 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 
 	gGL.popUIMatrix();
 
+	LLFontFreetype::flushGlyphStats();
+
 	return chars_drawn;
 }
 
@@ -560,6 +581,11 @@ void LLFontGL::generateASCIIglyphs()
     }
 }
 
+void LLFontGL::prewarmGlyphs(const LLWString& wstr)
+{
+	mFontFreetype->prewarmGlyphs(wstr);
+}
+
 // Returns the max number of complete characters from text (up to max_chars) that can be drawn in max_pixels
 S32 LLFontGL::maxDrawableChars(const llwchar* wchars, F32 max_pixels, S32 max_chars, EWordWrapStyle end_on_word_boundary) const
 {
@@ -891,6 +917,22 @@ void LLFontGL::destroyAllGL()
 	}
 }
 
+// static
+void LLFontGL::loadRecentGlyphs(const std::string& filename)
+{
+	LLFontFreetype::loadRecentGlyphs(filename);
+	if (sFontRegistry)
+	{
+		sFontRegistry->prewarmGlyphs(LLFontFreetype::getRecentGlyphs());
+	}
+}
+
+// static
+void LLFontGL::saveRecentGlyphs(const std::string& filename)
+{
+	LLFontFreetype::saveRecentGlyphs(filename);
+}
+
 // static
 U8 LLFontGL::getStyleFromString(const std::string &style)
 {
@@ -162,6 +162,8 @@ public:
 
 	void generateASCIIglyphs();
 
+	// Rasterize these characters in the background, see LLFontFreetype::prewarmGlyphs()
+	void prewarmGlyphs(const LLWString& wstr);
 
 	static void initClass(F32 screen_dpi, F32 x_scale, F32 y_scale, const std::string& app_dir, bool create_gl_textures = true);
 
@@ -172,6 +174,11 @@ public:
 	static void	destroyDefaultFonts();
 	static void destroyAllGL();
 
+	// Per-user list of non-Latin characters recently drawn, used to prewarm
+	// every font's glyph cache.  Loading queues the prewarm for loaded fonts.
+	static void loadRecentGlyphs(const std::string& filename);
+	static void saveRecentGlyphs(const std::string& filename);
+
 	// Takes a string with potentially several flags, i.e. "NORMAL|BOLD|ITALIC"
 	static U8 getStyleFromString(const std::string &style);
 	static std::string getStringFromStyle(U8 style);
@@ -583,6 +583,22 @@ void LLFontRegistry::destroyGL()
 	}
 }
 
+void LLFontRegistry::prewarmGlyphs(const LLWString& wstr)
+{
+	if (wstr.empty())
+	{
+		return;
+	}
+
+	for (font_reg_map_t::iterator it = mFontMap.begin();
+		 it != mFontMap.end();
+		 ++it)
+	{
+		if (it->second)
+			it->second->prewarmGlyphs(wstr);
+	}
+}
+
 LLFontGL *LLFontRegistry::getFont(const LLFontDescriptor& desc)
 {
 	font_reg_map_t::iterator it = mFontMap.find(desc);
@@ -601,6 +617,8 @@ LLFontGL *LLFontRegistry::getFont(const LLFontDescriptor& desc)
 		{
 			//generate glyphs for ASCII chars to avoid stalls later
 			fontp->generateASCIIglyphs();
+			//and rasterize recently used non-Latin glyphs in the background
+			fontp->prewarmGlyphs(LLFontFreetype::getRecentGlyphs());
 		}
 		return fontp;
 	}
@@ -86,6 +86,9 @@ public:
 
 	// GL cleanup
 	void destroyGL();
+
+	// Queue background rasterization of these characters for all fonts.
+	void prewarmGlyphs(const LLWString& wstr);
 		
 	LLFontGL *getFont(const LLFontDescriptor& desc);
 	const LLFontDescriptor *getMatchingFontDesc(const LLFontDescriptor& desc);
@@ -257,6 +257,11 @@ PFNGLTRANSFORMFEEDBACKVARYINGSPROC glTransformFeedbackVaryings = NULL;
 PFNGLBINDBUFFERRANGEPROC glBindBufferRange = NULL;
 PFNGLBINDBUFFERBASEPROC glBindBufferBase = NULL;
 
+//GL_ARB_get_program_binary (4.1 core)
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = NULL;
+
 //GL_ARB_debug_output
 PFNGLDEBUGMESSAGECONTROLARBPROC glDebugMessageControlARB = NULL;
 PFNGLDEBUGMESSAGEINSERTARBPROC glDebugMessageInsertARB = NULL;
@@ -432,6 +437,7 @@ LLGLManager::LLGLManager() :
 	mHasTextureRectangle(FALSE),
 	mHasTextureMultisample(FALSE),
 	mHasTransformFeedback(FALSE),
+	mHasProgramBinary(FALSE),
 	mMaxSampleMaskWords(0),
 	mMaxColorTextureSamples(0),
 	mMaxDepthTextureSamples(0),
@@ -910,6 +916,7 @@ void LLGLManager::asLLSD(LLSD& info)
 	info["has_texture_rectangle"] = mHasTextureRectangle;
 	info["has_texture_multisample"] = mHasTextureMultisample;
 	info["has_transform_feedback"] = mHasTransformFeedback;
+	info["has_program_binary"] = mHasProgramBinary;
 	info["max_sample_mask_words"] = mMaxSampleMaskWords;
 	info["max_color_texture_samples"] = mMaxColorTextureSamples;
 	info["max_depth_texture_samples"] = mMaxDepthTextureSamples;
@@ -1055,6 +1062,7 @@ void LLGLManager::initExtensions()
 	mHasTextureMultisample = ExtensionExists("GL_ARB_texture_multisample", gGLHExts.mSysExts);
 	mHasDebugOutput = ExtensionExists("GL_ARB_debug_output", gGLHExts.mSysExts);
 	mHasTransformFeedback = mGLVersion >= 4.f ? TRUE : FALSE;
+	mHasProgramBinary = (mGLVersion >= 4.1f || ExtensionExists("GL_ARB_get_program_binary", gGLHExts.mSysExts)) ? TRUE : FALSE;
 #if !LL_DARWIN
 	mHasPointParameters = ExtensionExists("GL_ARB_point_parameters", gGLHExts.mSysExts);
 #endif
@@ -1272,6 +1280,17 @@ void LLGLManager::initExtensions()
 		glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC) GLH_EXT_GET_PROC_ADDRESS("glBindBufferRange");
 		glBindBufferBase = (PFNGLBINDBUFFERBASEPROC) GLH_EXT_GET_PROC_ADDRESS("glBindBufferBase");
 	}
+	if (mHasProgramBinary)
+	{
+		glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) GLH_EXT_GET_PROC_ADDRESS("glGetProgramBinary");
+		glProgramBinary = (PFNGLPROGRAMBINARYPROC) GLH_EXT_GET_PROC_ADDRESS("glProgramBinary");
+		glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) GLH_EXT_GET_PROC_ADDRESS("glProgramParameteri");
+
+		// Some drivers expose the entry points but no binary format to go with them.
+		GLint num_formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+		mHasProgramBinary = (glGetProgramBinary && glProgramBinary && glProgramParameteri && num_formats > 0) ? TRUE : FALSE;
+	}
 	if (mHasDebugOutput)
 	{
 		glDebugMessageControlARB = (PFNGLDEBUGMESSAGECONTROLARBPROC) GLH_EXT_GET_PROC_ADDRESS("glDebugMessageControlARB");
@@ -421,26 +421,57 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     fprintf(stderr, "--- %s ---\n", mName.c_str());
 #endif // DEBUG_SHADER_INCLUDES
 
-    //compile new source
-    vector< pair<string,GLenum> >::iterator fileIter = mShaderFiles.begin();
-    for ( ; fileIter != mShaderFiles.end(); fileIter++ )
+    LLShaderMgr* shader_mgr = LLShaderMgr::instance();
+
+    // attachShaderFeatures() may change the channel count, but the source
+    // is compiled with the one we started with
+    S32 texture_index_channels = mFeatures.mIndexedTextureChannels;
+    bool features_attached = false;
+    mProgramCacheKey = 0;
+    mLoadedFromCache = false;
+
+    if (shader_mgr->isProgramCacheEnabled())
     {
-        GLhandleARB shaderhandle = LLShaderMgr::instance()->loadShaderFile((*fileIter).first, mShaderLevel, (*fileIter).second, &mDefines, mFeatures.mIndexedTextureChannels);
-        LL_DEBUGS("ShaderLoading") << "SHADER FILE: " << (*fileIter).first << " mShaderLevel=" << mShaderLevel << LL_ENDL;
-        if (shaderhandle)
+        // The feature objects are compiled up front and their source is part
+        // of the cache key, so attach them before looking the program up.
+        if (!shader_mgr->attachShaderFeatures(this))
         {
-            attachObject(shaderhandle);
+            return FALSE;
         }
-        else
+        features_attached = true;
+
+        mProgramCacheKey = shader_mgr->getProgramCacheKey(this, texture_index_channels, varying_count, varyings);
+        if (mProgramCacheKey)
         {
-            success = FALSE;
+            // On a miss or a rejected binary the program object is left
+            // unlinked and gets linked from source as usual below.
+            mLoadedFromCache = shader_mgr->loadCachedProgram(this, mProgramCacheKey);
         }
     }
 
-    // Attach existing objects
-    if (!LLShaderMgr::instance()->attachShaderFeatures(this))
+    if (!mLoadedFromCache)
     {
-        return FALSE;
+        //compile new source
+        vector< pair<string,GLenum> >::iterator fileIter = mShaderFiles.begin();
+        for ( ; fileIter != mShaderFiles.end(); fileIter++ )
+        {
+            GLhandleARB shaderhandle = shader_mgr->loadShaderFile((*fileIter).first, mShaderLevel, (*fileIter).second, &mDefines, texture_index_channels);
+            LL_DEBUGS("ShaderLoading") << "SHADER FILE: " << (*fileIter).first << " mShaderLevel=" << mShaderLevel << LL_ENDL;
+            if (shaderhandle)
+            {
+                attachObject(shaderhandle);
+            }
+            else
+            {
+                success = FALSE;
+            }
+        }
+
+        // Attach existing objects
+        if (!features_attached && !shader_mgr->attachShaderFeatures(this))
+        {
+            return FALSE;
+        }
     }
 
     if (gGLManager.mGLSLVersionMajor < 2 && gGLManager.mGLSLVersionMinor < 3)
@@ -450,7 +481,7 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     }
 
 #ifdef GL_INTERLEAVED_ATTRIBS
-    if (varying_count > 0 && varyings)
+    if (varying_count > 0 && varyings && !mLoadedFromCache)
     {
         glTransformFeedbackVaryings(mProgramObject, varying_count, varyings, GL_INTERLEAVED_ATTRIBS);
     }
@@ -465,6 +496,10 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     {
         success = mapUniforms(uniforms);
     }
+    if (success && mProgramCacheKey && !mLoadedFromCache)
+    {
+        shader_mgr->saveCachedProgram(this, mProgramCacheKey);
+    }
     if( !success )
     {
         LL_SHADER_LOADING_WARNS() << "Failed to link shader: " << mName << LL_ENDL;
@@ -593,15 +628,28 @@ BOOL LLGLSLShader::mapAttributes(const std::vector<LLStaticHashedString> * attri
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
 
-    //before linking, make sure reserved attributes always have consistent locations
-    for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
+    // a program loaded from the binary cache is already linked, with the
+    // attribute locations it was linked with
+    BOOL res = TRUE;
+    if (!mLoadedFromCache)
     {
-        const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
-        glBindAttribLocationARB(mProgramObject, i, (const GLcharARB *) name);
+        //before linking, make sure reserved attributes always have consistent locations
+        for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
+        {
+            const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
+            glBindAttribLocationARB(mProgramObject, i, (const GLcharARB *) name);
+        }
+
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+        if (mProgramCacheKey)
+        {
+            glProgramParameteri(mProgramObject, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+#endif
+
+        //link the program
+        res = link();
     }
-    
-    //link the program
-    BOOL res = link();
 
     mAttribute.clear();
     U32 numAttributes = (attributes == NULL) ? 0 : attributes->size();
@@ -290,6 +290,11 @@ public:
     // this pointer should be set to whichever shader represents this shader's rigged variant
     LLGLSLShader* mRiggedVariant = nullptr;
 
+    // program binary cache key of the current link, 0 if not cached
+    U64 mProgramCacheKey = 0;
+    // true if the program came out of the binary cache instead of being linked
+    bool mLoadedFromCache = false;
+
 private:
 	void unloadInternal();
 };
@@ -28,6 +28,8 @@
 #include "llshadermgr.h"
 #include "llrender.h"
 #include "llfile.h"
+#include "lldir.h"
+#include "hbxxh.h"
 
 #if LL_DARWIN
 #include "OpenGL/OpenGL.h"
@@ -41,7 +43,27 @@ using std::string;
 
 LLShaderMgr * LLShaderMgr::sInstance = NULL;
 
+static const U32 PROGRAM_CACHE_MAGIC = 0x42504c47;	// "GLPB"
+static const U32 PROGRAM_CACHE_VERSION = 1;
+static const std::string PROGRAM_CACHE_EXT(".glpb");
+
+// Header of a program cache file; the binary follows it.
+struct LLProgramCacheHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U64 mKey;
+	U32 mFormat;
+	S32 mShaderLevel;
+	S32 mIndexedTextureChannels;
+	U32 mLength;
+};
+
 LLShaderMgr::LLShaderMgr()
+:	mProgramCacheHits(0),
+	mProgramCacheMisses(0),
+	mProgramCacheRejects(0),
+	mProgramCacheEnabled(false)
 {
 }
 
@@ -1012,6 +1034,16 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 	}
 	stop_glerror();
 
+	if (ret)
+	{
+		HBXXH64 hash;
+		for (GLuint i = 0; i < shader_code_count; i++)
+		{
+			hash.update(shader_code_text[i], strlen(shader_code_text[i]));
+		}
+		mShaderObjectDigests[ret] = hash.digest();
+	}
+
 	//free memory
 	for (GLuint i = 0; i < shader_code_count; i++)
 	{
@@ -1065,6 +1097,252 @@ BOOL LLShaderMgr::linkProgramObject(GLhandleARB obj, BOOL suppress_errors)
 	return success;
 }
 
+void LLShaderMgr::setProgramCacheEnabled(bool enabled)
+{
+#ifdef GL_PROGRAM_BINARY_LENGTH
+	mProgramCacheEnabled = enabled && gGLManager.mHasProgramBinary && !getProgramCacheDir().empty();
+#else
+	mProgramCacheEnabled = false;
+#endif
+}
+
+void LLShaderMgr::resetProgramCacheStats()
+{
+	mProgramCacheHits = 0;
+	mProgramCacheMisses = 0;
+	mProgramCacheRejects = 0;
+}
+
+std::string LLShaderMgr::getProgramCacheFilename(U64 key)
+{
+	return getProgramCacheDir() + gDirUtilp->getDirDelimiter()
+		+ llformat("%016llx", (unsigned long long)key) + PROGRAM_CACHE_EXT;
+}
+
+U64 LLShaderMgr::getShaderFileDigest(const std::string& filename, S32 shader_level)
+{
+	// Same search as loadShaderFile(); a missing file is remembered as 0.
+	for (S32 gpu_class = shader_level; gpu_class > 0; gpu_class--)
+	{
+		std::string path = llformat("%s%d/%s", getShaderDirPrefix().c_str(), gpu_class, filename.c_str());
+		std::map<std::string, U64>::iterator it = mShaderFileDigests.find(path);
+		if (it == mShaderFileDigests.end())
+		{
+			U64 digest = 0;
+			LLFILE* file = LLFile::fopen(path, "rb");
+			if (file)
+			{
+				HBXXH64 hash;
+				hash.update(file);
+				LLFile::close(file);
+				// never 0, so that a found file can't look missing
+				digest = hash.digest() | 1;
+			}
+			it = mShaderFileDigests.insert(std::make_pair(path, digest)).first;
+		}
+		if (it->second)
+		{
+			return it->second;
+		}
+	}
+	return 0;
+}
+
+U64 LLShaderMgr::getProgramCacheKey(LLGLSLShader* shader, S32 texture_index_channels, U32 varying_count, const char** varyings)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+	HBXXH64 hash;
+	hash.update(&PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION));
+
+	// a driver update can change the binary format without changing its id
+	hash.update(gGLManager.mGLVendor);
+	hash.update(gGLManager.mGLRenderer);
+	hash.update(gGLManager.mGLVersionString);
+	hash.update(&gGLManager.mGLSLVersionMajor, sizeof(S32));
+	hash.update(&gGLManager.mGLSLVersionMinor, sizeof(S32));
+
+	hash.update(&shader->mShaderLevel, sizeof(S32));
+	hash.update(&texture_index_channels, sizeof(S32));
+	hash.update(&shader->mFeatures.mIndexedTextureChannels, sizeof(S32));
+
+	for (const auto& file : shader->mShaderFiles)
+	{
+		U64 digest = getShaderFileDigest(file.first, shader->mShaderLevel);
+		if (!digest)
+		{
+			return 0;
+		}
+		hash.update(file.first);
+		hash.update(&file.second, sizeof(file.second));
+		hash.update(&digest, sizeof(digest));
+	}
+
+	// mDefines is unordered, so sort it first
+	std::map<std::string, std::string> defines(shader->mDefines.begin(), shader->mDefines.end());
+	for (const auto& define : defines)
+	{
+		hash.update(define.first + "=" + define.second + "\n");
+	}
+	for (const auto& define : mDefinitions)
+	{
+		hash.update(define.first + "=" + define.second + "\n");
+	}
+
+	for (const std::string& attrib : mReservedAttribs)
+	{
+		hash.update(attrib + "\n");
+	}
+
+	for (U32 i = 0; i < varying_count && varyings; ++i)
+	{
+		hash.update(std::string(varyings[i]) + "\n");
+	}
+
+	// the feature objects attached so far, in attach order
+	GLhandleARB obj[1024];
+	GLsizei count = 0;
+	glGetAttachedObjectsARB(shader->mProgramObject, 1024, &count, obj);
+	for (GLsizei i = 0; i < count; i++)
+	{
+		std::map<GLhandleARB, U64>::iterator it = mShaderObjectDigests.find(obj[i]);
+		if (it == mShaderObjectDigests.end())
+		{
+			return 0;
+		}
+		hash.update(&it->second, sizeof(U64));
+	}
+
+	U64 key = hash.digest();
+	return key ? key : 1;
+}
+
+bool LLShaderMgr::loadCachedProgram(LLGLSLShader* shader, U64 key)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+	std::string filename = getProgramCacheFilename(key);
+	LLFILE* file = LLFile::fopen(filename, "rb");
+	if (!file)
+	{
+		++mProgramCacheMisses;
+		return false;
+	}
+
+	LLProgramCacheHeader header;
+	std::vector<U8> binary;
+	bool success = fread(&header, sizeof(header), 1, file) == 1
+		&& header.mMagic == PROGRAM_CACHE_MAGIC
+		&& header.mVersion == PROGRAM_CACHE_VERSION
+		&& header.mKey == key
+		&& header.mLength > 0;
+	if (success)
+	{
+		binary.resize(header.mLength);
+		success = fread(&binary[0], 1, header.mLength, file) == header.mLength;
+	}
+	LLFile::close(file);
+
+#ifdef GL_PROGRAM_BINARY_LENGTH
+	if (success)
+	{
+		glProgramBinary(shader->mProgramObject, header.mFormat, &binary[0], header.mLength);
+		GLint linked = GL_FALSE;
+		glGetObjectParameterivARB(shader->mProgramObject, GL_OBJECT_LINK_STATUS_ARB, &linked);
+		success = linked == GL_TRUE;
+		// a rejected binary is not an error, so don't leave one behind
+		glGetError();
+	}
+#else
+	success = false;
+#endif
+
+	if (!success)
+	{
+		// damaged, or the driver no longer accepts it
+		LL_INFOS("ShaderLoading") << "Discarding cached program for " << shader->mName << LL_ENDL;
+		LLFile::remove(filename);
+		++mProgramCacheRejects;
+		return false;
+	}
+
+	shader->mShaderLevel = header.mShaderLevel;
+	shader->mFeatures.mIndexedTextureChannels = header.mIndexedTextureChannels;
+	++mProgramCacheHits;
+	return true;
+}
+
+void LLShaderMgr::saveCachedProgram(LLGLSLShader* shader, U64 key)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+#ifdef GL_PROGRAM_BINARY_LENGTH
+	GLint length = 0;
+	glGetObjectParameterivARB(shader->mProgramObject, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+
+	LLProgramCacheHeader header;
+	header.mMagic = PROGRAM_CACHE_MAGIC;
+	header.mVersion = PROGRAM_CACHE_VERSION;
+	header.mKey = key;
+	header.mFormat = 0;
+	header.mShaderLevel = shader->mShaderLevel;
+	header.mIndexedTextureChannels = shader->mFeatures.mIndexedTextureChannels;
+
+	std::vector<U8> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	glGetProgramBinary(shader->mProgramObject, length, &written, &format, &binary[0]);
+	if (glGetError() != GL_NO_ERROR || written <= 0)
+	{
+		return;
+	}
+	header.mFormat = format;
+	header.mLength = written;
+
+	std::string dir = getProgramCacheDir();
+	if (!LLFile::isdir(dir))
+	{
+		LLFile::mkdir(dir);
+	}
+
+	// Write aside and rename, so that a crash never leaves half a binary
+	// for the driver to choke on.
+	std::string filename = getProgramCacheFilename(key);
+	std::string temp_filename = filename + ".tmp";
+	LLFILE* file = LLFile::fopen(temp_filename, "wb");
+	if (!file)
+	{
+		return;
+	}
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(&binary[0], 1, written, file) == (size_t)written;
+	LLFile::close(file);
+
+	if (success)
+	{
+		LLFile::remove(filename, ENOENT);
+		success = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!success)
+	{
+		LLFile::remove(temp_filename);
+	}
+#endif
+}
+
+void LLShaderMgr::clearProgramCache()
+{
+	std::string dir = getProgramCacheDir();
+	if (!dir.empty() && LLFile::isdir(dir))
+	{
+		gDirUtilp->deleteFilesInDir(dir, "*" + PROGRAM_CACHE_EXT);
+	}
+}
+
 BOOL LLShaderMgr::validateProgramObject(GLhandleARB obj)
 {
 	//check program validity against current GL
@@ -272,11 +272,44 @@ public:
 	// Implemented in the application to actually update out of date uniforms for a particular shader
 	virtual void updateShaderUniforms(LLGLSLShader * shader) = 0; // Pure Virtual
 
+	// Implemented in the application to point to the directory linked program
+	// binaries are cached in; an empty string disables the cache.
+	virtual std::string getProgramCacheDir(void) { return std::string(); }
+
+	// Program binary cache.  The key covers the source of every shader object
+	// that goes into the program, the defines, the shader level and the GL
+	// driver, so a cached binary is only ever reused for an identical link.
+	// Returns 0 if the program can't be cached.
+	U64 getProgramCacheKey(LLGLSLShader* shader, S32 texture_index_channels, U32 varying_count, const char** varyings);
+	// Loads the cached binary into shader->mProgramObject.  Returns false if
+	// there is none or the driver rejected it, in which case the program
+	// object must be linked from source (and the stale file is gone).
+	bool loadCachedProgram(LLGLSLShader* shader, U64 key);
+	void saveCachedProgram(LLGLSLShader* shader, U64 key);
+	void clearProgramCache();
+	bool isProgramCacheEnabled() const { return mProgramCacheEnabled; }
+	void setProgramCacheEnabled(bool enabled);
+	void resetProgramCacheStats();
+
+private:
+	std::string getProgramCacheFilename(U64 key);
+	U64 getShaderFileDigest(const std::string& filename, S32 shader_level);
+
 public:
 	// Map of shader names to compiled
     std::map<std::string, GLhandleARB> mVertexShaderObjects;
     std::map<std::string, GLhandleARB> mFragmentShaderObjects;
 
+	// Digest of the preprocessed source of each compiled shader object, and
+	// of the raw shader files read so far, for the program cache key.
+	std::map<GLhandleARB, U64> mShaderObjectDigests;
+	std::map<std::string, U64> mShaderFileDigests;
+
+	// Program cache counters since the last resetProgramCacheStats()
+	U32 mProgramCacheHits;
+	U32 mProgramCacheMisses;
+	U32 mProgramCacheRejects;
+
 	//global (reserved slot) shader parameters
 	std::vector<std::string> mReservedAttribs;
 
@@ -290,6 +323,8 @@ protected:
 	// our parameter manager singleton instance
 	static LLShaderMgr * sInstance;
 
+	bool mProgramCacheEnabled;
+
 }; //LLShaderMgr
 
 #endif
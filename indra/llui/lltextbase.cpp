@@ -1607,6 +1607,16 @@ void LLTextBase::reflow()
 		S32 start_index = mReflowIndex;
 		mReflowIndex = S32_MAX;
 
+		LLRect old_doc_rect = mDocumentView->getRect();
+
+		// where the inline widgets sat before this pass, see below
+		std::vector<std::pair<LLView*, LLRect> > old_child_rects;
+		old_child_rects.reserve(mDocumentView->getChildCount());
+		for (LLView* childp : *mDocumentView->getChildList())
+		{
+			old_child_rects.push_back(std::make_pair(childp, childp->getRect()));
+		}
+
 		// shrink document to minimum size (visible portion of text widget)
 		// to force inlined widgets with follows set to shrink
 		if (mWordWrap)
@@ -1628,6 +1638,11 @@ void LLTextBase::reflow()
 		{
 			// find first element whose end comes after start_index
 			line_list_t::iterator iter = std::upper_bound(mLineInfoList.begin(), mLineInfoList.end(), start_index, line_end_compare());
+			if (iter == mLineInfoList.end())
+			{
+				// appending past the end of the laid out text, only the last line can change
+				--iter;
+			}
             if (iter != mLineInfoList.end())
             {
                 line_start_index = iter->mDocIndexStart;
@@ -1638,6 +1653,9 @@ void LLTextBase::reflow()
             }
 		}
 
+		// first character whose layout may change
+		const S32 reflow_start_index = line_start_index;
+
 		S32 line_height = 0;
 		S32 seg_line_offset = line_count + 1;
 
@@ -1679,11 +1697,7 @@ void LLTextBase::reflow()
 			if (last_segment_char_on_line < segment->getEnd())
 			{
 				// add line info and keep going
-				mLineInfoList.push_back(line_info(
-											line_start_index, 
-											last_segment_char_on_line, 
-											line_rect, 
-											line_count));
+				appendLineInfo(line_start_index, last_segment_char_on_line, line_rect, line_count);
 
 				line_start_index = segment->getStart() + seg_offset;
 				cur_top -= ll_round((F32)line_height * mLineSpacingMult) + mLineSpacingPixels;
@@ -1693,11 +1707,7 @@ void LLTextBase::reflow()
 			// ...just consumed last segment..
 			else if (++segment_set_t::iterator(seg_iter) == mSegments.end())
 			{
-				mLineInfoList.push_back(line_info(
-											line_start_index, 
-											last_segment_char_on_line, 
-											line_rect, 
-											line_count));
+				appendLineInfo(line_start_index, last_segment_char_on_line, line_rect, line_count);
 				cur_top -= ll_round((F32)line_height * mLineSpacingMult) + mLineSpacingPixels;
 				break;
 			}
@@ -1707,11 +1717,7 @@ void LLTextBase::reflow()
 				// subtract pixels used and increment segment
 				if (force_newline)
 				{
-					mLineInfoList.push_back(line_info(
-												line_start_index, 
-												last_segment_char_on_line, 
-												line_rect, 
-												line_count));
+					appendLineInfo(line_start_index, last_segment_char_on_line, line_rect, line_count);
 					line_start_index = segment->getStart() + seg_offset;
 					cur_top -= ll_round((F32)line_height * mLineSpacingMult) + mLineSpacingPixels;
 					line_height = 0;
@@ -1727,16 +1733,35 @@ void LLTextBase::reflow()
 			}
 		}
 
+		S32 old_first_line_top = mLineInfoList.empty() ? 0 : mLineInfoList.front().mRect.mTop;
+
 		// calculate visible region for diplaying text
 		updateRects();
 
-		for (segment_set_t::iterator segment_it = mSegments.begin();
-			segment_it != mSegments.end();
-			++segment_it)
+		// Lines ahead of the reflowed ones keep their layout.  updateRects()
+		// may still have moved all of them vertically, e.g. when an append
+		// grows the document, so their widgets are moved by the same amount
+		// instead of laying out every segment of a long log again.
+		segment_set_t::iterator segment_it = mSegments.begin();
+		const LLRect& new_doc_rect = mDocumentView->getRect();
+		if (reflow_start_index > 0
+			&& new_doc_rect.mLeft == old_doc_rect.mLeft
+			&& new_doc_rect.mRight == old_doc_rect.mRight
+			&& !mLineInfoList.empty())
+		{
+			S32 delta_y = mLineInfoList.front().mRect.mTop - old_first_line_top;
+			for (std::pair<LLView*, LLRect>& child_rect : old_child_rects)
+			{
+				// undoes any follows-top shift from resizing the document too
+				child_rect.first->setOrigin(child_rect.second.mLeft, child_rect.second.mBottom + delta_y);
+			}
+			segment_it = getSegIterContaining(reflow_start_index);
+		}
+
+		for (; segment_it != mSegments.end(); ++segment_it)
 		{
 			LLTextSegmentPtr segmentp = *segment_it;
 			segmentp->updateLayout(*this);
-
 		}
 	}
 
@@ -1776,6 +1801,24 @@ void LLTextBase::reflow()
 	updateCursorXPos();
 }
 
+void LLTextBase::appendLineInfo(S32 index_start, S32 index_end, const LLRect& rect, S32 line_num)
+{
+	line_info line(index_start, index_end, rect, line_num);
+
+	// keep a running union of the line rects so updateRects() does not have to walk every line
+	line.mBoundsToHere = rect;
+	if (!mLineInfoList.empty())
+	{
+		const line_info& prev_line = mLineInfoList.back();
+		LLRect prev_bounds = prev_line.mBoundsToHere;
+		prev_bounds.translate(0, prev_line.mRect.mTop);
+		line.mBoundsToHere.unionWith(prev_bounds);
+	}
+	line.mBoundsToHere.translate(0, -rect.mTop);
+
+	mLineInfoList.push_back(line);
+}
+
 LLRect LLTextBase::getTextBoundingRect()
 {
 	reflow();
@@ -2960,13 +3003,9 @@ void LLTextBase::updateRects()
 	}
 	else
 	{
-		mTextBoundingRect = mLineInfoList.begin()->mRect;
-		for (line_list_t::const_iterator line_iter = ++mLineInfoList.begin();
-			line_iter != mLineInfoList.end();
-			++line_iter)
-		{
-			mTextBoundingRect.unionWith(line_iter->mRect);
-		}
+		const line_info& last_line = mLineInfoList.back();
+		mTextBoundingRect = last_line.mBoundsToHere;
+		mTextBoundingRect.translate(0, last_line.mRect.mTop);
 
 		mTextBoundingRect.mTop += mVPad;
 
@@ -2988,11 +3027,14 @@ void LLTextBase::updateRects()
 			break;
 		}
 		// move line segments to fit new document rect
-		for (line_list_t::iterator it = mLineInfoList.begin(); it != mLineInfoList.end(); ++it)
+		if (delta_pos != 0)
 		{
-			it->mRect.translate(0, delta_pos);
+			for (line_list_t::iterator it = mLineInfoList.begin(); it != mLineInfoList.end(); ++it)
+			{
+				it->mRect.translate(0, delta_pos);
+			}
+			mTextBoundingRect.translate(0, delta_pos);
 		}
-		mTextBoundingRect.translate(0, delta_pos);
 	}
 
 	// update document container dimensions according to text contents
@@ -500,6 +500,7 @@ protected:
 		S32 mDocIndexEnd;
 		LLRect mRect;
 		S32 mLineNum; // actual line count (ignoring soft newlines due to word wrap)
+		LLRect mBoundsToHere; // union of this and all previous line rects, relative to mRect.mTop so it survives vertical shifts
 	};
 	typedef std::vector<line_info> line_list_t;
 	
@@ -606,6 +607,7 @@ protected:
 	std::pair<S32, S32>				getVisibleLines(bool fully_visible = false);
 	S32								getLeftOffset(S32 width);
 	void							reflow();
+	void							appendLineInfo(S32 index_start, S32 index_end, const LLRect& rect, S32 line_num);
 
 	// cursor
 	void							updateCursorXPos();
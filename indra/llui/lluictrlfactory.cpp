@@ -30,6 +30,7 @@
 #include "lluictrlfactory.h"
 
 #include "llxmlnode.h"
+#include "llxuicache.h"
 
 #include <fstream>
 #include <boost/tokenizer.hpp>
@@ -102,7 +103,7 @@ void LLUICtrlFactory::loadWidgetTemplate(const std::string& widget_tag, LLInitPa
 	{
 		LLUICtrlFactory::instance().pushFileName(base_filename);
 
-		if (!LLXMLNode::getLayeredXMLNode(root_node, search_paths))
+		if (!LLXUICache::getLayeredXMLNode(root_node, search_paths))
 		{
 			LL_WARNS() << "Couldn't parse widget from: " << base_filename << LL_ENDL;
 			return;
@@ -169,7 +170,7 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNo
 		paths.push_back(xui_filename);
 	}
 
-	return LLXMLNode::getLayeredXMLNode(root, paths);
+	return LLXUICache::getLayeredXMLNode(root, paths);
 }
 
 
@@ -0,0 +1,415 @@
+/**
+ * @file llxuicache.cpp
+ * @brief Implementation of LLXUICache class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llxuicache.h"
+
+#include "hbxxh.h"
+#include "lldir.h"
+#include "llfile.h"
+
+static const U32 XUI_CACHE_MAGIC = 0x43495558;	// "XUIC"
+static const U32 XUI_CACHE_VERSION = 1;
+static const std::string XUI_CACHE_DIR("xui");
+static const std::string XUI_CACHE_EXT(".xuic");
+
+// static
+bool LLXUICache::sEnabled = true;
+
+namespace
+{
+	// Cache files are read whole and decoded from memory; every read is
+	// bounds checked so that a truncated or damaged file just misses.
+	class Reader
+	{
+	public:
+		Reader(const std::vector<U8>& data) : mData(data), mPos(0), mOK(true) {}
+
+		bool ok() const { return mOK; }
+		bool atEnd() const { return mPos == mData.size(); }
+
+		template<typename T> T read()
+		{
+			T value = T();
+			if (mPos + sizeof(T) > mData.size())
+			{
+				mOK = false;
+				return value;
+			}
+			memcpy(&value, &mData[mPos], sizeof(T));
+			mPos += sizeof(T);
+			return value;
+		}
+
+		void readString(std::string& str)
+		{
+			U32 len = read<U32>();
+			if (!mOK || mPos + len > mData.size())
+			{
+				mOK = false;
+				str.clear();
+				return;
+			}
+			str.assign((const char*)&mData[mPos], len);
+			mPos += len;
+		}
+
+	private:
+		const std::vector<U8>&	mData;
+		size_t					mPos;
+		bool					mOK;
+	};
+
+	class Writer
+	{
+	public:
+		template<typename T> void write(const T& value)
+		{
+			const U8* bytes = (const U8*)&value;
+			mData.insert(mData.end(), bytes, bytes + sizeof(T));
+		}
+
+		void writeString(const std::string& str)
+		{
+			write<U32>((U32)str.size());
+			mData.insert(mData.end(), str.begin(), str.end());
+		}
+
+		const std::vector<U8>& data() const { return mData; }
+
+	private:
+		std::vector<U8> mData;
+	};
+
+	bool read_file(const std::string& filename, std::vector<U8>& data)
+	{
+		LLFILE* fp = LLFile::fopen(filename, "rb");
+		if (!fp)
+		{
+			return false;
+		}
+		fseek(fp, 0, SEEK_END);
+		long size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		bool success = size >= 0;
+		if (success)
+		{
+			data.resize(size);
+			success = size == 0 || fread(&data[0], 1, size, fp) == (size_t)size;
+		}
+		LLFile::close(fp);
+		return success;
+	}
+
+	// Size, modification time and content digest of one source file.
+	struct SourceStamp
+	{
+		U64 mSize;
+		U64 mTime;
+		U64 mDigest;
+	};
+
+	bool stat_source(const std::string& filename, SourceStamp& stamp)
+	{
+		llstat stat_data;
+		if (LLFile::stat(filename, &stat_data))
+		{
+			return false;
+		}
+		stamp.mSize = (U64)stat_data.st_size;
+		stamp.mTime = (U64)stat_data.st_mtime;
+		stamp.mDigest = 0;
+		return true;
+	}
+
+	bool digest_source(const std::string& filename, U64& digest)
+	{
+		std::vector<U8> data;
+		if (!read_file(filename, data))
+		{
+			return false;
+		}
+		digest = HBXXH64::digest(data.empty() ? NULL : &data[0], data.size());
+		return true;
+	}
+
+	void write_node(Writer& out, LLXMLNode* node)
+	{
+		out.writeString(node->getName() ? node->getName()->mString : "");
+		out.write<U8>(node->mIsAttribute ? 1 : 0);
+		out.writeString(node->mID);
+		out.writeString(node->getValue());
+		out.write<U8>((U8)node->mType);
+		out.write<U8>((U8)node->mEncoding);
+		out.write<U32>(node->mLength);
+		out.write<U32>(node->mPrecision);
+		out.write<U32>(node->mVersionMajor);
+		out.write<U32>(node->mVersionMinor);
+		out.write<S32>(node->mLineNumber);
+
+		out.write<U32>((U32)node->mAttributes.size());
+		for (LLXMLAttribList::iterator it = node->mAttributes.begin(); it != node->mAttributes.end(); ++it)
+		{
+			write_node(out, it->second);
+		}
+
+		U32 child_count = 0;
+		for (LLXMLNodePtr child = node->mChildren.notNull() ? node->mChildren->head : LLXMLNodePtr(); child.notNull(); child = child->mNext)
+		{
+			++child_count;
+		}
+		out.write<U32>(child_count);
+		for (LLXMLNodePtr child = node->mChildren.notNull() ? node->mChildren->head : LLXMLNodePtr(); child.notNull(); child = child->mNext)
+		{
+			write_node(out, child);
+		}
+	}
+
+	LLXMLNodePtr read_node(Reader& in, S32 depth)
+	{
+		// XUI files nest a few dozen levels at most; anything deeper is damage.
+		if (depth > 256)
+		{
+			return LLXMLNodePtr();
+		}
+
+		std::string name;
+		in.readString(name);
+		BOOL is_attribute = in.read<U8>() ? TRUE : FALSE;
+		if (!in.ok())
+		{
+			return LLXMLNodePtr();
+		}
+
+		LLXMLNodePtr node = new LLXMLNode(name.c_str(), is_attribute);
+		in.readString(node->mID);
+		std::string value;
+		in.readString(value);
+		node->setValue(value);
+		node->mType = (LLXMLNode::ValueType)in.read<U8>();
+		node->mEncoding = (LLXMLNode::Encoding)in.read<U8>();
+		node->mLength = in.read<U32>();
+		node->mPrecision = in.read<U32>();
+		node->mVersionMajor = in.read<U32>();
+		node->mVersionMinor = in.read<U32>();
+		node->setLineNumber(in.read<S32>());
+
+		U32 attribute_count = in.read<U32>();
+		for (U32 i = 0; i < attribute_count && in.ok(); ++i)
+		{
+			LLXMLNodePtr attribute = read_node(in, depth + 1);
+			if (attribute.isNull())
+			{
+				return LLXMLNodePtr();
+			}
+			node->addChild(attribute);
+		}
+
+		U32 child_count = in.read<U32>();
+		for (U32 i = 0; i < child_count && in.ok(); ++i)
+		{
+			LLXMLNodePtr child = read_node(in, depth + 1);
+			if (child.isNull())
+			{
+				return LLXMLNodePtr();
+			}
+			node->addChild(child);
+		}
+
+		return in.ok() ? node : LLXMLNodePtr();
+	}
+
+	// Parsing depends on these, so they are part of the cache key.
+	U32 get_parse_flags()
+	{
+		return (LLXMLNode::sStripEscapedStrings ? 1 : 0) | (LLXMLNode::sStripWhitespaceValues ? 2 : 0);
+	}
+}
+
+// static
+bool LLXUICache::getLayeredXMLNode(LLXMLNodePtr& root, const std::vector<std::string>& paths)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
+
+	if (!sEnabled || paths.empty() || paths.front().empty())
+	{
+		return LLXMLNode::getLayeredXMLNode(root, paths);
+	}
+
+	const std::string cache_filename = getCacheFilename(paths);
+	if (readCache(cache_filename, paths, root))
+	{
+		return true;
+	}
+
+	if (!LLXMLNode::getLayeredXMLNode(root, paths))
+	{
+		return false;
+	}
+
+	writeCache(cache_filename, paths, root);
+	return true;
+}
+
+// static
+void LLXUICache::clear()
+{
+	std::string dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, XUI_CACHE_DIR);
+	if (LLFile::isdir(dir))
+	{
+		gDirUtilp->deleteFilesInDir(dir, "*" + XUI_CACHE_EXT);
+	}
+}
+
+// static
+std::string LLXUICache::getCacheFilename(const std::vector<std::string>& paths)
+{
+	// The path list already encodes the skin and the language.
+	HBXXH64 hash;
+	for (const std::string& path : paths)
+	{
+		hash.update(path);
+		hash.update("\n", 1);
+	}
+	return gDirUtilp->getExpandedFilename(LL_PATH_CACHE, XUI_CACHE_DIR,
+										  llformat("%016llx", (unsigned long long)hash.digest()) + XUI_CACHE_EXT);
+}
+
+// static
+bool LLXUICache::readCache(const std::string& cache_filename, const std::vector<std::string>& paths, LLXMLNodePtr& root)
+{
+	std::vector<U8> data;
+	if (!read_file(cache_filename, data))
+	{
+		return false;
+	}
+
+	Reader in(data);
+	if (in.read<U32>() != XUI_CACHE_MAGIC
+		|| in.read<U32>() != XUI_CACHE_VERSION
+		|| in.read<U32>() != get_parse_flags())
+	{
+		return false;
+	}
+
+	U32 source_count = in.read<U32>();
+	if (!in.ok() || source_count != paths.size())
+	{
+		return false;
+	}
+
+	std::string path;
+	for (U32 i = 0; i < source_count; ++i)
+	{
+		in.readString(path);
+		SourceStamp cached;
+		cached.mSize = in.read<U64>();
+		cached.mTime = in.read<U64>();
+		cached.mDigest = in.read<U64>();
+		if (!in.ok() || path != paths[i])
+		{
+			return false;
+		}
+		if (path.empty())
+		{
+			continue;
+		}
+
+		SourceStamp current;
+		if (!stat_source(path, current) || current.mSize != cached.mSize)
+		{
+			return false;
+		}
+		if (current.mTime != cached.mTime
+			&& (!digest_source(path, current.mDigest) || current.mDigest != cached.mDigest))
+		{
+			return false;
+		}
+	}
+
+	LLXMLNodePtr node = read_node(in, 0);
+	if (node.isNull() || !in.atEnd())
+	{
+		LL_WARNS() << "Discarding damaged XUI cache file " << cache_filename << LL_ENDL;
+		LLFile::remove(cache_filename);
+		return false;
+	}
+
+	root = node;
+	return true;
+}
+
+// static
+void LLXUICache::writeCache(const std::string& cache_filename, const std::vector<std::string>& paths, LLXMLNode* root)
+{
+	Writer out;
+	out.write<U32>(XUI_CACHE_MAGIC);
+	out.write<U32>(XUI_CACHE_VERSION);
+	out.write<U32>(get_parse_flags());
+	out.write<U32>((U32)paths.size());
+	for (const std::string& path : paths)
+	{
+		SourceStamp stamp = { 0, 0, 0 };
+		if (!path.empty()
+			&& (!stat_source(path, stamp) || !digest_source(path, stamp.mDigest)))
+		{
+			return;
+		}
+		out.writeString(path);
+		out.write<U64>(stamp.mSize);
+		out.write<U64>(stamp.mTime);
+		out.write<U64>(stamp.mDigest);
+	}
+	write_node(out, root);
+
+	std::string dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, XUI_CACHE_DIR);
+	if (!LLFile::isdir(dir))
+	{
+		LLFile::mkdir(dir);
+	}
+
+	// Write aside and rename, so a second viewer instance never reads half a file.
+	std::string temp_filename = cache_filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+	if (!fp)
+	{
+		return;
+	}
+	const std::vector<U8>& data = out.data();
+	bool success = fwrite(&data[0], 1, data.size(), fp) == data.size();
+	LLFile::close(fp);
+
+	if (success)
+	{
+		LLFile::remove(cache_filename, ENOENT);
+		success = LLFile::rename(temp_filename, cache_filename) == 0;
+	}
+	if (!success)
+	{
+		LLFile::remove(temp_filename);
+	}
+}
@@ -0,0 +1,62 @@
+/**
+ * @file llxuicache.h
+ * @brief On-disk cache of parsed and layered XUI files.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLXUICACHE_H
+#define LL_LLXUICACHE_H
+
+#include "llxmlnode.h"
+
+// Every floater, panel and widget template is read through
+// LLXMLNode::getLayeredXMLNode(), which runs expat over the default skin
+// file and then over each skin and language override and merges them.
+// LLXUICache keeps the merged tree in a compact binary file, one per list
+// of source files, so later loads only have to rebuild the nodes.
+//
+// A cache file is used only if every source file still has the size and
+// modification time it had when the cache was written, or, failing the
+// time check, the same content digest.  Anything else falls back to the
+// XML and rewrites the cache.
+class LLXUICache
+{
+public:
+	// Drop-in replacement for LLXMLNode::getLayeredXMLNode().
+	static bool getLayeredXMLNode(LLXMLNodePtr& root, const std::vector<std::string>& paths);
+
+	static void setEnabled(bool enabled) { sEnabled = enabled; }
+	static bool isEnabled() { return sEnabled; }
+
+	// Deletes every cache file, e.g. when the viewer cache is cleared.
+	static void clear();
+
+private:
+	static std::string getCacheFilename(const std::vector<std::string>& paths);
+	static bool readCache(const std::string& cache_filename, const std::vector<std::string>& paths, LLXMLNodePtr& root);
+	static void writeCache(const std::string& cache_filename, const std::vector<std::string>& paths, LLXMLNode* root);
+
+	static bool sEnabled;
+};
+
+#endif // LL_LLXUICACHE_H
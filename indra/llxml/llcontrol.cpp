@@ -155,7 +155,8 @@ LLControlVariable::LLControlVariable(const std::string& name, eControlType type,
 	  mComment(comment),
 	  mType(type),
 	  mPersist(persist),
-	  mHideFromSettingsEditor(hidefromsettingseditor)
+	  mHideFromSettingsEditor(hidefromsettingseditor),
+	  mHandleSlot(NULL)
 {
 	if ((persist != PERSIST_NO) && mComment.empty())
 	{
@@ -224,7 +225,7 @@ void LLControlVariable::setValue(const LLSD& new_value, bool saved_value)
 	if(saved_value)
 	{
     	// If we're going to save this value, return to default but don't fire
-		resetToDefault(false);
+		popToDefault();
 	    if (llsd_compare(mValues.back(), storable_value) == FALSE)
 	    {
 		    mValues.push_back(storable_value);
@@ -254,10 +255,16 @@ void LLControlVariable::setValue(const LLSD& new_value, bool saved_value)
 	    }
     }
 
+    // publish the final value only, handle readers must never see the
+    // default popToDefault() passed through
     if(value_changed)
     {
 		firePropertyChanged(original_value);
     }
+	else
+	{
+		updateHandleSlot();
+	}
 }
 
 void LLControlVariable::setDefaultValue(const LLSD& value)
@@ -270,12 +277,16 @@ void LLControlVariable::setDefaultValue(const LLSD& value)
 	LLSD comparable_value = getComparableValue(value);
 	LLSD original_value = getValue();
 	bool value_changed = (llsd_compare(original_value, comparable_value) == FALSE);
-	resetToDefault(false);
+	popToDefault();
 	mValues[0] = comparable_value;
 	if(value_changed)
 	{
 		firePropertyChanged(original_value);
 	}
+	else
+	{
+		updateHandleSlot();
+	}
 }
 
 void LLControlVariable::setPersist(ePersist state)
@@ -299,15 +310,52 @@ void LLControlVariable::resetToDefault(bool fire_signal)
 	//Pop to it and fire off the listener
 	LLSD originalValue = mValues.back();
 
+	popToDefault();
+	
+	if(fire_signal) 
+	{
+		firePropertyChanged(originalValue);
+	}
+	else
+	{
+		updateHandleSlot();
+	}
+}
+
+// Leaves the handle slot alone, callers publish the value they end up with
+void LLControlVariable::popToDefault()
+{
 	while(mValues.size() > 1)
 	{
 		mValues.pop_back();
 	}
-	
-	if(fire_signal) 
+}
+
+void LLControlVariable::updateHandleSlot()
+{
+	if (!mHandleSlot)
 	{
-		firePropertyChanged(originalValue);
+		return;
+	}
+
+	const LLSD& value = mValues.back();
+	U32 bits = 0;
+	switch (mType)
+	{
+	case TYPE_BOOLEAN:
+		bits = value.asBoolean() ? 1 : 0;
+		break;
+	case TYPE_F32:
+		{
+			F32 f = (F32)value.asReal();
+			memcpy(&bits, &f, sizeof(bits));
+		}
+		break;
+	default:
+		bits = (U32)value.asInteger();
+		break;
 	}
+	mHandleSlot->store(bits, std::memory_order_relaxed);
 }
 
 bool LLControlVariable::shouldSave(bool nondefault_only)
@@ -345,6 +393,9 @@ LLSD LLControlVariable::getSaveValue() const
 
 LLPointer<LLControlVariable> LLControlGroup::getControl(const std::string& name)
 {
+#ifndef LL_RELEASE_FOR_DOWNLOAD
+	sLookupCount.fetch_add(1, std::memory_order_relaxed);
+#endif
 	if (mSettingsProfile)
 	{
 		incrCount(name);
@@ -372,9 +423,13 @@ const std::string LLControlGroup::mTypeString[TYPE_COUNT] = { "U32"
                                                              ,"LLSD"
                                                              };
 
+// static
+std::atomic<U32> LLControlGroup::sLookupCount(0);
+
 LLControlGroup::LLControlGroup(const std::string& name)
 :	LLInstanceTracker<LLControlGroup, std::string>(name),
-	mSettingsProfile(false)
+	mSettingsProfile(false),
+	mHandleCount(0)
 {
 
 	if (NULL != getenv("LL_SETTINGS_PROFILE"))
@@ -553,6 +608,46 @@ LLControlVariable* LLControlGroup::declareLLSD(const std::string& name, const LL
 	return declareControl(name, TYPE_LLSD, initial_val, comment, persist);
 }
 
+LLControlHandle LLControlGroup::getHandle(const std::string& name)
+{
+	LLControlVariable* control = getControl(name);
+	if (!control)
+	{
+		LL_WARNS("Settings") << "Control " << name << " not found." << LL_ENDL;
+		return LLControlHandle();
+	}
+
+	const eControlType type = control->type();
+	if (type != TYPE_BOOLEAN && type != TYPE_S32 && type != TYPE_U32 && type != TYPE_F32)
+	{
+		LL_WARNS("Settings") << "Control " << name << " is a " << typeEnumToString(type)
+			<< ", handles only support BOOL, S32, U32 and F32 controls." << LL_ENDL;
+		return LLControlHandle();
+	}
+
+	if (!control->mHandleSlot)
+	{
+		if (!mHandleValues)
+		{
+			mHandleValues.reset(new std::atomic<U32>[MAX_HANDLES]);
+		}
+		if (mHandleCount >= MAX_HANDLES)
+		{
+			LL_ERRS("Settings") << "Out of control handles resolving " << name << LL_ENDL;
+		}
+		control->mHandleSlot = &mHandleValues[mHandleCount++];
+		control->updateHandleSlot();
+	}
+
+	return LLControlHandle((S32)(control->mHandleSlot - mHandleValues.get()), type);
+}
+
+// static
+U32 LLControlGroup::getAndResetLookupCount()
+{
+	return sLookupCount.exchange(0, std::memory_order_relaxed);
+}
+
 void LLControlGroup::incrCount(const std::string& name)
 {
 	if (0.0 == start_time)
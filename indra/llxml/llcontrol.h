@@ -34,6 +34,8 @@
 #include "llrefcount.h"
 #include "llinstancetracker.h"
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 // *NOTE: boost::visit_each<> generates warning 4675 on .net 2003
@@ -114,6 +116,9 @@ private:
 
 	commit_signal_t mCommitSignal;
 	validate_signal_t mValidateSignal;
+
+	// Slot in the owning group's handle value array, once a handle exists
+	std::atomic<U32>* mHandleSlot;
 	
 public:
 	LLControlVariable(const std::string& name, eControlType type,
@@ -153,8 +158,11 @@ public:
 private:
 	void firePropertyChanged(const LLSD &pPreviousValue)
 	{
+		updateHandleSlot();
 		mCommitSignal(this, mValues.back(), pPreviousValue);
 	}
+	void updateHandleSlot();
+	void popToDefault();
 	LLSD getComparableValue(const LLSD& value);
 	bool llsd_compare(const LLSD& a, const LLSD & b);
 };
@@ -183,6 +191,28 @@ T convert_from_llsd(const LLSD& sd, eControlType type, const std::string& contro
 	return T(sd);
 }
 
+//! Stable reference to a BOOL, S32, U32 or F32 control.
+
+//! Resolve it once with LLControlGroup::getHandle() (typically into a
+//! function static) and read it with the LLControlGroup getters that take
+//! a handle.  Those read a copy of the value kept in a flat array owned by
+//! the group, with no string compare, map walk or LLSD involved, and are
+//! safe to call from worker threads.
+class LLControlHandle
+{
+public:
+	LLControlHandle() : mIndex(-1), mType(TYPE_COUNT) {}
+
+	bool isValid() const { return mIndex >= 0; }
+
+private:
+	friend class LLControlGroup;
+	LLControlHandle(S32 index, eControlType type) : mIndex(index), mType(type) {}
+
+	S32				mIndex;
+	eControlType	mType;
+};
+
 //const U32 STRING_CACHE_SIZE = 10000;
 class LLControlGroup : public LLInstanceTracker<LLControlGroup, std::string>
 {
@@ -242,6 +272,18 @@ public:
 	LLColor4	getColor4(const std::string& name);
 	LLColor3	getColor3(const std::string& name);
 
+	// Handle based access, see LLControlHandle.  getHandle() must be called
+	// from the main thread; the getters may be called from any thread.
+	LLControlHandle getHandle(const std::string& name);
+	BOOL		getBOOL(const LLControlHandle& handle) const	{ return readHandle<bool>(handle); }
+	S32			getS32(const LLControlHandle& handle) const		{ return readHandle<S32>(handle); }
+	U32			getU32(const LLControlHandle& handle) const		{ return readHandle<U32>(handle); }
+	F32			getF32(const LLControlHandle& handle) const		{ return readHandle<F32>(handle); }
+
+	// Number of lookups by name since the last call, across all groups.
+	// Always 0 in release builds, where the lookups are not counted.
+	static U32	getAndResetLookupCount();
+
 	LLSD		asLLSD(bool diffs_only);
 	
 	// generic getter
@@ -307,6 +349,38 @@ public:
 	void	incrCount(const std::string& name);
 
 	bool	mSettingsProfile;
+
+private:
+	template<typename T> T readHandle(const LLControlHandle& handle) const
+	{
+		// not mHandleCount, workers read handles while the main thread adds more
+		llassert(handle.mIndex >= 0 && (U32)handle.mIndex < MAX_HANDLES);
+		if (handle.mIndex < 0)
+		{
+			return T();
+		}
+		U32 bits = mHandleValues[handle.mIndex].load(std::memory_order_relaxed);
+		switch (handle.mType)
+		{
+		case TYPE_F32:
+			{
+				F32 value;
+				memcpy(&value, &bits, sizeof(value));
+				return (T)value;
+			}
+		case TYPE_S32:
+			return (T)(S32)bits;
+		default:
+			return (T)bits;
+		}
+	}
+
+	// Fixed capacity so that handle reads never race with a reallocation.
+	static const U32 MAX_HANDLES = 4096;
+	std::unique_ptr<std::atomic<U32>[]>	mHandleValues;
+	U32									mHandleCount;
+
+	static std::atomic<U32>				sLookupCount;
 };
 
 
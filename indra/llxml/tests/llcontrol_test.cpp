@@ -151,4 +151,44 @@ namespace tut
 		ensure("listener fired on changed setting", mListenerFired);
 	}
 
+	//handles
+	template<> template<>
+	void control_group_t::test<5>()
+	{
+		mCG->loadFromFile(mTestConfigFile.c_str());
+		mCG->declareF32("TestFloat", 0.5f, "Dummy float used for testing");
+		mCG->declareBOOL("TestBool", FALSE, "Dummy bool used for testing");
+		mCG->declareString("TestString", "text", "Dummy string used for testing");
+
+		LLControlHandle u32_handle = mCG->getHandle("TestSetting");
+		LLControlHandle f32_handle = mCG->getHandle("TestFloat");
+		LLControlHandle bool_handle = mCG->getHandle("TestBool");
+		ensure("scalar handles valid", u32_handle.isValid() && f32_handle.isValid() && bool_handle.isValid());
+		ensure("string handle invalid", !mCG->getHandle("TestString").isValid());
+		ensure("missing handle invalid", !mCG->getHandle("NoSuchSetting").isValid());
+
+		ensure_equals("initial U32", mCG->getU32(u32_handle), 12);
+		ensure_equals("initial F32", mCG->getF32(f32_handle), 0.5f);
+		ensure_equals("initial BOOL", mCG->getBOOL(bool_handle), FALSE);
+
+		mCG->setU32("TestSetting", 13);
+		mCG->setF32("TestFloat", 2.25f);
+		mCG->setBOOL("TestBool", TRUE);
+		ensure_equals("changed U32", mCG->getU32(u32_handle), 13);
+		ensure_equals("changed F32", mCG->getF32(f32_handle), 2.25f);
+		ensure_equals("changed BOOL", mCG->getBOOL(bool_handle), TRUE);
+
+		// setting the current value again must not leave the handle on the default
+		mCG->setU32("TestSetting", 13);
+		ensure_equals("re-set U32", mCG->getU32(u32_handle), 13);
+
+		// new default equal to the current value
+		mCG->getControl("TestFloat")->setDefaultValue(2.25f);
+		ensure_equals("default set to current F32", mCG->getF32(f32_handle), 2.25f);
+
+		mCG->getControl("TestSetting")->resetToDefault(true);
+		ensure_equals("reset U32", mCG->getU32(u32_handle), 12);
+
+		ensure_equals("handle resolved again", mCG->getU32(mCG->getHandle("TestSetting")), 12);
+	}
 }
@@ -34,11 +34,13 @@
 #include "llinventorymodel.h"
 #include "llinventoryobserver.h"
 #include "llnotificationsutil.h"
+#include "llsdserialize.h"
 #include "llsdutil.h"
 #include "llviewerregion.h"
 #include "llvoavatar.h"
 #include "llvoavatarself.h"
 #include "llviewercontrol.h"
+#include "workqueue.h"
 
 ///----------------------------------------------------------------------------
 /// Classes for AISv3 support.
@@ -50,8 +52,8 @@ const std::string AISAPI::LIBRARY_CAP_NAME("LibraryAPIv3");
 const S32 AISAPI::HTTP_TIMEOUT = 180;
 
 std::list<AISAPI::ais_query_item_t> AISAPI::sPostponedQuery;
-
-const S32 MAX_SIMULTANEOUS_COROUTINES = 2048;
+const std::string AISAPI::ROUND_TRIP_KEY("ais_round_trip");
+F64 AISAPI::sCompletingRoundTrip = 0.0;
 
 // AIS3 allows '*' requests, but in reality those will be cut at some point
 // Specify own depth to be able to anticipate it and mark folders as incomplete
@@ -425,17 +427,7 @@ void AISAPI::FetchItem(const LLUUID &itemId, ITEM_TYPE type, completion_t callba
 	}
 	std::string url = cap + std::string("/item/") + itemId.asString();
 
-	invokationFn_t getFn = boost::bind(
-		// Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-		static_cast<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t, const std::string &, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t)>
-		//----
-		// _1 -> httpAdapter
-		// _2 -> httpRequest
-		// _3 -> url
-		// _4 -> body 
-		// _5 -> httpOptions
-		// _6 -> httpHeaders
-		(&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+	invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
 	LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
 		_1, getFn, url, itemId, LLSD(), callback, FETCHITEM));
@@ -473,17 +465,7 @@ void AISAPI::FetchCategoryChildren(const LLUUID &catId, ITEM_TYPE type, bool rec
 
     url += "?depth=" + std::to_string(depth);
 
-    invokationFn_t getFn = boost::bind(
-        // Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-        static_cast<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t, const std::string &, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t)>
-        //----
-        // _1 -> httpAdapter
-        // _2 -> httpRequest
-        // _3 -> url
-        // _4 -> body 
-        // _5 -> httpOptions
-        // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+    invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -526,17 +508,7 @@ void AISAPI::FetchCategoryChildren(const std::string &identifier, bool recursive
 
     url += "?depth=" + std::to_string(depth);
 
-    invokationFn_t getFn = boost::bind(
-        // Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-        static_cast<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t, const std::string &, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t)>
-        //----
-        // _1 -> httpAdapter
-        // _2 -> httpRequest
-        // _3 -> url
-        // _4 -> body 
-        // _5 -> httpOptions
-        // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+    invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -577,17 +549,7 @@ void AISAPI::FetchCategoryCategories(const LLUUID &catId, ITEM_TYPE type, bool r
 
     url += "?depth=" + std::to_string(depth);
 
-    invokationFn_t getFn = boost::bind(
-        // Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-        static_cast<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t, const std::string &, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t)>
-        //----
-        // _1 -> httpAdapter
-        // _2 -> httpRequest
-        // _3 -> url
-        // _4 -> body 
-        // _5 -> httpOptions
-        // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+    invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -654,17 +616,7 @@ void AISAPI::FetchCategorySubset(const LLUUID& catId,
         LL_WARNS("Inventory") << "Request url is too long, url: " << url << LL_ENDL;
     }
 
-    invokationFn_t getFn = boost::bind(
-        // Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-        static_cast<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t, const std::string&, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t)>
-        //----
-        // _1 -> httpAdapter
-        // _2 -> httpRequest
-        // _3 -> url
-        // _4 -> body 
-        // _5 -> httpOptions
-        // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+    invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -691,17 +643,7 @@ void AISAPI::FetchCOF(completion_t callback)
     }
     std::string url = cap + std::string("/category/current/links");
 
-    invokationFn_t getFn = boost::bind(
-        // Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-        static_cast<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t, const std::string&, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t)>
-        //----
-        // _1 -> httpAdapter
-        // _2 -> httpRequest
-        // _3 -> url
-        // _4 -> body 
-        // _5 -> httpOptions
-        // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+    invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
     LLSD body;
     // Only cof folder will be full, but cof can contain an outfit
@@ -727,19 +669,7 @@ void AISAPI::FetchCategoryLinks(const LLUUID &catId, completion_t callback)
     }
     std::string url = cap + std::string("/category/") + catId.asString() + "/links";
 
-    invokationFn_t getFn = boost::bind(
-        // Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-        static_cast<LLSD (LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t, const std::string &,
-                                                                   LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t)>
-        //----
-        // _1 -> httpAdapter
-        // _2 -> httpRequest
-        // _3 -> url
-        // _4 -> body
-        // _5 -> httpOptions
-        // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend),
-        _1, _2, _3, _5, _6);
+    invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
     LLSD body;
     body["depth"] = 0;
@@ -764,17 +694,7 @@ void AISAPI::FetchOrphans(completion_t callback)
     }
     std::string url = cap + std::string("/orphans");
 
-    invokationFn_t getFn = boost::bind(
-        // Humans ignore next line.  It is just a cast to specify which LLCoreHttpUtil::HttpCoroutineAdapter routine overload.
-        static_cast<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::*)(LLCore::HttpRequest::ptr_t , const std::string& , LLCore::HttpOptions::ptr_t , LLCore::HttpHeaders::ptr_t)>
-        //----
-        // _1 -> httpAdapter
-        // _2 -> httpRequest
-        // _3 -> url
-        // _4 -> body 
-        // _5 -> httpOptions
-        // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend) , _1 , _2 , _3 , _5 , _6);
+    invokationFn_t getFn = &AISAPI::getAndParseOffThread;
 
     LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro ,
                                                          _1 , getFn , url , LLUUID::null , LLSD() , callback , FETCHORPHANS));
@@ -786,17 +706,17 @@ void AISAPI::FetchOrphans(completion_t callback)
 void AISAPI::EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc)
 {
     LLCoprocedureManager &inst = LLCoprocedureManager::instance();
-    S32 pending_in_pool = inst.countPending("AIS");
     std::string procFullName = "AIS(" + procName + ")";
-    if (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES)
+    // Keep the order of AIS commands: nothing jumps ahead of postponed ones.
+    if (sPostponedQuery.empty() && inst.hasCapacity("AIS"))
     {
         inst.enqueueCoprocedure("AIS", procFullName, proc);
     }
     else
     {
-        // As I understand it, coroutines have built-in 'pending' pool
-        // but unfortunately it has limited size which inventory often goes over
-        // so this is a workaround to not overfill it.
+        // The "AIS" pool queue is bounded (see QueueSizeAIS) and refuses
+        // work when full, which inventory often goes over, so hold
+        // commands here until it drains.
         if (sPostponedQuery.empty())
         {
             sPostponedQuery.push_back(ais_query_item_t(procFullName, proc));
@@ -815,13 +735,11 @@ void AISAPI::onIdle(void *userdata)
     if (!sPostponedQuery.empty())
     {
         LLCoprocedureManager &inst = LLCoprocedureManager::instance();
-        S32 pending_in_pool = inst.countPending("AIS");
-        while (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES && !sPostponedQuery.empty())
+        while (inst.hasCapacity("AIS") && !sPostponedQuery.empty())
         {
             ais_query_item_t &item = sPostponedQuery.front();
             inst.enqueueCoprocedure("AIS", item.first, item.second);
             sPostponedQuery.pop_front();
-            pending_in_pool++;
         }
     }
     
@@ -847,6 +765,109 @@ void AISAPI::onUpdateReceived(const LLSD& update, COMMAND_TYPE type, const LLSD&
     LL_DEBUGS("Inventory", "AIS3") << "Elapsed processing: " << timer.getElapsedTimeF32() << LL_ENDL;
 }
 
+/*static*/
+LLSD AISAPI::getAndParseOffThread(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter, LLCore::HttpRequest::ptr_t httpRequest,
+    const std::string url, LLSD body, LLCore::HttpOptions::ptr_t httpOptions, LLCore::HttpHeaders::ptr_t httpHeaders)
+{
+    // Recursive fetches can return megabytes of LLSD XML. Take the body raw
+    // and deserialize it on a worker so that the main loop keeps running.
+    // The content type decides whether a body that fails to parse is an error.
+    httpOptions->setWantHeaders(true);
+    LLTimer round_trip;
+    LLSD result = httpAdapter->getRawAndSuspend(httpRequest, url, httpOptions, httpHeaders);
+    LLSD httpResults = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS];
+    httpResults[ROUND_TRIP_KEY] = round_trip.getElapsedTimeF64().value();
+
+    if (!result.has(LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_RAW))
+    {
+        // The raw handler does not parse error bodies. 4xx bodies carry
+        // LLSD the error handling below relies on, parse them the way the
+        // LLSD handler does. They are small, no need for a worker.
+        LLCore::HttpStatus status = LLCoreHttpUtil::HttpCoroutineAdapter::getStatusFromLLSD(httpResults);
+        if (!status && status.getType() >= 400 && status.getType() < 500
+            && httpResults.has("error_body"))
+        {
+            LLSD body;
+            std::istringstream stream(httpResults["error_body"].asString());
+            if (LLSDSerialize::fromXML(body, stream, true) != LLSDParser::PARSE_FAILURE
+                && !body.isUndefined())
+            {
+                if (body.isMap())
+                {
+                    result = body;
+                }
+                else
+                {
+                    result = LLSD::emptyMap();
+                    result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_CONTENT] = body;
+                }
+            }
+        }
+        result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS] = httpResults;
+        return result;
+    }
+
+    // LLSD is not safe to share between threads, give the worker its own bytes.
+    const LLSD::Binary& raw = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_RAW].asBinary();
+    std::string data(raw.begin(), raw.end());
+    result.clear();
+
+    // LLSD reference counts are not atomic. The parsed tree stays behind a
+    // pointer that is handed over, never copied, so its refcount is only
+    // ever touched by one thread at a time. Null means it failed to parse.
+    auto parse = [data = std::move(data)]() mutable
+    {
+        std::unique_ptr<LLSD> parsed(new LLSD);
+        std::istringstream stream(data);
+        if (LLSDSerialize::fromXML(*parsed, stream, true) == LLSDParser::PARSE_FAILURE)
+        {
+            parsed.reset();
+        }
+        return parsed;
+    };
+
+    std::unique_ptr<LLSD> parsed;
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    try
+    {
+        parsed = general_queue ? general_queue->waitForResult(std::move(parse)) : parse();
+    }
+    catch (const LL::WorkQueue::Closed&)
+    {
+        parsed = parse();
+    }
+
+    if (!parsed)
+    {
+        // Same as HttpCoroLLSDHandler: only a body that claimed to be LLSD
+        // is a failure, anything else is an empty result.
+        const LLSD& headers = httpResults[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_HEADERS];
+        if (headers.has(HTTP_IN_HEADER_CONTENT_TYPE)
+            && headers[HTTP_IN_HEADER_CONTENT_TYPE].asString() == HTTP_CONTENT_LLSD_XML)
+        {
+            LL_WARNS("Inventory") << "Failed to deserialize " << url << LL_ENDL;
+            LLCore::HttpStatus status(499, "Failed to deserialize LLSD.");
+            httpResults[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_SUCCESS] = false;
+            httpResults[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_TYPE] = LLSD::Integer(status.getType());
+            httpResults[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_STATUS] = LLSD::Integer(status.getStatus());
+            httpResults[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_MESSAGE] = status.getMessage();
+        }
+        result = LLSD::emptyMap();
+    }
+    else if (!parsed->isMap())
+    {
+        // Same shape as HttpCoroLLSDHandler produces
+        result = LLSD::emptyMap();
+        result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_CONTENT] = *parsed;
+    }
+    else
+    {
+        result = *parsed;
+    }
+    result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS] = httpResults;
+    return result;
+}
+
 /*static*/
 void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter, 
         invokationFn_t invoke, std::string url, 
@@ -969,6 +990,8 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
 
     if (callback && !callback.empty())
     {
+        sCompletingRoundTrip = httpResults[ROUND_TRIP_KEY].asReal();
+
         bool needs_callback = true;
         LLUUID id(LLUUID::null);
 
@@ -1031,6 +1054,7 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
             // UPDATEITEM doesn't expect an id
             callback(id);
         }
+        sCompletingRoundTrip = 0.0;
     }
 
 }
@@ -1053,8 +1077,7 @@ AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD&
         mFetchDepth = request_body["depth"].asInteger();
     }
 
-    mTimer.setTimerExpirySec(debugLoggingEnabled("Inventory") ? EXPIRY_SECONDS_DEBUG : EXPIRY_SECONDS_LIVE);
-    mTimer.start();
+    mLastCheckTime = LLTimer::getTotalSeconds();
 	parseUpdate(update);
 }
 
@@ -1073,14 +1096,31 @@ void AISUpdate::clearParseResults()
 	mCategoryIds.clear();
 }
 
+U32 AISUpdate::sBudgetFrame = 0;
+F64 AISUpdate::sBudgetUsed = 0.0;
+
 void AISUpdate::checkTimeout()
 {
-    if (mTimer.hasExpired())
+    const F64 budget = debugLoggingEnabled("Inventory") ? EXPIRY_SECONDS_DEBUG : EXPIRY_SECONDS_LIVE;
+    if (sBudgetFrame != LLFrameTimer::getFrameCount())
+    {
+        sBudgetFrame = LLFrameTimer::getFrameCount();
+        sBudgetUsed = 0.0;
+    }
+    sBudgetUsed += LLTimer::getTotalSeconds() - mLastCheckTime;
+
+    while (sBudgetUsed > budget)
     {
+        // Out of time for this frame, continue in a later one
         llcoro::suspend();
         LLCoros::checkStop();
-        mTimer.setTimerExpirySec(debugLoggingEnabled("Inventory") ? EXPIRY_SECONDS_DEBUG : EXPIRY_SECONDS_LIVE);
+        if (sBudgetFrame != LLFrameTimer::getFrameCount())
+        {
+            sBudgetFrame = LLFrameTimer::getFrameCount();
+            sBudgetUsed = 0.0;
+        }
     }
+    mLastCheckTime = LLTimer::getTotalSeconds();
 }
 
 void AISUpdate::parseUpdate(const LLSD& update)
@@ -66,6 +66,11 @@ public:
     static void FetchOrphans(completion_t callback = completion_t() );
     static void CopyLibraryCategory(const LLUUID& sourceId, const LLUUID& destId, bool copySubfolders, completion_t callback = completion_t());
 
+    // Only valid inside a completion_t: seconds the request spent on the
+    // HTTP round trip, without coprocedure queueing, parsing or applying
+    // the update. 0 when unknown.
+    static F64 getCompletingRoundTrip() { return sCompletingRoundTrip; }
+
     typedef enum {
         COPYINVENTORY,
         SLAMFOLDER,
@@ -99,12 +104,18 @@ private:
     static std::string getInvCap();
     static std::string getLibCap();
 
+    static LLSD getAndParseOffThread(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter, LLCore::HttpRequest::ptr_t httpRequest,
+        const std::string url, LLSD body, LLCore::HttpOptions::ptr_t httpOptions, LLCore::HttpHeaders::ptr_t httpHeaders);
+
     static void InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter, 
         invokationFn_t invoke, std::string url, LLUUID targetId, LLSD body, 
         completion_t callback, COMMAND_TYPE type);
 
     typedef std::pair<std::string, LLCoprocedureManager::CoProcedure_t> ais_query_item_t;
     static std::list<ais_query_item_t> sPostponedQuery;
+
+    static const std::string ROUND_TRIP_KEY;
+    static F64 sCompletingRoundTrip;
 };
 
 class AISUpdate
@@ -130,10 +141,13 @@ private:
 	void clearParseResults();
     void checkTimeout();
 
+    // Per-frame budget shared by every update in flight, so that several
+    // concurrent fetch responses cannot add up to a long frame.
     // Debug is very log-heavy, give it more time or it will take forever to process
-    // Todo: find a way to make throttle static isntead of per-request
     const F32 EXPIRY_SECONDS_DEBUG = 1.f;
     const F32 EXPIRY_SECONDS_LIVE = 0.008f;
+    static U32 sBudgetFrame;
+    static F64 sBudgetUsed;
 
 	typedef std::map<LLUUID,S32> uuid_int_map_t;
 	uuid_int_map_t mCatDescendentDeltas;
@@ -155,7 +169,7 @@ private:
 	uuid_list_t mCategoryIds;
     bool mFetch;
     S32 mFetchDepth;
-    LLTimer mTimer;
+    F64 mLastCheckTime;
     AISAPI::COMMAND_TYPE mType;
 };
 
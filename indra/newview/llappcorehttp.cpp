@@ -122,7 +122,8 @@ static void ssl_verification_changed();
 LLAppCoreHttp::HttpClass::HttpClass()
 	: mPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
 	  mConnLimit(0U),
-	  mPipelined(false)
+	  mPipelined(false),
+	  mHttp2Streams(0L)
 {}
 
 
@@ -299,6 +300,10 @@ void LLAppCoreHttp::init()
 			}
 		}
 	}
+	if (gSavedSettings.controlExists("HttpHTTP2Streams"))
+	{
+		mHttp2StreamsSignal = gSavedSettings.getControl("HttpHTTP2Streams")->getCommitSignal()->connect(boost::bind(&setting_changed));
+	}
 }
 
 
@@ -373,6 +378,7 @@ void LLAppCoreHttp::cleanup()
 	}
     mSSLNoVerifySignal.disconnect();
 	mPipelinedSignal.disconnect();
+	mHttp2StreamsSignal.disconnect();
 	
 	delete mRequest;
 	mRequest = NULL;
@@ -391,6 +397,10 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 {
 	LLCore::HttpStatus status;
 
+	// Streams per HTTP/2 connection for the pipelined classes, zero for HTTP/1.1
+	static const std::string http2_streams("HttpHTTP2Streams");
+	const long streams(gSavedSettings.controlExists(http2_streams) ? gSavedSettings.getU32(http2_streams) : 0L);
+
 	for (int i(0); i < LL_ARRAY_SIZE(init_data); ++i)
 	{
 		const EAppPolicy app_policy(static_cast<EAppPolicy>(i));
@@ -449,6 +459,30 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 				}
 			}
 		}
+
+		// Multiplexing takes precedence over pipelining in the policy.
+		// Zero is applied too, it switches the class back to HTTP/1.1.
+		if (init_data[i].mPipelined && streams != mHttpClasses[app_policy].mHttp2Streams)
+		{
+			LLCore::HttpHandle handle;
+			handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAMS,
+											   mHttpClasses[app_policy].mPolicy,
+											   streams,
+											   LLCore::HttpHandler::ptr_t());
+			if (LLCORE_HTTP_HANDLE_INVALID == handle)
+			{
+				status = mRequest->getStatus();
+				LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+								 << " HTTP/2 streams.  Reason:  " << status.toString()
+								 << LL_ENDL;
+			}
+			else
+			{
+				LL_INFOS("Init") << "HTTP/2 streams for " << init_data[i].mUsage
+								 << " set to " << streams << " per connection" << LL_ENDL;
+				mHttpClasses[app_policy].mHttp2Streams = streams;
+			}
+		}
 		
 		// Get target connection concurrency value
 		U32 setting(init_data[i].mDefault);
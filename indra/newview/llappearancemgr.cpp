@@ -3761,13 +3761,29 @@ void LLAppearanceMgr::onIdle(void *)
 
 void LLAppearanceMgr::requestServerAppearanceUpdate()
 {
+    if (mQueuedAppearanceBake.notNull())
+    {
+        // One is already waiting in the pool, it reads the COF when it runs
+        mRerequestAppearanceBake = false;
+        return;
+    }
+
     // Workaround: we shouldn't request update from server prior to uploading all attachments, but it is
     // complicated to check for pending attachment uploads, so we are just waiting for uploads to complete
     if (!mOutstandingAppearanceBakeRequest && gAssetStorage->getNumPendingUploads() == 0)
     {
         mRerequestAppearanceBake = false;
         LLCoprocedureManager::CoProcedure_t proc = boost::bind(&LLAppearanceMgr::serverAppearanceUpdateCoro, this, _1);
-        LLCoprocedureManager::instance().enqueueCoprocedure("AIS", "LLAppearanceMgr::serverAppearanceUpdateCoro", proc);
+        // The AIS pool is shared with inventory fetches that can fill its
+        // queue during login; the bake request goes ahead of them and is
+        // never refused for capacity.
+        mQueuedAppearanceBake = LLCoprocedureManager::instance().enqueueCoprocedure("AIS", "LLAppearanceMgr::serverAppearanceUpdateCoro", proc,
+                                                                                    LLCoprocedureManager::PRIORITY_HIGH);
+        if (mQueuedAppearanceBake.isNull() && !LLApp::isExiting())
+        {
+            LL_WARNS("Avatar") << "Unable to queue server appearance update, will retry" << LL_ENDL;
+            mRerequestAppearanceBake = true;
+        }
     }
     else
     {
@@ -3778,6 +3794,7 @@ void LLAppearanceMgr::requestServerAppearanceUpdate()
 
 void LLAppearanceMgr::serverAppearanceUpdateCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter)
 {
+    mQueuedAppearanceBake.setNull();
     BoolSetter outstanding(mOutstandingAppearanceBakeRequest);
     if (!gAgent.getRegion())
     {
@@ -4313,6 +4330,11 @@ LLAppearanceMgr::LLAppearanceMgr():
 LLAppearanceMgr::~LLAppearanceMgr()
 {
 	mActive = false;
+	// the queued request is bound to this
+	if (mQueuedAppearanceBake.notNull() && LLCoprocedureManager::instanceExists())
+	{
+		LLCoprocedureManager::instance().cancelCoprocedure(mQueuedAppearanceBake);
+	}
 }
 
 void LLAppearanceMgr::setAttachmentInvLinkEnable(bool val)
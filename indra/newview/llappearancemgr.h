@@ -264,6 +264,7 @@ private:
 	bool mIsInUpdateAppearanceFromCOF; // to detect recursive calls.
     bool mOutstandingAppearanceBakeRequest; // A bake request is outstanding.  Do not overlap.
     bool mRerequestAppearanceBake;
+    LLUUID mQueuedAppearanceBake; // coprocedure id of a bake request that has not started yet
 
 	/**
 	 * Lock for blocking operations on outfit until server reply or timeout exceed
@@ -32,6 +32,7 @@
 #include "llversioninfo.h"
 #include "llfeaturemanager.h"
 #include "lluictrlfactory.h"
+#include "llxuicache.h"
 #include "lltexteditor.h"
 #include "llenvironment.h"
 #include "llerrorcontrol.h"
@@ -79,6 +80,7 @@
 #include "llviewermediafocus.h"
 #include "llviewermessage.h"
 #include "llviewerobjectlist.h"
+#include "llviewerpartsim.h"
 #include "llworldmap.h"
 #include "llmutelist.h"
 #include "llviewerhelp.h"
@@ -86,6 +88,7 @@
 #include "llurldispatcher.h"
 #include "llurlhistory.h"
 #include "llrender.h"
+#include "llfontgl.h"
 #include "llteleporthistory.h"
 #include "lltoast.h"
 #include "llsdutil_math.h"
@@ -550,6 +553,7 @@ static void settings_to_globals()
 	LLVOAvatar::sPhysicsLODFactor		= llclamp(gSavedSettings.getF32("RenderAvatarPhysicsLODFactor"), 0.f, MAX_AVATAR_LOD_FACTOR);
 	LLVOAvatar::updateImpostorRendering(gSavedSettings.getU32("RenderAvatarMaxNonImpostors"));
 	LLVOAvatar::sVisibleInFirstPerson	= gSavedSettings.getBOOL("FirstPersonAvatarVisible");
+	LLPolyMesh::sDeferMorphs			= gSavedSettings.getBOOL("AvatarAsyncMorphs");
 	// clamp auto-open time to some minimum usable value
 	LLFolderView::sAutoOpenTime			= llmax(0.25f, gSavedSettings.getF32("FolderAutoOpenDelay"));
 	LLSelectMgr::sRectSelectInclusive	= gSavedSettings.getBOOL("RectangleSelectInclusive");
@@ -812,6 +816,7 @@ bool LLAppViewer::init()
 		LLUIImageList::getInstance(),
 		ui_audio_callback,
 		deferred_ui_audio_callback);
+	LLXUICache::setEnabled(gSavedSettings.getBOOL("XUIBinaryCache"));
 	LL_INFOS("InitInfo") << "UI initialized." << LL_ENDL ;
 
 	// NOW LLUI::getLanguage() should work. gDirUtilp must know the language
@@ -2001,6 +2006,11 @@ bool LLAppViewer::cleanup()
 		gSavedPerAccountSettings.saveToFile(gSavedSettings.getString("PerAccountSettingsFile"), TRUE);
 		LL_INFOS() << "Saved settings" << LL_ENDL;
 
+		if (gSavedSettings.getBOOL("FontGlyphPrewarm"))
+		{
+			LLFontGL::saveRecentGlyphs(gDirUtilp->getExpandedFilename(LL_PATH_PER_SL_ACCOUNT, "recent_glyphs.txt"));
+		}
+
 		if (LLViewerParcelAskPlay::instanceExists())
 		{
 			LLViewerParcelAskPlay::getInstance()->saveSettings();
@@ -4308,6 +4318,8 @@ void LLAppViewer::purgeCache()
 		// cef does not support clear_cache and clear_cookies, so clear what we can manually.
 		gDirUtilp->deleteDirAndContents(browser_cache);
 	}
+	LLXUICache::clear();
+	LLViewerShaderMgr::instance()->clearProgramCache();
 	gDirUtilp->deleteFilesInDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, ""), "*");
 }
 
@@ -4460,25 +4472,34 @@ void LLAppViewer::saveFinalSnapshot()
 
 void LLAppViewer::loadNameCache()
 {
-	// display names cache
+	// display names cache; the XML file is only read once, to migrate
+	// it to the binary cache
 	std::string filename =
 		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
-	LL_INFOS("AvNameCache") << filename << LL_ENDL;
-	llifstream name_cache_stream(filename.c_str());
-	if(name_cache_stream.is_open())
+	std::string bin_filename =
+		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.bin");
+	LL_INFOS("AvNameCache") << bin_filename << LL_ENDL;
+	if (!LLAvatarNameCache::getInstance()->openCacheFile(bin_filename))
 	{
-		if ( ! LLAvatarNameCache::getInstance()->importFile(name_cache_stream))
-        {
-            LL_WARNS("AppInit") << "removing invalid '" << filename << "'" << LL_ENDL;
-            name_cache_stream.close();
-            LLFile::remove(filename);
-        }
+		llifstream name_cache_stream(filename.c_str());
+		if(name_cache_stream.is_open())
+		{
+			if ( ! LLAvatarNameCache::getInstance()->importFile(name_cache_stream))
+			{
+				LL_WARNS("AppInit") << "removing invalid '" << filename << "'" << LL_ENDL;
+				name_cache_stream.close();
+				LLFile::remove(filename);
+			}
+		}
 	}
 
 	if (!gCacheName) return;
 
 	std::string name_cache;
 	name_cache = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "name.cache");
+	std::string bin_name_cache = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "name_cache.bin");
+	if (gCacheName->openCacheFile(bin_name_cache)) return;
+
 	llifstream cache_file(name_cache.c_str());
 	if(cache_file.is_open())
 	{
@@ -4489,24 +4510,14 @@ void LLAppViewer::loadNameCache()
 void LLAppViewer::saveNameCache()
 {
 	// display names cache
-	std::string filename =
-		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
-	llofstream name_cache_stream(filename.c_str());
-	if(name_cache_stream.is_open())
-	{
-		LLAvatarNameCache::getInstance()->exportFile(name_cache_stream);
-    }
+	LLAvatarNameCache::getInstance()->saveCacheFile();
+	LLFile::remove(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml"), ENOENT);
 
     // real names cache
 	if (gCacheName)
     {
-        std::string name_cache;
-        name_cache = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "name.cache");
-        llofstream cache_file(name_cache.c_str());
-        if(cache_file.is_open())
-        {
-            gCacheName->exportFile(cache_file);
-        }
+        gCacheName->saveCacheFile();
+        LLFile::remove(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "name.cache"), ENOENT);
 	}
 }
 
@@ -4910,47 +4921,112 @@ void LLAppViewer::idle()
 	// Here, particles are updated and drawables are moved.
 	//
 
+	if (!mWorldUpdateGraph.size())
 	{
-		LL_PROFILE_ZONE_NAMED_CATEGORY_APP("world update"); //LL_RECORD_BLOCK_TIME(FTM_WORLD_UPDATE);
-		gPipeline.updateMove();
+		buildWorldUpdateGraph();
 	}
+	mWorldUpdateGraph.run();
 
-	LLWorld::getInstance()->updateParticles();
-
-	if (gAgentPilot.isPlaying() && gAgentPilot.getOverrideCamera())
+	static LLCachedControl<bool> dump_graph(gSavedSettings, "DumpWorldUpdateGraph", false);
+	if (dump_graph)
 	{
-		gAgentPilot.moveCamera();
+		dumpWorldUpdateGraph();
+		gSavedSettings.setBOOL("DumpWorldUpdateGraph", FALSE);
 	}
-	else if (LLViewerJoystick::getInstance()->getOverrideCamera())
+
+	// Handle shutdown process, for example,
+	// wait for floaters to close, send quit message,
+	// forcibly quit if it has taken too long
+	if (mQuitRequested)
 	{
-		LLViewerJoystick::getInstance()->moveFlycam();
+		gGLActive = TRUE;
+		idleShutdown();
 	}
-	else
+}
+
+void LLAppViewer::buildWorldUpdateGraph()
+{
+	// The edges are the real constraints between the stages.  Particle
+	// simulation only touches the particles, so it runs on a worker while
+	// the main thread updates the camera, media, LOD and audio; everything
+	// else touches the scene, the UI or the audio engine and stays on the
+	// main thread.
+	LL::FrameGraph& graph = mWorldUpdateGraph;
+
+	LL::FrameGraph::job_t move = graph.add("world update", []()
 	{
-		if (LLToolMgr::getInstance()->inBuildMode())
+		LL_PROFILE_ZONE_NAMED_CATEGORY_APP("world update"); //LL_RECORD_BLOCK_TIME(FTM_WORLD_UPDATE);
+		gPipeline.updateMove();
+	});
+
+	// particle groups are rebalanced in the partitions updateMove() touches
+	LL::FrameGraph::job_t particle_sources = graph.add("particle sources", []()
+	{
+		LLViewerPartSim::getInstance()->beginSimulation();
+	}, LL::FrameGraph::MAIN_THREAD, { move });
+
+	LL::FrameGraph::job_t particle_sim = graph.add("particle simulation", []()
+	{
+		LLViewerPartSim::getInstance()->simulateParticles();
+	}, LL::FrameGraph::ANY_THREAD, { particle_sources });
+
+	// strays are regrouped against the moved camera, dead groups killed
+	graph.add("particle groups", []()
+	{
+		LLViewerPartSim::getInstance()->endSimulation();
+	}, LL::FrameGraph::MAIN_THREAD, { particle_sim });
+
+	// the camera follows the avatar drawable moved above; particles are
+	// sized against the camera from before it moves
+	LL::FrameGraph::job_t camera = graph.add("camera", []()
+	{
+		if (gAgentPilot.isPlaying() && gAgentPilot.getOverrideCamera())
+		{
+			gAgentPilot.moveCamera();
+		}
+		else if (LLViewerJoystick::getInstance()->getOverrideCamera())
 		{
-			LLViewerJoystick::getInstance()->moveObjects();
+			LLViewerJoystick::getInstance()->moveFlycam();
 		}
+		else
+		{
+			if (LLToolMgr::getInstance()->inBuildMode())
+			{
+				LLViewerJoystick::getInstance()->moveObjects();
+			}
 
-		gAgentCamera.updateCamera();
-	}
+			gAgentCamera.updateCamera();
+		}
+	}, LL::FrameGraph::MAIN_THREAD, { move, particle_sources });
 
 	// update media focus
-	LLViewerMediaFocus::getInstance()->update();
+	graph.add("media focus", []()
+	{
+		LLViewerMediaFocus::getInstance()->update();
+	}, LL::FrameGraph::MAIN_THREAD, { camera });
 
 	// Update marketplace
-	LLMarketplaceInventoryImporter::update();
-	LLMarketplaceInventoryNotifications::update();
+	graph.add("marketplace", []()
+	{
+		LLMarketplaceInventoryImporter::update();
+		LLMarketplaceInventoryNotifications::update();
+	});
 
 	// objects and camera should be in sync, do LOD calculations now
+	graph.add("lod update", []()
 	{
 		LL_RECORD_BLOCK_TIME(FTM_LOD_UPDATE);
 		gObjectList.updateApparentAngles(gAgent);
-	}
+	}, LL::FrameGraph::MAIN_THREAD, { camera });
 
 	// Update AV render info
-	LLAvatarRenderInfoAccountant::getInstance()->idle();
+	graph.add("render info", []()
+	{
+		LLAvatarRenderInfoAccountant::getInstance()->idle();
+	});
 
+	// the listener sits on the camera
+	graph.add("audio update", []()
 	{
 		LL_PROFILE_ZONE_NAMED_CATEGORY_APP("audio update"); //LL_RECORD_BLOCK_TIME(FTM_AUDIO_UPDATE);
 
@@ -4963,16 +5039,27 @@ void LLAppViewer::idle()
 			// this line actually commits the changes we've made to source positions, etc.
 			gAudiop->idle();
 		}
+	}, LL::FrameGraph::MAIN_THREAD, { camera });
+}
+
+// Writes the last run of the world update graph for chrome://tracing and
+// logs its critical path.
+void LLAppViewer::dumpWorldUpdateGraph()
+{
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "world_update_graph.json");
+	llofstream out(filename.c_str());
+	if (out.is_open())
+	{
+		mWorldUpdateGraph.writeTrace(out);
 	}
 
-	// Handle shutdown process, for example,
-	// wait for floaters to close, send quit message,
-	// forcibly quit if it has taken too long
-	if (mQuitRequested)
+	std::ostringstream path;
+	for (LL::FrameGraph::job_t job : mWorldUpdateGraph.getCriticalPath())
 	{
-		gGLActive = TRUE;
-		idleShutdown();
+		path << " " << mWorldUpdateGraph.getName(job) << " ("
+			 << mWorldUpdateGraph.getEnd(job) - mWorldUpdateGraph.getStart(job) << "us)";
 	}
+	LL_INFOS() << "World update critical path:" << path.str() << ", trace written to " << filename << LL_ENDL;
 }
 
 void LLAppViewer::idleShutdown()
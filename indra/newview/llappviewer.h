@@ -49,6 +49,7 @@
 #include "llsys.h"			// for LLOSInfo
 #include "lltimer.h"
 #include "llappcorehttp.h"
+#include "llframegraph.h"
 
 #include <boost/signals2.hpp>
 
@@ -271,6 +272,8 @@ private:
 	// update avatar SLID and display name caches
 	void idleNameCache();
 	void idleNetwork();
+	void buildWorldUpdateGraph();
+	void dumpWorldUpdateGraph();
 
 	void sendLogoutRequest();
 	void disconnectViewer();
@@ -299,6 +302,9 @@ private:
 	static LLPurgeDiskCacheThread* sPurgeDiskCacheThread;
     LL::ThreadPool* mGeneralThreadPool;
 
+	// Second half of idle(): moving drawables, particles, camera, LOD, audio
+	LL::FrameGraph mWorldUpdateGraph;
+
 	S32 mNumSessions;
 
 	std::string mSerialNumber;
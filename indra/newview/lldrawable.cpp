@@ -542,6 +542,7 @@ void LLDrawable::makeActive()
 			gPipeline.markRebuild(this, LLDrawable::REBUILD_VOLUME, TRUE);
 		}
 		updatePartition();
+		gPipeline.markLightMoved(this);
 	}
 	else if (!isRoot() && !mParent->isActive()) //this should not happen, but occasionally it does...
 	{
@@ -596,75 +597,80 @@ void LLDrawable::makeStatic(BOOL warning_enabled)
 			setSpatialBridge(NULL);
 		}
 		updatePartition();
+		gPipeline.markLightMoved(this);
 	}
 
 	llassert(isAvatar() || isRoot() || mParent->isStatic());
 }
 
-// Returns "distance" between target destination and resulting xfrom
-F32 LLDrawable::updateXform(BOOL undamped)
+// static
+F32 LLDrawable::getMoveInterpolant()
 {
-	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWABLE
+	return llclamp(LLSmoothInterpolation::getInterpolant(OBJECT_DAMPING_TIME_CONSTANT), 0.f, 1.f);
+}
 
+void LLDrawable::computeMove(BOOL undamped, F32 lerp_amt, MoveTarget& target) const
+{
 	BOOL damped = !undamped;
 
 	// Position
 	const LLVector3 old_pos(mXform.getPosition());
-	LLVector3 target_pos;
 	if (mXform.isRoot())
 	{
 		// get root position in your agent's region
-		target_pos = mVObjp->getPositionAgent();
+		target.mPosition = mVObjp->getPositionAgent();
 	}
 	else
 	{
 		// parent-relative position
-		target_pos = mVObjp->getPosition();
+		target.mPosition = mVObjp->getPosition();
 	}
 	
 	// Rotation
 	const LLQuaternion old_rot(mXform.getRotation());
-	LLQuaternion target_rot = mVObjp->getRotation();
+	target.mRotation = mVObjp->getRotation();
 	//scaling
-	LLVector3 target_scale = mVObjp->getScale();
-	LLVector3 old_scale = mCurrentScale;
+	target.mScale = mVObjp->getScale();
+	const LLVector3& old_scale = mCurrentScale;
 	
 	// Damping
-	F32 dist_squared = 0.f;
+	target.mDistSquared = 0.f;
+	target.mSnap = false;
 	F32 camdist2 = (mDistanceWRTCamera * mDistanceWRTCamera);
 
-	if (damped && isVisible())
+	// isVisible() without marking the entry visible, this may run on a worker
+	LLViewerOctreeGroup* group = getGroup();
+	bool visible = LLViewerOctreeEntryData::isVisible() || (group && group->isVisible());
+
+	if (damped && visible)
 	{
-		F32 lerp_amt = llclamp(LLSmoothInterpolation::getInterpolant(OBJECT_DAMPING_TIME_CONSTANT), 0.f, 1.f);
-		LLVector3 new_pos = lerp(old_pos, target_pos, lerp_amt);
-		dist_squared = dist_vec_squared(new_pos, target_pos);
+		LLVector3 new_pos = lerp(old_pos, target.mPosition, lerp_amt);
+		F32 dist_squared = dist_vec_squared(new_pos, target.mPosition);
 
-		LLQuaternion new_rot = nlerp(lerp_amt, old_rot, target_rot);
+		LLQuaternion new_rot = nlerp(lerp_amt, old_rot, target.mRotation);
 		// FIXME: This can be negative! It is be possible for some rots to 'cancel out' pos or size changes.
-		dist_squared += (1.f - dot(new_rot, target_rot)) * 10.f;
+		dist_squared += (1.f - dot(new_rot, target.mRotation)) * 10.f;
 
-		LLVector3 new_scale = lerp(old_scale, target_scale, lerp_amt);
-		dist_squared += dist_vec_squared(new_scale, target_scale);
+		LLVector3 new_scale = lerp(old_scale, target.mScale, lerp_amt);
+		dist_squared += dist_vec_squared(new_scale, target.mScale);
 
 		if ((dist_squared >= MIN_INTERPOLATE_DISTANCE_SQUARED * camdist2) &&
 			(dist_squared <= MAX_INTERPOLATE_DISTANCE_SQUARED))
 		{
 			// interpolate
-			target_pos = new_pos;
-			target_rot = new_rot;
-			target_scale = new_scale;
+			target.mPosition = new_pos;
+			target.mRotation = new_rot;
+			target.mScale = new_scale;
+			target.mDistSquared = dist_squared;
 		}
 		else if (mVObjp->getAngularVelocity().isExactlyZero())
 		{
 			// snap to final position (only if no target omega is applied)
-			dist_squared = 0.0f;
-			//set target scale here, because of dist_squared = 0.0f remove object from move list
-			mCurrentScale = target_scale;
-
-			if (getVOVolume() && !isRoot())
-			{ //child prim snapping to some position, needs a rebuild
-				gPipeline.markRebuild(this, LLDrawable::REBUILD_POSITION, TRUE);
-			}
+			target.mSnap = true;
+		}
+		else
+		{
+			target.mDistSquared = dist_squared;
 		}
 	}
 	else
@@ -676,6 +682,37 @@ F32 LLDrawable::updateXform(BOOL undamped)
 		//dist_squared += (1.f - dot(old_rot, target_rot)) * 10.f;
 		//dist_squared += dist_vec_squared(old_scale, target_scale);
 	}
+}
+
+// Returns "distance" between target destination and resulting xfrom
+F32 LLDrawable::updateXform(BOOL undamped)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWABLE
+
+	MoveTarget target;
+	computeMove(undamped, undamped ? 1.f : getMoveInterpolant(), target);
+	return applyMove(target);
+}
+
+F32 LLDrawable::applyMove(const MoveTarget& target)
+{
+	const LLVector3 old_pos(mXform.getPosition());
+	const LLQuaternion old_rot(mXform.getRotation());
+	const LLVector3& target_pos = target.mPosition;
+	const LLQuaternion& target_rot = target.mRotation;
+	const LLVector3& target_scale = target.mScale;
+	F32 dist_squared = target.mDistSquared;
+
+	if (target.mSnap)
+	{
+		//set target scale here, because of dist_squared = 0.0f remove object from move list
+		mCurrentScale = target_scale;
+
+		if (getVOVolume() && !isRoot())
+		{ //child prim snapping to some position, needs a rebuild
+			gPipeline.markRebuild(this, LLDrawable::REBUILD_POSITION, TRUE);
+		}
+	}
 
 	const LLVector3 vec = mCurrentScale-target_scale;
 	
@@ -780,6 +817,11 @@ void LLDrawable::movePartition()
 }
 
 BOOL LLDrawable::updateMove()
+{
+	return updateMove(NULL);
+}
+
+BOOL LLDrawable::updateMove(const MoveTarget* target)
 {
 	if (isDead())
 	{
@@ -794,12 +836,12 @@ BOOL LLDrawable::updateMove()
 	
 	makeActive();
 
-	return isState(MOVE_UNDAMPED) ? updateMoveUndamped() : updateMoveDamped();
+	return isState(MOVE_UNDAMPED) ? updateMoveUndamped(target) : updateMoveDamped(target);
 }
 
-BOOL LLDrawable::updateMoveUndamped()
+BOOL LLDrawable::updateMoveUndamped(const MoveTarget* target)
 {
-	F32 dist_squared = updateXform(TRUE);
+	F32 dist_squared = target ? applyMove(*target) : updateXform(TRUE);
 
 	mGeneration++;
 
@@ -833,11 +875,11 @@ void LLDrawable::updatePartition()
 	}
 }
 
-BOOL LLDrawable::updateMoveDamped()
+BOOL LLDrawable::updateMoveDamped(const MoveTarget* target)
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWABLE
 
-	F32 dist_squared = updateXform(FALSE);
+	F32 dist_squared = target ? applyMove(*target) : updateXform(FALSE);
 
 	mGeneration++;
 
@@ -1316,6 +1358,20 @@ void LLSpatialBridge::destroyTree()
 	mOctree = NULL;
 }
 
+// Rebounds the groups below the root of this bridge's octree.  Only this
+// bridge's own groups and drawables are touched, so moved bridges can do it
+// side by side.  The root is left dirty for updateSpatialExtents().
+void LLSpatialBridge::reboundChildren()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWABLE
+
+	for (U32 i = 0; i < mOctree->getChildCount(); i++)
+	{
+		LLSpatialGroup* group = (LLSpatialGroup*) mOctree->getChild(i)->getListener(0);
+		group->rebound();
+	}
+}
+
 void LLSpatialBridge::updateSpatialExtents()
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWABLE
@@ -150,8 +150,26 @@ public:
 	void destroy();
 
 	void update();
+
+	// Where updateXform() takes the drawable this frame, worked out by
+	// computeMove() without touching any state so that the moved list can be
+	// processed on several threads, then committed by applyMove().
+	struct MoveTarget
+	{
+		LLVector3		mPosition;
+		LLQuaternion	mRotation;
+		LLVector3		mScale;
+		F32				mDistSquared;
+		bool			mSnap;		// damping gave up, jump to the final transform
+		bool			mValid;		// set by the caller when computeMove() was run
+	};
+	void computeMove(BOOL undamped, F32 lerp_amt, MoveTarget& target) const;
+	F32 applyMove(const MoveTarget& target);
 	F32 updateXform(BOOL undamped);
 
+	// Damping factor for this frame; not thread safe, fetch it before computeMove().
+	static F32 getMoveInterpolant();
+
 	virtual void makeActive();
 	/*virtual*/ void makeStatic(BOOL warning_enabled = TRUE);
 
@@ -160,6 +178,7 @@ public:
 	BOOL isAnimating() const;
 
 	virtual BOOL updateMove();
+	BOOL updateMove(const MoveTarget* target);
 	virtual void movePartition();
 	
 	void updateTexture();
@@ -215,8 +234,8 @@ protected:
 	~LLDrawable() { destroy(); }
 	void moveUpdatePipeline(BOOL moved);
 	void updatePartition();
-	BOOL updateMoveDamped();
-	BOOL updateMoveUndamped();
+	BOOL updateMoveDamped(const MoveTarget* target = NULL);
+	BOOL updateMoveUndamped(const MoveTarget* target = NULL);
 	
 public:
 	friend class LLPipeline;
@@ -133,6 +133,7 @@ void LLFace::init(LLDrawable* drawablep, LLViewerObject* objp)
 	mLastMoveTime = 0.f;
 	mLastSkinTime = gFrameTimeSeconds;
 	mVSize = 0.f;
+	mTextureStatScale = 1.f;
 	mPixelArea = 16.f;
 	mState      = GLOBAL;
 	mDrawPoolp  = NULL;
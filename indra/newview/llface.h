@@ -123,6 +123,10 @@ public:
 	void			setVirtualSize(F32 size) { mVSize = size; }
 	void			setPixelArea(F32 area)	{ mPixelArea = area; }
 	F32				getVirtualSize() const { return mVSize; }
+	// virtual size to report to this face's textures, which may ask for less
+	// than is drawn (see setTextureStatScale)
+	F32				getTextureStatSize() const { return mVSize * mTextureStatScale; }
+	void			setTextureStatScale(F32 scale) { mTextureStatScale = scale; }
 	F32				getPixelArea() const { return mPixelArea; }
 
 	S32             getIndexInTex(U32 ch) const {llassert(ch < LLRender::NUM_TEXTURE_CHANNELS); return mIndexInTex[ch];}
@@ -301,6 +305,7 @@ private:
 	std::vector<S32> mRiggedIndex;
 	
 	F32			mVSize;
+	F32			mTextureStatScale;
 	F32			mPixelArea;
 
 	//importance factor, in the range [0, 1.0].
@@ -0,0 +1,232 @@
+/**
+ * @file llimpostoratlas.cpp
+ * @brief Implementation of LLImpostorAtlas class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llimpostoratlas.h"
+
+static U32 pow2_ceil(U32 value)
+{
+	U32 result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+static U32 log2_floor(U32 value)
+{
+	U32 result = 0;
+	while (value > 1)
+	{
+		value >>= 1;
+		++result;
+	}
+	return result;
+}
+
+LLImpostorAtlas::LLImpostorAtlas()
+:	mSize(0),
+	mMinSlot(0),
+	mSlotCount(0),
+	mAllocatedArea(0)
+{
+}
+
+void LLImpostorAtlas::init(U32 size, U32 min_slot)
+{
+	clear();
+
+	mSize = pow2_ceil(llmax(size, 1U));
+	mMinSlot = llmin(pow2_ceil(llmax(min_slot, 1U)), mSize);
+	mFree.resize(log2_floor(mSize / mMinSlot) + 1);
+	mFree[0].insert(key(0, 0));
+}
+
+void LLImpostorAtlas::clear()
+{
+	mFree.clear();
+	mSlots.clear();
+	mFreeSlots.clear();
+	mSize = 0;
+	mMinSlot = 0;
+	mSlotCount = 0;
+	mAllocatedArea = 0;
+}
+
+S32 LLImpostorAtlas::allocate(U32 width, U32 height)
+{
+	if (!mSize)
+	{
+		return -1;
+	}
+
+	const U32 wanted = llclamp(pow2_ceil(llmax(width, height)), mMinSlot, mSize);
+	for (U32 level = log2_floor(mSize / wanted); level < mFree.size(); ++level)
+	{
+		S32 block = takeBlock(level);
+		if (block < 0)
+		{
+			continue;
+		}
+
+		S32 slot;
+		if (mFreeSlots.empty())
+		{
+			slot = (S32)mSlots.size();
+			mSlots.push_back(Slot());
+		}
+		else
+		{
+			slot = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+
+		Slot& info = mSlots[slot];
+		info.mX = (U32)block % mSize;
+		info.mY = (U32)block / mSize;
+		info.mSize = levelSize(level);
+		info.mLevel = level;
+		info.mUsedWidth = 0;
+		info.mUsedHeight = 0;
+		info.mInUse = true;
+
+		++mSlotCount;
+		mAllocatedArea += info.mSize * info.mSize;
+		return slot;
+	}
+
+	return -1;
+}
+
+void LLImpostorAtlas::release(S32 slot)
+{
+	if (!isValid(slot))
+	{
+		return;
+	}
+
+	Slot& info = mSlots[slot];
+	freeBlock(info.mLevel, info.mX, info.mY);
+	info.mInUse = false;
+	mFreeSlots.push_back(slot);
+
+	--mSlotCount;
+	mAllocatedArea -= info.mSize * info.mSize;
+}
+
+bool LLImpostorAtlas::isValid(S32 slot) const
+{
+	return slot >= 0 && slot < (S32)mSlots.size() && mSlots[slot].mInUse;
+}
+
+void LLImpostorAtlas::setUsed(S32 slot, U32 width, U32 height)
+{
+	Slot& info = mSlots[slot];
+	const U32 longest = llmax(width, height, 1U);
+	if (longest > info.mSize)
+	{
+		width = (U32)((U64)width * info.mSize / longest);
+		height = (U32)((U64)height * info.mSize / longest);
+	}
+	info.mUsedWidth = llmax(width, 1U);
+	info.mUsedHeight = llmax(height, 1U);
+}
+
+void LLImpostorAtlas::getTexCoords(S32 slot, LLVector2& tc_min, LLVector2& tc_max) const
+{
+	const Slot& info = mSlots[slot];
+	const F32 scale = 1.f / (F32)mSize;
+	tc_min.set(info.mX * scale, info.mY * scale);
+	tc_max.set((info.mX + info.mUsedWidth) * scale, (info.mY + info.mUsedHeight) * scale);
+}
+
+S32 LLImpostorAtlas::takeBlock(U32 level)
+{
+	std::set<U32>& free_list = mFree[level];
+	if (!free_list.empty())
+	{
+		U32 block = *free_list.begin();
+		free_list.erase(free_list.begin());
+		return (S32)block;
+	}
+
+	if (level == 0)
+	{
+		return -1;
+	}
+
+	// split a bigger block, keeping the bottom left quarter
+	S32 parent = takeBlock(level - 1);
+	if (parent < 0)
+	{
+		return -1;
+	}
+
+	const U32 x = (U32)parent % mSize;
+	const U32 y = (U32)parent / mSize;
+	const U32 half = levelSize(level);
+	free_list.insert(key(x + half, y));
+	free_list.insert(key(x, y + half));
+	free_list.insert(key(x + half, y + half));
+	return parent;
+}
+
+void LLImpostorAtlas::freeBlock(U32 level, U32 x, U32 y)
+{
+	std::set<U32>& free_list = mFree[level];
+	if (level > 0)
+	{
+		const U32 size = levelSize(level);
+		const U32 px = x & ~(size * 2 - 1);
+		const U32 py = y & ~(size * 2 - 1);
+
+		U32 siblings[3];
+		U32 count = 0;
+		for (U32 i = 0; i < 4; ++i)
+		{
+			const U32 sx = px + (i & 1) * size;
+			const U32 sy = py + (i >> 1) * size;
+			if (sx != x || sy != y)
+			{
+				siblings[count++] = key(sx, sy);
+			}
+		}
+
+		if (free_list.count(siblings[0]) && free_list.count(siblings[1]) && free_list.count(siblings[2]))
+		{
+			for (U32 i = 0; i < 3; ++i)
+			{
+				free_list.erase(siblings[i]);
+			}
+			freeBlock(level - 1, px, py);
+			return;
+		}
+	}
+
+	free_list.insert(key(x, y));
+}
@@ -0,0 +1,112 @@
+/**
+ * @file llimpostoratlas.h
+ * @brief Layout of the shared avatar impostor texture.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMPOSTORATLAS_H
+#define LL_LLIMPOSTORATLAS_H
+
+#include <set>
+#include <vector>
+
+#include "v2math.h"
+
+//-----------------------------------------------------------------------------
+// class LLImpostorAtlas
+//
+// Hands out square power of two slots of one square texture to avatar
+// impostors, buddy style: a slot is split in four to make smaller ones and
+// four free siblings merge back when released.  When the texture is too
+// full for the size asked for, a smaller slot is handed out instead, so the
+// impostor is drawn at a lower resolution rather than not at all.
+//
+// Only does the bookkeeping; LLPipeline owns the render target the slots
+// live in.  Coordinates are in texels, origin at the bottom left.
+//-----------------------------------------------------------------------------
+class LLImpostorAtlas
+{
+public:
+	LLImpostorAtlas();
+
+	// Drops all slots and lays out a size x size texture with slots no
+	// smaller than min_slot.  Both are rounded up to powers of two.
+	void init(U32 size, U32 min_slot);
+	void clear();
+
+	U32 getSize() const { return mSize; }
+	bool isEmpty() const { return mSize == 0; }
+
+	// Returns a slot big enough for width x height or, failing that, the
+	// biggest smaller one available.  -1 if the texture is full.
+	S32 allocate(U32 width, U32 height);
+	void release(S32 slot);
+	bool isValid(S32 slot) const;
+
+	U32 getSlotX(S32 slot) const { return mSlots[slot].mX; }
+	U32 getSlotY(S32 slot) const { return mSlots[slot].mY; }
+	U32 getSlotSize(S32 slot) const { return mSlots[slot].mSize; }
+
+	// Part of the slot holding the impostor, set when it is rendered.
+	// Sizes bigger than the slot are scaled down to fit, keeping their
+	// aspect ratio.
+	void setUsed(S32 slot, U32 width, U32 height);
+	U32 getUsedWidth(S32 slot) const { return mSlots[slot].mUsedWidth; }
+	U32 getUsedHeight(S32 slot) const { return mSlots[slot].mUsedHeight; }
+
+	// Texture coordinates of the used part of the slot.
+	void getTexCoords(S32 slot, LLVector2& tc_min, LLVector2& tc_max) const;
+
+	U32 getSlotCount() const { return mSlotCount; }
+	U32 getAllocatedArea() const { return mAllocatedArea; }
+
+private:
+	struct Slot
+	{
+		U32		mX;
+		U32		mY;
+		U32		mSize;
+		U32		mLevel;
+		U32		mUsedWidth;
+		U32		mUsedHeight;
+		bool	mInUse;
+	};
+
+	// Free blocks per level, level 0 being the whole texture, keyed by
+	// position so the lowest free block is always used first.
+	U32 key(U32 x, U32 y) const { return y * mSize + x; }
+	U32 levelSize(U32 level) const { return mSize >> level; }
+	S32 takeBlock(U32 level);
+	void freeBlock(U32 level, U32 x, U32 y);
+
+	std::vector<std::set<U32> >	mFree;
+	std::vector<Slot>			mSlots;
+	std::vector<S32>			mFreeSlots;		// unused entries of mSlots
+
+	U32		mSize;
+	U32		mMinSlot;
+	U32		mSlotCount;
+	U32		mAllocatedArea;
+};
+
+#endif // LL_LLIMPOSTORATLAS_H
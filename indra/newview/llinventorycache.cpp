@@ -0,0 +1,510 @@
+/**
+ * @file llinventorycache.cpp
+ * @brief Implementation of the binary inventory cache.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorycache.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "hbxxh.h"
+#include "llfile.h"
+#include "llviewerinventory.h"
+
+static const char LOG_INV[] = "Inventory";
+
+// Bump when any of the records below change layout.
+static const U32 CACHE_FORMAT_VERSION = 1;
+static const char CACHE_MAGIC[8] = { 'S', 'L', 'I', 'N', 'V', 'B', 'I', 'N' };
+static const char CACHE_EXTENSION[] = ".bin";
+
+// All records are 8 byte aligned and padded to a multiple of 8 bytes so
+// they can be read in place from the mapped file.
+struct LLInventoryCacheFile::Header
+{
+	char	mMagic[8];
+	U32		mFormatVersion;
+	S32		mCacheVersion;		// LLInventoryModel::sCurrentInvCacheVersion
+	U32		mFolderRecordSize;
+	U32		mItemRecordSize;
+	U32		mFolderCount;
+	U32		mPad;
+	U64		mFileSize;
+};
+
+struct LLInventoryCacheFile::Folder
+{
+	LLUUID	mID;
+	LLUUID	mParentID;
+	LLUUID	mOwnerID;
+	LLUUID	mThumbnailID;
+	S32		mVersion;
+	S32		mPreferredType;
+	U32		mItemCount;
+	U32		mNameOffset;		// relative to the start of the block
+	U32		mNameLength;
+	U32		mPad;
+	U64		mBlockOffset;		// relative to the start of the file
+	U64		mBlockSize;
+	U64		mDigest;			// of the block
+};
+
+struct LLInventoryCacheFile::Item
+{
+	LLUUID	mID;
+	LLUUID	mAssetID;
+	LLUUID	mThumbnailID;
+	LLUUID	mCreatorID;
+	LLUUID	mOwnerID;
+	LLUUID	mLastOwnerID;
+	LLUUID	mGroupID;
+	U32		mBaseMask;
+	U32		mOwnerMask;
+	U32		mGroupMask;
+	U32		mEveryoneMask;
+	U32		mNextOwnerMask;
+	U32		mFlags;
+	S64		mCreationDate;
+	S32		mSalePrice;
+	S8		mSaleType;
+	S8		mType;
+	S8		mInventoryType;
+	S8		mPad;
+	U32		mNameOffset;		// relative to the start of the block
+	U32		mNameLength;
+	U32		mDescOffset;
+	U32		mDescLength;
+};
+
+static_assert(sizeof(LLUUID) == UUID_BYTES, "LLUUID is stored raw in the inventory cache");
+
+namespace
+{
+	inline U64 pad8(U64 size)
+	{
+		return (size + 7) & ~(U64)7;
+	}
+
+	inline std::string read_string(const U8* block, U64 block_size, U32 offset, U32 length)
+	{
+		if ((U64)offset + length > block_size)
+		{
+			return std::string();
+		}
+		return std::string((const char*)block + offset, length);
+	}
+}
+
+LLInventoryCacheFile::LLInventoryCacheFile()
+:	mMapping(NULL),
+	mRegion(NULL),
+	mData(NULL),
+	mSize(0),
+	mFolders(NULL),
+	mFolderCount(0)
+{
+}
+
+LLInventoryCacheFile::~LLInventoryCacheFile()
+{
+	close();
+}
+
+// static
+std::string LLInventoryCacheFile::getFilename(const LLUUID& owner_id)
+{
+	std::string filename = LLInventoryModel::getInvCacheAddres(owner_id);
+	size_t ext = filename.rfind(".llsd");
+	if (ext != std::string::npos)
+	{
+		filename.erase(ext);
+	}
+	return filename + CACHE_EXTENSION;
+}
+
+bool LLInventoryCacheFile::open(const std::string& filename)
+{
+	close();
+
+	llstat file_stat;
+	if (LLFile::stat(filename, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(Header))
+	{
+		return false;
+	}
+
+	try
+	{
+		mMapping = new boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+		mRegion = new boost::interprocess::mapped_region(*mMapping, boost::interprocess::read_only);
+	}
+	catch (const boost::interprocess::interprocess_exception& e)
+	{
+		LL_WARNS(LOG_INV) << "Unable to map inventory cache " << filename << ": " << e.what() << LL_ENDL;
+		close();
+		return false;
+	}
+
+	mData = (const U8*)mRegion->get_address();
+	mSize = mRegion->get_size();
+
+	const Header* header = (const Header*)mData;
+	if (mSize < sizeof(Header)
+		|| memcmp(header->mMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+		|| header->mFormatVersion != CACHE_FORMAT_VERSION
+		|| header->mCacheVersion != LLInventoryModel::sCurrentInvCacheVersion
+		|| header->mFolderRecordSize != sizeof(Folder)
+		|| header->mItemRecordSize != sizeof(Item)
+		|| header->mFileSize != mSize
+		|| sizeof(Header) + (U64)header->mFolderCount * sizeof(Folder) > mSize)
+	{
+		LL_WARNS(LOG_INV) << "Inventory cache " << filename << " is out of date or damaged" << LL_ENDL;
+		close();
+		return false;
+	}
+
+	mFolders = (const Folder*)(mData + sizeof(Header));
+	mFolderCount = header->mFolderCount;
+	mFolderIndex.reserve(mFolderCount);
+	for (U32 i = 0; i < mFolderCount; ++i)
+	{
+		mFolderIndex[mFolders[i].mID] = i;
+	}
+	return true;
+}
+
+void LLInventoryCacheFile::close()
+{
+	delete mRegion;
+	mRegion = NULL;
+	delete mMapping;
+	mMapping = NULL;
+	mData = NULL;
+	mSize = 0;
+	mFolders = NULL;
+	mFolderCount = 0;
+	mFolderIndex.clear();
+}
+
+const LLInventoryCacheFile::Folder* LLInventoryCacheFile::findFolder(const LLUUID& folder_id) const
+{
+	std::unordered_map<LLUUID, U32>::const_iterator it = mFolderIndex.find(folder_id);
+	return it != mFolderIndex.end() ? &mFolders[it->second] : NULL;
+}
+
+void LLInventoryCacheFile::load(const folder_version_map_t& skeleton_versions,
+								LLInventoryModel::cat_array_t& categories,
+								LLInventoryModel::item_array_t& items,
+								LLInventoryModel::changed_items_t& cats_to_update) const
+{
+	LL_PROFILE_ZONE_SCOPED;
+	if (!isOpen())
+	{
+		return;
+	}
+
+	categories.reserve(categories.size() + mFolderCount);
+	for (U32 i = 0; i < mFolderCount; ++i)
+	{
+		const Folder& folder = mFolders[i];
+		if (folder.mBlockOffset + folder.mBlockSize > mSize)
+		{
+			cats_to_update.insert(folder.mID);
+			continue;
+		}
+		const U8* block = mData + folder.mBlockOffset;
+
+		LLPointer<LLViewerInventoryCategory> cat = new LLViewerInventoryCategory(folder.mID, folder.mParentID,
+			(LLFolderType::EType)folder.mPreferredType,
+			read_string(block, folder.mBlockSize, folder.mNameOffset, folder.mNameLength),
+			folder.mOwnerID);
+		cat->setThumbnailUUID(folder.mThumbnailID);
+		cat->setVersion(folder.mVersion);
+		categories.push_back(cat);
+
+		// Folders that are stale on the server side get refetched anyway,
+		// so there is no point decoding their contents.
+		folder_version_map_t::const_iterator skel = skeleton_versions.find(folder.mID);
+		if (skel == skeleton_versions.end() || skel->second != folder.mVersion)
+		{
+			continue;
+		}
+
+		bool has_unknown_types = false;
+		if (!loadItems(folder, items, has_unknown_types) || has_unknown_types)
+		{
+			cats_to_update.insert(folder.mID);
+		}
+	}
+}
+
+bool LLInventoryCacheFile::loadItems(const Folder& folder,
+									 LLInventoryModel::item_array_t& items,
+									 bool& has_unknown_types) const
+{
+	const U8* block = mData + folder.mBlockOffset;
+	if ((U64)folder.mItemCount * sizeof(Item) > folder.mBlockSize
+		|| HBXXH64::digest(block, folder.mBlockSize) != folder.mDigest)
+	{
+		LL_WARNS(LOG_INV) << "Cached contents of folder " << folder.mID << " are damaged" << LL_ENDL;
+		return false;
+	}
+
+	const Item* records = (const Item*)block;
+	items.reserve(items.size() + folder.mItemCount);
+	for (U32 i = 0; i < folder.mItemCount; ++i)
+	{
+		const Item& record = records[i];
+		if (record.mID.isNull())
+		{
+			continue;
+		}
+		if ((LLAssetType::EType)record.mType == LLAssetType::AT_UNKNOWN)
+		{
+			has_unknown_types = true;
+			continue;
+		}
+
+		LLPermissions perm;
+		perm.init(record.mCreatorID, record.mOwnerID, record.mLastOwnerID, record.mGroupID);
+		perm.setMaskBase(record.mBaseMask);
+		perm.setMaskOwner(record.mOwnerMask);
+		perm.setMaskEveryone(record.mEveryoneMask);
+		perm.setMaskGroup(record.mGroupMask);
+		perm.setMaskNext(record.mNextOwnerMask);
+		perm.fix();
+
+		LLPointer<LLViewerInventoryItem> item = new LLViewerInventoryItem(record.mID, folder.mID, perm, record.mAssetID,
+			(LLAssetType::EType)record.mType, (LLInventoryType::EType)record.mInventoryType,
+			read_string(block, folder.mBlockSize, record.mNameOffset, record.mNameLength),
+			read_string(block, folder.mBlockSize, record.mDescOffset, record.mDescLength),
+			LLSaleInfo((LLSaleInfo::EForSale)record.mSaleType, record.mSalePrice),
+			record.mFlags, (time_t)record.mCreationDate);
+		item->setThumbnailUUID(record.mThumbnailID);
+		items.push_back(item);
+	}
+	return true;
+}
+
+
+// static
+void LLInventoryCacheFile::encodeBlock(const LLViewerInventoryCategory* cat,
+									   const std::vector<const LLViewerInventoryItem*>& contents,
+									   std::vector<U8>& block,
+									   Folder& folder)
+{
+	// Links forward most getters to their target, so read the item's own
+	// fields through the LLInventoryItem versions, as asLLSD() does.
+	const U64 records_size = contents.size() * sizeof(Item);
+	std::vector<Item> records(contents.size());
+	std::string strings;
+
+	folder.mNameOffset = (U32)(records_size + strings.size());
+	folder.mNameLength = (U32)cat->getName().size();
+	strings += cat->getName();
+
+	for (size_t i = 0; i < contents.size(); ++i)
+	{
+		const LLViewerInventoryItem* item = contents[i];
+		const LLPermissions& perm = item->LLInventoryItem::getPermissions();
+		const LLSaleInfo& sale_info = item->LLInventoryItem::getSaleInfo();
+		Item& record = records[i];
+
+		record.mID = item->getUUID();
+		record.mAssetID = item->LLInventoryItem::getAssetUUID();
+		record.mThumbnailID = item->LLInventoryItem::getThumbnailUUID();
+		record.mCreatorID = perm.getCreator();
+		record.mOwnerID = perm.getOwner();
+		record.mLastOwnerID = perm.getLastOwner();
+		record.mGroupID = perm.getGroup();
+		record.mBaseMask = perm.getMaskBase();
+		record.mOwnerMask = perm.getMaskOwner();
+		record.mGroupMask = perm.getMaskGroup();
+		record.mEveryoneMask = perm.getMaskEveryone();
+		record.mNextOwnerMask = perm.getMaskNextOwner();
+		record.mFlags = item->LLInventoryItem::getFlags();
+		record.mCreationDate = (S64)item->LLInventoryItem::getCreationDate();
+		record.mSalePrice = sale_info.getSalePrice();
+		record.mSaleType = (S8)sale_info.getSaleType();
+		record.mType = (S8)item->getActualType();
+		record.mInventoryType = (S8)item->LLInventoryItem::getInventoryType();
+		record.mPad = 0;
+
+		const std::string& name = item->LLInventoryItem::getName();
+		record.mNameOffset = (U32)(records_size + strings.size());
+		record.mNameLength = (U32)name.size();
+		strings += name;
+
+		const std::string& desc = item->LLInventoryItem::getDescription();
+		record.mDescOffset = (U32)(records_size + strings.size());
+		record.mDescLength = (U32)desc.size();
+		strings += desc;
+	}
+
+	block.assign(pad8(records_size + strings.size()), 0);
+	if (!records.empty())
+	{
+		memcpy(&block[0], &records[0], records_size);
+	}
+	if (!strings.empty())
+	{
+		memcpy(&block[records_size], strings.data(), strings.size());
+	}
+	folder.mBlockSize = block.size();
+	folder.mDigest = HBXXH64::digest(block.data(), block.size());
+}
+
+// static
+bool LLInventoryCacheFile::save(const std::string& filename,
+								const LLInventoryModel::cat_array_t& categories,
+								const LLInventoryModel::item_array_t& items,
+								LLInventoryCacheFile* previous,
+								const LLInventoryModel::changed_items_t& dirty_folders)
+{
+	LL_PROFILE_ZONE_SCOPED;
+	if (filename.empty())
+	{
+		LL_ERRS(LOG_INV) << "Filename is Null!" << LL_ENDL;
+		return false;
+	}
+
+	LL_INFOS(LOG_INV) << "saving inventory to: (" << filename << ")" << LL_ENDL;
+
+	typedef std::vector<const LLViewerInventoryItem*> contents_t;
+	std::unordered_map<LLUUID, contents_t> folder_contents;
+	for (const LLPointer<LLViewerInventoryItem>& item : items)
+	{
+		folder_contents[item->getParentUUID()].push_back(item.get());
+	}
+
+	std::vector<const LLViewerInventoryCategory*> folders;
+	folders.reserve(categories.size());
+	for (const LLPointer<LLViewerInventoryCategory>& cat : categories)
+	{
+		if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
+		{
+			folders.push_back(cat.get());
+		}
+	}
+
+	// Write next to the real file so that the final rename stays on one volume.
+	const std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+	if (!fp)
+	{
+		LL_WARNS(LOG_INV) << "Failed to open file. Unable to save inventory to: " << temp_filename << LL_ENDL;
+		return false;
+	}
+
+	std::vector<Folder> index(folders.size());
+	U64 offset = pad8(sizeof(Header) + index.size() * sizeof(Folder));
+	bool ok = fseek(fp, (long)offset, SEEK_SET) == 0;
+
+	const bool use_previous = previous && previous->isOpen();
+	const contents_t no_contents;
+	std::vector<U8> block;
+	S32 copied_count = 0;
+	for (size_t i = 0; ok && i < folders.size(); ++i)
+	{
+		const LLViewerInventoryCategory* cat = folders[i];
+		std::unordered_map<LLUUID, contents_t>::const_iterator contents_it = folder_contents.find(cat->getUUID());
+		const contents_t& contents = contents_it != folder_contents.end() ? contents_it->second : no_contents;
+
+		Folder& folder = index[i];
+		folder.mID = cat->getUUID();
+		folder.mParentID = cat->getParentUUID();
+		folder.mOwnerID = cat->getOwnerID();
+		folder.mThumbnailID = cat->getThumbnailUUID();
+		folder.mVersion = cat->getVersion();
+		folder.mPreferredType = cat->getPreferredType();
+		folder.mItemCount = (U32)contents.size();
+		folder.mPad = 0;
+
+		const U8* data = NULL;
+		const Folder* old = use_previous ? previous->findFolder(folder.mID) : NULL;
+		if (old
+			&& old->mVersion == folder.mVersion
+			&& old->mItemCount == folder.mItemCount
+			&& old->mBlockOffset + old->mBlockSize <= previous->mSize
+			&& dirty_folders.find(folder.mID) == dirty_folders.end())
+		{
+			// Nothing in this folder changed since it was loaded, so the
+			// encoded block can be reused as is.
+			folder.mNameOffset = old->mNameOffset;
+			folder.mNameLength = old->mNameLength;
+			folder.mBlockSize = old->mBlockSize;
+			folder.mDigest = old->mDigest;
+			data = previous->mData + old->mBlockOffset;
+			++copied_count;
+		}
+		else
+		{
+			encodeBlock(cat, contents, block, folder);
+			data = block.data();
+		}
+
+		folder.mBlockOffset = offset;
+		ok = fwrite(data, 1, (size_t)folder.mBlockSize, fp) == folder.mBlockSize;
+		offset += folder.mBlockSize;
+	}
+
+	Header header;
+	memcpy(header.mMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.mFormatVersion = CACHE_FORMAT_VERSION;
+	header.mCacheVersion = LLInventoryModel::sCurrentInvCacheVersion;
+	header.mFolderRecordSize = sizeof(Folder);
+	header.mItemRecordSize = sizeof(Item);
+	header.mFolderCount = (U32)index.size();
+	header.mPad = 0;
+	header.mFileSize = offset;
+
+	ok = ok && fseek(fp, 0, SEEK_SET) == 0;
+	ok = ok && fwrite(&header, sizeof(Header), 1, fp) == 1;
+	ok = ok && (index.empty() || fwrite(&index[0], sizeof(Folder), index.size(), fp) == index.size());
+	ok = (fclose(fp) == 0) && ok;
+
+	// The old file may be mapped; it has to go before it can be replaced.
+	if (previous)
+	{
+		previous->close();
+	}
+
+	if (ok)
+	{
+		LLFile::remove(filename, ENOENT);
+		ok = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!ok)
+	{
+		LL_WARNS(LOG_INV) << "Failed to write inventory cache " << filename << LL_ENDL;
+		LLFile::remove(temp_filename, ENOENT);
+		return false;
+	}
+
+	LL_INFOS(LOG_INV) << "Inventory saved: " << folders.size() << " categories (" << copied_count
+					  << " unchanged), " << items.size() << " items." << LL_ENDL;
+	return true;
+}
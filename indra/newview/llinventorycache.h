@@ -0,0 +1,108 @@
+/**
+ * @file llinventorycache.h
+ * @brief Binary, memory-mapped on-disk cache of inventory folders and items.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYCACHE_H
+#define LL_LLINVENTORYCACHE_H
+
+#include <unordered_map>
+
+#include "llinventorymodel.h"
+
+namespace boost { namespace interprocess { class file_mapping; class mapped_region; } }
+
+//-----------------------------------------------------------------------------
+// class LLInventoryCacheFile
+//
+// Versioned binary replacement for the gzipped LLSD-per-line inventory cache.
+//
+// The file is a fixed-size header, then one fixed-size index record per
+// folder, then one block per folder holding that folder's fixed-size item
+// records followed by the strings they reference.  Each folder block is
+// self-contained and carries a digest, so:
+//  - at login the file is mapped and only the blocks of folders whose cached
+//    version still matches the server skeleton are decoded;
+//  - on save, blocks of folders that have not changed since they were loaded
+//    are copied verbatim from the previous file instead of being re-encoded.
+//-----------------------------------------------------------------------------
+class LLInventoryCacheFile
+{
+public:
+	typedef std::unordered_map<LLUUID, S32> folder_version_map_t;
+
+	LLInventoryCacheFile();
+	~LLInventoryCacheFile();
+
+	static std::string getFilename(const LLUUID& owner_id);
+
+	// Maps the file and validates its header and index.  Returns false if
+	// the file is missing, truncated or from another format version.
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const { return mData != NULL; }
+
+	// Decodes every cached folder into categories.  Items are decoded only
+	// for folders present in skeleton_versions with the same version; folders
+	// whose block is damaged or holds items of unknown type are added to
+	// cats_to_update instead.
+	void load(const folder_version_map_t& skeleton_versions,
+			  LLInventoryModel::cat_array_t& categories,
+			  LLInventoryModel::item_array_t& items,
+			  LLInventoryModel::changed_items_t& cats_to_update) const;
+
+	// Writes categories and items to filename.  If previous is open, blocks
+	// of folders that are not in dirty_folders and whose version and item
+	// count are unchanged are copied from it rather than re-encoded.
+	// previous is closed before the new file replaces the old one.
+	static bool save(const std::string& filename,
+					 const LLInventoryModel::cat_array_t& categories,
+					 const LLInventoryModel::item_array_t& items,
+					 LLInventoryCacheFile* previous,
+					 const LLInventoryModel::changed_items_t& dirty_folders);
+
+private:
+	struct Header;
+	struct Folder;
+	struct Item;
+
+	const Folder* findFolder(const LLUUID& folder_id) const;
+	bool loadItems(const Folder& folder,
+				   LLInventoryModel::item_array_t& items,
+				   bool& has_unknown_types) const;
+	static void encodeBlock(const LLViewerInventoryCategory* cat,
+							const std::vector<const LLViewerInventoryItem*>& contents,
+							std::vector<U8>& block,
+							Folder& folder);
+
+	boost::interprocess::file_mapping*	mMapping;
+	boost::interprocess::mapped_region*	mRegion;
+	const U8*							mData;
+	size_t								mSize;
+	const Folder*						mFolders;
+	U32									mFolderCount;
+	std::unordered_map<LLUUID, U32>		mFolderIndex;
+};
+
+#endif // LL_LLINVENTORYCACHE_H
@@ -34,6 +34,7 @@
 #include "llfolderviewitem.h"
 #include "llinventorymodel.h"
 #include "llinventorymodelbackgroundfetch.h"
+#include "llinventorysearchindex.h"
 #include "llinventoryfunctions.h"
 #include "llmarketplacefunctions.h"
 #include "llregex.h"
@@ -83,7 +84,11 @@ LLInventoryFilter::LLInventoryFilter(const Params& p)
 	mFirstRequiredGeneration(0),
 	mFirstSuccessGeneration(0),
 	mSearchType(SEARCHTYPE_NAME),
-    mSingleFolderMode(false)
+    mSingleFolderMode(false),
+	mIndexSearchType(SEARCHTYPE_NAME),
+	mIndexGeneration(-1),
+	mIndexSerial(0),
+	mIndexMatchesValid(false)
 {
 	// copy mFilterOps into mDefaultFilterOps
 	markDefault();
@@ -102,55 +107,63 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
 		return true;
 	}
 
-	std::string desc = listener->getSearchableCreatorName();
-	switch(mSearchType)
+	bool passed = true;
+	if (!is_folder
+		&& !mFilterSubString.empty() && mExactToken.empty() && mFilterTokens.empty()
+		&& checkAgainstSearchIndex(listener, passed))
 	{
-		case SEARCHTYPE_CREATOR:
-			desc = listener->getSearchableCreatorName();
-			break;
-		case SEARCHTYPE_DESCRIPTION:
-			desc = listener->getSearchableDescription();
-			break;
-		case SEARCHTYPE_UUID:
-			desc = listener->getSearchableUUIDString();
-			break;
-		case SEARCHTYPE_NAME:
-		default:
-			desc = listener->getSearchableName();
-			break;
+		// string test answered by the search index
 	}
-
-
-	bool passed = true;
-	if (!mExactToken.empty() && (mSearchType == SEARCHTYPE_NAME))
+	else
 	{
-		passed = false;
-		typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
-		boost::char_separator<char> sep(" ");
-		tokenizer tokens(desc, sep);
+		std::string desc;
+		switch(mSearchType)
+		{
+			case SEARCHTYPE_CREATOR:
+				desc = listener->getSearchableCreatorName();
+				break;
+			case SEARCHTYPE_DESCRIPTION:
+				desc = listener->getSearchableDescription();
+				break;
+			case SEARCHTYPE_UUID:
+				desc = listener->getSearchableUUIDString();
+				break;
+			case SEARCHTYPE_NAME:
+			default:
+				desc = listener->getSearchableName();
+				break;
+		}
 
-		for (auto token_iter : tokens)
+		if (!mExactToken.empty() && (mSearchType == SEARCHTYPE_NAME))
 		{
-			if (token_iter == mExactToken)
+			passed = false;
+			typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+			boost::char_separator<char> sep(" ");
+			tokenizer tokens(desc, sep);
+
+			for (auto token_iter : tokens)
 			{
-				passed = true;
-				break;
-			}
-		}	
-	}
-	else if ((mFilterTokens.size() > 0) && (mSearchType == SEARCHTYPE_NAME))
-	{
-		for (auto token_iter : mFilterTokens)
+				if (token_iter == mExactToken)
+				{
+					passed = true;
+					break;
+				}
+			}	
+		}
+		else if ((mFilterTokens.size() > 0) && (mSearchType == SEARCHTYPE_NAME))
 		{
-			if (desc.find(token_iter) == std::string::npos)
+			for (auto token_iter : mFilterTokens)
 			{
-				return false;
+				if (desc.find(token_iter) == std::string::npos)
+				{
+					return false;
+				}
 			}
 		}
-	}
-	else
-	{
-		passed = (mFilterSubString.size() ? desc.find(mFilterSubString) != std::string::npos : true);
+		else
+		{
+			passed = (mFilterSubString.size() ? desc.find(mFilterSubString) != std::string::npos : true);
+		}
 	}
 
 	passed = passed && checkAgainstFilterType(listener);
@@ -532,6 +545,100 @@ bool LLInventoryFilter::checkAgainstClipboard(const LLUUID& object_id) const
 	return true;
 }
 
+// Answers the search string test for items known to LLInventorySearchIndex.
+// Returns false, leaving passed alone, if the caller has to compare strings.
+bool LLInventoryFilter::checkAgainstSearchIndex(const LLFolderViewModelItemInventory* listener, bool& passed)
+{
+	if (mSearchType != SEARCHTYPE_NAME && mSearchType != SEARCHTYPE_CREATOR)
+	{
+		return false;
+	}
+
+	updateSearchIndexMatches();
+	if (!mIndexMatchesValid)
+	{
+		return false;
+	}
+
+	const LLInventorySearchIndex& index = LLInventorySearchIndex::instance();
+	const LLUUID& item_id = listener->getUUID();
+	if (mSearchType == SEARCHTYPE_CREATOR)
+	{
+		const LLUUID* creator_id = index.getCreatorID(item_id);
+		if (!creator_id)
+		{
+			return false;
+		}
+		passed = mIndexMatches.find(*creator_id) != mIndexMatches.end();
+		return true;
+	}
+
+	const std::string* name = index.getName(item_id);
+	if (!name)
+	{
+		return false;
+	}
+	if (mIndexMatches.find(item_id) != mIndexMatches.end())
+	{
+		passed = true;
+		return true;
+	}
+
+	// The name itself does not match, but the searchable name also carries
+	// the label suffix ("(worn)", "(no copy)"...) so look for the string
+	// anywhere it could overlap that.
+	const std::string& desc = listener->getSearchableName();
+	const size_t query_len = mFilterSubString.size();
+	const size_t start = name->size() >= query_len ? name->size() - query_len + 1 : 0;
+	passed = desc.size() > name->size() && desc.find(mFilterSubString, start) != std::string::npos;
+	return true;
+}
+
+void LLInventoryFilter::updateSearchIndexMatches()
+{
+	LLInventorySearchIndex& index = LLInventorySearchIndex::instance();
+	const U32 serial = index.getSerial();
+	if (mIndexGeneration == mCurrentGeneration && mIndexSerial == serial)
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED;
+
+	if (mSearchType == SEARCHTYPE_CREATOR)
+	{
+		// Creators are few enough to rescan, and their names may have
+		// arrived since the last pass.
+		index.findCreators(mFilterSubString, mIndexMatches);
+		mIndexMatchesValid = true;
+	}
+	else
+	{
+		// Typing more characters only ever removes matches, so re-check the
+		// previous result instead of going back to the index.
+		const bool narrowing = mIndexMatchesValid
+			&& mIndexSearchType == SEARCHTYPE_NAME
+			&& mIndexSerial == serial
+			&& mIndexQuery.size() >= LLInventorySearchIndex::MIN_QUERY_LENGTH
+			&& mFilterSubString.find(mIndexQuery) != std::string::npos;
+		if (narrowing)
+		{
+			LLInventorySearchIndex::id_set_t previous;
+			previous.swap(mIndexMatches);
+			mIndexMatchesValid = index.findName(mFilterSubString, mIndexMatches, &previous);
+		}
+		else
+		{
+			mIndexMatchesValid = index.findName(mFilterSubString, mIndexMatches);
+		}
+	}
+
+	mIndexQuery = mFilterSubString;
+	mIndexSearchType = mSearchType;
+	mIndexGeneration = mCurrentGeneration;
+	mIndexSerial = serial;
+}
+
 bool LLInventoryFilter::checkAgainstPermissions(const LLFolderViewModelItemInventory* listener) const
 {
 	if (!listener) return FALSE;
@@ -31,6 +31,8 @@
 #include "llpermissionsflags.h"
 #include "llfolderviewmodel.h"
 
+#include <unordered_set>
+
 class LLFolderViewItem;
 class LLFolderViewFolder;
 class LLInventoryItem;
@@ -349,6 +351,8 @@ private:
 	bool 				checkAgainstCreator(const class LLFolderViewModelItemInventory* listener) const;
 	bool				checkAgainstSearchVisibility(const class LLFolderViewModelItemInventory* listener) const;
 	bool				checkAgainstClipboard(const LLUUID& object_id) const;
+	bool				checkAgainstSearchIndex(const class LLFolderViewModelItemInventory* listener, bool& passed);
+	void				updateSearchIndexMatches();
 
 	FilterOps				mFilterOps;
 	FilterOps				mDefaultFilterOps;
@@ -378,6 +382,16 @@ private:
 	std::vector<std::string> mFilterTokens;
 	std::string				 mExactToken;
 
+	// Items (name search) or creators (creator search) matching mIndexQuery
+	// according to LLInventorySearchIndex, valid for mIndexGeneration and
+	// the index serial mIndexSerial.
+	std::unordered_set<LLUUID> mIndexMatches;
+	std::string				 mIndexQuery;
+	ESearchType				 mIndexSearchType;
+	S32						 mIndexGeneration;
+	U32						 mIndexSerial;
+	bool					 mIndexMatchesValid;
+
     bool mSingleFolderMode;
 };
 
@@ -40,6 +40,7 @@
 #include "lldispatcher.h"
 #include "llinventorypanel.h"
 #include "llinventorybridge.h"
+#include "llinventorycache.h"
 #include "llinventoryfunctions.h"
 #include "llinventorymodelbackgroundfetch.h"
 #include "llinventoryobserver.h"
@@ -1272,13 +1273,24 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
 											BOOL include_trash,
 											LLInventoryCollectFunctor& add)
 {
-	// Start with categories
+	// Look the trash up once rather than at every level of the recursion.
+	LLUUID trash_id;
 	if(!include_trash)
 	{
-		const LLUUID trash_id = findCategoryUUIDForType(LLFolderType::FT_TRASH);
-		if(trash_id.notNull() && (trash_id == id))
-			return;
+		trash_id = findCategoryUUIDForType(LLFolderType::FT_TRASH);
 	}
+	collectDescendentsIfNotIn(id, cats, items, trash_id, add);
+}
+
+void LLInventoryModel::collectDescendentsIfNotIn(const LLUUID& id,
+												 cat_array_t& cats,
+												 item_array_t& items,
+												 const LLUUID& excluded_id,
+												 LLInventoryCollectFunctor& add)
+{
+	// Start with categories
+	if(excluded_id.notNull() && (excluded_id == id))
+		return;
 	cat_array_t* cat_array = get_ptr_in_map(mParentChildCategoryTree, id);
 	if(cat_array)
 	{
@@ -1290,7 +1302,7 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
 			{
 				cats.push_back(cat);
 			}
-			collectDescendentsIf(cat->getUUID(), cats, items, include_trash, add);
+			collectDescendentsIfNotIn(cat->getUUID(), cats, items, excluded_id, add);
 		}
 	}
 
@@ -1687,7 +1699,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
 		return;
 	}
 
-	if((object_id == cat_id) || !is_in_map(mCategoryMap, cat_id))
+	if((object_id == cat_id) || mCategoryMap.find(cat_id) == mCategoryMap.end())
 	{
 		LL_WARNS(LOG_INV) << "Could not move inventory object " << object_id << " to "
 						  << cat_id << LL_ENDL;
@@ -2173,6 +2185,20 @@ void LLInventoryModel::notifyObservers()
 // and id of object change applies to
 void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent) 
 { 
+	if (referent.notNull())
+	{
+		// A changed folder needs its own cache block rewritten, a changed
+		// item needs its parent's.
+		if (LLViewerInventoryItem* item = getItem(referent))
+		{
+			mCacheDirtyFolderIDs.insert(item->getParentUUID());
+		}
+		else
+		{
+			mCacheDirtyFolderIDs.insert(referent);
+		}
+	}
+
 	if (mIsNotifyObservers)
 	{
 		// Something marked an item for change within a call to notifyObservers
@@ -2329,20 +2355,16 @@ void LLInventoryModel::cache(
 		items,
 		INCLUDE_TRASH,
 		can_cache);
-    // Use temporary file to avoid potential conflicts with other
-    // instances (even a 'read only' instance unzips into a file)
-    std::string temp_file = gDirUtilp->getTempFilename();
-	saveToFile(temp_file, categories, items);
-    std::string gzip_filename = getInvCacheAddres(agent_id);
-	gzip_filename.append(".gz");
-	if(gzip_file(temp_file, gzip_filename))
-	{
-		LL_DEBUGS(LOG_INV) << "Successfully compressed " << temp_file << " to " << gzip_filename << LL_ENDL;
-		LLFile::remove(temp_file);
-	}
-	else
-	{
-		LL_WARNS(LOG_INV) << "Unable to compress " << temp_file << " into " << gzip_filename << LL_ENDL;
+	// Folders untouched since login are copied straight from the old file.
+	std::string filename = LLInventoryCacheFile::getFilename(agent_id);
+	LLInventoryCacheFile previous;
+	previous.open(filename);
+	if (LLInventoryCacheFile::save(filename, categories, items, &previous, mCacheDirtyFolderIDs))
+	{
+		// The binary cache supersedes the old gzipped LLSD one.
+		std::string gzip_filename = getInvCacheAddres(agent_id);
+		gzip_filename.append(".gz");
+		LLFile::remove(gzip_filename, ENOENT);
 	}
 }
 
@@ -2695,26 +2717,50 @@ bool LLInventoryModel::loadSkeleton(
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
 		std::string gzip_filename(inventory_filename);
 		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
 		bool remove_inventory_file = false;
-		if(fp)
-		{
-			fclose(fp);
-			fp = NULL;
-			if(gunzip_file(gzip_filename, inventory_filename))
+		bool is_cache_obsolete = false;
+		bool is_cache_loaded = false;
+		LLInventoryCacheFile cache_file;
+		if (cache_file.open(LLInventoryCacheFile::getFilename(owner_id)))
+		{
+			// Only the contents of folders whose cached version still
+			// matches the skeleton get decoded.
+			LLInventoryCacheFile::folder_version_map_t skeleton_versions;
+			skeleton_versions.reserve(temp_cats.size());
+			for (cat_set_t::iterator it = temp_cats.begin(); it != temp_cats.end(); ++it)
 			{
-				// we only want to remove the inventory file if it was
-				// gzipped before we loaded, and we successfully
-				// gunziped it.
-				remove_inventory_file = true;
+				skeleton_versions[(*it)->getUUID()] = (*it)->getVersion();
 			}
-			else
+			LLTimer load_timer;
+			cache_file.load(skeleton_versions, categories, items, categories_to_update);
+			cache_file.close();
+			is_cache_loaded = true;
+			LL_INFOS(LOG_INV) << "Loaded " << categories.size() << " categories and " << items.size()
+							  << " items from binary cache in " << load_timer.getElapsedTimeF32() << "s" << LL_ENDL;
+		}
+		else
+		{
+			// Fall back on the gzipped LLSD cache written by older viewers.
+			LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+			if(fp)
 			{
-				LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+				fclose(fp);
+				fp = NULL;
+				if(gunzip_file(gzip_filename, inventory_filename))
+				{
+					// we only want to remove the inventory file if it was
+					// gzipped before we loaded, and we successfully
+					// gunziped it.
+					remove_inventory_file = true;
+				}
+				else
+				{
+					LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+				}
 			}
+			is_cache_loaded = loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete);
 		}
-		bool is_cache_obsolete = false;
-		if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+		if (is_cache_loaded)
 		{
 			// We were able to find a cache of files. So, use what we
 			// found to generate a set of categories we should add. We
@@ -2940,6 +2986,9 @@ void LLInventoryModel::buildParentChildMap()
 	cat_array_t* catsp;
 	item_array_t* itemsp;
 	
+	cats.reserve(mCategoryMap.size());
+	mParentChildCategoryTree.reserve(mCategoryMap.size() + 1);
+	mParentChildItemTree.reserve(mCategoryMap.size());
 	for(cat_map_t::iterator cit = mCategoryMap.begin(); cit != mCategoryMap.end(); ++cit)
 	{
 		LLViewerInventoryCategory* cat = cit->second;
@@ -3406,85 +3455,6 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 	return !is_cache_obsolete;	
 }
 
-// static
-bool LLInventoryModel::saveToFile(const std::string& filename,
-	const cat_array_t& categories,
-	const item_array_t& items)
-{
-	if (filename.empty())
-	{
-		LL_ERRS(LOG_INV) << "Filename is Null!" << LL_ENDL;
-		return false;
-	}
-
-	LL_INFOS(LOG_INV) << "saving inventory to: (" << filename << ")" << LL_ENDL;
-
-    try
-    {
-        llofstream fileXML(filename.c_str());
-        if (!fileXML.is_open())
-        {
-            LL_WARNS(LOG_INV) << "Failed to open file. Unable to save inventory to: " << filename << LL_ENDL;
-            return false;
-        }
-
-        LLSD cache_ver;
-        cache_ver["inv_cache_version"] = sCurrentInvCacheVersion;
-
-        if (fileXML.fail())
-        {
-            LL_WARNS(LOG_INV) << "Failed to write cache version to file. Unable to save inventory to: " << filename << LL_ENDL;
-            return false;
-        }
-
-        fileXML << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
-
-        S32 count = categories.size();
-        S32 cat_count = 0;
-        S32 i;
-        for (i = 0; i < count; ++i)
-        {
-            LLViewerInventoryCategory* cat = categories[i];
-            if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
-            {
-                fileXML << LLSDOStreamer<LLSDNotationFormatter>(cat->exportLLSD()) << std::endl;
-                cat_count++;
-            }
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write a folder to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
-        }
-
-        S32 it_count = items.size();
-        for (i = 0; i < it_count; ++i)
-        {
-            fileXML << LLSDOStreamer<LLSDNotationFormatter>(items[i]->asLLSD()) << std::endl;
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write an item to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
-        }
-        fileXML.flush();
-
-        fileXML.close();
-
-        LL_INFOS(LOG_INV) << "Inventory saved: " << cat_count << " categories, " << it_count << " items." << LL_ENDL;
-    }
-    catch (...)
-    {
-        LOG_UNHANDLED_EXCEPTION("");
-        LL_INFOS(LOG_INV) << "Failed to save inventory to: (" << filename << ")" << LL_ENDL;
-        return false;
-    }
-
-    return true;
-}
-
 // message handling functionality
 // static
 void LLInventoryModel::registerCallbacks(LLMessageSystem* msg)
@@ -4308,6 +4278,151 @@ void LLInventoryModel::dumpInventory() const
 	LL_INFOS() << "\n**********************\nEnd Inventory Dump" << LL_ENDL;
 }
 
+namespace
+{
+	class LLBenchmarkIsLink : public LLInventoryCollectFunctor
+	{
+	public:
+		virtual bool operator()(LLInventoryCategory* cat, LLInventoryItem* item)
+		{
+			// Use the actual type, resolving links would go through gInventory.
+			return item && item->getActualType() == LLAssetType::AT_LINK;
+		}
+	};
+}
+
+// *NOTE: DEBUG functionality
+// static
+void LLInventoryModel::benchmarkLookups(S32 num_items)
+{
+	const S32 ITEMS_PER_FOLDER = 50;
+	const S32 FOLDER_FANOUT = 8;
+	const S32 LINK_EVERY = 10;
+	const S32 NUM_QUERIES = 100000;
+
+	num_items = llmax(num_items, ITEMS_PER_FOLDER);
+	const S32 num_folders = num_items / ITEMS_PER_FOLDER;
+
+	LLInventoryModel model;
+	std::mt19937 rng(42);
+	LLUUID owner_id;
+	owner_id.generate();
+	LLPermissions perm;
+	perm.init(owner_id, owner_id, LLUUID::null, LLUUID::null);
+
+	LLTimer timer;
+
+	// Folders form a FOLDER_FANOUT-ary tree, so folder i's parent is (i - 1) / FOLDER_FANOUT.
+	uuid_vec_t folder_ids(num_folders);
+	uuid_vec_t item_ids;
+	uuid_vec_t link_target_ids;
+	item_ids.reserve(num_items);
+	model.mCategoryMap.reserve(num_folders);
+	model.mItemMap.reserve(num_items);
+	model.mParentChildCategoryTree.reserve(num_folders + 1);
+	model.mParentChildItemTree.reserve(num_folders);
+	model.mParentChildCategoryTree[LLUUID::null] = new cat_array_t;
+	for (S32 i = 0; i < num_folders; ++i)
+	{
+		folder_ids[i].generate();
+		const LLUUID& parent_id = i ? folder_ids[(i - 1) / FOLDER_FANOUT] : LLUUID::null;
+		LLPointer<LLViewerInventoryCategory> cat = new LLViewerInventoryCategory(folder_ids[i], parent_id,
+			i ? LLFolderType::FT_NONE : LLFolderType::FT_ROOT_INVENTORY, llformat("Folder %d", i), owner_id);
+		model.mCategoryMap[folder_ids[i]] = cat;
+		model.mParentChildCategoryTree[folder_ids[i]] = new cat_array_t;
+		model.mParentChildItemTree[folder_ids[i]] = new item_array_t;
+		model.mParentChildCategoryTree[parent_id]->push_back(cat);
+	}
+	for (S32 i = 0; i < num_folders; ++i)
+	{
+		item_array_t* items = model.mParentChildItemTree[folder_ids[i]];
+		items->reserve(ITEMS_PER_FOLDER);
+		for (S32 j = 0; j < ITEMS_PER_FOLDER; ++j)
+		{
+			LLUUID item_id;
+			item_id.generate();
+			LLUUID asset_id;
+			LLAssetType::EType type = LLAssetType::AT_NOTECARD;
+			LLInventoryType::EType inv_type = LLInventoryType::IT_NOTECARD;
+			bool is_link = !item_ids.empty() && (j % LINK_EVERY) == LINK_EVERY - 1;
+			if (is_link)
+			{
+				asset_id = item_ids[rng() % item_ids.size()];
+				type = LLAssetType::AT_LINK;
+				inv_type = LLInventoryType::IT_NONE;
+			}
+			else
+			{
+				asset_id.generate();
+			}
+			LLPointer<LLViewerInventoryItem> item = new LLViewerInventoryItem(item_id, folder_ids[i], perm, asset_id,
+				type, inv_type, llformat("Item %d", (S32)item_ids.size()), std::string(), LLSaleInfo::DEFAULT, 0, time_corrected());
+			model.mItemMap[item_id] = item;
+			items->push_back(item);
+			if (is_link)
+			{
+				model.mBacklinkMMap.insert(std::make_pair(asset_id, item_id));
+				link_target_ids.push_back(asset_id);
+			}
+			item_ids.push_back(item_id);
+		}
+	}
+	LL_INFOS("Inventory") << "Built synthetic inventory of " << model.mCategoryMap.size() << " folders and "
+						  << model.mItemMap.size() << " items (" << model.mBacklinkMMap.size() << " links) in "
+						  << timer.getElapsedTimeF64() << "s" << LL_ENDL;
+
+	S32 found = 0;
+	timer.reset();
+	for (S32 i = 0; i < NUM_QUERIES; ++i)
+	{
+		found += model.getItem(item_ids[rng() % item_ids.size()]) ? 1 : 0;
+	}
+	LL_INFOS("Inventory") << NUM_QUERIES << " getItem() calls: " << timer.getElapsedTimeF64() << "s (" << found << " found)" << LL_ENDL;
+
+	found = 0;
+	timer.reset();
+	for (S32 i = 0; i < NUM_QUERIES; ++i)
+	{
+		found += model.getCategory(folder_ids[rng() % folder_ids.size()]) ? 1 : 0;
+	}
+	LL_INFOS("Inventory") << NUM_QUERIES << " getCategory() calls: " << timer.getElapsedTimeF64() << "s (" << found << " found)" << LL_ENDL;
+
+	found = 0;
+	timer.reset();
+	for (S32 i = 0; i < NUM_QUERIES; ++i)
+	{
+		cat_array_t* cats = NULL;
+		item_array_t* items = NULL;
+		model.getDirectDescendentsOf(folder_ids[rng() % folder_ids.size()], cats, items);
+		found += items ? (S32)items->size() : 0;
+	}
+	LL_INFOS("Inventory") << NUM_QUERIES << " getDirectDescendentsOf() calls: " << timer.getElapsedTimeF64() << "s (" << found << " items)" << LL_ENDL;
+
+	cat_array_t cats;
+	item_array_t items;
+	timer.reset();
+	model.collectDescendents(folder_ids[0], cats, items, INCLUDE_TRASH);
+	LL_INFOS("Inventory") << "collectDescendents() of root: " << timer.getElapsedTimeF64() << "s ("
+						  << cats.size() << " folders, " << items.size() << " items)" << LL_ENDL;
+
+	cats.clear();
+	items.clear();
+	LLBenchmarkIsLink is_link;
+	timer.reset();
+	model.collectDescendentsIf(folder_ids[0], cats, items, INCLUDE_TRASH, is_link);
+	LL_INFOS("Inventory") << "collectDescendentsIf() links under root: " << timer.getElapsedTimeF64() << "s ("
+						  << items.size() << " links)" << LL_ENDL;
+
+	found = 0;
+	const S32 num_link_queries = llmin(NUM_QUERIES, (S32)link_target_ids.size());
+	timer.reset();
+	for (S32 i = 0; i < num_link_queries; ++i)
+	{
+		found += (S32)model.collectLinksTo(link_target_ids[rng() % link_target_ids.size()]).size();
+	}
+	LL_INFOS("Inventory") << num_link_queries << " collectLinksTo() calls: " << timer.getElapsedTimeF64() << "s (" << found << " links)" << LL_ENDL;
+}
+
 // Do various integrity checks on model, logging issues found and
 // returning an overall good/bad flag. 
 LLPointer<LLInventoryValidationInfo> LLInventoryModel::validate() const
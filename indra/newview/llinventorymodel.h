@@ -30,6 +30,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "llassettype.h"
@@ -202,24 +203,32 @@ private:
 	// the inventory using several different identifiers.
 	// mInventory member data is the 'master' list of inventory, and
 	// mCategoryMap and mItemMap store uuid->object mappings. 
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	// These are hashed on the UUID digest since large inventories make
+	// the tree-based lookups show up in profiles; nothing here relies on
+	// iteration order.
+	typedef std::unordered_map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	typedef std::unordered_map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
 	cat_map_t mCategoryMap;
 	item_map_t mItemMap;
 	// This last set of indices is used to map parents to children.
-	typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
-	typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+	typedef std::unordered_map<LLUUID, cat_array_t*> parent_cat_map_t;
+	typedef std::unordered_map<LLUUID, item_array_t*> parent_item_map_t;
 	parent_cat_map_t mParentChildCategoryTree;
 	parent_item_map_t mParentChildItemTree;
 
 	// Track links to items and categories. We do not store item or
 	// category pointers here, because broken links are also supported.
-	typedef std::multimap<LLUUID, LLUUID> backlink_mmap_t;
+	typedef std::unordered_multimap<LLUUID, LLUUID> backlink_mmap_t;
 	backlink_mmap_t mBacklinkMMap; // key = target_id: ID of item, values = link_ids: IDs of item or folder links referencing it.
 	// For internal use only
 	bool hasBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id) const;
 	void addBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id);
 	void removeBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id);
+	void collectDescendentsIfNotIn(const LLUUID& id,
+								   cat_array_t& categories,
+								   item_array_t& items,
+								   const LLUUID& excluded_id,
+								   LLInventoryCollectFunctor& add);
 	
 	//--------------------------------------------------------------------
 	// Login
@@ -227,10 +236,10 @@ private:
 public:
 	static BOOL getIsFirstTimeInViewer2();
     static bool  isSysFoldersReady() { return (sPendingSystemFolders == 0); }
+	const static S32 sCurrentInvCacheVersion; // expected inventory cache version
 
 private:
 	static BOOL sFirstTimeInViewer2;
-	const static S32 sCurrentInvCacheVersion; // expected inventory cache version
 
     static S32 sPendingSystemFolders;
 
@@ -580,6 +589,9 @@ private:
 	U32 mModifyMask;
 	changed_items_t mChangedItemIDs;
 	changed_items_t mAddedItemIDs;
+	// Folders whose contents changed since login, and so must be re-encoded
+	// rather than copied when the inventory cache is saved.
+	changed_items_t mCacheDirtyFolderIDs;
     // Fallback when notifyObservers is in progress
     U32 mModifyMaskBacklog;
     changed_items_t mChangedItemIDsBacklog;
@@ -665,9 +677,6 @@ protected:
 							 item_array_t& items,
 							 changed_items_t& cats_to_update,
 							 bool& is_cache_obsolete); 
-	static bool saveToFile(const std::string& filename,
-						   const cat_array_t& categories,
-						   const item_array_t& items); 
 
 	//--------------------------------------------------------------------
 	// Message handling functionality
@@ -705,6 +714,9 @@ private:
 	//--------------------------------------------------------------------
 public:
 	void dumpInventory() const;
+	// Builds a synthetic inventory of roughly num_items items in a private
+	// model and logs timings for the common lookups.
+	static void benchmarkLookups(S32 num_items);
 	LLPointer<LLInventoryValidationInfo> validate() const;
 	LLPointer<LLInventoryValidationInfo> mValidationInfo;
 	std::string getFullPath(const LLInventoryObject *obj) const;
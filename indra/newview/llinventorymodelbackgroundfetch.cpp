@@ -195,7 +195,10 @@ LLInventoryModelBackgroundFetch::LLInventoryModelBackgroundFetch():
     mAllRecursiveFoldersFetched(false),
 	mRecursiveInventoryFetchStarted(false),
 	mRecursiveLibraryFetchStarted(false),
-	mMinTimeBetweenFetches(0.3f)
+	mMinTimeBetweenFetches(0.3f),
+    mFetchConcurrency(0.f),
+    mMinFetchLatency(0.0),
+    mAvgFetchLatency(0.0)
 {}
 
 LLInventoryModelBackgroundFetch::~LLInventoryModelBackgroundFetch()
@@ -612,6 +615,59 @@ void LLInventoryModelBackgroundFetch::onAISFolderCalback(const LLUUID &request_i
     }
 }
 
+U32 LLInventoryModelBackgroundFetch::getMaxConcurrentFetches() const
+{
+    static LLCachedControl<U32> ais_pool(gSavedSettings, "PoolSizeAIS", 20);
+    // Don't have too many requests at once, AIS throttles
+    // Reserve one request for actions outside of fetch (like renames)
+    const U32 pool_limit = llclamp(ais_pool - 1, 1, 50);
+    if (mFetchConcurrency < 1.f)
+    {
+        return pool_limit;
+    }
+    return llclamp((U32)ll_round(mFetchConcurrency), (U32)1, pool_limit);
+}
+
+// Gradient style limiter: the limit grows while responses come back about as
+// fast as the quickest one seen, and shrinks as they slow down, which is the
+// sign of requests queueing up on the server.  Failures halve it.
+void LLInventoryModelBackgroundFetch::updateFetchConcurrency(F64 latency, bool success)
+{
+    static LLCachedControl<U32> ais_pool(gSavedSettings, "PoolSizeAIS", 20);
+    const F32 pool_limit = (F32)llclamp(ais_pool - 1, 1, 50);
+    if (mFetchConcurrency < 1.f)
+    {
+        mFetchConcurrency = pool_limit;
+    }
+
+    if (!success)
+    {
+        mFetchConcurrency = llmax(1.f, mFetchConcurrency * 0.5f);
+        return;
+    }
+
+    if (latency <= 0.0)
+    {
+        // not timed
+        return;
+    }
+
+    if (mMinFetchLatency <= 0.0 || latency < mMinFetchLatency)
+    {
+        mMinFetchLatency = latency;
+    }
+    else
+    {
+        // Let the baseline creep up so that one lucky response does not pin it
+        mMinFetchLatency += (latency - mMinFetchLatency) * 0.01;
+    }
+    mAvgFetchLatency = mAvgFetchLatency > 0.0 ? lerp(mAvgFetchLatency, latency, 0.1) : latency;
+
+    const F32 gradient = llclamp((F32)(mMinFetchLatency / llmax(mAvgFetchLatency, 0.001)), 0.5f, 1.f);
+    const F32 target = mFetchConcurrency * gradient + sqrtf(mFetchConcurrency);
+    mFetchConcurrency = llclamp(lerp(mFetchConcurrency, target, 0.2f), 1.f, pool_limit);
+}
+
 static LLTrace::BlockTimerStatHandle FTM_BULK_FETCH("Bulk Fetch");
 
 void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
@@ -623,10 +679,7 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
         return;
     }
 
-    static LLCachedControl<U32> ais_pool(gSavedSettings, "PoolSizeAIS", 20);
-    // Don't have too many requests at once, AIS throttles
-    // Reserve one request for actions outside of fetch (like renames)
-    const U32 max_concurrent_fetches = llclamp(ais_pool - 1, 1, 50);
+    const U32 max_concurrent_fetches = getMaxConcurrentFetches();
 
     if (mFetchCount >= max_concurrent_fetches)
     {
@@ -666,6 +719,7 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
         LL_DEBUGS(LOG_INV , "AIS3") << "Total active fetches: " << mLastFetchCount << "->" << last_fetch_count << "->" << mFetchCount
             << ", scheduled folder fetches: " << (S32)mFetchFolderQueue.size()
             << ", scheduled item fetches: " << (S32)mFetchItemQueue.size()
+            << ", concurrency limit: " << max_concurrent_fetches
             << LL_ENDL;
         mLastFetchCount = mFetchCount;
 
@@ -743,6 +797,10 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                     // Top limit is 'as many as you can put into url'
                     static LLCachedControl<S32> ais_batch(gSavedSettings, "BatchSizeAIS3", 20);
                     S32 batch_limit = llclamp(ais_batch(), 1, 40);
+                    // Also keep the size of each response in check: small folders
+                    // get packed together, big ones go in short batches or alone.
+                    static LLCachedControl<S32> ais_batch_descendents(gSavedSettings, "BatchDescendentsAIS3", 2000);
+                    S32 batch_descendents = 0;
 
                     for (LLInventoryModel::cat_array_t::iterator it = categories->begin();
                          it != categories->end();
@@ -775,6 +833,14 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                             }
                         }
 
+                        const S32 descendents = llmax(child_cat->getDescendentCount(), 0);
+                        if (!children.empty() && batch_descendents + descendents > ais_batch_descendents())
+                        {
+                            content_done = false;
+                            break;
+                        }
+                        batch_descendents += descendents;
+
                         children.push_back(child_cat->getUUID());
                         mExpectedFolderIds.push_back(child_cat->getUUID());
                         child_cat->setFetching(target_state);
@@ -795,7 +861,9 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                         LLUUID cat_id = cat->getUUID(); // need a copy for lambda
                         AISAPI::completion_t cb = [cat_id, children, type](const LLUUID& response_id)
                         {
-                            LLInventoryModelBackgroundFetch::instance().onAISContentCalback(cat_id, children, response_id, type);
+                            LLInventoryModelBackgroundFetch& fetcher = LLInventoryModelBackgroundFetch::instance();
+                            fetcher.updateFetchConcurrency(AISAPI::getCompletingRoundTrip(), response_id.notNull());
+                            fetcher.onAISContentCalback(cat_id, children, response_id, type);
                         };
 
                         AISAPI::ITEM_TYPE item_type = AISAPI::INVENTORY;
@@ -849,7 +917,9 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                         LLUUID cat_id = cat->getUUID();
                         AISAPI::completion_t cb = [cat_id , type](const LLUUID& response_id)
                         {
-                            LLInventoryModelBackgroundFetch::instance().onAISFolderCalback(cat_id , response_id , type);
+                            LLInventoryModelBackgroundFetch& fetcher = LLInventoryModelBackgroundFetch::instance();
+                            fetcher.updateFetchConcurrency(AISAPI::getCompletingRoundTrip(), response_id.notNull());
+                            fetcher.onAISFolderCalback(cat_id , response_id , type);
                         };
 
                         AISAPI::ITEM_TYPE item_type = AISAPI::INVENTORY;
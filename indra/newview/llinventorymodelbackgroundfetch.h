@@ -112,6 +112,10 @@ protected:
 
 	bool fetchQueueContainsNoDescendentsOf(const LLUUID& cat_id) const;
 
+    // Adaptive limit on AIS requests in flight, driven by folder fetch latency
+    U32 getMaxConcurrentFetches() const;
+    void updateFetchConcurrency(F64 latency, bool success); // latency is the HTTP round trip, 0 if not timed
+
 private:
  	bool mRecursiveInventoryFetchStarted;
 	bool mRecursiveLibraryFetchStarted;
@@ -130,6 +134,10 @@ private:
 	fetch_queue_t mFetchFolderQueue;
     fetch_queue_t mFetchItemQueue;
     std::list<LLUUID> mExpectedFolderIds; // for debug, should this track time?
+
+    F32 mFetchConcurrency; // 0 until the first folder response arrives
+    F64 mMinFetchLatency;
+    F64 mAvgFetchLatency;
 };
 
 #endif // LL_LLINVENTORYMODELBACKGROUNDFETCH_H
@@ -0,0 +1,315 @@
+/**
+ * @file llinventorysearchindex.cpp
+ * @brief Implementation of LLInventorySearchIndex class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchindex.h"
+
+#include "llavatarnamecache.h"
+#include "llinventorymodel.h"
+#include "llviewerinventory.h"
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:	mSerial(0)
+{
+}
+
+LLInventorySearchIndex::~LLInventorySearchIndex()
+{
+}
+
+void LLInventorySearchIndex::initSingleton()
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	LLInventoryModel::cat_array_t cats;
+	LLInventoryModel::item_array_t items;
+	const LLUUID roots[] = { gInventory.getRootFolderID(), gInventory.getLibraryRootFolderID() };
+	for (const LLUUID& root_id : roots)
+	{
+		if (root_id.notNull())
+		{
+			gInventory.collectDescendents(root_id, cats, items, LLInventoryModel::INCLUDE_TRASH);
+		}
+	}
+
+	mEntries.reserve(items.size());
+	mSlots.reserve(items.size());
+	for (LLViewerInventoryItem* item : items)
+	{
+		addItem(item->getUUID(), item);
+	}
+
+	gInventory.addObserver(this);
+
+	LL_INFOS("Inventory") << "Indexed " << mEntries.size() << " items, "
+		<< mPostings.size() << " trigrams, " << mCreators.size() << " creators" << LL_ENDL;
+}
+
+void LLInventorySearchIndex::cleanupSingleton()
+{
+	if (gInventory.containsObserver(this))
+	{
+		gInventory.removeObserver(this);
+	}
+}
+
+void LLInventorySearchIndex::changed(U32 mask)
+{
+	const U32 interesting = LLInventoryObserver::LABEL | LLInventoryObserver::ADD
+		| LLInventoryObserver::REMOVE | LLInventoryObserver::INTERNAL | LLInventoryObserver::REBUILD;
+	if (!(mask & interesting))
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED;
+
+	for (const LLUUID& id : gInventory.getChangedIDs())
+	{
+		const LLViewerInventoryItem* item = gInventory.getItem(id);
+		if (item)
+		{
+			addItem(id, item);
+		}
+		else
+		{
+			// Also covers categories, which are never in mEntries.
+			removeItem(id);
+		}
+	}
+}
+
+const std::string* LLInventorySearchIndex::getName(const LLUUID& item_id) const
+{
+	auto it = mEntries.find(item_id);
+	return it != mEntries.end() ? &it->second.mName : NULL;
+}
+
+const LLUUID* LLInventorySearchIndex::getCreatorID(const LLUUID& item_id) const
+{
+	auto it = mEntries.find(item_id);
+	return it != mEntries.end() ? &it->second.mCreatorID : NULL;
+}
+
+// static
+void LLInventorySearchIndex::getTrigrams(const std::string& name, std::vector<U32>& trigrams)
+{
+	trigrams.clear();
+	if (name.size() < MIN_QUERY_LENGTH)
+	{
+		return;
+	}
+
+	trigrams.reserve(name.size() - 2);
+	for (size_t i = 0; i + 2 < name.size(); ++i)
+	{
+		trigrams.push_back(((U32)(U8)name[i] << 16) | ((U32)(U8)name[i + 1] << 8) | (U32)(U8)name[i + 2]);
+	}
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+void LLInventorySearchIndex::addItem(const LLUUID& item_id, const LLViewerInventoryItem* item)
+{
+	// A broken link reports its own name until the target shows up, and
+	// the target arriving does not notify for the link.  Leave it out so
+	// the filter compares it the slow way.
+	if (item->getIsBrokenLink())
+	{
+		removeItem(item_id);
+		return;
+	}
+
+	std::string name = item->getName();
+	LLStringUtil::toUpper(name);
+	const LLUUID& creator_id = item->getCreatorUUID();
+
+	auto it = mEntries.find(item_id);
+	if (it != mEntries.end())
+	{
+		if (it->second.mName == name && it->second.mCreatorID == creator_id)
+		{
+			return;
+		}
+		removeItem(item_id);
+	}
+
+	Entry entry;
+	if (!mFreeSlots.empty())
+	{
+		entry.mSlot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+		mSlots[entry.mSlot] = item_id;
+	}
+	else
+	{
+		entry.mSlot = (U32)mSlots.size();
+		mSlots.push_back(item_id);
+	}
+	entry.mCreatorID = creator_id;
+	entry.mName.swap(name);
+
+	std::vector<U32> trigrams;
+	getTrigrams(entry.mName, trigrams);
+	for (U32 trigram : trigrams)
+	{
+		mPostings[trigram].push_back(entry.mSlot);
+	}
+
+	addCreator(creator_id);
+	mEntries.emplace(item_id, std::move(entry));
+	++mSerial;
+}
+
+void LLInventorySearchIndex::removeItem(const LLUUID& item_id)
+{
+	auto it = mEntries.find(item_id);
+	if (it == mEntries.end())
+	{
+		return;
+	}
+
+	const U32 slot = it->second.mSlot;
+	std::vector<U32> trigrams;
+	getTrigrams(it->second.mName, trigrams);
+	for (U32 trigram : trigrams)
+	{
+		auto posting = mPostings.find(trigram);
+		if (posting == mPostings.end())
+		{
+			continue;
+		}
+		posting_list_t& slots = posting->second;
+		auto found = std::find(slots.begin(), slots.end(), slot);
+		if (found != slots.end())
+		{
+			*found = slots.back();
+			slots.pop_back();
+		}
+		if (slots.empty())
+		{
+			mPostings.erase(posting);
+		}
+	}
+
+	removeCreator(it->second.mCreatorID);
+	mSlots[slot].setNull();
+	mFreeSlots.push_back(slot);
+	mEntries.erase(it);
+	++mSerial;
+}
+
+void LLInventorySearchIndex::addCreator(const LLUUID& creator_id)
+{
+	++mCreators[creator_id];
+}
+
+void LLInventorySearchIndex::removeCreator(const LLUUID& creator_id)
+{
+	auto it = mCreators.find(creator_id);
+	if (it != mCreators.end() && --it->second <= 0)
+	{
+		mCreators.erase(it);
+	}
+}
+
+bool LLInventorySearchIndex::findName(const std::string& query, id_set_t& matches, const id_set_t* previous) const
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	matches.clear();
+	if (query.size() < MIN_QUERY_LENGTH)
+	{
+		return false;
+	}
+
+	if (previous)
+	{
+		// Narrowing an earlier search: only what matched before can match now.
+		for (const LLUUID& id : *previous)
+		{
+			auto it = mEntries.find(id);
+			if (it != mEntries.end() && it->second.mName.find(query) != std::string::npos)
+			{
+				matches.insert(id);
+			}
+		}
+		return true;
+	}
+
+	// Every match contains all of the query's trigrams, so checking the
+	// items under the rarest one is enough.
+	std::vector<U32> trigrams;
+	getTrigrams(query, trigrams);
+	const posting_list_t* shortest = NULL;
+	for (U32 trigram : trigrams)
+	{
+		auto posting = mPostings.find(trigram);
+		if (posting == mPostings.end())
+		{
+			return true;
+		}
+		if (!shortest || posting->second.size() < shortest->size())
+		{
+			shortest = &posting->second;
+		}
+	}
+
+	if (shortest)
+	{
+		for (U32 slot : *shortest)
+		{
+			const LLUUID& id = mSlots[slot];
+			auto it = mEntries.find(id);
+			if (it != mEntries.end() && it->second.mName.find(query) != std::string::npos)
+			{
+				matches.insert(id);
+			}
+		}
+	}
+	return true;
+}
+
+void LLInventorySearchIndex::findCreators(const std::string& query, id_set_t& creators) const
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	creators.clear();
+	LLAvatarName av_name;
+	for (const auto& creator : mCreators)
+	{
+		if (LLAvatarNameCache::get(creator.first, &av_name))
+		{
+			std::string username = av_name.getUserName();
+			LLStringUtil::toUpper(username);
+			if (username.find(query) != std::string::npos)
+			{
+				creators.insert(creator.first);
+			}
+		}
+	}
+}
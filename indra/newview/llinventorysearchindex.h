@@ -0,0 +1,112 @@
+/**
+ * @file llinventorysearchindex.h
+ * @brief Incrementally maintained search index over inventory item names and creators.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "llsingleton.h"
+#include "lluuid.h"
+#include "llinventoryobserver.h"
+
+class LLViewerInventoryItem;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventorySearchIndex
+//
+// Trigram index over the upper case names of every item in gInventory, plus
+// the creator of each item.  It is built the first time a filter asks for it
+// and then kept current from the inventory observer notifications, so a
+// search string only has to be compared against the items sharing its
+// rarest trigram rather than against every item in the panel.
+//
+// Items that were added to the model without a change notification are
+// simply not indexed; callers must fall back to a plain string compare
+// for anything getName() does not know about.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventorySearchIndex : public LLSingleton<LLInventorySearchIndex>, public LLInventoryObserver
+{
+	LLSINGLETON(LLInventorySearchIndex);
+	~LLInventorySearchIndex();
+public:
+	typedef std::unordered_set<LLUUID> id_set_t;
+
+	// Shorter search strings have no trigram to look up.
+	static const size_t MIN_QUERY_LENGTH = 3;
+
+	/*virtual*/ void changed(U32 mask);
+
+	// Upper case name or creator the item is indexed under, NULL if unknown.
+	const std::string* getName(const LLUUID& item_id) const;
+	const LLUUID* getCreatorID(const LLUUID& item_id) const;
+
+	// Bumped on every change to the index.  Match sets computed under an
+	// older serial may be missing items.
+	U32 getSerial() const { return mSerial; }
+
+	// Fills matches with every indexed item whose upper case name contains
+	// query.  If previous is not NULL it must hold the matches of a
+	// substring of query computed under the current serial; only those
+	// items are re-checked.  Returns false if query is too short to use
+	// the index.
+	bool findName(const std::string& query, id_set_t& matches, const id_set_t* previous = NULL) const;
+
+	// Fills creators with every creator of an indexed item whose upper case
+	// user name contains query.  Creators whose name is not cached yet do
+	// not match, same as get_searchable_creator_name().
+	void findCreators(const std::string& query, id_set_t& creators) const;
+
+private:
+	/*virtual*/ void initSingleton();
+	/*virtual*/ void cleanupSingleton();
+
+	struct Entry
+	{
+		U32			mSlot;
+		LLUUID		mCreatorID;
+		std::string	mName;
+	};
+
+	void addItem(const LLUUID& item_id, const LLViewerInventoryItem* item);
+	void removeItem(const LLUUID& item_id);
+	void addCreator(const LLUUID& creator_id);
+	void removeCreator(const LLUUID& creator_id);
+
+	typedef std::vector<U32> posting_list_t;
+
+	static void getTrigrams(const std::string& name, std::vector<U32>& trigrams);
+
+	std::unordered_map<LLUUID, Entry>			mEntries;
+	std::vector<LLUUID>							mSlots;		// slot -> item id
+	std::vector<U32>							mFreeSlots;
+	std::unordered_map<U32, posting_list_t>		mPostings;	// trigram -> slots
+	std::unordered_map<LLUUID, S32>				mCreators;	// creator -> item count
+	U32											mSerial;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
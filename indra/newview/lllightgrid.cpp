@@ -0,0 +1,261 @@
+/**
+ * @file lllightgrid.cpp
+ * @brief Implementation of LLLightGrid class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lllightgrid.h"
+
+#include "llcamera.h"
+#include "lldrawable.h"
+#include "llprimitive.h"
+#include "llvovolume.h"
+
+// Lights reach at most LIGHT_MAX_RADIUS (20m), so a light only ever touches
+// its own cell and its neighbours.
+const F32 LLLightGrid::CELL_SIZE = 32.f;
+
+static const U64 DYNAMIC_CELL = ~(U64)0;
+static const S32 CELL_COORD_BIAS = 1 << 20;
+static const U64 CELL_COORD_MASK = (1 << 21) - 1;
+
+static inline U64 pack_cell(S32 x, S32 y, S32 z)
+{
+	return ((U64)(x + CELL_COORD_BIAS) & CELL_COORD_MASK)
+		| (((U64)(y + CELL_COORD_BIAS) & CELL_COORD_MASK) << 21)
+		| (((U64)(z + CELL_COORD_BIAS) & CELL_COORD_MASK) << 42);
+}
+
+LLLightGrid::LLLightGrid()
+:	mCursor(0)
+{
+}
+
+// static
+bool LLLightGrid::isDynamic(LLDrawable* light)
+{
+	LLVOVolume* volume = light->getVOVolume();
+	return !volume || light->isDead() || light->isActive() || volume->isAttachment();
+}
+
+// static
+U64 LLLightGrid::cellKey(const LLVector3& pos)
+{
+	return pack_cell(llfloor(pos.mV[VX] / CELL_SIZE), llfloor(pos.mV[VY] / CELL_SIZE), llfloor(pos.mV[VZ] / CELL_SIZE));
+}
+
+void LLLightGrid::update(LLDrawable* light)
+{
+	entry_map_t::iterator iter = mEntries.find(light);
+	if (iter == mEntries.end())
+	{
+		Entry& entry = mEntries[light];
+		entry.mIndex = (U32)mAll.size();
+		mAll.push_back(light);
+		insert(light, entry);
+		return;
+	}
+
+	Entry& entry = iter->second;
+	U64 key = isDynamic(light) ? DYNAMIC_CELL : cellKey(light->getVOVolume()->getRenderPosition());
+	if (key != entry.mCell)
+	{
+		unlink(light, entry);
+		insert(light, entry);
+	}
+}
+
+void LLLightGrid::remove(LLDrawable* light)
+{
+	entry_map_t::iterator iter = mEntries.find(light);
+	if (iter == mEntries.end())
+	{
+		return;
+	}
+
+	unlink(light, iter->second);
+
+	U32 index = iter->second.mIndex;
+	LLDrawable* last = mAll.back();
+	mAll[index] = last;
+	mEntries[last].mIndex = index;
+	mAll.pop_back();
+	mEntries.erase(light);
+}
+
+void LLLightGrid::clear()
+{
+	mCells.clear();
+	mEntries.clear();
+	mDynamic.clear();
+	mAll.clear();
+	mCursor = 0;
+}
+
+void LLLightGrid::revalidate(U32 count)
+{
+	count = llmin(count, (U32)mAll.size());
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (mCursor >= mAll.size())
+		{
+			mCursor = 0;
+		}
+		update(mAll[mCursor++]);
+	}
+}
+
+void LLLightGrid::shift()
+{
+	for (U32 i = 0; i < mAll.size(); ++i)
+	{
+		update(mAll[i]);
+	}
+}
+
+void LLLightGrid::insert(LLDrawable* light, Entry& entry)
+{
+	if (isDynamic(light))
+	{
+		entry.mCell = DYNAMIC_CELL;
+		mDynamic.push_back(light);
+		return;
+	}
+
+	const LLVector3& pos = light->getVOVolume()->getRenderPosition();
+	entry.mCell = cellKey(pos);
+	Cell& cell = mCells[entry.mCell];
+	if (cell.mLights.empty())
+	{
+		for (U32 i = 0; i < 3; ++i)
+		{
+			cell.mMin.mV[i] = llfloor(pos.mV[i] / CELL_SIZE) * CELL_SIZE;
+		}
+	}
+	cell.mLights.push_back(light);
+}
+
+void LLLightGrid::unlink(LLDrawable* light, const Entry& entry)
+{
+	cell_map_t::iterator cell = mCells.end();
+	light_list_t* list = &mDynamic;
+	if (entry.mCell != DYNAMIC_CELL)
+	{
+		cell = mCells.find(entry.mCell);
+		llassert(cell != mCells.end());
+		if (cell == mCells.end())
+		{
+			return;
+		}
+		list = &cell->second.mLights;
+	}
+
+	light_list_t::iterator iter = std::find(list->begin(), list->end(), light);
+	if (iter != list->end())
+	{
+		*iter = list->back();
+		list->pop_back();
+	}
+
+	if (cell != mCells.end() && list->empty())
+	{
+		mCells.erase(cell);
+	}
+}
+
+void LLLightGrid::getCells(LLCamera& camera, F32 max_dist, bool cull, cell_list_t& cells) const
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	cells.clear();
+
+	const LLVector3 origin = camera.getOrigin();
+	const LLVector3 cell_size(CELL_SIZE, CELL_SIZE, CELL_SIZE);
+	LLVector4a cell_radius;
+	cell_radius.splat(CELL_SIZE * 0.5f + LIGHT_MAX_RADIUS);
+
+	auto visit = [&](const Cell& cell)
+	{
+		// distance from the camera to the cell box, less the widest light
+		LLVector3 nearest = origin;
+		nearest.clamp(cell.mMin, cell.mMin + cell_size);
+		F32 dist = llmax(dist_vec(origin, nearest) - LIGHT_MAX_RADIUS, 0.f);
+		if (dist >= max_dist)
+		{
+			return;
+		}
+
+		if (cull)
+		{
+			LLVector4a center;
+			center.load3((cell.mMin + cell_size * 0.5f).mV);
+			if (camera.AABBInFrustumNoFarClip(center, cell_radius) == 0)
+			{
+				return;
+			}
+		}
+
+		CellRef ref;
+		ref.mDist = dist;
+		ref.mCell = &cell;
+		cells.push_back(ref);
+	};
+
+	// Walk whichever is smaller: the cells of the query box or the
+	// occupied cells.
+	const S32 reach = llceil((max_dist + LIGHT_MAX_RADIUS) / CELL_SIZE);
+	const F32 box_cells = powf(2.f * reach + 1.f, 3.f);
+	if (box_cells < (F32)mCells.size())
+	{
+		S32 center[3];
+		for (U32 i = 0; i < 3; ++i)
+		{
+			center[i] = llfloor(origin.mV[i] / CELL_SIZE);
+		}
+		for (S32 x = center[0] - reach; x <= center[0] + reach; ++x)
+		{
+			for (S32 y = center[1] - reach; y <= center[1] + reach; ++y)
+			{
+				for (S32 z = center[2] - reach; z <= center[2] + reach; ++z)
+				{
+					cell_map_t::const_iterator iter = mCells.find(pack_cell(x, y, z));
+					if (iter != mCells.end())
+					{
+						visit(iter->second);
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		for (cell_map_t::const_iterator iter = mCells.begin(); iter != mCells.end(); ++iter)
+		{
+			visit(iter->second);
+		}
+	}
+
+	std::sort(cells.begin(), cells.end());
+}
@@ -0,0 +1,122 @@
+/**
+ * @file lllightgrid.h
+ * @brief Spatial hash of light drawables used to pick the nearby lights.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLLIGHTGRID_H
+#define LL_LLLIGHTGRID_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "v3math.h"
+
+class LLCamera;
+class LLDrawable;
+
+//-----------------------------------------------------------------------------
+// class LLLightGrid
+//
+// Buckets the static lights of the scene into a hashed uniform grid so that
+// LLPipeline::calcNearbyLights() only has to look at the cells around the
+// camera instead of every light in mLights.
+//
+// Only lights whose position changes through LLPipeline::updateMove() are
+// kept in cells.  Lights on active drawables and attachments move with their
+// parent every frame without being told, so they sit in a flat dynamic list
+// that is scanned in full, as before.  revalidate() re-buckets a few lights
+// per frame to catch anything that moved or changed state behind our back.
+//
+// Holds raw pointers: the pipeline removes a light here whenever it drops it
+// from mLights.
+//-----------------------------------------------------------------------------
+class LLLightGrid
+{
+public:
+	typedef std::vector<LLDrawable*> light_list_t;
+
+	struct Cell
+	{
+		LLVector3		mMin;
+		light_list_t	mLights;
+	};
+
+	// A cell in range of a query, with a lower bound on the distance from
+	// the query origin to the edge of any light sphere in it.
+	struct CellRef
+	{
+		F32			mDist;
+		const Cell*	mCell;
+
+		bool operator<(const CellRef& rhs) const { return mDist < rhs.mDist; }
+	};
+	typedef std::vector<CellRef> cell_list_t;
+
+	LLLightGrid();
+
+	// Adds a light or moves it to the cell/list matching its current state.
+	void update(LLDrawable* light);
+	void remove(LLDrawable* light);
+	void clear();
+
+	// Re-buckets the next count lights, round robin.
+	void revalidate(U32 count);
+
+	// Rebuilds every cell after the agent space origin moved.
+	void shift();
+
+	// Collects the cells that may hold a light reaching within max_dist of
+	// the camera, nearest first.  If cull is set, cells whose lights cannot
+	// touch the view frustum are skipped.
+	void getCells(LLCamera& camera, F32 max_dist, bool cull, cell_list_t& cells) const;
+
+	const light_list_t& getDynamicLights() const { return mDynamic; }
+	U32 size() const { return (U32)mAll.size(); }
+
+	static const F32 CELL_SIZE;
+
+private:
+	struct Entry
+	{
+		U64		mCell;		// key of the cell holding the light, DYNAMIC for the dynamic list
+		U32		mIndex;		// index in mAll
+	};
+
+	static bool isDynamic(LLDrawable* light);
+	static U64 cellKey(const LLVector3& pos);
+
+	void insert(LLDrawable* light, Entry& entry);
+	void unlink(LLDrawable* light, const Entry& entry);
+
+	typedef std::unordered_map<U64, Cell> cell_map_t;
+	typedef std::unordered_map<LLDrawable*, Entry> entry_map_t;
+
+	cell_map_t		mCells;
+	entry_map_t		mEntries;
+	light_list_t	mDynamic;
+	light_list_t	mAll;
+	U32				mCursor;
+};
+
+#endif // LL_LLLIGHTGRID_H
@@ -0,0 +1,338 @@
+/**
+ * @file llmeshdecodedcache.cpp
+ * @brief Implementation of LLMeshDecodedCache class.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llmeshdecodedcache.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "llassettype.h"
+#include "lldiskcache.h"
+#include "llfile.h"
+#include "llvolume.h"
+
+static const U32 MESH_DECODED_MAGIC = 0x43444d4c;	// "LMDC"
+
+// Bump whenever LLVolume::unpackVolumeFaces() or LLVolumeFace::cacheOptimize()
+// change what they produce; old files are then simply never looked up again.
+static const U32 MESH_DECODED_VERSION = 1;
+
+// static
+bool LLMeshDecodedCache::sEnabled = true;
+
+namespace
+{
+	struct Header
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U32 mSourceSize;
+		U32 mFaceCount;
+	};
+
+	enum
+	{
+		FACE_OPTIMIZED = 0x1,
+		FACE_TANGENTS = 0x2,
+		FACE_WEIGHTS = 0x4
+	};
+
+	// Followed by positions, normals, texture coordinates, tangents,
+	// weights and indices, each padded to 16 bytes.
+	struct FaceHeader
+	{
+		S32 mNumVertices;
+		S32 mNumIndices;
+		U32 mFlags;
+		U32 mPad;
+		F32 mExtents[12];			// min, max, center
+		F32 mTexCoordExtents[4];
+	};
+
+	static_assert(sizeof(Header) % 16 == 0, "mesh cache sections are 16 byte aligned");
+	static_assert(sizeof(FaceHeader) % 16 == 0, "mesh cache sections are 16 byte aligned");
+
+	inline size_t padded(size_t bytes)
+	{
+		return (bytes + 0xF) & ~(size_t)0xF;
+	}
+
+	void append(std::vector<U8>& out, const void* data, size_t bytes)
+	{
+		size_t start = out.size();
+		out.resize(start + padded(bytes), 0);
+		if (bytes)
+		{
+			memcpy(&out[start], data, bytes);
+		}
+	}
+
+	// Bounds checked copies out of the mapped file.
+	class Reader
+	{
+	public:
+		Reader(const U8* data, size_t size) : mData(data), mSize(size), mPos(0) {}
+
+		bool read(void* dst, size_t bytes)
+		{
+			if (mPos + padded(bytes) > mSize)
+			{
+				return false;
+			}
+			if (bytes)
+			{
+				memcpy(dst, mData + mPos, bytes);
+			}
+			mPos += padded(bytes);
+			return true;
+		}
+
+		bool atEnd() const { return mPos == mSize; }
+
+	private:
+		const U8*	mData;
+		size_t		mSize;
+		size_t		mPos;
+	};
+
+	bool read_face(Reader& in, LLVolumeFace& face)
+	{
+		FaceHeader header;
+		if (!in.read(&header, sizeof(header))
+			|| header.mNumVertices < 0 || header.mNumVertices > 65536
+			|| header.mNumIndices < 0 || header.mNumIndices % 3)
+		{
+			return false;
+		}
+
+		const S32 num_verts = header.mNumVertices;
+		face.resizeVertices(num_verts);
+		face.resizeIndices(header.mNumIndices);
+		if ((num_verts && !face.mPositions) || (header.mNumIndices && !face.mIndices))
+		{
+			return false;
+		}
+		if (!in.read(face.mPositions, sizeof(LLVector4a) * num_verts)
+			|| !in.read(face.mNormals, sizeof(LLVector4a) * num_verts)
+			|| !in.read(face.mTexCoords, sizeof(LLVector2) * num_verts))
+		{
+			return false;
+		}
+
+		if (header.mFlags & FACE_TANGENTS)
+		{
+			face.allocateTangents(num_verts);
+			if (!face.mTangents || !in.read(face.mTangents, sizeof(LLVector4a) * num_verts))
+			{
+				return false;
+			}
+		}
+		if (header.mFlags & FACE_WEIGHTS)
+		{
+			face.allocateWeights(num_verts);
+			if (!face.mWeights || !in.read(face.mWeights, sizeof(LLVector4a) * num_verts))
+			{
+				return false;
+			}
+		}
+		if (!in.read(face.mIndices, sizeof(U16) * header.mNumIndices))
+		{
+			return false;
+		}
+		for (S32 i = 0; i < header.mNumIndices; ++i)
+		{
+			if (face.mIndices[i] >= num_verts)
+			{
+				return false;
+			}
+		}
+
+		for (S32 i = 0; i < 3; ++i)
+		{
+			face.mExtents[i].loadua(header.mExtents + 4 * i);
+		}
+		face.mTexCoordExtents[0].set(header.mTexCoordExtents[0], header.mTexCoordExtents[1]);
+		face.mTexCoordExtents[1].set(header.mTexCoordExtents[2], header.mTexCoordExtents[3]);
+		face.mOptimized = (header.mFlags & FACE_OPTIMIZED) ? TRUE : FALSE;
+		return true;
+	}
+
+	void write_face(std::vector<U8>& out, const LLVolumeFace& face)
+	{
+		FaceHeader header;
+		memset(&header, 0, sizeof(header));
+		header.mNumVertices = face.mNumVertices;
+		header.mNumIndices = face.mNumIndices;
+		header.mFlags = (face.mOptimized ? FACE_OPTIMIZED : 0)
+						| (face.mTangents ? FACE_TANGENTS : 0)
+						| (face.mWeights ? FACE_WEIGHTS : 0);
+		for (S32 i = 0; i < 3; ++i)
+		{
+			memcpy(header.mExtents + 4 * i, face.mExtents[i].getF32ptr(), 4 * sizeof(F32));
+		}
+		header.mTexCoordExtents[0] = face.mTexCoordExtents[0].mV[VX];
+		header.mTexCoordExtents[1] = face.mTexCoordExtents[0].mV[VY];
+		header.mTexCoordExtents[2] = face.mTexCoordExtents[1].mV[VX];
+		header.mTexCoordExtents[3] = face.mTexCoordExtents[1].mV[VY];
+		append(out, &header, sizeof(header));
+
+		const S32 num_verts = face.mNumVertices;
+		append(out, face.mPositions, sizeof(LLVector4a) * num_verts);
+		append(out, face.mNormals, sizeof(LLVector4a) * num_verts);
+		append(out, face.mTexCoords, sizeof(LLVector2) * num_verts);
+		if (face.mTangents)
+		{
+			append(out, face.mTangents, sizeof(LLVector4a) * num_verts);
+		}
+		if (face.mWeights)
+		{
+			append(out, face.mWeights, sizeof(LLVector4a) * num_verts);
+		}
+		append(out, face.mIndices, sizeof(U16) * face.mNumIndices);
+	}
+}
+
+// static
+std::string LLMeshDecodedCache::getFilename(const LLVolumeParams& mesh_params, S32 lod)
+{
+	// Mirror and invert change the unpacked geometry, the rest of the
+	// sculpt type is always LL_SCULPT_TYPE_MESH here.
+	const U32 sculpt_flags = mesh_params.getSculptType() & LL_SCULPT_FLAG_MASK;
+	return LLDiskCache::getInstance()->metaDataToFilepath(mesh_params.getSculptID().asString(),
+														  LLAssetType::AT_MESH,
+														  llformat("lod%d_%x_v%u", lod, sculpt_flags, MESH_DECODED_VERSION));
+}
+
+// static
+bool LLMeshDecodedCache::load(const LLVolumeParams& mesh_params, S32 lod, S32 source_size, LLVolume* volume)
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	if (!sEnabled)
+	{
+		return false;
+	}
+
+	const std::string filename = getFilename(mesh_params, lod);
+	if (!LLFile::isfile(filename))
+	{
+		return false;
+	}
+
+	bool success = false;
+	try
+	{
+		boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+		Reader in((const U8*)region.get_address(), region.get_size());
+
+		Header header;
+		if (!in.read(&header, sizeof(header))
+			|| header.mMagic != MESH_DECODED_MAGIC
+			|| header.mVersion != MESH_DECODED_VERSION
+			|| header.mSourceSize != (U32)source_size
+			|| header.mFaceCount == 0
+			|| header.mFaceCount > (U32)LL_SCULPT_MESH_MAX_FACES)
+		{
+			return false;
+		}
+
+		LLVolume::face_list_t& faces = volume->getVolumeFaces();
+		faces.resize(header.mFaceCount);
+		success = true;
+		for (U32 i = 0; i < header.mFaceCount && success; ++i)
+		{
+			success = read_face(in, faces[i]);
+		}
+		success = success && in.atEnd();
+		if (!success)
+		{
+			faces.clear();
+		}
+	}
+	catch (const boost::interprocess::interprocess_exception& e)
+	{
+		LL_WARNS("MeshStreaming") << "Unable to map decoded mesh " << filename << ": " << e.what() << LL_ENDL;
+		return false;
+	}
+
+	if (!success)
+	{
+		LL_WARNS("MeshStreaming") << "Discarding damaged decoded mesh " << filename << LL_ENDL;
+		LLFile::remove(filename);
+		return false;
+	}
+
+	volume->setSculptLevel(0);
+	LLDiskCache::getInstance()->updateFileAccessTime(filename);
+	return true;
+}
+
+// static
+void LLMeshDecodedCache::store(const LLVolumeParams& mesh_params, S32 lod, S32 source_size, const LLVolume* volume)
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	if (!sEnabled || volume->getNumVolumeFaces() <= 0)
+	{
+		return;
+	}
+
+	std::vector<U8> data;
+	Header header;
+	header.mMagic = MESH_DECODED_MAGIC;
+	header.mVersion = MESH_DECODED_VERSION;
+	header.mSourceSize = (U32)source_size;
+	header.mFaceCount = (U32)volume->getNumVolumeFaces();
+	append(data, &header, sizeof(header));
+	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+	{
+		write_face(data, volume->getVolumeFace(i));
+	}
+
+	// Write aside and rename so a concurrent load never maps half a file.
+	const std::string filename = getFilename(mesh_params, lod);
+	const std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+	if (!fp)
+	{
+		return;
+	}
+	bool success = fwrite(&data[0], 1, data.size(), fp) == data.size();
+	LLFile::close(fp);
+
+	if (success)
+	{
+		LLFile::remove(filename, ENOENT);
+		success = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!success)
+	{
+		LLFile::remove(temp_filename);
+	}
+}
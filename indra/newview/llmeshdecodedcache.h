@@ -0,0 +1,63 @@
+/**
+ * @file llmeshdecodedcache.h
+ * @brief Disk cache of unpacked and optimized mesh LOD faces.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESHDECODEDCACHE_H
+#define LL_LLMESHDECODEDCACHE_H
+
+class LLVolume;
+class LLVolumeParams;
+
+//-----------------------------------------------------------------------------
+// class LLMeshDecodedCache
+//
+// Second level cache behind the mesh asset cache.  Once a LOD block has been
+// inflated, parsed and vertex cache optimized by LLVolume::unpackVolumeFaces(),
+// its face buffers are written out as-is, each one 16 byte aligned so that
+// the file can be mapped and copied straight into the face allocations.  A
+// warm load then skips zlib, LLSD and the optimizer entirely.
+//
+// Files live in the disk cache directory next to the mesh assets, keyed by
+// mesh id, LOD, the sculpt flags that change the unpacked geometry and the
+// processing version, so they share the disk cache's size budget, purge and
+// clearing.  Both calls are made from the mesh repository thread.
+//-----------------------------------------------------------------------------
+class LLMeshDecodedCache
+{
+public:
+	// Fills volume with the faces cached for mesh_params and lod.  source_size
+	// is the size of the compressed LOD block, checked against the cached one.
+	static bool load(const LLVolumeParams& mesh_params, S32 lod, S32 source_size, LLVolume* volume);
+
+	// Saves the faces of a volume just unpacked from a LOD block.
+	static void store(const LLVolumeParams& mesh_params, S32 lod, S32 source_size, const LLVolume* volume);
+
+	static bool sEnabled;
+
+private:
+	static std::string getFilename(const LLVolumeParams& mesh_params, S32 lod);
+};
+
+#endif // LL_LLMESHDECODEDCACHE_H
@@ -44,6 +44,7 @@
 #include "llimagej2c.h"
 #include "llhost.h"
 #include "llmath.h"
+#include "llmeshdecodedcache.h"
 #include "llnotificationsutil.h"
 #include "llsd.h"
 #include "llsdutil_math.h"
@@ -58,6 +59,7 @@
 #include "llviewerregion.h"
 #include "llviewerstatsrecorder.h"
 #include "llviewertexturelist.h"
+#include "llvoavatar.h"
 #include "llvolume.h"
 #include "llvolumemgr.h"
 #include "llvovolume.h"
@@ -227,6 +229,7 @@
 //     sCacheBytesWritten              "
 //     sCacheReads                     "
 //     sCacheWrites                    "
+//     sDecodedCacheHits               "
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -390,6 +393,7 @@ U32 LLMeshRepository::sCacheBytesSkins = 0;
 U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
 U32 LLMeshRepository::sCacheWrites = 0;
+U32 LLMeshRepository::sDecodedCacheHits = 0;
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
@@ -1764,6 +1768,12 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				
 		if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
 		{
+			//check cache for already unpacked faces
+			if (decodedLODLoaded(mesh_params, lod, size))
+			{
+				LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mesh_id << " - was retrieved from the decoded cache." << LL_ENDL;
+				return true;
+			}
 
 			//check cache for mesh asset
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
@@ -1944,17 +1954,8 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 	{
 		if (volume->getNumFaces() > 0)
 		{
-			LoadedMesh mesh(volume, mesh_params, lod);
-			{
-				LLMutexLock lock(mMutex);
-				mLoadedQ.push_back(mesh);
-				// LLPointer is not thread safe, since we added this pointer into
-				// threaded list, make sure counter gets decreased inside mutex lock
-				// and won't affect mLoadedQ processing
-				volume = NULL;
-				// might be good idea to turn mesh into pointer to avoid making a copy
-				mesh.mVolume = NULL;
-			}
+			LLMeshDecodedCache::store(mesh_params, lod, data_size, volume);
+			queueLoadedMesh(volume, mesh_params, lod);
 			return MESH_OK;
 		}
 	}
@@ -1962,6 +1963,36 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 	return MESH_UNKNOWN;
 }
 
+// Loads a LOD unpacked in an earlier session, data_size being the size of
+// its compressed block in the mesh asset.
+bool LLMeshRepoThread::decodedLODLoaded(const LLVolumeParams& mesh_params, S32 lod, S32 data_size)
+{
+	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+	if (!LLMeshDecodedCache::load(mesh_params, lod, data_size, volume))
+	{
+		return false;
+	}
+
+	++LLMeshRepository::sDecodedCacheHits;
+	queueLoadedMesh(volume, mesh_params, lod);
+	return true;
+}
+
+void LLMeshRepoThread::queueLoadedMesh(LLPointer<LLVolume>& volume, const LLVolumeParams& mesh_params, S32 lod)
+{
+	LoadedMesh mesh(volume, mesh_params, lod);
+	{
+		LLMutexLock lock(mMutex);
+		mLoadedQ.push_back(mesh);
+		// LLPointer is not thread safe, since we added this pointer into
+		// threaded list, make sure counter gets decreased inside mutex lock
+		// and won't affect mLoadedQ processing
+		volume = NULL;
+		// might be good idea to turn mesh into pointer to avoid making a copy
+		mesh.mVolume = NULL;
+	}
+}
+
 bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
 	LLSD skin;
@@ -3557,6 +3588,8 @@ void LLMeshRepository::init()
 
 	metrics_teleport_started_signal = LLViewerMessage::getInstance()->setTeleportStartedCallback(teleport_started);
 	
+	LLMeshDecodedCache::sEnabled = gSavedSettings.getBOOL("MeshDecodedCache");
+
 	mThread = new LLMeshRepoThread();
 	mThread->start();
 }
@@ -3935,6 +3968,12 @@ void LLMeshRepository::notifyLoadedMeshes()
 								if (drawable)
 								{
 									F32 cur_score = drawable->getRadius()/llmax(drawable->mDistanceWRTCamera, 1.f);
+									LLVOAvatar* avatar = object->getAvatar();
+									if (avatar)
+									{
+										// over budget avatars wait their turn
+										cur_score *= avatar->getStreamingPriorityScale();
+									}
 									max_score = llmax(max_score, cur_score);
 								}
 							}
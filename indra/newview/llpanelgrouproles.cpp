@@ -792,14 +792,7 @@ LLPanelGroupMembersSubTab::LLPanelGroupMembersSubTab()
 
 LLPanelGroupMembersSubTab::~LLPanelGroupMembersSubTab()
 {
-	for (avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
-	{
-		if (it->second.connected())
-		{
-			it->second.disconnect();
-		}
-	}
-	mAvatarNameCacheConnections.clear();
+	disconnectAvatarNameCache();
 	if (mMembersList)
 	{
 		gSavedSettings.setString("GroupMembersSortOrder", mMembersList->getSortColumnName());
@@ -1739,36 +1732,49 @@ void LLPanelGroupMembersSubTab::addMemberToList(LLGroupMemberData* data)
 	mHasMatch = TRUE;
 }
 
-void LLPanelGroupMembersSubTab::onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id)
+void LLPanelGroupMembersSubTab::disconnectAvatarNameCache()
 {
-	avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(av_id);
-	if (it != mAvatarNameCacheConnections.end())
+	for (avatar_name_cache_connection_list_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
 	{
-		if (it->second.connected())
+		if (it->connected())
 		{
-			it->second.disconnect();
+			it->disconnect();
 		}
-		mAvatarNameCacheConnections.erase(it);
 	}
+	mAvatarNameCacheConnections.clear();
+}
 
+void LLPanelGroupMembersSubTab::onNamesCache(const LLUUID& update_id, const uuid_vec_t& agent_ids)
+{
 	LLGroupMgrGroupData* gdatap = LLGroupMgr::getInstance()->getGroupData(mGroupID);
 	if (!gdatap
-		|| gdatap->getMemberVersion() != update_id
-		|| !member)
+		|| gdatap->getMemberVersion() != update_id)
 	{
 		return;
 	}
-	
-	// trying to avoid unnecessary hash lookups
-	if (matchesSearchFilter(av_name.getAccountName()))
+
+	for (uuid_vec_t::const_iterator id_it = agent_ids.begin(); id_it != agent_ids.end(); ++id_it)
 	{
-		addMemberToList(member);
-		if(!mMembersList->getEnabled())
+		LLGroupMgrGroupData::member_list_t::iterator member_it = gdatap->mMembers.find(*id_it);
+		LLAvatarName av_name;
+		if (member_it == gdatap->mMembers.end()
+			|| !member_it->second
+			|| !LLAvatarNameCache::get(*id_it, &av_name))
 		{
-			mMembersList->setEnabled(TRUE);
+			continue;
+		}
+
+		// trying to avoid unnecessary hash lookups
+		if (matchesSearchFilter(av_name.getAccountName()))
+		{
+			addMemberToList(member_it->second);
 		}
 	}
-	
+
+	if (mHasMatch && !mMembersList->getEnabled())
+	{
+		mMembersList->setEnabled(TRUE);
+	}
 }
 
 void LLPanelGroupMembersSubTab::updateMembers()
@@ -1797,6 +1803,7 @@ void LLPanelGroupMembersSubTab::updateMembers()
 	if(mMemberProgress == gdatap->mMembers.begin())
 	{
 		mMembersList->deleteAllItems();
+		disconnectAvatarNameCache();
 	}
 
 	LLGroupMgrGroupData::member_list_t::iterator end = gdatap->mMembers.end();
@@ -1804,6 +1811,7 @@ void LLPanelGroupMembersSubTab::updateMembers()
 	LLTimer update_time;
 	update_time.setTimerExpirySec(UPDATE_MEMBERS_SECONDS_PER_FRAME);
 
+	uuid_vec_t uncached_ids;
 	for( ; mMemberProgress != end && !update_time.hasExpired(); ++mMemberProgress)
 	{
 		if (!mMemberProgress->second)
@@ -1820,20 +1828,17 @@ void LLPanelGroupMembersSubTab::updateMembers()
 		}
 		else
 		{
-			// If name is not cached, onNameCache() should be called when it is cached and add this member to list.
-			avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(mMemberProgress->first);
-			if (it != mAvatarNameCacheConnections.end())
-			{
-				if (it->second.connected())
-				{
-					it->second.disconnect();
-				}
-				mAvatarNameCacheConnections.erase(it);
-			}
-			mAvatarNameCacheConnections[mMemberProgress->first] = LLAvatarNameCache::get(mMemberProgress->first, boost::bind(&LLPanelGroupMembersSubTab::onNameCache, this, gdatap->getMemberVersion(), mMemberProgress->second, _2, _1));
+			uncached_ids.push_back(mMemberProgress->first);
 		}
 	}
 
+	if (!uncached_ids.empty())
+	{
+		// onNamesCache() adds these members to the list as their names arrive,
+		// a batch of responses at a time.
+		mAvatarNameCacheConnections.push_back(LLAvatarNameCache::getNames(uncached_ids, boost::bind(&LLPanelGroupMembersSubTab::onNamesCache, this, gdatap->getMemberVersion(), _1)));
+	}
+
 	if (mMemberProgress == end)
 	{
 		if (mHasMatch)
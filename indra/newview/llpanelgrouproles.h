@@ -200,7 +200,7 @@ public:
 	virtual void setGroupID(const LLUUID& id);
 
 	void addMemberToList(LLGroupMemberData* data);
-	void onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id);
+	void onNamesCache(const LLUUID& update_id, const uuid_vec_t& agent_ids);
 
 protected:
 	typedef std::map<LLUUID, LLRoleMemberChangeType> role_change_data_map_t;
@@ -229,8 +229,10 @@ protected:
 	U32 mNumOwnerAdditions;
 
 	LLGroupMgrGroupData::member_list_t::iterator mMemberProgress;
-	typedef std::map<LLUUID, boost::signals2::connection> avatar_name_cache_connection_map_t;
-	avatar_name_cache_connection_map_t mAvatarNameCacheConnections;
+	typedef std::vector<boost::signals2::connection> avatar_name_cache_connection_list_t;
+	avatar_name_cache_connection_list_t mAvatarNameCacheConnections;
+
+	void disconnectAvatarNameCache();
 };
 
 
@@ -131,9 +131,21 @@ void LLSkinningUtil::initSkinningMatrixPalette(
 
     LLMatrix4a world[LL_CHARACTER_MAX_ANIMATED_JOINTS];
 
+    const LLJointHierarchy& hierarchy = avatar->getJointHierarchy();
+
     for (U32 j = 0; j < count; ++j)
     {
         S32 joint_num = skin->mJointNums[j];
+
+        // Read straight from the flat joint arrays when the last batched
+        // update is still current for this joint.
+        const LLMatrix4a* flat_world = hierarchy.getWorldMatrix4a(joint_num);
+        if (flat_world)
+        {
+            world[j] = *flat_world;
+            continue;
+        }
+
         LLJoint *joint = avatar->getJoint(joint_num);
 
         if (joint)
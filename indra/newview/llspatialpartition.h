@@ -449,6 +449,7 @@ public:
 
 	virtual BOOL isSpatialBridge() const		{ return TRUE; }
 	virtual void updateSpatialExtents();
+	void reboundChildren();
 	virtual void updateBinRadius();
 	virtual void setVisible(LLCamera& camera_in, std::vector<LLDrawable*>* results = NULL, BOOL for_select = FALSE);
 	virtual void updateDistance(LLCamera& camera_in, bool force_update);
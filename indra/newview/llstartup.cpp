@@ -57,6 +57,7 @@
 #include "llerrorcontrol.h"
 #include "llfloaterreg.h"
 #include "llfocusmgr.h"
+#include "llfontgl.h"
 #include "llfloatergridstatus.h"
 #include "llfloaterimsession.h"
 #include "lllocationhistory.h"
@@ -949,6 +950,12 @@ bool idle_startup()
 		// Overwrite default user settings with user settings								 
 		LLAppViewer::instance()->loadSettingsFromDirectory("Account");
 
+		if (gSavedSettings.getBOOL("FontGlyphPrewarm"))
+		{
+			// Rasterize the characters this account needed last session in the background
+			LLFontGL::loadRecentGlyphs(gDirUtilp->getExpandedFilename(LL_PATH_PER_SL_ACCOUNT, "recent_glyphs.txt"));
+		}
+
 		// Convert 'LogInstantMessages' into 'KeepConversationLogTranscripts' for backward compatibility (CHUI-743).
 		LLControlVariablePtr logInstantMessagesControl = gSavedPerAccountSettings.getControl("LogInstantMessages");
 		if (logInstantMessagesControl.notNull())
@@ -3041,6 +3048,7 @@ void LLStartUp::initNameCache()
 	// capabilities for display name lookup
 	LLAvatarNameCache* cache_inst = LLAvatarNameCache::getInstance();
 	cache_inst->setUsePeopleAPI(gSavedSettings.getBOOL("UsePeopleAPI"));
+	cache_inst->setBatchWindow(gSavedSettings.getF32("NameCacheBatchWindow"));
 	cache_inst->setUseDisplayNames(gSavedSettings.getBOOL("UseDisplayNames"));
 	cache_inst->setUseUsernames(gSavedSettings.getBOOL("NameTagShowUsernames"));
 }
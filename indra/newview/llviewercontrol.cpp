@@ -49,6 +49,7 @@
 #include "llviewertexturelist.h"
 #include "llviewerthrottle.h"
 #include "llviewerwindow.h"
+#include "llpolymesh.h"
 #include "llvoavatarself.h"
 #include "llvoiceclient.h"
 #include "llvosky.h"
@@ -66,6 +67,7 @@
 #include "llvosurfacepatch.h"
 #include "llvowlsky.h"
 #include "llrender.h"
+#include "llsculptcache.h"
 #include "llnavigationbar.h"
 #include "llnotificationsutil.h"
 #include "llfloatertools.h"
@@ -106,6 +108,12 @@ static bool handleRenderAvatarMouselookChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleAvatarAsyncMorphsChanged(const LLSD& newvalue)
+{
+	LLPolyMesh::sDeferMorphs = newvalue.asBoolean();
+	return true;
+}
+
 static bool handleRenderFarClipChanged(const LLSD& newvalue)
 {
     if (LLStartUp::getStartupState() >= STATE_STARTED)
@@ -286,6 +294,12 @@ static bool handleVolumeLODChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleSculptCacheSizeChanged(const LLSD& newvalue)
+{
+	LLSculptCache::setMaxSize((size_t)newvalue.asInteger() * 1024 * 1024);
+	return true;
+}
+
 static bool handleAvatarLODChanged(const LLSD& newvalue)
 {
 	LLVOAvatar::sLODFactor = llclamp((F32) newvalue.asReal(), 0.f, MAX_AVATAR_LOD_FACTOR);
@@ -755,6 +769,7 @@ void setting_setup_signal_listener(LLControlGroup& group, const std::string& set
 void settings_setup_listeners()
 {
     setting_setup_signal_listener(gSavedSettings, "FirstPersonAvatarVisible", handleRenderAvatarMouselookChanged);
+    setting_setup_signal_listener(gSavedSettings, "AvatarAsyncMorphs", handleAvatarAsyncMorphsChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderFarClip", handleRenderFarClipChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderTerrainDetail", handleTerrainDetailChanged);
     setting_setup_signal_listener(gSavedSettings, "OctreeStaticObjectSizeFactor", handleRepartition);
@@ -779,6 +794,7 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "WindLightUseAtmosShaders", handleSetShaderChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderGammaFull", handleSetShaderChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderVolumeLODFactor", handleVolumeLODChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderSculptCacheSize", handleSculptCacheSizeChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderAvatarLODFactor", handleAvatarLODChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderAvatarPhysicsLODFactor", handleAvatarPhysicsLODChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderTerrainLODFactor", handleTerrainLODChanged);
@@ -1394,6 +1394,24 @@ class LLAdvancedDumpInventory : public view_listener_t
 	}
 };
 
+class LLAdvancedBenchmarkInventory : public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		LLInventoryModel::benchmarkLookups(250000);
+		return true;
+	}
+};
+
+class LLAdvancedBenchmarkMoves : public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		gPipeline.benchmarkMoves(512, 16, 100);
+		return true;
+	}
+};
+
 
 
 ////////////////////////////////
@@ -9493,6 +9511,8 @@ void initialize_menus()
 	view_listener_t::addMenu(new LLAdvancedBuyCurrencyTest(), "Advanced.BuyCurrencyTest");
 	view_listener_t::addMenu(new LLAdvancedDumpSelectMgr(), "Advanced.DumpSelectMgr");
 	view_listener_t::addMenu(new LLAdvancedDumpInventory(), "Advanced.DumpInventory");
+	view_listener_t::addMenu(new LLAdvancedBenchmarkInventory(), "Advanced.BenchmarkInventory");
+	view_listener_t::addMenu(new LLAdvancedBenchmarkMoves(), "Advanced.BenchmarkMoves");
 	commit.add("Advanced.DumpTimers", boost::bind(&handle_dump_timers) );
 	commit.add("Advanced.DumpFocusHolder", boost::bind(&handle_dump_focus) );
 	view_listener_t::addMenu(new LLAdvancedPrintSelectedObjectInfo(), "Advanced.PrintSelectedObjectInfo");
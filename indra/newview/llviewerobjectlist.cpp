@@ -81,6 +81,7 @@
 #include "llvocache.h"
 #include "llcorehttputil.h"
 #include "llstartup.h"
+#include "llparallel.h"
 
 #include <algorithm>
 #include <iterator>
@@ -304,6 +305,9 @@ void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp,
 
 static LLTrace::BlockTimerStatHandle FTM_PROCESS_OBJECTS("Process Objects");
 
+// Below this many avatars the joint updates are not worth handing out.
+static const U32 MIN_PARALLEL_AVATARS = 4;
+
 LLViewerObject* LLViewerObjectList::processObjectUpdateFromCache(LLVOCacheEntry* entry, LLViewerRegion* regionp)
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
@@ -933,12 +937,107 @@ void LLViewerObjectList::update(LLAgent &agent)
 	}
 	else
 	{
-		for (std::vector<LLViewerObject*>::iterator idle_iter = idle_list.begin();
-			idle_iter != idle_end; idle_iter++)
+		// Avatars are updated in steps when there are enough of them.  Their
+		// animations are run first, up to posing the skeleton, and the joint
+		// transforms of all of them are then computed at once on worker
+		// threads.  The list is then walked in order as usual, each of these
+		// avatars finishing its update in its own place, and once they are
+		// all done their skinning palettes for the coming frame are built on
+		// worker threads too.  Animesh worn by an avatar follows its
+		// attachment point, so it waits for the avatars to finish.
+		enum { IDLE_UPDATE, IDLE_FINISH, IDLE_SKIP };
+		static LLCachedControl<bool> parallel_avatars(gSavedSettings, "AvatarParallelUpdate", true);
+		static std::vector<LLVOAvatar*> deferred_avatars;
+		static std::vector<LLViewerObject*> dependent_avatars;
+		static std::vector<U8> idle_steps;
+		deferred_avatars.clear();
+		dependent_avatars.clear();
+		idle_steps.assign(idle_count, IDLE_UPDATE);
+
+		U32 avatar_count = 0;
+		if (parallel_avatars)
+		{
+			for (std::vector<LLViewerObject*>::iterator idle_iter = idle_list.begin();
+				idle_iter != idle_end; idle_iter++)
+			{
+				if ((*idle_iter)->isAvatar() && ((LLVOAvatar*)*idle_iter)->canDeferJoints())
+				{
+					++avatar_count;
+				}
+			}
+		}
+
+		if (avatar_count >= MIN_PARALLEL_AVATARS)
 		{
-			objectp = *idle_iter;
+			for (U32 i = 0; i < idle_count; ++i)
+			{
+				objectp = idle_list[i];
+				if (!objectp->isAvatar())
+				{
+					continue;
+				}
+
+				LLVOAvatar* avatarp = (LLVOAvatar*)objectp;
+				if (avatarp->getAttachedAvatar())
+				{
+					dependent_avatars.push_back(objectp);
+					idle_steps[i] = IDLE_SKIP;
+				}
+				else if (avatarp->canDeferJoints())
+				{
+					if (avatarp->beginIdleUpdate(agent, frame_time, true))
+					{
+						deferred_avatars.push_back(avatarp);
+						idle_steps[i] = IDLE_FINISH;
+					}
+					else
+					{
+						idle_steps[i] = IDLE_SKIP;
+					}
+				}
+			}
+		}
+
+		if (!deferred_avatars.empty())
+		{
+			LL_PROFILE_ZONE_NAMED("parallel avatar joints");
+			add(LLStatViewer::AVATAR_PARALLEL_UPDATES, deferred_avatars.size());
+			LL::parallel_for((U32)deferred_avatars.size(), [](U32 i)
+			{
+				deferred_avatars[i]->updateDeferredJoints();
+			});
+		}
+
+		for (U32 i = 0; i < idle_count; ++i)
+		{
+			objectp = idle_list[i];
 			llassert(objectp->isActive());
-                objectp->idleUpdate(agent, frame_time);
+			if (idle_steps[i] == IDLE_UPDATE)
+			{
+				objectp->idleUpdate(agent, frame_time);
+			}
+			else if (idle_steps[i] == IDLE_FINISH)
+			{
+				((LLVOAvatar*)objectp)->finishIdleUpdate();
+			}
+		}
+
+		for (LLViewerObject* dependentp : dependent_avatars)
+		{
+			dependentp->idleUpdate(agent, frame_time);
+		}
+
+		if (!deferred_avatars.empty())
+		{
+			LL_PROFILE_ZONE_NAMED("parallel avatar palettes");
+			LL::parallel_for((U32)deferred_avatars.size(), [](U32 i)
+			{
+				// may have been killed by a later object's idleUpdate()
+				if (!deferred_avatars[i]->isDead())
+				{
+					deferred_avatars[i]->updateDeferredPalettes();
+				}
+			});
 		}
 
 		//update flexible objects
@@ -959,6 +1058,9 @@ void LLViewerObjectList::update(LLAgent &agent)
 	// update max computed render cost
 	LLVOVolume::updateRenderComplexity();
 
+	// rebuild prims whose new LOD finished generating
+	LLVOVolume::updatePendingVolumes();
+
 	// compute all sorts of time-based stats
 	// don't factor frames that were paused into the stats
 	if (! mWasPaused)
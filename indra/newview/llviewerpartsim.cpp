@@ -65,9 +65,9 @@ const F32 LLViewerPartSim::PART_ADAPT_RATE_MULT_RECIP = 1.0f/PART_ADAPT_RATE_MUL
 
 U32 LLViewerPart::sNextPartID = 1;
 
-F32 calc_desired_size(LLViewerCamera* camera, LLVector3 pos, LLVector2 scale)
+F32 calc_desired_size(const LLVector3& camera_origin, LLVector3 pos, LLVector2 scale)
 {
-	F32 desired_size = (pos - camera->getOrigin()).magVec();
+	F32 desired_size = (pos - camera_origin).magVec();
 	desired_size /= 4;
 	return llclamp(desired_size, scale.magVec()*0.5f, PART_SIM_BOX_SIDE*2);
 }
@@ -189,6 +189,7 @@ LLViewerPartGroup::LLViewerPartGroup(const LLVector3 &center_agent, const F32 bo
 	}
 
 	mSkippedTime = 0.f;
+	mRemovedCount = 0;
 
 	static U32 id_seed = 0;
 	mID = ++id_seed;
@@ -204,8 +205,18 @@ LLViewerPartGroup::~LLViewerPartGroup()
 		delete mParticles[i] ;
 	}
 	mParticles.clear();
+
+	// anything simulateParticles() took out and removeParticles() never got to
+	for (LLViewerPart* part : mDeadParticles)
+	{
+		delete part;
+	}
+	for (LLViewerPart* part : mStrayParticles)
+	{
+		delete part;
+	}
 	
-	LLViewerPartSim::decPartCount(count);
+	LLViewerPartSim::decPartCount(count + mRemovedCount);
 }
 
 void LLViewerPartGroup::cleanup()
@@ -273,15 +284,12 @@ BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 }
 
 
-void LLViewerPartGroup::updateParticles(const F32 lastdt)
+void LLViewerPartGroup::simulateParticles(const F32 lastdt, const LLVector3& camera_origin)
 {
 	F32 dt;
 	
 	LLVector3 gravity(0.f, 0.f, GRAVITY);
 
-	LLViewerPartSim::checkParticleCount(mParticles.size());
-
-	LLViewerCamera* camera = LLViewerCamera::getInstance();
 	LLViewerRegion *regionp = getRegion();
 	S32 end = (S32) mParticles.size();
 	for (S32 i = 0 ; i < (S32)mParticles.size();)
@@ -397,21 +405,23 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 
 
 		// Kill dead particles (either flagged dead, or too old)
+		// Deleting them unlinks ribbons in other groups, so that waits
+		// for removeParticles()
 		if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
 		{
 			mParticles[i] = mParticles.back() ;
 			mParticles.pop_back() ;
-			delete part ;
+			mDeadParticles.push_back(part);
 		}
 		else 
 		{
-			F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
+			F32 desired_size = calc_desired_size(camera_origin, part->mPosAgent, part->mScale);
 			if (!posInGroup(part->mPosAgent, desired_size))
 			{
 				// Transfer particles between groups
-				LLViewerPartSim::getInstance()->put(part) ;
 				mParticles[i] = mParticles.back() ;
 				mParticles.pop_back() ;
+				mStrayParticles.push_back(part);
 			}
 			else
 			{
@@ -420,7 +430,21 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 		}
 	}
 
-	S32 removed = end - (S32)mParticles.size();
+	mRemovedCount = end - (S32)mParticles.size();
+}
+
+void LLViewerPartGroup::removeParticles(part_list_t& strays)
+{
+	for (LLViewerPart* part : mDeadParticles)
+	{
+		delete part;
+	}
+	mDeadParticles.clear();
+	strays.insert(strays.end(), mStrayParticles.begin(), mStrayParticles.end());
+	mStrayParticles.clear();
+
+	S32 removed = mRemovedCount;
+	mRemovedCount = 0;
 	if (removed > 0)
 	{
 		// we removed one or more particles, so flag this group for update
@@ -430,15 +454,6 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 		}
 		LLViewerPartSim::decPartCount(removed);
 	}
-	
-	// Kill the viewer object if this particle group is empty
-	if (mParticles.empty())
-	{
-		gObjectList.killObject(mVOPartGroupp);
-		mVOPartGroupp = NULL;
-	}
-
-	LLViewerPartSim::checkParticleCount() ;
 }
 
 
@@ -490,6 +505,7 @@ LLViewerPartSim::LLViewerPartSim()
 	sMaxParticleCount = llmin(gSavedSettings.getS32("RenderMaxPartCount"), LL_MAX_PARTICLE_COUNT);
 	static U32 id_seed = 0;
 	mID = ++id_seed;
+	mSimulating = false;
 }
 
 //enable/disable particle system
@@ -582,8 +598,7 @@ LLViewerPartGroup *LLViewerPartSim::put(LLViewerPart* part)
 	}
 	else
 	{	
-		LLViewerCamera* camera = LLViewerCamera::getInstance();
-		F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
+		F32 desired_size = calc_desired_size(LLViewerCamera::getInstance()->getOrigin(), part->mPosAgent, part->mScale);
 
 		S32 count = (S32) mViewerPartGroups.size();
 		for (S32 i = 0; i < count; i++)
@@ -659,18 +674,30 @@ void LLViewerPartSim::shift(const LLVector3 &offset)
 static LLTrace::BlockTimerStatHandle FTM_SIMULATE_PARTICLES("Simulate Particles");
 
 void LLViewerPartSim::updateSimulation()
+{
+	beginSimulation();
+	simulateParticles();
+	endSimulation();
+}
+
+void LLViewerPartSim::beginSimulation()
 {
 	static LLFrameTimer update_timer;
 
 	const F32 dt = llmin(update_timer.getElapsedTimeAndResetF32(), 0.1f);
 
- 	if (!(gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES)))
+	mUpdateGroups.clear();
+	mSimulating = gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES);
+ 	if (!mSimulating)
 	{
 		return;
 	}
 
 	LL_RECORD_BLOCK_TIME(FTM_SIMULATE_PARTICLES);
 
+	// particles are sized against the camera as it was before this frame's update
+	mCameraOrigin = LLViewerCamera::getInstance()->getOrigin();
+
 	// Start at a random particle system so the same
 	// particle system doesn't always get first pick at the
 	// particles.  Theoretically we'd want to do this in distance
@@ -768,15 +795,7 @@ void LLViewerPartSim::updateSimulation()
 			{
 				gPipeline.markRebuild(vobj->mDrawable, LLDrawable::REBUILD_ALL, TRUE);
 			}
-			mViewerPartGroups[i]->updateParticles(dt * visirate);
-			mViewerPartGroups[i]->mSkippedTime=0.0f;
-			if (!mViewerPartGroups[i]->getCount())
-			{
-				delete mViewerPartGroups[i];
-				mViewerPartGroups.erase(mViewerPartGroups.begin() + i);
-				i--;
-				count--;
-			}
+			mUpdateGroups.push_back(std::make_pair(mViewerPartGroups[i], dt * visirate));
 		}
 		else
 		{	
@@ -784,6 +803,60 @@ void LLViewerPartSim::updateSimulation()
 		}
 
 	}
+}
+
+void LLViewerPartSim::simulateParticles()
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	for (std::pair<LLViewerPartGroup*, F32>& update : mUpdateGroups)
+	{
+		update.first->simulateParticles(update.second, mCameraOrigin);
+	}
+}
+
+void LLViewerPartSim::endSimulation()
+{
+	if (!mSimulating)
+	{
+		return;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_SIMULATE_PARTICLES);
+
+	checkParticleCount();
+
+	LLViewerPartGroup::part_list_t strays;
+	for (std::pair<LLViewerPartGroup*, F32>& update : mUpdateGroups)
+	{
+		update.first->removeParticles(strays);
+		update.first->mSkippedTime = 0.f;
+	}
+
+	// Transfer particles between groups, before any group is let go so
+	// that every group they can land in still has its viewer object
+	for (LLViewerPart* part : strays)
+	{
+		put(part);
+	}
+
+	for (std::pair<LLViewerPartGroup*, F32>& update : mUpdateGroups)
+	{
+		LLViewerPartGroup* groupp = update.first;
+		if (!groupp->getCount())
+		{
+			// Kill the viewer object if this particle group is empty
+			gObjectList.killObject(groupp->mVOPartGroupp);
+			groupp->mVOPartGroupp = NULL;
+
+			mViewerPartGroups.erase(std::find(mViewerPartGroups.begin(), mViewerPartGroups.end(), groupp));
+			delete groupp;
+		}
+	}
+	mUpdateGroups.clear();
+
+	checkParticleCount();
+
 	if (LLDrawable::getCurrentFrame()%16==0)
 	{
 		if (sParticleCount > sMaxParticleCount * 0.875f
@@ -95,9 +95,17 @@ public:
 
 	void cleanup();
 
+	typedef std::vector<LLViewerPart*>  part_list_t;
+
 	BOOL addPart(LLViewerPart* part, const F32 desired_size = -1.f);
 	
-	void updateParticles(const F32 lastdt);
+	// Moves the particles and takes out the ones that died or left the
+	// box.  Only this group's particles are touched, so groups can be
+	// simulated on a worker while the main thread gets on with the frame.
+	void simulateParticles(const F32 lastdt, const LLVector3& camera_origin);
+	// Deletes what simulateParticles() took out and returns the strays to
+	// be regrouped, on the main thread.
+	void removeParticles(part_list_t& strays);
 
 	BOOL posInGroup(const LLVector3 &pos, const F32 desired_size = -1.f);
 
@@ -106,7 +114,6 @@ public:
 	F32 getBoxRadius() { return mBoxRadius; }
 	F32 getBoxSide() { return mBoxSide; }
 
-	typedef std::vector<LLViewerPart*>  part_list_t;
 	part_list_t mParticles;
 
 	const LLVector3 &getCenterAgent() const		{ return mCenterAgent; }
@@ -131,6 +138,10 @@ protected:
 	LLVector3 mMaxObjPos;
 
 	LLViewerRegion *mRegionp;
+
+	part_list_t mDeadParticles;		// taken out by simulateParticles()
+	part_list_t mStrayParticles;
+	S32 mRemovedCount;
 };
 
 class LLViewerPartSim : public LLSingleton<LLViewerPartSim>
@@ -148,6 +159,14 @@ public:
 
 	void updateSimulation();
 
+	// updateSimulation() in three steps, so the frame graph can run the
+	// middle one on a worker: beginSimulation() updates the sources and
+	// picks the groups due this frame, simulateParticles() moves their
+	// particles and endSimulation() regroups and deletes on the main thread.
+	void beginSimulation();
+	void simulateParticles();
+	void endSimulation();
+
 	void addPartSource(LLPointer<LLViewerPartSource> sourcep);
 
 	void cleanupRegion(LLViewerRegion *regionp);
@@ -194,6 +213,11 @@ protected:
 	source_list_t mViewerPartSources;
 	LLFrameTimer mSimulationTimer;
 
+	// groups beginSimulation() picked, with the time each is moved by
+	std::vector<std::pair<LLViewerPartGroup*, F32> > mUpdateGroups;
+	LLVector3 mCameraOrigin;
+	bool mSimulating;
+
 	static S32 sMaxParticleCount;
 	static S32 sParticleCount;
 	static F32 sParticleAdaptiveRate;
@@ -448,12 +448,21 @@ void LLViewerShaderMgr::setShaders()
 
     reentrance = true;
 
+    LLTimer load_timer;
+
     //setup preprocessor definitions
     LLShaderMgr::instance()->mDefinitions["NUM_TEX_UNITS"] = llformat("%d", gGLManager.mNumTextureImageUnits);
     
     // Make sure the compiled shader map is cleared before we recompile shaders.
     mVertexShaderObjects.clear();
     mFragmentShaderObjects.clear();
+    mShaderObjectDigests.clear();
+    // re-read the shader files, in case they were edited since the last load
+    mShaderFileDigests.clear();
+
+    static LLCachedControl<bool> shader_cache(gSavedSettings, "RenderShaderCache", true);
+    setProgramCacheEnabled(shader_cache);
+    resetProgramCacheStats();
     
     initAttribsAndUniforms();
     gPipeline.releaseGLBuffers();
@@ -736,6 +745,12 @@ void LLViewerShaderMgr::setShaders()
     }
     gPipeline.createGLBuffers();
 
+    LL_INFOS("ShaderLoading") << "Loaded shaders in " << load_timer.getElapsedTimeF32() << " seconds"
+        << (isProgramCacheEnabled() ? "" : ", program cache disabled")
+        << ", program cache hits: " << mProgramCacheHits
+        << ", misses: " << mProgramCacheMisses
+        << ", rejected by driver: " << mProgramCacheRejects << LL_ENDL;
+
     reentrance = false;
 }
 
@@ -3952,6 +3967,11 @@ std::string LLViewerShaderMgr::getShaderDirPrefix(void)
 	return gDirUtilp->getExpandedFilename(LL_PATH_APP_SETTINGS, "shaders/class");
 }
 
+std::string LLViewerShaderMgr::getProgramCacheDir(void)
+{
+	return gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "shader_cache");
+}
+
 void LLViewerShaderMgr::updateShaderUniforms(LLGLSLShader * shader)
 {
     LLEnvironment::instance().updateShaderUniforms(shader);
@@ -35,6 +35,7 @@
 #include "lltimer.h"
 
 #include "llappviewer.h"
+#include "llavatarnamecache.h"
 
 #include "pipeline.h" 
 #include "lltexturefetch.h" 
@@ -93,7 +94,11 @@ LLTrace::CountStatHandle<>	FPS("FPS", "Frames rendered"),
 							FRAMETIME_DOUBLED("frametimedoubled", "Ratio of frames 2x longer than previous"),
 							TEX_BAKES("texbakes", "Number of times avatar textures have been baked"),
 							TEX_REBAKES("texrebakes", "Number of times avatar textures have been forced to rebake"),
-							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache");
+							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache"),
+							AVATAR_MORPH_JOBS("avatarmorphjobs", "Avatar mesh morph jobs dispatched to worker threads"),
+							AVATAR_PARALLEL_UPDATES("avatarparallelupdates", "Avatars whose joint transforms were updated on worker threads"),
+							AVATAR_STREAMING_CAPPED("avatarstreamingcapped", "Avatar-frames in which an avatar's attachments streamed at reduced detail"),
+							SETTINGS_LOOKUPS("settingslookups", "Settings looked up by name instead of through a cached control or handle (development builds only)");
 
 LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > 
 							TRIANGLES_DRAWN("trianglesdrawnstat");
@@ -356,10 +361,17 @@ void update_statistics()
 
 	record(LLStatViewer::TRIANGLES_DRAWN_PER_FRAME, last_frame_recording.getSum(LLStatViewer::TRIANGLES_DRAWN));
 
-	sample(LLStatViewer::ENABLE_VBO,      (F64)gSavedSettings.getBOOL("RenderVBOEnable"));
+	static LLControlHandle render_vbo_enable = gSavedSettings.getHandle("RenderVBOEnable");
+	static LLControlHandle render_far_clip = gSavedSettings.getHandle("RenderFarClip");
+	static LLControlHandle use_chat_bubbles = gSavedSettings.getHandle("UseChatBubbles");
+	sample(LLStatViewer::ENABLE_VBO,      (F64)gSavedSettings.getBOOL(render_vbo_enable));
 	sample(LLStatViewer::LIGHTING_DETAIL, (F64)gPipeline.getLightingDetail());
-	sample(LLStatViewer::DRAW_DISTANCE,   (F64)gSavedSettings.getF32("RenderFarClip"));
-	sample(LLStatViewer::CHAT_BUBBLES,    gSavedSettings.getBOOL("UseChatBubbles"));
+	sample(LLStatViewer::DRAW_DISTANCE,   (F64)gSavedSettings.getF32(render_far_clip));
+	sample(LLStatViewer::CHAT_BUBBLES,    gSavedSettings.getBOOL(use_chat_bubbles));
+
+	// Name lookups made since the last frame; any call site that shows up
+	// here every frame should use LLCachedControl or an LLControlHandle.
+	add(LLStatViewer::SETTINGS_LOOKUPS, LLControlGroup::getAndResetLookupCount());
 
 	typedef LLTrace::StatType<LLTrace::TimeBlockAccumulator>::instance_tracker_t stat_type_t;
 
@@ -696,6 +708,8 @@ void send_viewer_stats(bool include_preferences)
 		
 	body["stats"]["voice"] = LLVoiceVivoxStats::getInstance()->read();
 
+	body["stats"]["names"] = LLAvatarNameCache::getInstance()->getBatchStats();
+
 	// Misc stats, two strings and two ints
 	// These are not expecticed to persist across multiple releases
 	// Comment any changes with your name and the expected release revision
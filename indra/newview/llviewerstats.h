@@ -138,7 +138,11 @@ extern LLTrace::CountStatHandle<>			FPS,
 											FRAMETIME_DOUBLED,
 											TEX_BAKES,
 											TEX_REBAKES,
-											NUM_NEW_OBJECTS;
+											NUM_NEW_OBJECTS,
+											AVATAR_MORPH_JOBS,
+											AVATAR_PARALLEL_UPDATES,
+											AVATAR_STREAMING_CAPPED,
+											SETTINGS_LOOKUPS;
 
 extern LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > TRIANGLES_DRAWN;
 
@@ -1998,7 +1998,7 @@ void LLViewerFetchedTexture::updateVirtualSize()
 					{
 						setBoostLevel(LLViewerTexture::BOOST_SELECTED);
 					}
-					addTextureStats(facep->getVirtualSize());
+					addTextureStats(facep->getTextureStatSize());
 					setAdditionalDecodePriority(facep->getImportanceToCamera());
 				}
 			}
@@ -3675,7 +3675,7 @@ void LLViewerMediaTexture::initVirtualSize()
 	findFaces();
 	for(std::list< LLFace* >::iterator iter = mMediaFaceList.begin(); iter!= mMediaFaceList.end(); ++iter)
 	{
-		addTextureStats((*iter)->getVirtualSize());
+		addTextureStats((*iter)->getTextureStatSize());
 	}
 }
 
@@ -3950,7 +3950,7 @@ F32 LLViewerMediaTexture::getMaxVirtualSize()
 				LLFace* facep = mFaceList[ch][i];
 			if(facep->getDrawable()->isRecentlyVisible())
 			{
-				addTextureStats(facep->getVirtualSize());
+				addTextureStats(facep->getTextureStatSize());
 			}
 		}		
 	}
@@ -3966,7 +3966,7 @@ F32 LLViewerMediaTexture::getMaxVirtualSize()
 				LLFace* facep = *iter;
 				if(facep->getDrawable()->isRecentlyVisible())
 				{
-					addTextureStats(facep->getVirtualSize());
+					addTextureStats(facep->getTextureStatSize());
 				}
 			}
 		}
@@ -53,6 +53,7 @@
 #include "lldrawpoolavatar.h"
 #include "lldriverparam.h"
 #include "llpolyskeletaldistortion.h"
+#include "llpolymesh.h"
 #include "lleditingmotion.h"
 #include "llemote.h"
 #include "llfloatertools.h"
@@ -94,6 +95,7 @@
 #include "llvoavatarself.h"
 #include "llvovolume.h"
 #include "llworld.h"
+#include "workqueue.h"
 #include "pipeline.h"
 #include "llviewershadermgr.h"
 #include "llsky.h"
@@ -209,6 +211,13 @@ const F32 MAX_TEXTURE_WAIT_TIME_SEC = 60;
 
 const S32 MIN_NONTUNED_AVS = 5;
 
+// Main thread only, like any LLCachedControl
+static bool use_flat_joint_update()
+{
+	static LLCachedControl<bool> flat_joint_update(gSavedSettings, "AvatarFlatJointUpdate", true);
+	return flat_joint_update;
+}
+
 enum ERenderName
 {
 	RENDER_NAME_NEVER,
@@ -671,6 +680,11 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mVisibilityRank(0),
 	mNeedsSkin(FALSE),
 	mLastSkinTime(0.f),
+	mDeferJointUpdate(false),
+	mJointUpdatePending(false),
+	mFlatJointUpdate(true),
+	mPalettesPending(false),
+	mIdleDetailedUpdate(false),
 	mUpdatePeriod(1),
 	mOverallAppearance(AOA_INVISIBLE),
 	mVisualComplexityStale(true),
@@ -719,6 +733,7 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 
 	mNeedsImpostorUpdate = TRUE;
 	mLastImpostorUpdateReason = 0;
+	mImpostorSlot = -1;
 	mNeedsAnimUpdate = TRUE;
 
 	mNeedsExtentUpdate = true;
@@ -855,6 +870,7 @@ void LLVOAvatar::markDead()
 	}
 	mVoiceVisualizer->markDead();
 	LLLoadedCallbackEntry::cleanUpCallbackList(&mCallbackTextureList) ;
+	releaseImpostor();
 	LLViewerObject::markDead();
 }
 
@@ -1107,10 +1123,11 @@ void LLVOAvatar::resetImpostors()
 		 iter != LLCharacter::sInstances.end(); ++iter)
 	{
 		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
-		avatar->mImpostor.release();
+		avatar->mImpostorSlot = -1;
 		avatar->mNeedsImpostorUpdate = TRUE;
 		avatar->mLastImpostorUpdateReason = 1;
 	}
+	gPipeline.releaseImpostorAtlas();
 }
 
 // static
@@ -2550,17 +2567,37 @@ void LLVOAvatar::dumpAnimationState()
 // idleUpdate()
 //------------------------------------------------------------------------
 void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	if (beginIdleUpdate(agent, time, false))
+	{
+		finishIdleUpdate();
+	}
+}
+
+bool LLVOAvatar::canDeferJoints() const
+{
+	// Your own avatar stays in step with the agent and camera code, animesh
+	// is driven by its object, or by the avatar wearing it, and a sitting
+	// avatar follows its seat, which may not have moved yet when the
+	// deferred avatars begin.
+	return !isSelf() && !isControlAvatar() && !isDead() && !mIsSitting;
+}
+
+bool LLVOAvatar::beginIdleUpdate(LLAgent &agent, const F64 &time, bool defer_joints)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
 
 	if (isDead())
 	{
 		LL_INFOS() << "Warning!  Idle on dead avatar" << LL_ENDL;
-		return;
+		return false;
 	}
     // record time and refresh "tooSlow" status
     LLPerfStats::RecordAvatarTime T(getID(), LLPerfStats::StatType_t::RENDER_IDLE); // per avatar "idle" time.
     updateTooSlow();
+    updateStreamingBudget();
 
 	static LLCachedControl<bool> disable_all_render_types(gSavedSettings, "DisableAllRenderTypes");
 	if (!(gPipeline.hasRenderType(mIsControlAvatar ? LLPipeline::RENDER_TYPE_CONTROL_AV : LLPipeline::RENDER_TYPE_AVATAR))
@@ -2570,7 +2607,7 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
         {
             idleUpdateNameTag( mLastRootPos );
         }
-        return;
+        return false;
 	}
 
     // Update should be happening max once per frame.
@@ -2646,7 +2683,69 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
 	// animate the character
 	// store off last frame's root position to be consistent with camera position
 	mLastRootPos = mRoot->getWorldPosition();
-	BOOL detailed_update = updateCharacter(agent);
+	mDeferJointUpdate = defer_joints;
+	mIdleDetailedUpdate = updateCharacter(agent);
+	mDeferJointUpdate = false;
+	return true;
+}
+
+//------------------------------------------------------------------------
+// updateDeferredJoints()
+// Only touches this avatar's own skeleton, so it can run on a worker thread
+// while the main thread waits for it.
+//------------------------------------------------------------------------
+void LLVOAvatar::updateDeferredJoints()
+{
+	if (!mJointUpdatePending)
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	LLPerfStats::RecordAvatarTime T(getID(), LLPerfStats::StatType_t::RENDER_IDLE);
+
+	mJointUpdatePending = false;
+	updateWorldMatrices(mFlatJointUpdate);
+}
+
+//------------------------------------------------------------------------
+// updateDeferredPalettes()
+// Only touches this avatar's skeleton and palette cache, like
+// updateDeferredJoints(), and runs once finishIdleUpdate() is done with the
+// skeleton, so the palettes see attachments and lip sync too.
+//------------------------------------------------------------------------
+void LLVOAvatar::updateDeferredPalettes()
+{
+	if (!mPalettesPending)
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	LLPerfStats::RecordAvatarTime T(getID(), LLPerfStats::StatType_t::RENDER_IDLE);
+
+	mPalettesPending = false;
+	prebuildMatrixPalettes();
+}
+
+void LLVOAvatar::finishIdleUpdate()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	if (isDead())
+	{
+		return;
+	}
+
+	LLPerfStats::RecordAvatarTime T(getID(), LLPerfStats::StatType_t::RENDER_IDLE);
+	LLScopedContextString str("avatar_idle_update " + getFullname());
+
+	// in case nobody called updateDeferredJoints()
+	updateDeferredJoints();
+
+	const bool detailed_update = mIdleDetailedUpdate;
+	// Checking prebuilt palettes needs the flat joint arrays
+	mPalettesPending = detailed_update && mFlatJointUpdate;
 
 	static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
 	bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
@@ -2655,6 +2754,7 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
 	idleUpdateVoiceVisualizer( voice_enabled );
 	idleUpdateMisc( detailed_update );
 	idleUpdateAppearanceAnimation();
+	updateMorphJobs();
 	if (detailed_update)
 	{
 		idleUpdateLipSync( voice_enabled );
@@ -3042,6 +3142,52 @@ void LLVOAvatar::idleUpdateAppearanceAnimation()
 	}
 }
 
+//------------------------------------------------------------------------
+// updateMorphJobs()
+// Publishes finished mesh morph jobs and hands newly queued morphs to the
+// General thread pool.  See LLPolyMesh::sDeferMorphs.
+//------------------------------------------------------------------------
+void LLVOAvatar::updateMorphJobs()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	LL::WorkQueue::ptr_t general_queue;
+	bool swapped = false;
+	for (polymesh_map_t::value_type& mesh_pair : mPolyMeshes)
+	{
+		LLPolyMesh* mesh = mesh_pair.second;
+		if (mesh->isLOD())
+		{
+			// shares the vertex data of its reference mesh
+			continue;
+		}
+
+		swapped |= mesh->finishMorphJob();
+
+		LLPointer<LLPolyMorphJob> job = mesh->startMorphJob();
+		if (job.isNull())
+		{
+			continue;
+		}
+		add(LLStatViewer::AVATAR_MORPH_JOBS, 1);
+
+		if (!general_queue)
+		{
+			general_queue = LL::WorkQueue::getInstance("General");
+		}
+		if (!general_queue || !general_queue->postIfOpen([job]() mutable { job->run(); }))
+		{
+			job->run();
+			swapped |= mesh->finishMorphJob();
+		}
+	}
+
+	if (swapped)
+	{
+		dirtyMesh();
+	}
+}
+
 F32 LLVOAvatar::calcMorphAmount()
 {
 	F32 appearance_anim_time = mAppearanceMorphTimer.getElapsedTimeF32();
@@ -3698,7 +3844,7 @@ void LLVOAvatar::slamPosition()
 	{
 		gPipeline.updateMoveNormalAsync(mDrawable);
 	}
-	mRoot->updateWorldMatrixChildren();
+	updateWorldMatrices();
 }
 
 bool LLVOAvatar::isVisuallyMuted()
@@ -4711,7 +4857,16 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
     updateFootstepSounds();
 
 	// Update child joints as needed.
-	mRoot->updateWorldMatrixChildren();
+	if (mDeferJointUpdate)
+	{
+		// read here, the setting can't be looked up from a worker
+		mFlatJointUpdate = use_flat_joint_update();
+		mJointUpdatePending = true;
+	}
+	else
+	{
+		updateWorldMatrices();
+	}
 
     if (visible)
     {
@@ -4819,10 +4974,36 @@ void LLVOAvatar::debugBodySize() const
 //------------------------------------------------------------------------
 void LLVOAvatar::postPelvisSetRecalc()
 {		
-	mRoot->updateWorldMatrixChildren();			
+	updateWorldMatrices();			
 	computeBodySize();
 	dirtyMesh(2);
 }
+//------------------------------------------------------------------------
+// updateWorldMatrices()
+//------------------------------------------------------------------------
+void LLVOAvatar::updateWorldMatrices()
+{
+	updateWorldMatrices(use_flat_joint_update());
+}
+
+void LLVOAvatar::updateWorldMatrices(bool flat)
+{
+	if (!flat)
+	{
+		mJointHierarchy.clear();
+		mRoot->updateWorldMatrixChildren();
+		return;
+	}
+
+	// Rebuilt whenever joints are added, removed or renumbered anywhere,
+	// which only happens while skeletons and attachment points are set up.
+	if (mJointHierarchy.isStale())
+	{
+		mJointHierarchy.build(mRoot);
+	}
+	mJointHierarchy.update();
+}
+
 //------------------------------------------------------------------------
 // updateVisibility()
 //------------------------------------------------------------------------
@@ -5258,11 +5439,15 @@ U32 LLVOAvatar::renderRigid()
 
 U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 {
-	if (!mImpostor.isComplete())
+	if (!hasImpostor())
 	{
 		return 0;
 	}
 
+	LLVector2 tc_min;
+	LLVector2 tc_max;
+	gPipeline.mImpostorAtlas.getTexCoords(mImpostorSlot, tc_min, tc_max);
+
 	LLVector3 pos(getRenderPosition()+mImpostorOffset);
 	LLVector3 at = (pos - LLViewerCamera::getInstance()->getOrigin());
 	at.normalize();
@@ -5306,15 +5491,15 @@ U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
     gGL.flush();
 
 	gGL.color4ubv(color.mV);
-	gGL.getTexUnit(diffuse_channel)->bind(&mImpostor);
+	gGL.getTexUnit(diffuse_channel)->bind(&gPipeline.mImpostorTarget);
 	gGL.begin(LLRender::QUADS);
-	gGL.texCoord2f(0,0);
+	gGL.texCoord2f(tc_min.mV[0], tc_min.mV[1]);
 	gGL.vertex3fv((pos+left-up).mV);
-	gGL.texCoord2f(1,0);
+	gGL.texCoord2f(tc_max.mV[0], tc_min.mV[1]);
 	gGL.vertex3fv((pos-left-up).mV);
-	gGL.texCoord2f(1,1);
+	gGL.texCoord2f(tc_max.mV[0], tc_max.mV[1]);
 	gGL.vertex3fv((pos-left+up).mV);
-	gGL.texCoord2f(0,1);
+	gGL.texCoord2f(tc_min.mV[0], tc_max.mV[1]);
 	gGL.vertex3fv((pos+left+up).mV);
 	gGL.end();
 	gGL.flush();
@@ -7052,7 +7237,7 @@ void LLVOAvatar::updateVisualParams()
 	{
 		computeBodySize();
 		mLastSkeletonSerialNum = mSkeletonSerialNum;
-		mRoot->updateWorldMatrixChildren();
+		updateWorldMatrices();
 	}
 
 	dirtyMesh();
@@ -7706,7 +7891,7 @@ void LLVOAvatar::sitOnObject(LLViewerObject *sit_object)
 	mRoot->getXform()->setParent(&sit_object->mDrawable->mXform); // LLVOAvatar::sitOnObject
 	// SL-315
 	mRoot->setPosition(getPosition());
-	mRoot->updateWorldMatrixChildren();
+	updateWorldMatrices();
 
 	stopMotion(ANIM_AGENT_BODY_NOISE);
 	
@@ -8313,6 +8498,68 @@ bool LLVOAvatar::isTooSlow() const
     return mTooSlow;
 }
 
+// beyond this distance an over budget avatar's detail is cut further
+const F32 STREAMING_FULL_DETAIL_DISTANCE = 16.f;
+
+void LLVOAvatar::updateStreamingBudget()
+{
+    static LLCachedControl<bool> streaming_budget(gSavedSettings, "AvatarStreamingBudget", true);
+    static LLCachedControl<U32> max_discard_bias(gSavedSettings, "AvatarStreamingMaxDiscardBias", 3U);
+    static LLCachedControl<U32> max_render_cost(gSavedSettings, "RenderAvatarMaxComplexity", 0U);
+    static LLCachedControl<bool> always_render_friends(gSavedSettings, "AlwaysRenderFriends");
+
+    mStreamingDiscardBias = 0;
+
+    if (!streaming_budget || isSelf() || mVisuallyMuteSetting == AV_ALWAYS_RENDER)
+    {
+        return;
+    }
+
+    // how far over its limits the avatar is, 1 being right at them
+    F32 over = 0.f;
+    if (max_render_cost > 0)
+    {
+        over = (F32) mVisualComplexity / (F32) max_render_cost;
+    }
+    if (mTooSlow && LLPerfStats::renderAvatarMaxART_ns > 0)
+    {
+        over = llmax(over, (F32) (LLPerfStats::raw_to_ns(mRenderTime) / (F64) LLPerfStats::renderAvatarMaxART_ns));
+    }
+    if (over <= 1.f
+        || (always_render_friends && LLAvatarTracker::instance().isBuddy(getID())))
+    {
+        return;
+    }
+
+    // the further away, the less of its detail shows
+    if (mDrawable.notNull())
+    {
+        over *= llmax(1.f, mDrawable->mDistanceWRTCamera / STREAMING_FULL_DETAIL_DISTANCE);
+    }
+
+    // and the further behind the target frame rate, the less there is to spare
+    if (LLPerfStats::tunables.userAutoTuneEnabled && LLPerfStats::tunables.userTargetFPS > 0 && LLPerfStats::meanFrameTime > 0)
+    {
+        F64 target_frame_time_raw = LLPerfStats::cpu_hertz / LLPerfStats::tunables.userTargetFPS;
+        over *= llmax(1.f, (F32) (LLPerfStats::meanFrameTime / target_frame_time_raw));
+    }
+
+    // one discard level, a quarter of the texels, per doubling over budget
+    mStreamingDiscardBias = llmin((S32) floorf(log2f(over)) + 1, (S32) max_discard_bias);
+
+    if (mStreamingDiscardBias > 0)
+    {
+        add(LLStatViewer::AVATAR_STREAMING_CAPPED, 1);
+    }
+}
+
+S32 LLVOAvatar::getStreamingLODCap() const
+{
+    // the lowest LOD is often little more than a placeholder, don't go below
+    // LOW
+    return llmax(LLModel::LOD_HIGH - mStreamingDiscardBias, (S32) LLModel::LOD_LOW);
+}
+
 // use Avatar Render Time as complexity metric
 // markARTStale - Mark stale and set the frameupdate to now so that we can wait at least one frame to get a revised number.
 void LLVOAvatar::markARTStale()
@@ -9661,47 +9908,99 @@ const LLVOAvatar::MatrixPaletteCache& LLVOAvatar::updateSkinInfoMatrixPalette(co
     U64 hash = skin->mHash;
     MatrixPaletteCache& entry = mMatrixPaletteCache[hash];
 
-    if (entry.mFrame != gFrameCount)
+    // A palette built ahead of time is stale if the skeleton moved since,
+    // e.g. a joint override arriving with a mesh later in the frame.
+    if (entry.mFrame != gFrameCount || (entry.mPrebuilt && !isMatrixPaletteCurrent(skin)))
     {
-        LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
-
         entry.mFrame = gFrameCount;
+        entry.mSkinInfo = skin;
+        entry.mPrebuilt = false;
+        buildMatrixPalette(entry, skin);
+    }
 
-        //build matrix palette
-        U32 count = LLSkinningUtil::getMeshJointCount(skin);
-        entry.mMatrixPalette.resize(count);
-        LLSkinningUtil::initSkinningMatrixPalette(&(entry.mMatrixPalette[0]), count, skin, this);
+    return entry;
+}
 
-        const LLMatrix4a* mat = &(entry.mMatrixPalette[0]);
+bool LLVOAvatar::isMatrixPaletteCurrent(const LLMeshSkinInfo* skin) const
+{
+    if (!skin->mJointNumsInitialized)
+    {
+        return false;
+    }
 
-        entry.mGLMp.resize(count * 12);
+    U32 count = LLSkinningUtil::getMeshJointCount(skin);
+    for (U32 j = 0; j < count; ++j)
+    {
+        // NULL once the joint was touched after the last flat update
+        if (!mJointHierarchy.getWorldMatrix4a(skin->mJointNums[j]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-        F32* mp = &(entry.mGLMp[0]);
+void LLVOAvatar::prebuildMatrixPalettes()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
 
-        for (U32 i = 0; i < count; ++i)
+    // Runs at the end of idle, before gFrameCount is bumped for the frame
+    // about to be drawn, so entries drawn last frame are stamped gFrameCount,
+    // and gFrameCount + 1 if prebuilt by an idle that was not followed by a
+    // draw.  Each is checked with isMatrixPaletteCurrent() before drawing.
+    for (matrix_palette_cache_t::value_type& pair : mMatrixPaletteCache)
+    {
+        // Leaves mSkinInfo alone, reference counts are not thread safe.
+        // Joint numbers are looked up on the main thread the first time a
+        // skin is drawn, so only rebuild palettes for skins past that point.
+        MatrixPaletteCache& entry = pair.second;
+        const LLMeshSkinInfo* skin = entry.mSkinInfo.get();
+        if ((entry.mFrame == gFrameCount || entry.mFrame == gFrameCount + 1)
+            && skin && skin->mJointNumsInitialized)
         {
-            F32* m = (F32*)mat[i].mMatrix[0].getF32ptr();
+            entry.mFrame = gFrameCount + 1;
+            entry.mPrebuilt = true;
+            buildMatrixPalette(entry, skin);
+        }
+    }
+}
+
+void LLVOAvatar::buildMatrixPalette(MatrixPaletteCache& entry, const LLMeshSkinInfo* skin)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
 
-            U32 idx = i * 12;
+    //build matrix palette
+    U32 count = LLSkinningUtil::getMeshJointCount(skin);
+    entry.mMatrixPalette.resize(count);
+    LLSkinningUtil::initSkinningMatrixPalette(&(entry.mMatrixPalette[0]), count, skin, this);
 
-            mp[idx + 0] = m[0];
-            mp[idx + 1] = m[1];
-            mp[idx + 2] = m[2];
-            mp[idx + 3] = m[12];
+    const LLMatrix4a* mat = &(entry.mMatrixPalette[0]);
 
-            mp[idx + 4] = m[4];
-            mp[idx + 5] = m[5];
-            mp[idx + 6] = m[6];
-            mp[idx + 7] = m[13];
+    entry.mGLMp.resize(count * 12);
 
-            mp[idx + 8] = m[8];
-            mp[idx + 9] = m[9];
-            mp[idx + 10] = m[10];
-            mp[idx + 11] = m[14];
-        }
-    }
+    F32* mp = &(entry.mGLMp[0]);
 
-    return entry;
+    for (U32 i = 0; i < count; ++i)
+    {
+        F32* m = (F32*)mat[i].mMatrix[0].getF32ptr();
+
+        U32 idx = i * 12;
+
+        mp[idx + 0] = m[0];
+        mp[idx + 1] = m[1];
+        mp[idx + 2] = m[2];
+        mp[idx + 3] = m[12];
+
+        mp[idx + 4] = m[4];
+        mp[idx + 5] = m[5];
+        mp[idx + 6] = m[6];
+        mp[idx + 7] = m[13];
+
+        mp[idx + 8] = m[8];
+        mp[idx + 9] = m[9];
+        mp[idx + 10] = m[10];
+        mp[idx + 11] = m[14];
+    }
 }
 
 // static
@@ -10574,24 +10873,95 @@ void LLVOAvatar::updateImpostors()
 {
 	LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
 
+	// Impostors due for an update, most important first, and avatars out of
+	// view that hold on to theirs for when they come back, which give up
+	// their slots first if the atlas runs out of room.
+	std::vector<std::pair<F32, LLVOAvatar*> > due;
+	std::vector<LLVOAvatar*> hidden;
+
     std::vector<LLCharacter*> instances_copy = LLCharacter::sInstances;
 	for (std::vector<LLCharacter*>::iterator iter = instances_copy.begin();
 		iter != instances_copy.end(); ++iter)
 	{
 		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
-		if (!avatar->isDead()
-			&& avatar->isVisible()
-			&& avatar->isImpostor()
-			&& avatar->needsImpostorUpdate())
+		if (avatar->isDead() || !avatar->isImpostor())
+		{
+			avatar->releaseImpostor();
+		}
+		else if (!avatar->isVisible())
+		{
+			if (avatar->hasImpostor())
+			{
+				hidden.push_back(avatar);
+			}
+		}
+		else if (avatar->needsImpostorUpdate() || !avatar->hasImpostor())
 		{
-            avatar->calcMutedAVColor();
-			gPipeline.generateImpostor(avatar);
+			due.push_back(std::make_pair(avatar->getImpostorUpdatePriority(), avatar));
 		}
 	}
 
+	std::sort(due.begin(), due.end(), [](const std::pair<F32, LLVOAvatar*>& lhs, const std::pair<F32, LLVOAvatar*>& rhs)
+	{
+		return lhs.first > rhs.first;
+	});
+
+	// the rest keep their current impostor, and their place in line
+	U32 budget = LLPipeline::RenderAvatarImpostorUpdates;
+	if (budget && due.size() > budget)
+	{
+		due.resize(budget);
+	}
+
+	std::vector<LLVOAvatar*> avatars;
+	avatars.reserve(due.size());
+	for (const std::pair<F32, LLVOAvatar*>& entry : due)
+	{
+		entry.second->calcMutedAVColor();
+		avatars.push_back(entry.second);
+	}
+	gPipeline.generateImpostors(avatars, hidden);
+
 	LLCharacter::sAllowInstancesChange = TRUE;
 }
 
+bool LLVOAvatar::hasImpostor() const
+{
+	return gPipeline.mImpostorAtlas.isValid(mImpostorSlot);
+}
+
+void LLVOAvatar::releaseImpostor()
+{
+	if (mImpostorSlot >= 0)
+	{
+		gPipeline.mImpostorAtlas.release(mImpostorSlot);
+		mImpostorSlot = -1;
+		mNeedsImpostorUpdate = TRUE;
+	}
+}
+
+F32 LLVOAvatar::getImpostorUpdatePriority() const
+{
+	F32 priority = llmax(mPixelArea, 1.f);
+	if (!hasImpostor())
+	{
+		// nothing to draw at all until it gets one
+		return priority * 1000.f;
+	}
+
+	// Bigger on screen, longer since the last update and more change in
+	// pose since then all make a stale impostor more noticeable.
+	LLVector4a extents[2];
+	extents[0].load3(mLastAnimExtents[0].mV);
+	extents[1].load3(mLastAnimExtents[1].mV);
+	extents[0].sub(mImpostorExtents[0]);
+	extents[1].sub(mImpostorExtents[1]);
+	F32 drift = llmax(extents[0].getLength3().getF32(), extents[1].getLength3().getF32());
+	F32 age = gFrameTimeSeconds - mLastImpostorUpdateFrameTime;
+
+	return priority * (1.f + age) * (1.f + drift * 10.f);
+}
+
 // virtual
 BOOL LLVOAvatar::isImpostor()
 {
@@ -40,6 +40,7 @@
 #include "lldrawpoolalpha.h"
 #include "llviewerobject.h"
 #include "llcharacter.h"
+#include "lljointhierarchy.h"
 #include "llcontrol.h"
 #include "llviewerjointmesh.h"
 #include "llviewerjointattachment.h"
@@ -132,6 +133,22 @@ public:
 													 const EObjectUpdateType update_type,
 													 LLDataPacker *dp);
 	virtual void   	 	 	idleUpdate(LLAgent &agent, const F64 &time);
+
+	// idleUpdate() in three steps, so LLViewerObjectList can update many
+	// avatars at once: beginIdleUpdate() runs the animations up to posing
+	// the skeleton, updateDeferredJoints() computes the joint transforms and
+	// may run for different avatars on different threads, and
+	// finishIdleUpdate() does everything that reads the posed skeleton.
+	// beginIdleUpdate() returns false if there is nothing more to do this
+	// frame.  Once finished, updateDeferredPalettes() can rebuild the
+	// skinning palettes for the coming frame, again on any thread.
+	bool					beginIdleUpdate(LLAgent &agent, const F64 &time, bool defer_joints);
+	void					updateDeferredJoints();
+	void					finishIdleUpdate();
+	void					updateDeferredPalettes();
+	// True if this avatar can go through the steps above alongside others.
+	bool					canDeferJoints() const;
+
 	/*virtual*/ BOOL   	 	 	updateLOD();
 	BOOL  	 	 	 	 	updateJointLODs();
 	void					updateLODRiggedAttachments( void );
@@ -278,6 +295,7 @@ public:
 	void 			idleUpdateVoiceVisualizer(bool voice_enabled);
 	void 			idleUpdateMisc(bool detailed_update);
 	virtual void	idleUpdateAppearanceAnimation();
+	void			updateMorphJobs();
 	void 			idleUpdateLipSync(bool voice_enabled);
 	void 			idleUpdateLoadingEffect();
 	void 			idleUpdateWindEffect();
@@ -365,6 +383,15 @@ public:
 
     void 			updateTooSlow();
 
+    // How much detail to stream for this avatar's attachments.  Avatars
+    // over the complexity or render time limits get their textures asked
+    // for mStreamingDiscardBias levels lower and their meshes capped at a
+    // lower LOD, more so further away and when behind the target frame rate.
+    void 			updateStreamingBudget();
+    S32 			getStreamingDiscardBias() const { return mStreamingDiscardBias; }
+    S32 			getStreamingLODCap() const;
+    F32 			getStreamingPriorityScale() const { return 1.f / (F32) (1 << mStreamingDiscardBias); }
+
 	bool 			isTooComplex() const;
 	bool 			visualParamWeightsAreDefault();
 	virtual bool	getIsCloud() const;
@@ -417,6 +444,8 @@ private:
 
     bool            mTuned{false};
 
+    S32				mStreamingDiscardBias{0};
+
 private:
 	LLViewerStats::PhaseMap mPhases;
 
@@ -439,6 +468,9 @@ public:
 	void				updateHeadOffset();
     void				debugBodySize() const;
 	void				postPelvisSetRecalc( void );
+	void				updateWorldMatrices();
+	void				updateWorldMatrices(bool flat);
+	const LLJointHierarchy& getJointHierarchy() const { return mJointHierarchy; }
 
 	/*virtual*/ BOOL	loadSkeletonNode();
     void                initAttachmentPoints(bool ignore_hud_joints = false);
@@ -451,6 +483,8 @@ public:
 	LLVector3			mTargetRootToHeadOffset;
 
 	S32					mLastSkeletonSerialNum;
+private:
+	LLJointHierarchy	mJointHierarchy; // flattened copy of mRoot's joint tree, see updateWorldMatrices()
 
 
 /**                    Skeleton
@@ -530,6 +564,12 @@ private:
 	BOOL 		mNeedsSkin; // avatar has been animated and verts have not been updated
 	F32			mLastSkinTime; //value of gFrameTimeSeconds at last skin update
 
+	bool		mDeferJointUpdate; // leave updateWorldMatrices() to updateDeferredJoints()
+	bool		mJointUpdatePending; // skeleton posed, joint transforms not yet updated
+	bool		mFlatJointUpdate; // AvatarFlatJointUpdate, read on the main thread for updateDeferredJoints()
+	bool		mPalettesPending; // finished a detailed update, palettes not yet prebuilt
+	bool		mIdleDetailedUpdate; // updateCharacter() result, for finishIdleUpdate()
+
 	S32	 		mUpdatePeriod;
 	S32  		mNumInitFaces; //number of faces generated when creating the avatar drawable, does not inculde splitted faces due to long vertex buffer.
 
@@ -599,7 +639,12 @@ public:
 	void 		setImpostorDim(const LLVector2& dim);
 	static void	resetImpostors();
 	static void updateImpostors();
-	LLRenderTarget mImpostor;
+	bool		hasImpostor() const;
+	void		releaseImpostor();
+	// Order in which impostors are regenerated when there are more due than
+	// the per frame budget allows, see updateImpostors().
+	F32			getImpostorUpdatePriority() const;
+	S32			mImpostorSlot; // in gPipeline.mImpostorAtlas, -1 if none
 	BOOL		mNeedsImpostorUpdate;
 	S32			mLastImpostorUpdateReason;
 	F32SecondsImplicit mLastImpostorUpdateFrameTime;
@@ -775,6 +820,13 @@ public:
         // Last frame this entry was updated
         U32 mFrame;
 
+        // Skin the palette was built for, to rebuild it ahead of rendering
+        LLConstPointer<LLMeshSkinInfo> mSkinInfo;
+
+        // Built ahead by prebuildMatrixPalettes(), checked against the
+        // skeleton again before it is drawn
+        bool mPrebuilt;
+
         // List of Matrix4a's for this entry
         LLMeshSkinInfo::matrix_list_t mMatrixPalette;
 
@@ -782,7 +834,8 @@ public:
         std::vector<F32> mGLMp;
 
         MatrixPaletteCache() :
-            mFrame(gFrameCount - 1)
+            mFrame(gFrameCount - 1),
+            mPrebuilt(false)
         {
         }
     };
@@ -792,6 +845,12 @@ public:
     // Will update said entry if it hasn't been updated yet this frame
     const MatrixPaletteCache& updateSkinInfoMatrixPalette(const LLMeshSkinInfo* skinInfo);
 
+    // Rebuilds the palettes used last frame for the frame about to render.
+    void prebuildMatrixPalettes();
+    // True if no joint the skin uses moved since the last joint update.
+    bool isMatrixPaletteCurrent(const LLMeshSkinInfo* skin) const;
+    void buildMatrixPalette(MatrixPaletteCache& entry, const LLMeshSkinInfo* skin);
+
     // Map of LLMeshSkinInfo::mHash to MatrixPaletteCache
     typedef std::unordered_map<U64, MatrixPaletteCache> matrix_palette_cache_t;
     matrix_palette_cache_t mMatrixPaletteCache;
@@ -86,6 +86,7 @@
 #include "llinventorytype.h"
 #include "llviewerinventory.h"
 #include "llcallstack.h"
+#include "llsculptcache.h"
 #include "llsculptidsize.h"
 #include "llavatarappearancedefines.h"
 #include "llperfstats.h" 
@@ -101,6 +102,7 @@ F32 LLVOVolume::sLODFactor = 1.f;
 F32	LLVOVolume::sLODSlopDistanceFactor = 0.5f; //Changing this to zero, effectively disables the LOD transition slop 
 F32 LLVOVolume::sDistanceFactor = 1.0f;
 S32 LLVOVolume::sNumLODChanges = 0;
+std::vector<LLPointer<LLVOVolume> > LLVOVolume::sPendingVolumeObjects;
 S32 LLVOVolume::mRenderComplexity_last = 0;
 S32 LLVOVolume::mRenderComplexity_current = 0;
 LLPointer<LLObjectMediaDataClient> LLVOVolume::sObjectMediaClient = NULL;
@@ -303,6 +305,8 @@ void LLVOVolume::markDead()
 void LLVOVolume::initClass()
 {
 	// gSavedSettings better be around
+	LLSculptCache::setMaxSize((size_t)gSavedSettings.getU32("RenderSculptCacheSize") * 1024 * 1024);
+
 	if (gSavedSettings.getBOOL("PrimMediaMasterEnabled"))
 	{
 		const F32 queue_timer_delay = gSavedSettings.getF32("PrimMediaRequestQueueDelay");
@@ -322,6 +326,8 @@ void LLVOVolume::cleanupClass()
 {
     sObjectMediaClient = NULL;
     sObjectMediaNavigateClient = NULL;
+    sPendingVolumeObjects.clear();
+    LLSculptCache::clear();
 }
 
 U32 LLVOVolume::processUpdateMessage(LLMessageSystem *mesgsys,
@@ -792,10 +798,20 @@ void LLVOVolume::updateTextureVirtualSize(bool forced)
 	const S32 num_faces = mDrawable->getNumFaces();
 	F32 min_vsize=999999999.f, max_vsize=0.f;
 	LLViewerCamera* camera = LLViewerCamera::getInstance();
+
+	// ask for less of an over budget avatar's textures, each discard level
+	// being a quarter of the pixels
+	F32 streaming_scale = 1.f;
+	LLVOAvatar* avatar = getAvatar();
+	if (avatar && avatar->getStreamingDiscardBias() > 0 && !isHUDAttachment())
+	{
+		streaming_scale = 1.f / (F32) (1 << (avatar->getStreamingDiscardBias() * 2));
+	}
 	for (S32 i = 0; i < num_faces; i++)
 	{
 		LLFace* face = mDrawable->getFace(i);
 		if (!face) continue;
+		face->setTextureStatScale(streaming_scale);
 		const LLTextureEntry *te = face->getTextureEntry();
 		LLViewerTexture *imagep = face->getTexture();
 		if (!imagep || !te ||			
@@ -1080,6 +1096,13 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
 		volume_params.setSculptID(LLUUID::null, LL_SCULPT_TYPE_NONE);
 
 	}
+	else if (last_lod != -1 && lod != last_lod && !is_flexible && !isSculpted()
+			 && volume_params == getVolume()->getParams()
+			 && waitForVolume(volume_params, lod))
+	{
+		// Keep showing the current LOD until the new one is generated
+		lod = last_lod;
+	}
 
 	if ((LLPrimitive::setVolume(volume_params, lod, (mVolumeImpl && mVolumeImpl->isVolumeUnique()))) || mSculptChanged)
 	{
@@ -1310,7 +1333,7 @@ void LLVOVolume::sculpt()
 
 		if (current_discard == discard_level)  // no work to do here
 			return;
-		
+
 		if(!raw_image)
 		{
 			llassert(discard_level < 0) ;
@@ -1525,6 +1548,12 @@ BOOL LLVOVolume::calcLOD()
     else
     {
         cur_detail = computeLODDetail(ll_round(distance, 0.01f), ll_round(radius, 0.01f), lod_factor);
+
+        LLVOAvatar* avatar = getAvatar();
+        if (avatar)
+        {
+            cur_detail = llmin(cur_detail, avatar->getStreamingLODCap());
+        }
     }
 
     if (gPipeline.hasRenderDebugMask(LLPipeline::RENDER_DEBUG_TRIANGLE_COUNT) && mDrawable->getFace(0))
@@ -4345,6 +4374,58 @@ void LLVOVolume::updateRenderComplexity()
 	mRenderComplexity_current = 0;
 }
 
+// Starts generating a prim LOD on a worker thread, returns true if the
+// caller should keep the current LOD meanwhile.
+bool LLVOVolume::waitForVolume(const LLVolumeParams &volume_params, S32 lod)
+{
+	static LLCachedControl<bool> async_generation(gSavedSettings, "RenderAsyncVolumeGeneration", true);
+	if (!async_generation)
+	{
+		return false;
+	}
+
+	LLPointer<LLVolumeRequest> request = LLPrimitive::getVolumeManager()->requestVolume(volume_params, lod);
+	if (request.isNull() || request->isReady())
+	{
+		mPendingVolume = NULL;
+		return false;
+	}
+
+	if (mPendingVolume.isNull())
+	{
+		sPendingVolumeObjects.push_back(this);
+	}
+	mPendingVolume = request;
+	return true;
+}
+
+// static
+void LLVOVolume::updatePendingVolumes()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+	for (U32 i = 0; i < sPendingVolumeObjects.size(); )
+	{
+		LLVOVolume* volobjp = sPendingVolumeObjects[i];
+		if (!volobjp->isDead() && volobjp->mPendingVolume.notNull() && !volobjp->mPendingVolume->isReady())
+		{
+			++i;
+			continue;
+		}
+
+		if (!volobjp->isDead() && volobjp->mPendingVolume.notNull() && volobjp->mDrawable.notNull())
+		{
+			// setVolume() adopts the finished LOD on the rebuild
+			gPipeline.markRebuild(volobjp->mDrawable, LLDrawable::REBUILD_VOLUME, FALSE);
+			volobjp->mLODChanged = TRUE;
+		}
+		volobjp->mPendingVolume = NULL;
+
+		sPendingVolumeObjects[i] = sPendingVolumeObjects.back();
+		sPendingVolumeObjects.pop_back();
+	}
+}
+
 U32 LLVOVolume::getTriangleCount(S32* vcount) const
 {
 	U32 count = 0;
@@ -5331,7 +5412,7 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
 		}
 	}
 
-    F32 vsize = facep->getVirtualSize(); //TODO -- adjust by texture scale?
+    F32 vsize = facep->getTextureStatSize(); //TODO -- adjust by texture scale?
 
 	if (index < FACE_DO_NOT_BATCH_TEXTURES && idx >= 0)
 	{
@@ -46,6 +46,7 @@ class LLObjectMediaDataClient;
 class LLObjectMediaNavigateClient;
 class LLVOAvatar;
 class LLMeshSkinInfo;
+class LLVolumeRequest;
 
 typedef std::vector<viewer_media_t> media_list_t;
 
@@ -400,12 +401,16 @@ protected:
 
 private:
     bool lodOrSculptChanged(LLDrawable *drawable, BOOL &compiled, BOOL &shouldUpdateOctreeBounds);
+	bool waitForVolume(const LLVolumeParams &volume_params, S32 lod);
 
 public:
 
 	static S32 getRenderComplexityMax() {return mRenderComplexity_last;}
 	static void updateRenderComplexity();
 
+	// Rebuilds objects whose asynchronously generated LOD became ready.
+	static void updatePendingVolumes();
+
 	LLViewerTextureAnim *mTextureAnimp;
 	U8 mTexAnimMode;
     F32 mLODDistance;
@@ -419,6 +424,7 @@ private:
 	LLFrameTimer mTextureUpdateTimer;
 	S32			mLOD;
 	BOOL		mLODChanged;
+	LLPointer<LLVolumeRequest> mPendingVolume;	// LOD being generated while the last one is shown
 	BOOL		mSculptChanged;
     BOOL		mColorChanged;
 	F32			mSpotLightPriority;
@@ -452,6 +458,7 @@ public:
 
 protected:
 	static S32 sNumLODChanges;
+	static std::vector<LLPointer<LLVOVolume> > sPendingVolumeObjects;
 
 	friend class LLVolumeImplFlexible;
 
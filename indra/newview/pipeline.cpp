@@ -97,6 +97,7 @@
 #include "llvotree.h"
 #include "llvopartgroup.h"
 #include "llworld.h"
+#include "llparallel.h"
 #include "llcubemap.h"
 #include "llviewershadermgr.h"
 #include "llviewerstats.h"
@@ -218,7 +219,18 @@ bool LLPipeline::CameraOffset;
 F32 LLPipeline::CameraMaxCoF;
 F32 LLPipeline::CameraDoFResScale;
 F32 LLPipeline::RenderAutoHideSurfaceAreaLimit;
+bool LLPipeline::RenderParallelPostSort;
+bool LLPipeline::RenderNearbyLightGrid;
+bool LLPipeline::RenderParallelMove;
+U32 LLPipeline::RenderAvatarImpostorAtlasSize;
+U32 LLPipeline::RenderAvatarImpostorUpdates;
 LLTrace::EventStatHandle<S64> LLPipeline::sStatBatchSize("renderbatchsize");
+LLTrace::EventStatHandle<S64> LLPipeline::sStatNearbyLightCandidates("nearbylightcandidates", "Lights looked at when picking the nearby lights");
+LLTrace::EventStatHandle<F64Milliseconds> LLPipeline::sStatNearbyLightTime("nearbylighttime", "Time spent finding new nearby lights");
+LLTrace::EventStatHandle<S64> LLPipeline::sStatMoveCount("movedrawables", "Drawables on the moved list");
+LLTrace::EventStatHandle<F64Milliseconds> LLPipeline::sStatMoveTime("movetime", "Time spent updating moved drawables");
+LLTrace::EventStatHandle<S64> LLPipeline::sStatImpostorUpdates("impostorupdates", "Avatar impostors regenerated");
+LLTrace::EventStatHandle<F64> LLPipeline::sStatImpostorAtlasUse("impostoratlasuse", "Fraction of the avatar impostor atlas in use");
 
 const F32 BACKLIGHT_DAY_MAGNITUDE_OBJECT = 0.1f;
 const F32 BACKLIGHT_NIGHT_MAGNITUDE_OBJECT = 0.08f;
@@ -613,6 +625,11 @@ void LLPipeline::init()
 	connectRefreshCachedSettingsSafe("CameraMaxCoF");
 	connectRefreshCachedSettingsSafe("CameraDoFResScale");
 	connectRefreshCachedSettingsSafe("RenderAutoHideSurfaceAreaLimit");
+	connectRefreshCachedSettingsSafe("RenderParallelPostSort");
+	connectRefreshCachedSettingsSafe("RenderNearbyLightGrid");
+	connectRefreshCachedSettingsSafe("RenderParallelMove");
+	connectRefreshCachedSettingsSafe("RenderAvatarImpostorAtlasSize");
+	connectRefreshCachedSettingsSafe("RenderAvatarImpostorUpdates");
 	gSavedSettings.getControl("RenderAutoHideSurfaceAreaLimit")->getCommitSignal()->connect(boost::bind(&LLPipeline::refreshCachedSettings));
 }
 
@@ -1144,6 +1161,11 @@ void LLPipeline::refreshCachedSettings()
 	CameraMaxCoF = gSavedSettings.getF32("CameraMaxCoF");
 	CameraDoFResScale = gSavedSettings.getF32("CameraDoFResScale");
 	RenderAutoHideSurfaceAreaLimit = gSavedSettings.getF32("RenderAutoHideSurfaceAreaLimit");
+	RenderParallelPostSort = gSavedSettings.getBOOL("RenderParallelPostSort");
+	RenderNearbyLightGrid = gSavedSettings.getBOOL("RenderNearbyLightGrid");
+	RenderParallelMove = gSavedSettings.getBOOL("RenderParallelMove");
+	RenderAvatarImpostorAtlasSize = gSavedSettings.getU32("RenderAvatarImpostorAtlasSize");
+	RenderAvatarImpostorUpdates = gSavedSettings.getU32("RenderAvatarImpostorUpdates");
 	RenderSpotLight = nullptr;
 	updateRenderDeferred();
 
@@ -1741,6 +1763,7 @@ void LLPipeline::unlinkDrawable(LLDrawable *drawable)
 	}
 
 	mLights.erase(drawablep);
+	mLightGrid.remove(drawablep);
 
 	for (light_set_t::iterator iter = mNearbyLights.begin();
 				iter != mNearbyLights.end(); iter++)
@@ -1786,6 +1809,7 @@ void LLPipeline::removeMutedAVsLights(LLVOAvatar* muted_avatar)
             && vobj->isAttachment() && vobj->getAvatar() == muted_avatar)
 		{
 			gPipeline.mLights.erase(iter->drawable);
+			gPipeline.mLightGrid.remove(iter->drawable);
 			gPipeline.mNearbyLights.erase(iter);
 		}
 	}
@@ -1945,20 +1969,77 @@ void LLPipeline::updateMoveNormalAsync(LLDrawable* drawablep)
 	}
 }
 
+// Below this many moves the transforms are worked out inline
+static const U32 MIN_PARALLEL_MOVES = 256;
+static const U32 MOVES_PER_TASK = 64;
+
+void LLPipeline::computeMoves(const LLDrawable::drawable_vector_t& moved_list)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	const U32 count = (U32)moved_list.size();
+	mMoveTargets.resize(count);
+
+	// Volumes only: avatars and bridges drag other drawables along when they
+	// move, so their order in the list matters and they stay serial.
+	const F32 lerp_amt = LLDrawable::getMoveInterpolant();
+	LL::parallel_for((count + MOVES_PER_TASK - 1) / MOVES_PER_TASK, [this, &moved_list, count, lerp_amt](U32 task)
+	{
+		const U32 end = llmin((task + 1) * MOVES_PER_TASK, count);
+		for (U32 i = task * MOVES_PER_TASK; i < end; ++i)
+		{
+			LLDrawable* drawablep = moved_list[i];
+			LLDrawable::MoveTarget& target = mMoveTargets[i];
+			target.mValid = !drawablep->isDead()
+				&& !drawablep->isState(LLDrawable::EARLY_MOVE)
+				&& !drawablep->isSpatialBridge()
+				&& drawablep->getVOVolume() != NULL;
+			if (target.mValid)
+			{
+				drawablep->computeMove(drawablep->isState(LLDrawable::MOVE_UNDAMPED), lerp_amt, target);
+			}
+		}
+	});
+}
+
 void LLPipeline::updateMovedList(LLDrawable::drawable_vector_t& moved_list)
 {
     LL_PROFILE_ZONE_SCOPED;
+
+	const U32 count = (U32)moved_list.size();
+
+	// Transforms are computed up front on worker threads when there are many
+	// of them; applying them, which rebuilds and repartitions, stays serial
+	// and in list order.
+	const bool parallel = RenderParallelMove && count >= MIN_PARALLEL_MOVES;
+	if (parallel)
+	{
+		computeMoves(moved_list);
+	}
+
+	U32 index = 0;
 	for (LLDrawable::drawable_vector_t::iterator iter = moved_list.begin();
-		 iter != moved_list.end(); )
+		 iter != moved_list.end(); ++index)
 	{
 		LLDrawable::drawable_vector_t::iterator curiter = iter++;
 		LLDrawable *drawablep = *curiter;
 		bool done = true;
 		if (!drawablep->isDead() && (!drawablep->isState(LLDrawable::EARLY_MOVE)))
 		{
-			done = drawablep->updateMove();
+			if (parallel && mMoveTargets[index].mValid)
+			{
+				done = drawablep->updateMove(&mMoveTargets[index]);
+			}
+			else
+			{
+				done = drawablep->updateMove();
+			}
 		}
 		drawablep->clearState(LLDrawable::EARLY_MOVE | LLDrawable::MOVE_UNDAMPED);
+		if (drawablep->isState(LLDrawable::LIGHT))
+		{
+			mLightGrid.update(drawablep);
+		}
 		if (done)
 		{
 			if (drawablep->isRoot() && !drawablep->isState(LLDrawable::ACTIVE))
@@ -1981,6 +2062,70 @@ void LLPipeline::updateMovedList(LLDrawable::drawable_vector_t& moved_list)
 	}
 }
 
+// Below this many moved bridges their octrees are rebounded inline
+static const U32 MIN_PARALLEL_BRIDGES = 32;
+static const U32 BRIDGES_PER_TASK = 8;
+
+static LLSpatialPartition* get_bridge_target(LLDrawable* drawablep)
+{
+	LLViewerRegion* region = drawablep->isDead() ? NULL : drawablep->getRegion();
+	return region ? region->getSpatialPartition(drawablep->asPartition()->mPartitionType) : NULL;
+}
+
+void LLPipeline::updateMovedBridges()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	LLDrawable::drawable_vector_t& moved_list = mMovedBridge;
+	const U32 count = (U32)moved_list.size();
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (RenderParallelMove && count >= MIN_PARALLEL_BRIDGES)
+	{
+		// Each bridge only rebounds its own octree, so that is done on worker
+		// threads.  Rebounding the root and moving the bridge in its region's
+		// partition stays serial below.
+		LL::parallel_for((count + BRIDGES_PER_TASK - 1) / BRIDGES_PER_TASK, [&moved_list, count](U32 task)
+		{
+			const U32 end = llmin((task + 1) * BRIDGES_PER_TASK, count);
+			for (U32 i = task * BRIDGES_PER_TASK; i < end; ++i)
+			{
+				LLDrawable* drawablep = moved_list[i];
+				if (!drawablep->isDead() && !drawablep->isState(LLDrawable::EARLY_MOVE))
+				{
+					((LLSpatialBridge*) drawablep)->reboundChildren();
+				}
+			}
+		});
+	}
+
+	if (count > 1)
+	{
+		// Reinsert the bridges one partition at a time.  Bridges only move
+		// themselves, so their order in the list does not matter.
+		std::vector<std::pair<LLSpatialPartition*, LLPointer<LLDrawable> > > batches;
+		batches.reserve(count);
+		for (U32 i = 0; i < count; ++i)
+		{
+			batches.push_back(std::make_pair(get_bridge_target(moved_list[i]), moved_list[i]));
+		}
+		std::stable_sort(batches.begin(), batches.end(),
+			[](const std::pair<LLSpatialPartition*, LLPointer<LLDrawable> >& lhs, const std::pair<LLSpatialPartition*, LLPointer<LLDrawable> >& rhs)
+			{
+				return lhs.first < rhs.first;
+			});
+		for (U32 i = 0; i < count; ++i)
+		{
+			moved_list[i] = batches[i].second;
+		}
+	}
+
+	updateMovedList(moved_list);
+}
+
 void LLPipeline::updateMove()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
@@ -2003,7 +2148,10 @@ void LLPipeline::updateMove()
 	}
 	mRetexturedList.clear();
 
+	LLTimer move_timer;
+	record(sStatMoveCount, (S64)mMovedList.size());
 	updateMovedList(mMovedList);
+	record(sStatMoveTime, F64Milliseconds(move_timer.getElapsedTimeF64() * 1000.0));
 
 	//balance octrees
 	for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin(); 
@@ -2028,6 +2176,119 @@ void LLPipeline::updateMove()
 	}
 }
 
+// *NOTE: DEBUG functionality
+// Times the move phases on a synthetic scene: num_linksets box linksets of
+// prims_per_linkset prims each are created above the agent and their roots
+// moved every frame, once with the parallel phases and once without.
+void LLPipeline::benchmarkMoves(S32 num_linksets, S32 prims_per_linkset, S32 num_frames)
+{
+	LLViewerRegion* region = gAgent.getRegion();
+	if (!region || num_linksets <= 0 || prims_per_linkset <= 0 || num_frames <= 0)
+	{
+		LL_WARNS() << "Nothing to benchmark" << LL_ENDL;
+		return;
+	}
+
+	const F32 SPACING = 4.f;
+	const F32 HEIGHT = 200.f;
+
+	LLVolumeParams volume_params;
+	volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+	volume_params.setBeginAndEndS(0.f, 1.f);
+	volume_params.setBeginAndEndT(0.f, 1.f);
+	volume_params.setRatio(1.f, 1.f);
+	volume_params.setShear(0.f, 0.f);
+
+	const S32 side = llceil(sqrtf((F32) num_linksets));
+	const LLVector3 origin = region->getPosRegionFromAgent(gAgent.getPositionAgent()) + LLVector3(0.f, 0.f, HEIGHT);
+
+	std::vector<LLPointer<LLViewerObject> > roots;
+	std::vector<LLVector3> positions;
+	std::vector<LLPointer<LLViewerObject> > objects;
+	roots.reserve(num_linksets);
+	positions.reserve(num_linksets);
+	objects.reserve(num_linksets * prims_per_linkset);
+	for (S32 i = 0; i < num_linksets; ++i)
+	{
+		LLViewerObject* root = NULL;
+		for (S32 j = 0; j < prims_per_linkset; ++j)
+		{
+			LLViewerObject* objectp = gObjectList.createObjectViewer(LL_PCODE_VOLUME, region);
+			if (!objectp)
+			{
+				break;
+			}
+			objectp->setVolume(volume_params, 0);
+			objectp->setScale(LLVector3(0.5f, 0.5f, 0.5f));
+			objectp->setNumTEs(6);
+			for (U8 te = 0; te < 6; ++te)
+			{
+				objectp->setTEImage(te, LLViewerFetchedTexture::sDefaultImagep);
+			}
+			if (root)
+			{
+				root->addChild(objectp);
+				objectp->setPosition(LLVector3(0.f, 0.f, 0.6f * j));
+			}
+			else
+			{
+				root = objectp;
+				positions.push_back(origin + LLVector3(SPACING * (i % side - side / 2), SPACING * (i / side - side / 2), 0.f));
+				root->setPositionRegion(positions.back());
+				roots.push_back(root);
+			}
+			createObject(objectp);
+			objects.push_back(objectp);
+		}
+	}
+
+	// Make the linksets active so each gets a spatial bridge, as moving
+	// linksets do, then let the initial rebuilds and moves settle.
+	for (LLViewerObject* root : roots)
+	{
+		if (root->mDrawable)
+		{
+			root->mDrawable->makeActive();
+		}
+	}
+	updateMove();
+	updateGeom(F32_MAX);
+
+	const bool parallel_move = RenderParallelMove;
+	F64 frame_ms[2] = { 0.0, 0.0 };
+	for (S32 pass = 0; pass < 2; ++pass)
+	{
+		RenderParallelMove = pass != 0;
+		LLTimer timer;
+		F64 elapsed = 0.0;
+		for (S32 frame = 0; frame < num_frames; ++frame)
+		{
+			const F32 offset = 0.1f * ((frame & 1) ? 1.f : -1.f);
+			for (size_t i = 0; i < roots.size(); ++i)
+			{
+				roots[i]->setPositionRegion(positions[i] + LLVector3(offset, 0.f, 0.f));
+				roots[i]->setRotation(LLQuaternion(offset, LLVector3::z_axis));
+			}
+
+			timer.reset();
+			updateMove();
+			updateMovedBridges();
+			elapsed += timer.getElapsedTimeF64();
+		}
+		frame_ms[pass] = elapsed * 1000.0 / num_frames;
+	}
+	RenderParallelMove = parallel_move;
+
+	LL_INFOS() << "Moved " << roots.size() << " linksets of " << prims_per_linkset << " prims for "
+		<< num_frames << " frames: " << frame_ms[0] << " ms/frame serial, "
+		<< frame_ms[1] << " ms/frame parallel" << LL_ENDL;
+
+	for (LLViewerObject* objectp : objects)
+	{
+		gObjectList.killObject(objectp);
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Culling and occlusion testing
 /////////////////////////////////////////////////////////////////////////////
@@ -2901,7 +3162,7 @@ void LLPipeline::rebuildGroups()
 
 	mGroupQ2Locked = false;
 
-	updateMovedList(mMovedBridge);
+	updateMovedBridges();
 }
 
 void LLPipeline::updateGeom(F32 max_dtime)
@@ -3001,7 +3262,7 @@ void LLPipeline::updateGeom(F32 max_dtime)
 		}
 	}	
 
-	updateMovedList(mMovedBridge);
+	updateMovedBridges();
 }
 
 void LLPipeline::markVisible(LLDrawable *drawablep, LLCamera& camera)
@@ -3149,6 +3410,8 @@ void LLPipeline::shiftObjects(const LLVector3 &offset)
 		}
 	}
 
+	mLightGrid.shift();
+
 	LLHUDText::shiftAll(offset);
 	LLHUDNameTag::shiftAll(offset);
 
@@ -3751,6 +4014,94 @@ void LLPipeline::touchTextures(LLDrawInfo* info)
     touchTexture(info->mNormalMap, info->mVSize);
 }
 
+// Packs what the render pools batch on into a radix sort key: render type,
+// shader, texture (avatar and skin for rigged batches, which upload a matrix
+// palette whenever those change), then distance so each run of identical
+// state is drawn front to back.
+static_assert(LLRenderPass::NUM_RENDER_TYPES <= 256, "render type must fit the top byte of a post sort key");
+
+static U64 post_sort_key(U32 type, const LLDrawInfo* info, F32 distance_squared)
+{
+	if (!info)
+	{
+		return (U64)type << 56;
+	}
+
+	uintptr_t state;
+	if (info->mAvatar.notNull())
+	{
+		state = ((uintptr_t)info->mAvatar.get() >> 4) * 2654435761u ^ ((uintptr_t)info->mSkinInfo >> 4);
+	}
+	else
+	{
+		state = (uintptr_t)info->mTexture.get() >> 4;
+	}
+
+	return ((U64)type << 56)
+		| ((U64)(info->mShaderMask & 0xFF) << 48)
+		| ((U64)(U32)state << 16)
+		| (U64)(ll_float_sort_key(distance_squared) >> 16);
+}
+
+// Collects the draw infos and alpha groups of mPostSortGroups[first, last).
+// Runs on worker threads, so it only reads the groups; distance updates,
+// texture stats and everything else that writes stays in postSort().
+void LLPipeline::postSortShard(LLCamera& camera, U32 first, U32 last, PostSortShard& shard)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	shard.mDrawInfos.clear();
+	shard.mAlphaGroups.clear();
+	shard.mRiggedAlphaGroups.clear();
+
+	const bool alpha = hasRenderType(LLPipeline::RENDER_TYPE_PASS_ALPHA);
+	LLVector4a origin;
+	origin.load3(camera.getOrigin().mV);
+
+	for (U32 i = first; i < last; ++i)
+	{
+		LLSpatialGroup* group = mPostSortGroups[i];
+
+		LLVector4a center = group->getObjectBounds()[0];
+		LLSpatialBridge* bridge = group->getSpatialPartition()->asBridge();
+		if (bridge)
+		{
+			center.load3(bridge->getPositionAgent().mV);
+		}
+		center.sub(origin);
+		const F32 distance_squared = center.dot3(center).getF32();
+
+		for (LLSpatialGroup::draw_map_t::iterator j = group->mDrawMap.begin(); j != group->mDrawMap.end(); ++j)
+		{
+			if (!hasRenderType(j->first))
+			{
+				continue;
+			}
+
+			LLSpatialGroup::drawmap_elem_t& src_vec = j->second;
+			for (LLSpatialGroup::drawmap_elem_t::iterator k = src_vec.begin(); k != src_vec.end(); ++k)
+			{
+				LLDrawInfo* info = *k;
+				sorted_draw_info_t item = { post_sort_key(j->first, info, distance_squared), info };
+				shard.mDrawInfos.push_back(item);
+			}
+		}
+
+		if (alpha)
+		{
+			if (group->mDrawMap.find(LLRenderPass::PASS_ALPHA) != group->mDrawMap.end())
+			{
+				shard.mAlphaGroups.push_back(group);
+			}
+
+			if (group->mDrawMap.find(LLRenderPass::PASS_ALPHA_RIGGED) != group->mDrawMap.end())
+			{ //store rigged alpha groups for LLDrawPoolAlpha prepass (skip distance update, rigged attachments use depth buffer)
+				shard.mRiggedAlphaGroups.push_back(group);
+			}
+		}
+	}
+}
+
 void LLPipeline::postSort(LLCamera& camera)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
@@ -3776,7 +4127,8 @@ void LLPipeline::postSort(LLCamera& camera)
 	LL_PUSH_CALLSTACKS();
 
 	
-	//build render map
+	//pick the groups to draw, rebuilding any that can't be drawn otherwise
+	mPostSortGroups.clear();
 	for (LLCullResult::sg_iterator i = sCull->beginVisibleGroups(); i != sCull->endVisibleGroups(); ++i)
 	{
 		LLSpatialGroup* group = *i;
@@ -3793,62 +4145,61 @@ void LLPipeline::postSort(LLCamera& camera)
 			group->rebuildGeom();
 		}
 
-		for (LLSpatialGroup::draw_map_t::iterator j = group->mDrawMap.begin(); j != group->mDrawMap.end(); ++j)
+		mPostSortGroups.push_back(group);
+	}
+
+	//gather draw infos into shards, one per worker
+	const U32 POST_SORT_GROUPS_PER_SHARD = 128;
+	const U32 MAX_POST_SORT_SHARDS = 8;
+	const U32 group_count = mPostSortGroups.size();
+	const U32 shard_count = RenderParallelPostSort ? llclamp(group_count / POST_SORT_GROUPS_PER_SHARD, (U32)1, MAX_POST_SORT_SHARDS) : 1;
+	if (mPostSortShards.size() < shard_count)
+	{
+		mPostSortShards.resize(shard_count);
+	}
+	LL::parallel_for(shard_count, [this, &camera, group_count, shard_count](U32 shard)
 		{
-			LLSpatialGroup::drawmap_elem_t& src_vec = j->second;	
-			if (!hasRenderType(j->first))
-			{
-				continue;
-			}
-			
-			for (LLSpatialGroup::drawmap_elem_t::iterator k = src_vec.begin(); k != src_vec.end(); ++k)
-			{
-                LLDrawInfo* info = *k;
-				
-				sCull->pushDrawInfo(j->first, info);
-                if (!sShadowRender && !sReflectionRender)
-                {
-                    touchTextures(info);
-                    addTrianglesDrawn(info->mCount, info->mDrawMode);
-                }
-			}
+			postSortShard(camera, group_count * shard / shard_count, group_count * (shard + 1) / shard_count, mPostSortShards[shard]);
+		});
+
+	//build render map, in one sorted pass over all shards
+	mPostSortDrawInfos.clear();
+	for (U32 shard = 0; shard < shard_count; ++shard)
+	{
+		std::vector<sorted_draw_info_t>& draw_infos = mPostSortShards[shard].mDrawInfos;
+		mPostSortDrawInfos.insert(mPostSortDrawInfos.end(), draw_infos.begin(), draw_infos.end());
+	}
+	ll_radix_sort(mPostSortDrawInfos, mPostSortDrawInfoScratch);
+
+	for (const sorted_draw_info_t& item : mPostSortDrawInfos)
+	{
+		LLDrawInfo* info = item.mValue;
+		sCull->pushDrawInfo((U32)(item.mKey >> 56), info);
+		if (!sShadowRender && !sReflectionRender)
+		{
+			touchTextures(info);
+			addTrianglesDrawn(info->mCount, info->mDrawMode);
 		}
+	}
 
-		if (hasRenderType(LLPipeline::RENDER_TYPE_PASS_ALPHA))
+	//store alpha groups for sorting
+	for (U32 shard = 0; shard < shard_count; ++shard)
+	{
+		for (LLSpatialGroup* group : mPostSortShards[shard].mAlphaGroups)
 		{
-			LLSpatialGroup::draw_map_t::iterator alpha = group->mDrawMap.find(LLRenderPass::PASS_ALPHA);
-			
-			if (alpha != group->mDrawMap.end())
-			{ //store alpha groups for sorting
-				LLSpatialBridge* bridge = group->getSpatialPartition()->asBridge();
-				if (LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD)
+			LLSpatialBridge* bridge = group->getSpatialPartition()->asBridge();
+			if (LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD)
+			{
+				if (bridge)
 				{
-					if (bridge)
-					{
-						LLCamera trans_camera = bridge->transformCamera(camera);
-						group->updateDistance(trans_camera);
-					}
-					else
-					{
-						group->updateDistance(camera);
-					}
+					LLCamera trans_camera = bridge->transformCamera(camera);
+					group->updateDistance(trans_camera);
 				}
-							
-				if (hasRenderType(LLDrawPool::POOL_ALPHA))
+				else
 				{
-					sCull->pushAlphaGroup(group);
+					group->updateDistance(camera);
 				}
 			}
-
-            LLSpatialGroup::draw_map_t::iterator rigged_alpha = group->mDrawMap.find(LLRenderPass::PASS_ALPHA_RIGGED);
-
-            if (rigged_alpha != group->mDrawMap.end())
-            { //store rigged alpha groups for LLDrawPoolAlpha prepass (skip distance update, rigged attachments use depth buffer)
-                if (hasRenderType(LLDrawPool::POOL_ALPHA))
-                {
-                    sCull->pushRiggedAlphaGroup(group);
-                }
-            }
 		}
 	}
 	
@@ -3890,13 +4241,46 @@ void LLPipeline::postSort(LLCamera& camera)
 	
 	mMeshDirtyGroup.clear();
 
-	if (!sShadowRender)
+	if (hasRenderType(LLDrawPool::POOL_ALPHA))
 	{
-        // order alpha groups by distance
-		std::sort(sCull->beginAlphaGroups(), sCull->endAlphaGroups(), LLSpatialGroup::CompareDepthGreater());
+		// order alpha groups by distance, farthest first
+		mPostSortAlphaGroups.clear();
+		for (U32 shard = 0; shard < shard_count; ++shard)
+		{
+			for (LLSpatialGroup* group : mPostSortShards[shard].mAlphaGroups)
+			{
+				sorted_group_t item = { sShadowRender ? 0 : (U64)(U32)~ll_float_sort_key(group->mDepth), group };
+				mPostSortAlphaGroups.push_back(item);
+			}
+		}
+		ll_radix_sort(mPostSortAlphaGroups, mPostSortAlphaGroupScratch);
+		for (const sorted_group_t& item : mPostSortAlphaGroups)
+		{
+			sCull->pushAlphaGroup(item.mValue);
+		}
 
-        // order rigged alpha groups by avatar attachment order
-        std::sort(sCull->beginRiggedAlphaGroups(), sCull->endRiggedAlphaGroups(), LLSpatialGroup::CompareRenderOrder());
+		// order rigged alpha groups by avatar, then attachment order
+		mPostSortAlphaGroups.clear();
+		std::unordered_map<LLVOAvatar*, U32> avatar_order;
+		for (U32 shard = 0; shard < shard_count; ++shard)
+		{
+			for (LLSpatialGroup* group : mPostSortShards[shard].mRiggedAlphaGroups)
+			{
+				U64 key = 0;
+				if (!sShadowRender)
+				{
+					U32 avatar = avatar_order.emplace(group->mAvatarp, (U32)avatar_order.size()).first->second;
+					key = ((U64)avatar << 32) | (U32)~group->mRenderOrder;
+				}
+				sorted_group_t item = { key, group };
+				mPostSortAlphaGroups.push_back(item);
+			}
+		}
+		ll_radix_sort(mPostSortAlphaGroups, mPostSortAlphaGroupScratch);
+		for (const sorted_group_t& item : mPostSortAlphaGroups)
+		{
+			sCull->pushRiggedAlphaGroup(item.mValue);
+		}
 	}
 
 	LL_PUSH_CALLSTACKS();
@@ -4857,6 +5241,13 @@ void LLPipeline::renderDebug()
 {
 	assertInitialized();
 
+	static LLControlHandle pathfinding_ambiance = gSavedSettings.getHandle("PathfindingAmbiance");
+	static LLControlHandle pathfinding_line_offset = gSavedSettings.getHandle("PathfindingLineOffset");
+	static LLControlHandle pathfinding_line_width = gSavedSettings.getHandle("PathfindingLineWidth");
+	static LLControlHandle pathfinding_xray_tint = gSavedSettings.getHandle("PathfindingXRayTint");
+	static LLControlHandle pathfinding_xray_opacity = gSavedSettings.getHandle("PathfindingXRayOpacity");
+	static LLControlHandle pathfinding_xray_wireframe = gSavedSettings.getHandle("PathfindingXRayWireframe");
+
 	bool hud_only = hasRenderType(LLPipeline::RENDER_TYPE_HUD);
 
 	if (!hud_only )
@@ -4907,7 +5298,7 @@ void LLPipeline::renderDebug()
 
 				if ( pathfindingConsole->getVisible() || gAgentCamera.cameraMouselook() )
 				{				
-					F32 ambiance = gSavedSettings.getF32("PathfindingAmbiance");
+					F32 ambiance = gSavedSettings.getF32(pathfinding_ambiance);
 
 					gPathfindingProgram.bind();
 			
@@ -5037,18 +5428,18 @@ void LLPipeline::renderDebug()
 								LLGLEnable lineOffset(GL_POLYGON_OFFSET_LINE);
 								glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );	
 						
-								F32 offset = gSavedSettings.getF32("PathfindingLineOffset");
+								F32 offset = gSavedSettings.getF32(pathfinding_line_offset);
 
 								if (pathfindingConsole->isRenderXRay())
 								{
-									gPathfindingProgram.uniform1f(sTint, gSavedSettings.getF32("PathfindingXRayTint"));
-									gPathfindingProgram.uniform1f(sAlphaScale, gSavedSettings.getF32("PathfindingXRayOpacity"));
+									gPathfindingProgram.uniform1f(sTint, gSavedSettings.getF32(pathfinding_xray_tint));
+									gPathfindingProgram.uniform1f(sAlphaScale, gSavedSettings.getF32(pathfinding_xray_opacity));
 									LLGLEnable blend(GL_BLEND);
 									LLGLDepthTest depth(GL_TRUE, GL_FALSE, GL_GREATER);
 								
 									glPolygonOffset(offset, -offset);
 								
-									if (gSavedSettings.getBOOL("PathfindingXRayWireframe"))
+									if (gSavedSettings.getBOOL(pathfinding_xray_wireframe))
 									{ //draw hidden wireframe as darker and less opaque
 										gPathfindingProgram.uniform1f(sAmbiance, 1.f);
 										llPathingLibInstance->renderNavMeshShapesVBO( render_order[i] );				
@@ -5068,7 +5459,7 @@ void LLPipeline::renderDebug()
 									gPathfindingProgram.uniform1f(sTint, 1.f);
 									gPathfindingProgram.uniform1f(sAlphaScale, 1.f);
 
-									glLineWidth(gSavedSettings.getF32("PathfindingLineWidth"));
+									glLineWidth(gSavedSettings.getF32(pathfinding_line_width));
 									LLGLDisable blendOut(GL_BLEND);
 									llPathingLibInstance->renderNavMeshShapesVBO( render_order[i] );				
 									gGL.flush();
@@ -5084,12 +5475,12 @@ void LLPipeline::renderDebug()
 
 					if ( pathfindingConsole->isRenderNavMesh() && pathfindingConsole->isRenderXRay() )
 					{	//render navmesh xray
-						F32 ambiance = gSavedSettings.getF32("PathfindingAmbiance");
+						F32 ambiance = gSavedSettings.getF32(pathfinding_ambiance);
 
 						LLGLEnable lineOffset(GL_POLYGON_OFFSET_LINE);
 						LLGLEnable polyOffset(GL_POLYGON_OFFSET_FILL);
 											
-						F32 offset = gSavedSettings.getF32("PathfindingLineOffset");
+						F32 offset = gSavedSettings.getF32(pathfinding_line_offset);
 						glPolygonOffset(offset, -offset);
 
 						LLGLEnable blend(GL_BLEND);
@@ -5098,10 +5489,10 @@ void LLPipeline::renderDebug()
 						glLineWidth(2.0f);	
 						LLGLEnable cull(GL_CULL_FACE);
 																		
-						gPathfindingProgram.uniform1f(sTint, gSavedSettings.getF32("PathfindingXRayTint"));
-						gPathfindingProgram.uniform1f(sAlphaScale, gSavedSettings.getF32("PathfindingXRayOpacity"));
+						gPathfindingProgram.uniform1f(sTint, gSavedSettings.getF32(pathfinding_xray_tint));
+						gPathfindingProgram.uniform1f(sAlphaScale, gSavedSettings.getF32(pathfinding_xray_opacity));
 								
-						if (gSavedSettings.getBOOL("PathfindingXRayWireframe"))
+						if (gSavedSettings.getBOOL(pathfinding_xray_wireframe))
 						{ //draw hidden wireframe as darker and less opaque
 							glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );	
 							gPathfindingProgram.uniform1f(sAmbiance, 1.f);
@@ -5116,8 +5507,8 @@ void LLPipeline::renderDebug()
 
 						//render edges
 						gPathfindingNoNormalsProgram.bind();
-						gPathfindingNoNormalsProgram.uniform1f(sTint, gSavedSettings.getF32("PathfindingXRayTint"));
-						gPathfindingNoNormalsProgram.uniform1f(sAlphaScale, gSavedSettings.getF32("PathfindingXRayOpacity"));
+						gPathfindingNoNormalsProgram.uniform1f(sTint, gSavedSettings.getF32(pathfinding_xray_tint));
+						gPathfindingNoNormalsProgram.uniform1f(sAlphaScale, gSavedSettings.getF32(pathfinding_xray_opacity));
 						llPathingLibInstance->renderNavMeshEdges();
 						gPathfindingProgram.bind();
 					
@@ -5947,6 +6338,9 @@ void LLPipeline::setupAvatarLights(bool for_edit)
 	}
 }
 
+// Lights re-bucketed per frame in case they moved without an updateMove()
+static const U32 LIGHT_GRID_REVALIDATE_COUNT = 64;
+
 static F32 calc_light_dist(LLVOVolume* light, const LLVector3& cam_pos, F32 max_dist)
 {
 	F32 inten = light->getLightIntensity();
@@ -6065,44 +6459,119 @@ void LLPipeline::calcNearbyLights(LLCamera& camera)
 		mNearbyLights = cur_nearby_lights;
 				
 		// FIND NEW LIGHTS THAT ARE IN RANGE
-		light_set_t new_nearby_lights;
-		for (LLDrawable::drawable_set_t::iterator iter = mLights.begin();
-			 iter != mLights.end(); ++iter)
+		LLTimer find_timer;
+		S64 candidates = 0;
+
+		// Forward rendering only has MAX_LOCAL_LIGHTS slots: keep the closest
+		// candidates in a max-heap whose top is the farthest one kept, and
+		// don't spend a slot on a light that can't touch the view.
+		const bool bounded = !LLPipeline::sRenderDeferred;
+		mNewLights.clear();
+		auto consider = [&](LLDrawable* drawable)
 		{
-			LLDrawable* drawable = *iter;
+			++candidates;
 			LLVOVolume* light = drawable->getVOVolume();
 			if (!light || drawable->isState(LLDrawable::NEARBY_LIGHT))
 			{
-				continue;
+				return;
 			}
 			if (light->isHUDAttachment())
 			{
-				continue; // no lighting from HUD objects
+				return; // no lighting from HUD objects
 			}
             if (!sRenderAttachedLights && light && light->isAttachment())
 			{
-				continue;
+				return;
 			}
             LLVOAvatar * av = light->getAvatar();
             if (av && (av->isTooComplex() || av->isInMuteList() || av->isTooSlow()))
             {
                 // avatars that are already in the list will be removed by removeMutedAVsLights
-                continue;
+                return;
             }
             F32 dist = calc_light_dist(light, cam_pos, max_dist);
             if (dist >= max_dist)
 			{
-				continue;
+				return;
+			}
+			if (bounded && RenderNearbyLightGrid && !light->isSelected()
+				&& !camera.sphereInFrustum(light->getRenderPosition(), light->getLightRadius() * 1.5f))
+			{
+				return;
+			}
+			mNewLights.push_back(Light(drawable, dist, 0.f));
+            if (bounded)
+			{
+				std::push_heap(mNewLights.begin(), mNewLights.end(), Light::compare());
+				if (mNewLights.size() > (U32)MAX_LOCAL_LIGHTS)
+				{
+					std::pop_heap(mNewLights.begin(), mNewLights.end(), Light::compare());
+					mNewLights.pop_back();
+					max_dist = mNewLights.front().dist;
+				}
+			}
+		};
+
+		if (RenderNearbyLightGrid)
+		{
+			mLightGrid.revalidate(LIGHT_GRID_REVALIDATE_COUNT);
+
+			// selected lights get the highest priority wherever they are, so
+			// they are looked at here and skipped below
+			LLObjectSelectionHandle selection = LLSelectMgr::getInstance()->getSelection();
+			for (LLObjectSelection::iterator iter = selection->begin(); iter != selection->end(); ++iter)
+			{
+				LLViewerObject* object = (*iter)->getObject();
+				if (object && object->isSelected() && object->mDrawable.notNull()
+					&& object->mDrawable->isState(LLDrawable::LIGHT))
+				{
+					consider(object->mDrawable);
+				}
+			}
+
+			// lights moving with their parent are not bucketed
+			const LLLightGrid::light_list_t& dynamic_lights = mLightGrid.getDynamicLights();
+			for (U32 i = 0; i < dynamic_lights.size(); ++i)
+			{
+				LLDrawable* drawable = dynamic_lights[i];
+				if (!drawable->getVObj() || !drawable->getVObj()->isSelected())
+				{
+					consider(drawable);
+				}
+			}
+
+			mLightGrid.getCells(camera, max_dist, bounded, mLightCells);
+			for (U32 i = 0; i < mLightCells.size(); ++i)
+			{
+				if (mLightCells[i].mDist >= max_dist)
+				{
+					break; // cells are nearest first and the heap is full
+				}
+				const LLLightGrid::light_list_t& lights = mLightCells[i].mCell->mLights;
+				for (U32 j = 0; j < lights.size(); ++j)
+				{
+					LLDrawable* drawable = lights[j];
+					if (!drawable->getVObj() || !drawable->getVObj()->isSelected())
+					{
+						consider(drawable);
+					}
+				}
 			}
-			new_nearby_lights.insert(Light(drawable, dist, 0.f));
-            if (!LLPipeline::sRenderDeferred && new_nearby_lights.size() > (U32)MAX_LOCAL_LIGHTS)
+		}
+		else
+		{
+			for (LLDrawable::drawable_set_t::iterator iter = mLights.begin();
+				 iter != mLights.end(); ++iter)
 			{
-				new_nearby_lights.erase(--new_nearby_lights.end());
-				const Light& last = *new_nearby_lights.rbegin();
-				max_dist = last.dist;
+				consider(*iter);
 			}
 		}
 
+		light_set_t new_nearby_lights(mNewLights.begin(), mNewLights.end());
+		mNewLights.clear();
+		record(sStatNearbyLightCandidates, candidates);
+		record(sStatNearbyLightTime, F64Milliseconds(find_timer.getElapsedTimeF64() * 1000.0));
+
 		// INSERT ANY NEW LIGHTS
 		for (light_set_t::iterator iter = new_nearby_lights.begin();
 			 iter != new_nearby_lights.end(); iter++)
@@ -6696,15 +7165,25 @@ void LLPipeline::setLight(LLDrawable *drawablep, bool is_light)
 		{
 			mLights.insert(drawablep);
 			drawablep->setState(LLDrawable::LIGHT);
+			mLightGrid.update(drawablep);
 		}
 		else
 		{
 			drawablep->clearState(LLDrawable::LIGHT);
 			mLights.erase(drawablep);
+			mLightGrid.remove(drawablep);
 		}
 	}
 }
 
+void LLPipeline::markLightMoved(LLDrawable *drawablep)
+{
+	if (drawablep && drawablep->isState(LLDrawable::LIGHT) && assertInitialized())
+	{
+		mLightGrid.update(drawablep);
+	}
+}
+
 //static
 void LLPipeline::toggleRenderType(U32 type)
 {
@@ -8864,7 +9343,8 @@ void LLPipeline::renderDeferredLighting(LLRenderTarget *screen_target)
 
         gDeferredPostGammaCorrectProgram.uniform2f(LLShaderMgr::DEFERRED_SCREEN_RES, screen_target->getWidth(), screen_target->getHeight());
 
-        F32 gamma = gSavedSettings.getF32("RenderDeferredDisplayGamma");
+        static LLControlHandle display_gamma = gSavedSettings.getHandle("RenderDeferredDisplayGamma");
+        F32 gamma = gSavedSettings.getF32(display_gamma);
 
         gDeferredPostGammaCorrectProgram.uniform1f(LLShaderMgr::DISPLAY_GAMMA, (gamma > 0.1f) ? 1.0f / gamma : (1.0f / 2.2f));
 
@@ -9632,7 +10112,8 @@ void LLPipeline::renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera
 
         gGL.diffuseColor4f(1, 1, 1, 1);
 
-        S32 shadow_detail = gSavedSettings.getS32("RenderShadowDetail");
+        static LLControlHandle render_shadow_detail = gSavedSettings.getHandle("RenderShadowDetail");
+        S32 shadow_detail = gSavedSettings.getS32(render_shadow_detail);
 
         // if not using VSM, disable color writes
         if (shadow_detail <= 2)
@@ -10868,6 +11349,59 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
                               << " is " << ( too_complex ? "" : "not ") << "too complex"
                               << LL_ENDL;
 
+	LLViewerCamera* viewer_camera = LLViewerCamera::getInstance();
+
+	LLCamera camera = *viewer_camera;
+	LLVector2 tdim;
+	U32 resY = 0;
+	U32 resX = 0;
+	F32 fov = 0.f;
+	F32 aspect = 1.f;
+
+    if (!preview_avatar)
+	{
+		const LLVector4a* ext = avatar->mDrawable->getSpatialExtents();
+		LLVector3 pos(avatar->getRenderPosition()+avatar->getImpostorOffset());
+
+		camera.lookAt(viewer_camera->getOrigin(), pos, viewer_camera->getUpAxis());
+	
+		LLVector4a half_height;
+		half_height.setSub(ext[1], ext[0]);
+		half_height.mul(0.5f);
+
+		LLVector4a left;
+		left.load3(camera.getLeftAxis().mV);
+		left.mul(left);
+		llassert(left.dot3(left).getF32() > F_APPROXIMATELY_ZERO);
+		left.normalize3fast();
+
+		LLVector4a up;
+		up.load3(camera.getUpAxis().mV);
+		up.mul(up);
+		llassert(up.dot3(up).getF32() > F_APPROXIMATELY_ZERO);
+		up.normalize3fast();
+
+		tdim.mV[0] = fabsf(half_height.dot3(left).getF32());
+		tdim.mV[1] = fabsf(half_height.dot3(up).getF32());
+
+		F32 distance = (pos-camera.getOrigin()).length();
+		fov = atanf(tdim.mV[1]/distance)*2.f*RAD_TO_DEG;
+		aspect = tdim.mV[0]/tdim.mV[1];
+
+		// get the number of pixels per angle
+		F32 pa = gViewerWindow->getWindowHeightRaw() / (RAD_TO_DEG * viewer_camera->getView());
+
+		//get resolution based on angle width and height of impostor (double desired resolution to prevent aliasing)
+		resY = llmin(nhpo2((U32) (fov*pa)), (U32) 512);
+		resX = llmin(nhpo2((U32) (atanf(tdim.mV[0]/distance)*2.f*RAD_TO_DEG*pa)), (U32) 512);
+
+		if (!placeImpostor(avatar, resX, resY))
+		{
+			// atlas is full, try again next time
+			return;
+		}
+	}
+
     pushRenderTypeMask();
 
     if (visually_muted || too_complex)
@@ -10907,8 +11441,6 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	sShadowRender = true;
 	sImpostorRender = true;
 
-	LLViewerCamera* viewer_camera = LLViewerCamera::getInstance();
-
 	{
 		markVisible(avatar->mDrawable, *viewer_camera);
 
@@ -10976,44 +11508,16 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	}
 
 	stateSort(*LLViewerCamera::getInstance(), result);
-	
-	LLCamera camera = *viewer_camera;
-	LLVector2 tdim;
-	U32 resY = 0;
-	U32 resX = 0;
+
+	// the whole slot, used or not, so a smaller impostor than last time
+	// doesn't leave stale pixels around it
+	LLGLState scissor(GL_SCISSOR_TEST, preview_avatar ? LLGLState::CURRENT_STATE : TRUE);
 
     if (!preview_avatar)
 	{
-		const LLVector4a* ext = avatar->mDrawable->getSpatialExtents();
-		LLVector3 pos(avatar->getRenderPosition()+avatar->getImpostorOffset());
-
-		camera.lookAt(viewer_camera->getOrigin(), pos, viewer_camera->getUpAxis());
-	
-		LLVector4a half_height;
-		half_height.setSub(ext[1], ext[0]);
-		half_height.mul(0.5f);
-
-		LLVector4a left;
-		left.load3(camera.getLeftAxis().mV);
-		left.mul(left);
-		llassert(left.dot3(left).getF32() > F_APPROXIMATELY_ZERO);
-		left.normalize3fast();
-
-		LLVector4a up;
-		up.load3(camera.getUpAxis().mV);
-		up.mul(up);
-		llassert(up.dot3(up).getF32() > F_APPROXIMATELY_ZERO);
-		up.normalize3fast();
-
-		tdim.mV[0] = fabsf(half_height.dot3(left).getF32());
-		tdim.mV[1] = fabsf(half_height.dot3(up).getF32());
-
 		gGL.matrixMode(LLRender::MM_PROJECTION);
 		gGL.pushMatrix();
 	
-		F32 distance = (pos-camera.getOrigin()).length();
-		F32 fov = atanf(tdim.mV[1]/distance)*2.f*RAD_TO_DEG;
-		F32 aspect = tdim.mV[0]/tdim.mV[1];
 		glh::matrix4f persp = gl_perspective(fov, aspect, 1.f, 256.f);
 		set_current_projection(persp);
 		gGL.loadMatrix(persp.m);
@@ -11030,33 +11534,23 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 
 		glClearColor(0.0f,0.0f,0.0f,0.0f);
 		gGL.setColorMask(true, true);
-	
-		// get the number of pixels per angle
-		F32 pa = gViewerWindow->getWindowHeightRaw() / (RAD_TO_DEG * viewer_camera->getView());
 
-		//get resolution based on angle width and height of impostor (double desired resolution to prevent aliasing)
-		resY = llmin(nhpo2((U32) (fov*pa)), (U32) 512);
-		resX = llmin(nhpo2((U32) (atanf(tdim.mV[0]/distance)*2.f*RAD_TO_DEG*pa)), (U32) 512);
+		// mImpostorTarget is bound by generateImpostors(), draw into this
+		// avatar's slot of it
+		const S32 slot = avatar->mImpostorSlot;
+		const U32 slot_x = mImpostorAtlas.getSlotX(slot);
+		const U32 slot_y = mImpostorAtlas.getSlotY(slot);
+		const U32 slot_size = mImpostorAtlas.getSlotSize(slot);
+		glScissor(slot_x, slot_y, slot_size, slot_size);
+		glViewport(slot_x, slot_y, mImpostorAtlas.getUsedWidth(slot), mImpostorAtlas.getUsedHeight(slot));
 
-		if (!avatar->mImpostor.isComplete())
-		{
-            avatar->mImpostor.allocate(resX, resY, GL_RGBA, TRUE, FALSE);
-
-			if (LLPipeline::sRenderDeferred)
-			{
-				addDeferredAttachments(avatar->mImpostor, true);
-			}
-		
-			gGL.getTexUnit(0)->bind(&avatar->mImpostor);
-			gGL.getTexUnit(0)->setTextureFilteringOption(LLTexUnit::TFO_POINT);
-			gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
-		}
-		else if(resX != avatar->mImpostor.getWidth() || resY != avatar->mImpostor.getHeight())
+		if (LLPipeline::sRenderDeferred)
 		{
-			avatar->mImpostor.resize(resX,resY);
+			// the previous impostor's alpha mask left only the first one bound
+			static const GLenum drawbuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+			LL_PROFILER_GPU_ZONEC( "gl.DrawBuffersARB", 0x8000FF );
+			glDrawBuffersARB(llmin(mImpostorTarget.getNumTextures(), (U32) (sizeof(drawbuffers) / sizeof(drawbuffers[0]))), drawbuffers);
 		}
-
-		avatar->mImpostor.bindTarget();
 	}
 
 	F32 old_alpha = LLDrawPoolAvatar::sMinimumAlpha;
@@ -11081,7 +11575,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
     }
     else if (LLPipeline::sRenderDeferred)
 	{
-		avatar->mImpostor.clear();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 		renderGeomDeferred(camera);
 
 		renderGeomPostDeferred(camera);		
@@ -11103,9 +11597,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	}
 	else
 	{
-		LLGLEnable scissor(GL_SCISSOR_TEST);
-		glScissor(0, 0, resX, resY);
-		avatar->mImpostor.clear();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 		renderGeom(camera);
 
 		// Shameless hack time: render it all again,
@@ -11190,7 +11682,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 
     if (!preview_avatar)
     {
-        avatar->mImpostor.flush();
+        gGL.flush();
         avatar->setImpostorDim(tdim);
     }
 
@@ -11217,6 +11709,113 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	LLGLState::checkTextureChannels();
 }
 
+void LLPipeline::generateImpostors(const std::vector<LLVOAvatar*>& avatars, const std::vector<LLVOAvatar*>& hidden)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	if (avatars.empty() || !allocateImpostorAtlas())
+	{
+		return;
+	}
+
+	// one bind and flush for all of them, each draws into its own slot
+	mImpostorTarget.bindTarget();
+
+	size_t evict = 0;
+	S64 count = 0;
+	for (LLVOAvatar* avatar : avatars)
+	{
+		if (avatar->isDead())
+		{
+			continue;
+		}
+
+		generateImpostor(avatar);
+
+		// out of room, make some by dropping the impostors of avatars out
+		// of view and try once more
+		while (!avatar->hasImpostor() && evict < hidden.size())
+		{
+			hidden[evict++]->releaseImpostor();
+			generateImpostor(avatar);
+		}
+
+		if (avatar->hasImpostor())
+		{
+			++count;
+		}
+	}
+
+	mImpostorTarget.flush();
+
+	record(sStatImpostorUpdates, count);
+	record(sStatImpostorAtlasUse, (F64) mImpostorAtlas.getAllocatedArea() / (F64) (mImpostorAtlas.getSize() * mImpostorAtlas.getSize()));
+}
+
+void LLPipeline::releaseImpostorAtlas()
+{
+	mImpostorTarget.release();
+	mImpostorAtlas.clear();
+}
+
+bool LLPipeline::allocateImpostorAtlas()
+{
+	const U32 size = llclamp(nhpo2(RenderAvatarImpostorAtlasSize), (U32) 512, gGLManager.mGLMaxTextureSize > 0 ? (U32) gGLManager.mGLMaxTextureSize : (U32) 4096);
+	if (mImpostorTarget.isComplete()
+		&& mImpostorAtlas.getSize() == size
+		&& (mImpostorTarget.getNumTextures() > 1) == sRenderDeferred)
+	{
+		return true;
+	}
+
+	// all current impostors go with the old target
+	LLVOAvatar::resetImpostors();
+
+	if (!mImpostorTarget.allocate(size, size, GL_RGBA, TRUE, FALSE))
+	{
+		LL_WARNS() << "Failed to allocate " << size << "x" << size << " impostor atlas" << LL_ENDL;
+		releaseImpostorAtlas();
+		return false;
+	}
+
+	if (sRenderDeferred)
+	{
+		addDeferredAttachments(mImpostorTarget, true);
+	}
+
+	gGL.getTexUnit(0)->bind(&mImpostorTarget);
+	gGL.getTexUnit(0)->setTextureFilteringOption(LLTexUnit::TFO_POINT);
+	gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
+
+	mImpostorAtlas.init(size, 32);
+	return true;
+}
+
+bool LLPipeline::placeImpostor(LLVOAvatar* avatar, U32 width, U32 height)
+{
+	S32& slot = avatar->mImpostorSlot;
+	if (!mImpostorAtlas.isValid(slot)
+		|| mImpostorAtlas.getSlotSize(slot) != llclamp(llmax(width, height), (U32) 32, mImpostorAtlas.getSize()))
+	{
+		// missing or the wrong size now, move it; the old slot is only given
+		// up once there is a new one, so the avatar keeps its last image if
+		// the atlas is full
+		S32 new_slot = mImpostorAtlas.allocate(width, height);
+		if (new_slot < 0)
+		{
+			return false;
+		}
+		if (mImpostorAtlas.isValid(slot))
+		{
+			mImpostorAtlas.release(slot);
+		}
+		slot = new_slot;
+	}
+
+	mImpostorAtlas.setUsed(slot, width, height);
+	return true;
+}
+
 bool LLPipeline::hasRenderBatches(const U32 type) const
 {
 	return sCull->getRenderMapSize(type) > 0;
@@ -37,7 +37,10 @@
 #include "lldrawpoolmaterials.h"
 #include "llgl.h"
 #include "lldrawable.h"
+#include "llimpostoratlas.h"
+#include "lllightgrid.h"
 #include "llrendertarget.h"
+#include "llradixsort.h"
 
 #include <stack>
 
@@ -135,6 +138,11 @@ public:
 	
 	void resetVertexBuffers(LLDrawable* drawable);
 	void generateImpostor(LLVOAvatar* avatar, bool preview_avatar = false);
+	// Renders the impostors of avatars, in order, into mImpostorTarget.
+	// Slots held by avatars in hidden are given up if the atlas runs out of
+	// room.
+	void generateImpostors(const std::vector<LLVOAvatar*>& avatars, const std::vector<LLVOAvatar*>& hidden);
+	void releaseImpostorAtlas();
 	void bindScreenToTexture();
 	void renderFinalize();
 
@@ -236,6 +244,9 @@ public:
 	void updateMoveDampedAsync(LLDrawable* drawablep);
 	void updateMoveNormalAsync(LLDrawable* drawablep);
 	void updateMovedList(LLDrawable::drawable_vector_t& move_list);
+	void computeMoves(const LLDrawable::drawable_vector_t& move_list);
+	void updateMovedBridges();
+	void benchmarkMoves(S32 num_linksets, S32 prims_per_linkset, S32 num_frames); // *NOTE: DEBUG functionality
 	void updateMove();
 	bool visibleObjectsInFrustum(LLCamera& camera);
 	bool getVisibleExtents(LLCamera& camera, LLVector3 &min, LLVector3& max);
@@ -332,6 +343,7 @@ public:
 	void shiftObjects(const LLVector3 &offset);
 
 	void setLight(LLDrawable *drawablep, bool is_light);
+	void markLightMoved(LLDrawable *drawablep);
 	
 	bool hasRenderBatches(const U32 type) const;
 	LLCullResult::drawinfo_iterator beginRenderMap(U32 type);
@@ -438,6 +450,8 @@ private:
 	void hideDrawable( LLDrawable *pDrawable );
 	void unhideDrawable( LLDrawable *pDrawable );
     void skipRenderingShadows();
+	bool allocateImpostorAtlas();
+	bool placeImpostor(LLVOAvatar* avatar, U32 width, U32 height);
 public:
 	enum {GPU_CLASS_MAX = 3 };
 
@@ -633,6 +647,12 @@ public:
     static F32              sDistortionWaterClipPlaneMargin;
 
 	static LLTrace::EventStatHandle<S64> sStatBatchSize;
+	static LLTrace::EventStatHandle<S64> sStatNearbyLightCandidates;
+	static LLTrace::EventStatHandle<F64Milliseconds> sStatNearbyLightTime;
+	static LLTrace::EventStatHandle<S64> sStatMoveCount;
+	static LLTrace::EventStatHandle<F64Milliseconds> sStatMoveTime;
+	static LLTrace::EventStatHandle<S64> sStatImpostorUpdates;
+	static LLTrace::EventStatHandle<F64> sStatImpostorAtlasUse;
 
 	//screen texture
 	U32 					mScreenWidth;
@@ -689,6 +709,10 @@ public:
 
     LLRenderTarget				mBake;
 
+	//avatar impostors, laid out by mImpostorAtlas
+	LLRenderTarget				mImpostorTarget;
+	LLImpostorAtlas				mImpostorAtlas;
+
 	//texture for making the glow
 	LLRenderTarget				mGlow[3];
 
@@ -724,6 +748,7 @@ protected:
 	//
 	LLDrawable::drawable_vector_t	mMovedList;
 	LLDrawable::drawable_vector_t mMovedBridge;
+	std::vector<LLDrawable::MoveTarget> mMoveTargets; // indexed like the list passed to updateMovedList
 	LLDrawable::drawable_vector_t	mShiftList;
 
 	/////////////////////////////////////////////
@@ -755,6 +780,9 @@ protected:
 	typedef std::set< Light, Light::compare > light_set_t;
 	
 	LLDrawable::drawable_set_t		mLights;
+	LLLightGrid						mLightGrid; // spatial index of mLights
+	LLLightGrid::cell_list_t		mLightCells; // scratch for calcNearbyLights
+	std::vector<Light>				mNewLights; // scratch for calcNearbyLights
 	light_set_t						mNearbyLights; // lights near camera
 	LLColor4						mHWLightColors[8];
 	
@@ -770,6 +798,23 @@ protected:
 	LLSpatialGroup::sg_vector_t		mGroupSaveQ1; // a place to save mGroupQ1 until it is safe to unref
 
 	LLSpatialGroup::sg_vector_t		mMeshDirtyGroup; //groups that need rebuildMesh called
+
+	// postSort() working storage, kept between frames to reuse allocations
+	typedef LLRadixSortItem<LLDrawInfo*> sorted_draw_info_t;
+	typedef LLRadixSortItem<LLSpatialGroup*> sorted_group_t;
+	struct PostSortShard
+	{
+		std::vector<sorted_draw_info_t>	mDrawInfos;
+		std::vector<LLSpatialGroup*>	mAlphaGroups;
+		std::vector<LLSpatialGroup*>	mRiggedAlphaGroups;
+	};
+	std::vector<LLSpatialGroup*>	mPostSortGroups;
+	std::vector<PostSortShard>		mPostSortShards;
+	std::vector<sorted_draw_info_t>	mPostSortDrawInfos;
+	std::vector<sorted_draw_info_t>	mPostSortDrawInfoScratch;
+	std::vector<sorted_group_t>		mPostSortAlphaGroups;
+	std::vector<sorted_group_t>		mPostSortAlphaGroupScratch;
+	void postSortShard(LLCamera& camera, U32 first, U32 last, PostSortShard& shard);
 	U32 mMeshDirtyQueryObject;
 
 	LLDrawable::drawable_list_t		mPartitionQ; //drawables that need to update their spatial partition radius 
@@ -981,6 +1026,11 @@ public:
 	static F32 CameraMaxCoF;
 	static F32 CameraDoFResScale;
 	static F32 RenderAutoHideSurfaceAreaLimit;
+	static bool RenderParallelPostSort;
+	static bool RenderNearbyLightGrid;
+	static bool RenderParallelMove;
+	static U32 RenderAvatarImpostorAtlasSize;
+	static U32 RenderAvatarImpostorUpdates;
 };
 
 void render_bbox(const LLVector3 &min, const LLVector3 &max);
@@ -0,0 +1,159 @@
+/**
+ * @file llimpostoratlas_test.cpp
+ * @brief LLImpostorAtlas tests
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+// Precompiled header
+#include "../llviewerprecompiledheaders.h"
+
+#include "../test/lltut.h"
+
+#include "../llimpostoratlas.h"
+
+#include <vector>
+
+namespace tut
+{
+	struct impostoratlas
+	{
+		// True if no two live slots overlap and all lie inside the atlas.
+		bool disjoint(const LLImpostorAtlas& atlas, const std::vector<S32>& slots)
+		{
+			for (size_t i = 0; i < slots.size(); ++i)
+			{
+				U32 ax = atlas.getSlotX(slots[i]);
+				U32 ay = atlas.getSlotY(slots[i]);
+				U32 as = atlas.getSlotSize(slots[i]);
+				if (ax + as > atlas.getSize() || ay + as > atlas.getSize())
+				{
+					return false;
+				}
+				for (size_t j = i + 1; j < slots.size(); ++j)
+				{
+					U32 bx = atlas.getSlotX(slots[j]);
+					U32 by = atlas.getSlotY(slots[j]);
+					U32 bs = atlas.getSlotSize(slots[j]);
+					if (ax < bx + bs && bx < ax + as && ay < by + bs && by < ay + as)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+	};
+	typedef test_group<impostoratlas> impostoratlas_t;
+	typedef impostoratlas_t::object impostoratlas_object_t;
+	tut::impostoratlas_t tut_impostoratlas("LLImpostorAtlas");
+
+	template<> template<>
+	void impostoratlas_object_t::test<1>()
+	{
+		set_test_name("slot sizes");
+
+		LLImpostorAtlas atlas;
+		ensure_equals("uninitialized atlas is full", atlas.allocate(64, 64), -1);
+
+		atlas.init(1024, 32);
+		S32 tall = atlas.allocate(100, 200);
+		ensure("allocated", atlas.isValid(tall));
+		ensure_equals("rounded up to a power of two", atlas.getSlotSize(tall), 256U);
+
+		S32 tiny = atlas.allocate(3, 5);
+		ensure_equals("no smaller than the minimum", atlas.getSlotSize(tiny), 32U);
+
+		S32 huge = atlas.allocate(4096, 4096);
+		ensure("oversized request fails over to a smaller slot", atlas.isValid(huge));
+		ensure("smaller than the whole atlas", atlas.getSlotSize(huge) < 1024U);
+
+		std::vector<S32> slots = { tall, tiny, huge };
+		ensure("disjoint", disjoint(atlas, slots));
+	}
+
+	template<> template<>
+	void impostoratlas_object_t::test<2>()
+	{
+		set_test_name("fill, fall back and merge");
+
+		LLImpostorAtlas atlas;
+		atlas.init(512, 64);
+
+		std::vector<S32> slots;
+		for (U32 i = 0; i < 4; ++i)
+		{
+			slots.push_back(atlas.allocate(256, 256));
+			ensure_equals("full size slot", atlas.getSlotSize(slots.back()), 256U);
+		}
+		ensure_equals("whole atlas in use", atlas.getAllocatedArea(), 512U * 512U);
+		ensure_equals("nothing left", atlas.allocate(64, 64), -1);
+		ensure("disjoint", disjoint(atlas, slots));
+
+		// split one quarter up into small slots
+		atlas.release(slots[1]);
+		slots.erase(slots.begin() + 1);
+		S32 half = atlas.allocate(128, 128);
+		ensure_equals("exact fit", atlas.getSlotSize(half), 128U);
+		S32 fallback = atlas.allocate(256, 256);
+		ensure_equals("falls back to what is left", atlas.getSlotSize(fallback), 128U);
+		slots.push_back(half);
+		slots.push_back(fallback);
+		ensure("disjoint after split", disjoint(atlas, slots));
+
+		// releasing everything merges back into one block
+		for (S32 slot : slots)
+		{
+			atlas.release(slot);
+		}
+		ensure_equals("no slots", atlas.getSlotCount(), 0U);
+		S32 whole = atlas.allocate(512, 512);
+		ensure_equals("merged", atlas.getSlotSize(whole), 512U);
+	}
+
+	template<> template<>
+	void impostoratlas_object_t::test<3>()
+	{
+		set_test_name("used area and texture coordinates");
+
+		LLImpostorAtlas atlas;
+		atlas.init(256, 32);
+		atlas.allocate(128, 128);
+		S32 slot = atlas.allocate(128, 128);
+
+		atlas.setUsed(slot, 64, 128);
+		LLVector2 tc_min;
+		LLVector2 tc_max;
+		atlas.getTexCoords(slot, tc_min, tc_max);
+		ensure_equals("width", (tc_max.mV[0] - tc_min.mV[0]) * 256.f, 64.f);
+		ensure_equals("height", (tc_max.mV[1] - tc_min.mV[1]) * 256.f, 128.f);
+		ensure_equals("slot origin", tc_min.mV[0] * 256.f, (F32)atlas.getSlotX(slot));
+
+		atlas.setUsed(slot, 128, 512);
+		ensure_equals("scaled to fit height", atlas.getUsedHeight(slot), 128U);
+		ensure_equals("keeps aspect", atlas.getUsedWidth(slot), 32U);
+
+		atlas.release(slot);
+		ensure("released", !atlas.isValid(slot));
+		atlas.release(slot);
+		ensure_equals("double release is harmless", atlas.getSlotCount(), 1U);
+	}
+}